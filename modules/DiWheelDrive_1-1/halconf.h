@@ -96,7 +96,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * @brief   Enables the GPT subsystem.
  */
 #if !defined(HAL_USE_GPT) || defined(__DOXYGEN__)
-#define HAL_USE_GPT                 FALSE
+#define HAL_USE_GPT                 TRUE
 #endif
 
 /**
@@ -280,6 +280,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MMC_NICE_WAITING            FALSE
 #endif
 
+/*===========================================================================*/
+/* QEI driver related settings.                                              */
+/*===========================================================================*/
+
+/**
+ * @brief   Enables the extended 64 bit position counter.
+ */
+#if !defined(QEI_USE_EXTENDED_POSITION) || defined(__DOXYGEN__)
+#define QEI_USE_EXTENDED_POSITION   TRUE
+#endif
+
+/**
+ * @brief   Enables the velocity estimation.
+ */
+#if !defined(QEI_USE_VELOCITY) || defined(__DOXYGEN__)
+#define QEI_USE_VELOCITY            TRUE
+#endif
+
 /*===========================================================================*/
 /* SDC driver related settings.                                              */
 /*===========================================================================*/
@@ -89,13 +89,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /*
  * GPT driver system settings.
  */
-#define STM32_GPT_USE_TIM1                  FALSE
+#define STM32_GPT_USE_TIM1                  TRUE
 #define STM32_GPT_USE_TIM2                  FALSE
 #define STM32_GPT_USE_TIM3                  FALSE
 #define STM32_GPT_USE_TIM4                  FALSE
 #define STM32_GPT_USE_TIM5                  FALSE
 #define STM32_GPT_USE_TIM8                  FALSE
-#define STM32_GPT_TIM1_IRQ_PRIORITY         7
+#define STM32_GPT_TIM1_IRQ_PRIORITY         6
 #define STM32_GPT_TIM2_IRQ_PRIORITY         7
 #define STM32_GPT_TIM3_IRQ_PRIORITY         7
 #define STM32_GPT_TIM4_IRQ_PRIORITY         7
@@ -223,5 +223,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define STM32_QEI_USE_TIM4                  TRUE
 #define STM32_QEI_USE_TIM5                  FALSE
 #define STM32_QEI_USE_TIM8                  FALSE
+#define STM32_QEI_TIM1_IRQ_PRIORITY         7
+#define STM32_QEI_TIM2_IRQ_PRIORITY         7
+#define STM32_QEI_TIM3_IRQ_PRIORITY         7
+#define STM32_QEI_TIM4_IRQ_PRIORITY         7
+#define STM32_QEI_TIM5_IRQ_PRIORITY         7
+#define STM32_QEI_TIM8_IRQ_PRIORITY         7
 
 #endif /* _MCUCONF_H_ */
@@ -49,7 +49,7 @@ static void _modulePalIsrCallback(void *args) {
 /*===========================================================================*/
 
 CANConfig moduleHalCanConfig = {
-  /* mcr  */ CAN_MCR_ABOM | CAN_MCR_AWUM | CAN_MCR_TXFP,
+  /* mcr  */ CAN_MCR_ABOM | CAN_MCR_AWUM,
   /* btr  */ CAN_BTR_SJW(1) | CAN_BTR_TS2(2) | CAN_BTR_TS1(13) | CAN_BTR_BRP(1),
 };
 
@@ -193,6 +193,8 @@ QEIConfig moduleHalQeiConfig = {
     },
   },
   /* encoder range  */  0x10000u,
+  /* velocity period  */ TIME_MS2I(1),
+  /* velocity timeout */ 200000,
 };
 
 SerialConfig moduleHalProgIfConfig = {
@@ -307,6 +309,59 @@ apalGpio_t moduleGpioSysWarmrst = {
 const char* moduleShellPrompt = "DiWheelDrive";
 #endif
 
+/**
+ * @brief   Clock levels.
+ * @details The APB prescalers compensate the AHB prescaler, so all peripheral clocks are identical on each level.
+ *          Since the timer clocks are doubled only for APB prescalers other than 1, they are halved on the slower level.
+ */
+static const aos_clocklevel_t _clockLevels[2] = {
+  /* 72MHz */ {
+    /* CFGR     */ STM32_HPRE | STM32_PPRE1 | STM32_PPRE2,
+    /* HCLK     */ STM32_HCLK,
+    /* TIMCLK1  */ STM32_TIMCLK1,
+    /* TIMCLK2  */ STM32_TIMCLK2,
+  },
+  /* 36MHz */ {
+    /* CFGR     */ STM32_HPRE_DIV2 | STM32_PPRE1_DIV1 | STM32_PPRE2_DIV1,
+    /* HCLK     */ STM32_HCLK / 2,
+    /* TIMCLK1  */ STM32_TIMCLK1 / 2,
+    /* TIMCLK2  */ STM32_TIMCLK2 / 2,
+  },
+};
+
+/**
+ * @brief   Adapts the drive timers and the velocity estimation of the encoders to a new clock level.
+ * @details The PWM and the control loop timer keep their tick frequencies, so neither the duty cycles nor the loop rate
+ *          change.
+ *
+ * @param[in] level   The new clock level.
+ * @param[in] param   Unused.
+ */
+static void _clockCb(const aos_clocklevel_t* level, void* param)
+{
+  (void)param;
+
+  if (MODULE_HAL_PWM_DRIVE.state == PWM_READY) {
+    aosClockSetTimerFrequencyX(MODULE_HAL_PWM_DRIVE.tim, level->timclk1, moduleHalPwmDriveConfig.frequency);
+  }
+  if (MODULE_HAL_GPT_MOTORCONTROL.state != GPT_STOP) {
+    aosClockSetTimerFrequencyX(MODULE_HAL_GPT_MOTORCONTROL.tim, level->timclk2, MODULE_HAL_GPT_MOTORCONTROL.config->frequency);
+  }
+  qeiSetRealtimeFrequencyI(&MODULE_HAL_QEI_LEFT_WHEEL, level->hclk);
+  qeiSetRealtimeFrequencyI(&MODULE_HAL_QEI_RIGHT_WHEEL, level->hclk);
+
+  return;
+}
+
+/**
+ * @brief   Clock change notifier of the drive.
+ */
+static aos_clocknotifier_t _clockNotifier = {
+  /* callback */ _clockCb,
+  /* param    */ NULL,
+  /* next     */ NULL,
+};
+
 /** @} */
 
 /*===========================================================================*/
@@ -439,6 +494,519 @@ VCNL4020Driver moduleLldProximity = {
 
 /** @} */
 
+/*===========================================================================*/
+/**
+ * @name Services
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   EEPROM flush thread working area.
+ */
+static THD_WORKING_AREA(_svcEepromWa, MODULE_SVC_EEPROM_STACKSIZE);
+
+/**
+ * @brief   EEPROM cache configuration.
+ */
+static const svc_eeprom_config_t _svcEepromConfig = {
+  /* driver   */ &moduleLldEeprom,
+  /* timeout  */ MICROSECONDS_PER_SECOND,
+  /* delay    */ MODULE_SVC_EEPROM_DELAY,
+};
+
+svc_eeprom_t moduleSvcEeprom;
+
+/**
+ * @brief   Persistent settings configuration.
+ */
+static const svc_settings_config_t _svcSettingsConfig = {
+  /* EEPROM   */ &moduleSvcEeprom,
+  /* address  */ MODULE_SVC_SETTINGS_ADDRESS,
+  /* size     */ MODULE_SVC_SETTINGS_SIZE,
+};
+
+svc_settings_t moduleSvcSettings;
+
+/**
+ * @brief   CAN transmit thread working area.
+ */
+static THD_WORKING_AREA(_svcCanTxWa, MODULE_SVC_CANTX_STACKSIZE);
+
+/**
+ * @brief   Queue of control frames.
+ */
+static svc_cantx_entry_t _svcCanTxControlQueue[MODULE_SVC_CANTX_CONTROLQUEUE];
+
+/**
+ * @brief   Queue of data frames.
+ */
+static svc_cantx_entry_t _svcCanTxDataQueue[MODULE_SVC_CANTX_DATAQUEUE];
+
+/**
+ * @brief   Queue of bulk frames.
+ */
+static svc_cantx_entry_t _svcCanTxBulkQueue[MODULE_SVC_CANTX_BULKQUEUE];
+
+/**
+ * @brief   CAN transmit scheduler configuration.
+ */
+static const svc_cantx_config_t _svcCanTxConfig = {
+  /* driver  */ &MODULE_HAL_CAN,
+  /* classes */ {
+    /* control */ {
+      /* entries  */ _svcCanTxControlQueue,
+      /* size     */ MODULE_SVC_CANTX_CONTROLQUEUE,
+      /* lifetime */ 0,
+    },
+    /* data    */ {
+      /* entries  */ _svcCanTxDataQueue,
+      /* size     */ MODULE_SVC_CANTX_DATAQUEUE,
+      /* lifetime */ 0,
+    },
+    /* bulk    */ {
+      /* entries  */ _svcCanTxBulkQueue,
+      /* size     */ MODULE_SVC_CANTX_BULKQUEUE,
+      /* lifetime */ MODULE_SVC_CANTX_BULKLIFETIME,
+    },
+  },
+};
+
+svc_cantx_t moduleSvcCanTx;
+
+/**
+ * @brief   CAN bus thread working area.
+ */
+static THD_WORKING_AREA(_svcCanBusWa, MODULE_SVC_CANBUS_STACKSIZE);
+
+/**
+ * @brief   Message pool of the CAN bus service.
+ */
+static svc_canbus_message_t _svcCanBusMessages[MODULE_SVC_CANBUS_POOLSIZE];
+
+/**
+ * @brief   CAN bus service configuration.
+ */
+static const svc_canbus_config_t _svcCanBusConfig = {
+  /* driver    */ &MODULE_HAL_CAN,
+  /* scheduler */ &moduleSvcCanTx,
+  /* messages  */ _svcCanBusMessages,
+  /* number    */ MODULE_SVC_CANBUS_POOLSIZE,
+};
+
+svc_canbus_t moduleSvcCanBus;
+
+/**
+ * @brief   Time synchronization thread working area.
+ */
+static THD_WORKING_AREA(_svcTimeSyncWa, MODULE_SVC_TIMESYNC_STACKSIZE);
+
+/**
+ * @brief   Time synchronization service configuration.
+ */
+static const svc_timesync_config_t _svcTimeSyncConfig = {
+  /* bus        */ &moduleSvcCanBus,
+  /* sync flags */ MODULE_SSSP_EVENTFLAGS_SYNC,
+};
+
+svc_timesync_t moduleSvcTimeSync;
+
+/**
+ * @brief   Hardware configuration and initial gains of the differential drive controller.
+ * @details The gains are initial values and should be tuned via the module:drive shell command.
+ */
+static const svc_diffdrive_config_t _svcDiffDriveConfig = {
+  /* timer            */ &MODULE_HAL_GPT_MOTORCONTROL,
+  /* timer frequency  */ MODULE_SVC_DIFFDRIVE_GPTFREQUENCY,
+  /* loop rate        */ MODULE_SVC_DIFFDRIVE_RATE,
+  /* PWM driver       */ &MODULE_HAL_PWM_DRIVE,
+  /* motor driver     */ &moduleLldMotors,
+  /* wheels           */ {
+    /* left wheel       */ {
+      /* encoder          */ &MODULE_HAL_QEI_LEFT_WHEEL,
+      /* forward channel  */ MODULE_HAL_PWM_DRIVE_CHANNEL_LEFT_FORWARD,
+      /* backward channel */ MODULE_HAL_PWM_DRIVE_CHANNEL_LEFT_BACKWARD,
+    },
+    /* right wheel      */ {
+      /* encoder          */ &MODULE_HAL_QEI_RIGHT_WHEEL,
+      /* forward channel  */ MODULE_HAL_PWM_DRIVE_CHANNEL_RIGHT_FORWARD,
+      /* backward channel */ MODULE_HAL_PWM_DRIVE_CHANNEL_RIGHT_BACKWARD,
+    },
+  },
+  /* increments       */ MODULE_HAL_QEI_INCREMENTS_PER_REVOLUTION,
+  /* wheel diameter   */ MODULE_SVC_DIFFDRIVE_WHEELDIAMETER,
+  /* wheel base       */ MODULE_SVC_DIFFDRIVE_WHEELBASE,
+  /* gains            */ {
+    /* kp   */ 2.0e-4f,
+    /* ki   */ 2.0e-3f,
+    /* kd   */ 0.0f,
+    /* kff  */ 1.25e-4f,
+    /* kfs  */ 0.05f,
+  },
+};
+
+svc_diffdrive_t moduleSvcDiffDrive;
+
+/**
+ * @brief   Odometry configuration.
+ */
+static const svc_odometry_config_t _svcOdometryConfig = {
+  /* encoders         */ {
+    /* left wheel       */ &MODULE_HAL_QEI_LEFT_WHEEL,
+    /* right wheel      */ &MODULE_HAL_QEI_RIGHT_WHEEL,
+  },
+  /* period           */ TIME_MS2I(1),
+  /* increments       */ MODULE_HAL_QEI_INCREMENTS_PER_REVOLUTION,
+  /* wheel diameter   */ MODULE_SVC_DIFFDRIVE_WHEELDIAMETER,
+  /* wheel base       */ MODULE_SVC_DIFFDRIVE_WHEELBASE,
+  /* gyro weight      */ MODULE_SVC_ODOMETRY_GYROWEIGHT,
+  /* gyro timeout     */ MODULE_SVC_ODOMETRY_GYROTIMEOUT,
+};
+
+svc_odometry_t moduleSvcOdometry;
+
+/**
+ * @brief   IMU thread working area.
+ */
+static THD_WORKING_AREA(_svcImuWa, MODULE_SVC_IMU_STACKSIZE);
+
+/**
+ * @brief   Forwards the gyroscope yaw rate to the odometry.
+ */
+static void _svcImuGyroCb(void* arg, const float rate[3], aos_timestamp_t timestamp)
+{
+  chSysLock();
+  svcOdometrySetYawRateI((svc_odometry_t*)arg, (int32_t)(rate[2] * 1000000.0f), timestamp);
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   IMU configuration.
+ */
+static const svc_imu_config_t _svcImuConfig = {
+  /* gyroscope            */ &moduleLldGyroscope,
+  /* gyroscope SPI        */ &moduleHalSpiGyroscopeConfig,
+  /* accelerometer        */ &moduleLldAccelerometer,
+  /* accelerometer SPI    */ &moduleHalSpiAccelerometerConfig,
+  /* compass              */ &moduleLldCompass,
+  /* compass timeout      */ MICROSECONDS_PER_SECOND,
+  /* period               */ MODULE_SVC_IMU_PERIOD,
+  /* accel divider        */ 1,
+  /* compass divider      */ 2,
+  /* gyroscope scale      */ 8.75e-3f * 0.0174532925f,
+  /* bias samples         */ MODULE_SVC_IMU_BIASSAMPLES,
+  /* standstill           */ {
+    /* window               */ 50,
+    /* max. std. deviation  */ 0.005f,
+    /* max. deviation       */ 0.02f,
+    /* weight               */ 0.1f,
+  },
+  /* compass span         */ 200.0f,
+  /* EEPROM               */ &moduleSvcEeprom,
+  /* EEPROM address       */ MODULE_SVC_IMU_EEPROMADDRESS,
+  /* kp                   */ 1.0f,
+  /* ki                   */ 0.01f,
+  /* gyroscope callback   */ _svcImuGyroCb,
+  /* callback argument    */ &moduleSvcOdometry,
+};
+
+svc_imu_t moduleSvcImu;
+
+/**
+ * @brief   CPU frequency governor thread working area.
+ */
+static THD_WORKING_AREA(_svcCpuFreqWa, MODULE_SVC_CPUFREQ_STACKSIZE);
+
+/**
+ * @brief   CPU frequency governor configuration.
+ */
+static const svc_cpufreq_config_t _svcCpuFreqConfig = {
+  /* period */ MODULE_SVC_CPUFREQ_PERIOD,
+  /* up     */ MODULE_SVC_CPUFREQ_UP,
+  /* down   */ MODULE_SVC_CPUFREQ_DOWN,
+};
+
+svc_cpufreq_t moduleSvcCpuFreq;
+
+#if (AMIROOS_CFG_SHELL_ENABLE == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Callback function for the module:eeprom shell command.
+ */
+static int _svcShellCmdCb_Eeprom(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcEepromShellCmd(&moduleSvcEeprom, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the EEPROM cache.
+ */
+static aos_shellcommand_t _svcShellCmdEeprom = {
+  /* name     */ "module:eeprom",
+  /* callback */ _svcShellCmdCb_Eeprom,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:settings shell command.
+ */
+static int _svcShellCmdCb_Settings(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcSettingsShellCmd(&moduleSvcSettings, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the persistent settings.
+ */
+static aos_shellcommand_t _svcShellCmdSettings = {
+  /* name     */ "module:settings",
+  /* callback */ _svcShellCmdCb_Settings,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:canbus shell command.
+ */
+static int _svcShellCmdCb_CanBus(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcCanBusShellCmd(&moduleSvcCanBus, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the CAN publish/subscribe service.
+ */
+static aos_shellcommand_t _svcShellCmdCanBus = {
+  /* name     */ "module:canbus",
+  /* callback */ _svcShellCmdCb_CanBus,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:cantx shell command.
+ */
+static int _svcShellCmdCb_CanTx(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcCanTxShellCmd(&moduleSvcCanTx, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the CAN transmit scheduler.
+ */
+static aos_shellcommand_t _svcShellCmdCanTx = {
+  /* name     */ "module:cantx",
+  /* callback */ _svcShellCmdCb_CanTx,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:timesync shell command.
+ */
+static int _svcShellCmdCb_TimeSync(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcTimeSyncShellCmd(&moduleSvcTimeSync, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the time synchronization.
+ */
+static aos_shellcommand_t _svcShellCmdTimeSync = {
+  /* name     */ "module:timesync",
+  /* callback */ _svcShellCmdCb_TimeSync,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:drive shell command.
+ */
+static int _svcShellCmdCb_DiffDrive(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcDiffDriveShellCmd(&moduleSvcDiffDrive, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to control the differential drive.
+ */
+static aos_shellcommand_t _svcShellCmdDiffDrive = {
+  /* name     */ "module:drive",
+  /* callback */ _svcShellCmdCb_DiffDrive,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:odometry shell command.
+ */
+static int _svcShellCmdCb_Odometry(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcOdometryShellCmd(&moduleSvcOdometry, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to print the pose estimate.
+ */
+static aos_shellcommand_t _svcShellCmdOdometry = {
+  /* name     */ "module:odometry",
+  /* callback */ _svcShellCmdCb_Odometry,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:imu shell command.
+ */
+static int _svcShellCmdCb_Imu(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcImuShellCmd(&moduleSvcImu, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to print the orientation estimate.
+ */
+static aos_shellcommand_t _svcShellCmdImu = {
+  /* name     */ "module:imu",
+  /* callback */ _svcShellCmdCb_Imu,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:cpufreq shell command.
+ */
+static int _svcShellCmdCb_CpuFreq(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcCpuFreqShellCmd(&moduleSvcCpuFreq, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the CPU frequency governor.
+ */
+static aos_shellcommand_t _svcShellCmdCpuFreq = {
+  /* name     */ "module:cpufreq",
+  /* callback */ _svcShellCmdCb_CpuFreq,
+  /* next     */ NULL,
+};
+#endif
+
+/**
+ * @brief   Initializes all services.
+ */
+void moduleServicesInit(void)
+{
+  svcEepromInit(&moduleSvcEeprom, &_svcEepromConfig);
+  svcSettingsInit(&moduleSvcSettings, &_svcSettingsConfig);
+  svcCanTxInit(&moduleSvcCanTx, &_svcCanTxConfig);
+  svcCanBusInit(&moduleSvcCanBus, &_svcCanBusConfig);
+  svcTimeSyncInit(&moduleSvcTimeSync, &_svcTimeSyncConfig);
+  svcDiffDriveInit(&moduleSvcDiffDrive, &_svcDiffDriveConfig);
+  svcOdometryInit(&moduleSvcOdometry, &_svcOdometryConfig);
+  svcImuInit(&moduleSvcImu, &_svcImuConfig);
+  aosClockInit(_clockLevels, sizeof(_clockLevels) / sizeof(_clockLevels[0]));
+  aosClockRegisterNotifier(&_clockNotifier);
+  svcCpuFreqInit(&moduleSvcCpuFreq, &_svcCpuFreqConfig);
+#if (AMIROOS_CFG_SHELL_ENABLE == true)
+  aosShellAddCommand(&aos.shell, &_svcShellCmdEeprom);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdSettings);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdCanBus);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdCanTx);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdTimeSync);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdDiffDrive);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdOdometry);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdImu);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdCpuFreq);
+#endif
+
+  return;
+}
+
+/**
+ * @brief   Starts all services.
+ */
+void moduleServicesStart(void)
+{
+  // the cache is loaded synchronously, so services can read the EEPROM right away
+  svcEepromStart(&moduleSvcEeprom, _svcEepromWa, sizeof(_svcEepromWa), AOS_THD_NORMALPRIO_MIN);
+  svcSettingsStart(&moduleSvcSettings);
+  // the transmit thread refills the mailboxes as soon as they are empty, so it preempts all transmitting threads
+  svcCanTxStart(&moduleSvcCanTx, _svcCanTxWa, sizeof(_svcCanTxWa), AOS_THD_RTPRIO_MIN);
+  // the receive FIFOs hold three frames each, so they must be drained with high priority
+  svcCanBusStart(&moduleSvcCanBus, _svcCanBusWa, sizeof(_svcCanBusWa), AOS_THD_HIGHPRIO_MIN);
+  svcTimeSyncStart(&moduleSvcTimeSync, _svcTimeSyncWa, sizeof(_svcTimeSyncWa), AOS_THD_HIGHPRIO_MAX);
+  svcDiffDriveStart(&moduleSvcDiffDrive);
+  svcOdometryStart(&moduleSvcOdometry);
+  svcImuStart(&moduleSvcImu, _svcImuWa, sizeof(_svcImuWa), AOS_THD_NORMALPRIO_MAX);
+  // started last, so all services are initialized at full speed
+  svcCpuFreqStart(&moduleSvcCpuFreq, _svcCpuFreqWa, sizeof(_svcCpuFreqWa), AOS_THD_HIGHPRIO_MIN);
+
+  return;
+}
+
+/**
+ * @brief   Teardown tasks of all services and periphery communication interfaces.
+ */
+static struct {
+  aos_teardown_t eeprom;               /**< The eeprom service.                              */
+  aos_teardown_t settings;             /**< The settings service.                            */
+  aos_teardown_t cantx;                /**< The cantx service.                               */
+  aos_teardown_t canbus;               /**< The canbus service.                              */
+  aos_teardown_t timesync;             /**< The timesync service.                            */
+  aos_teardown_t diffdrive;            /**< The diffdrive service.                           */
+  aos_teardown_t odometry;             /**< The odometry service.                            */
+  aos_teardown_t imu;                  /**< The imu service.                                 */
+  aos_teardown_t cpufreq;              /**< The cpufreq service.                             */
+  aos_teardown_t pwmdrive;             /**< The @p MODULE_HAL_PWM_DRIVE driver.              */
+  aos_teardown_t qeileft;              /**< The @p MODULE_HAL_QEI_LEFT_WHEEL driver.         */
+  aos_teardown_t qeiright;             /**< The @p MODULE_HAL_QEI_RIGHT_WHEEL driver.        */
+  aos_teardown_t i2ccompass;           /**< The @p MODULE_HAL_I2C_COMPASS driver.            */
+  aos_teardown_t i2cproxeeprompwrmtr;  /**< The @p MODULE_HAL_I2C_PROX_EEPROM_PWRMTR driver. */
+} _teardown;
+
+/**
+ * @brief   Registers the teardown tasks of all services and periphery communication interfaces.
+ * @details Services, which access other services, are stopped before them.
+ *          Independent tasks are executed concurrently on shutdown.
+ */
+void moduleTeardownInit(void)
+{
+  // services
+  aosTeardownInit(&_teardown.eeprom, "eeprom", svcEepromTeardown, &moduleSvcEeprom, AOS_TEARDOWN_SERVICES, 10 * MICROSECONDS_PER_MILLISECOND);
+  aosTeardownRegister(&_teardown.eeprom);
+  aosTeardownInit(&_teardown.settings, "settings", svcSettingsTeardown, &moduleSvcSettings, AOS_TEARDOWN_SERVICES, MICROSECONDS_PER_MILLISECOND);
+  aosTeardownRegister(&_teardown.settings);
+  aosTeardownInit(&_teardown.cantx, "cantx", svcCanTxTeardown, &moduleSvcCanTx, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.cantx);
+  aosTeardownInit(&_teardown.canbus, "canbus", svcCanBusTeardown, &moduleSvcCanBus, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.canbus);
+  aosTeardownInit(&_teardown.timesync, "timesync", svcTimeSyncTeardown, &moduleSvcTimeSync, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.timesync);
+  aosTeardownInit(&_teardown.diffdrive, "diffdrive", svcDiffDriveTeardown, &moduleSvcDiffDrive, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.diffdrive);
+  aosTeardownInit(&_teardown.odometry, "odometry", svcOdometryTeardown, &moduleSvcOdometry, AOS_TEARDOWN_SERVICES, 10);
+  aosTeardownRegister(&_teardown.odometry);
+  aosTeardownInit(&_teardown.imu, "imu", svcImuTeardown, &moduleSvcImu, AOS_TEARDOWN_SERVICES, MODULE_SVC_IMU_PERIOD);
+  aosTeardownRegister(&_teardown.imu);
+  aosTeardownInit(&_teardown.cpufreq, "cpufreq", svcCpuFreqTeardown, &moduleSvcCpuFreq, AOS_TEARDOWN_SERVICES, MODULE_SVC_CPUFREQ_PERIOD);
+  aosTeardownRegister(&_teardown.cpufreq);
+  aosTeardownDepends(&_teardown.eeprom, &_teardown.settings);
+  aosTeardownDepends(&_teardown.eeprom, &_teardown.imu);
+  aosTeardownDepends(&_teardown.odometry, &_teardown.imu);
+  aosTeardownDepends(&_teardown.canbus, &_teardown.timesync);
+  aosTeardownDepends(&_teardown.cantx, &_teardown.canbus);
+  // periphery communication interfaces
+  aosTeardownInit(&_teardown.pwmdrive, "pwm", aosTeardownPwm, &MODULE_HAL_PWM_DRIVE, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.pwmdrive);
+  aosTeardownInit(&_teardown.qeileft, "qei left", aosTeardownQei, &MODULE_HAL_QEI_LEFT_WHEEL, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.qeileft);
+  aosTeardownInit(&_teardown.qeiright, "qei right", aosTeardownQei, &MODULE_HAL_QEI_RIGHT_WHEEL, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.qeiright);
+  aosTeardownInit(&_teardown.i2ccompass, "i2c compass", aosTeardownI2c, &MODULE_HAL_I2C_COMPASS, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.i2ccompass);
+  aosTeardownInit(&_teardown.i2cproxeeprompwrmtr, "i2c prox", aosTeardownI2c, &MODULE_HAL_I2C_PROX_EEPROM_PWRMTR, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.i2cproxeeprompwrmtr);
+  // don't stop the serial driver so messages can still be printed
+
+  return;
+}
+
+/** @} */
+
 /*===========================================================================*/
 /**
  * @name Unit tests (UT)
@@ -454,6 +1022,8 @@ static int _utShellCmdCb_AlldA3906(BaseSequentialStream* stream, int argc, char*
 {
   (void)argc;
   (void)argv;
+  // the test drives the motors directly
+  svcDiffDriveDisable(&moduleSvcDiffDrive);
   aosUtRun(stream, &moduleUtAlldA3906, NULL);
   return AOS_OK;
 }
@@ -493,7 +1063,13 @@ static int _utShellCmdCb_AlldAt24c01bn(BaseSequentialStream* stream, int argc, c
 {
   (void)argc;
   (void)argv;
+  // the test accesses the device directly, so the cache is flushed before and reloaded afterwards
+  const bool cache = (moduleSvcEeprom.thread != NULL);
+  svcEepromStop(&moduleSvcEeprom);
   aosUtRun(stream, &moduleUtAlldAt24c01bn, NULL);
+  if (cache) {
+    svcEepromStart(&moduleSvcEeprom, _svcEepromWa, sizeof(_svcEepromWa), AOS_THD_NORMALPRIO_MIN);
+  }
   return AOS_OK;
 }
 static ut_at24c01bndata_t _utAt24c01bnData = {
@@ -517,9 +1093,14 @@ static int _utShellCmdCb_AlldHmc5883l(BaseSequentialStream* stream, int argc, ch
 {
   (void)argc;
   (void)argv;
+  const bool imu = (moduleSvcImu.thread != NULL);
+  svcImuStop(&moduleSvcImu);
   aosIntEnable(&moduleIntDriver, MODULE_GPIO_INT_COMPASSDRDY);
   aosUtRun(stream, &moduleUtAlldHmc5883l, NULL);
   aosIntDisable(&moduleIntDriver, MODULE_GPIO_INT_COMPASSDRDY);
+  if (imu) {
+    svcImuStart(&moduleSvcImu, _svcImuWa, sizeof(_svcImuWa), AOS_THD_NORMALPRIO_MAX);
+  }
   return AOS_OK;
 }
 static ut_hmc5883ldata_t _utHmc5883lData = {
@@ -571,11 +1152,16 @@ static int _utShellCmdCb_AlldL3g4200d(BaseSequentialStream* stream, int argc, ch
 {
   (void)argc;
   (void)argv;
+  const bool imu = (moduleSvcImu.thread != NULL);
+  svcImuStop(&moduleSvcImu);
   aosIntEnable(&moduleIntDriver, MODULE_GPIO_INT_GYRODRDY);
   spiStart(((ut_l3g4200ddata_t*)moduleUtAlldL3g4200d.data)->l3gd->spid, ((ut_l3g4200ddata_t*)moduleUtAlldL3g4200d.data)->spiconf);
   aosUtRun(stream, &moduleUtAlldL3g4200d, NULL);
   spiStop(((ut_l3g4200ddata_t*)moduleUtAlldL3g4200d.data)->l3gd->spid);
   aosIntDisable(&moduleIntDriver, MODULE_GPIO_INT_GYRODRDY);
+  if (imu) {
+    svcImuStart(&moduleSvcImu, _svcImuWa, sizeof(_svcImuWa), AOS_THD_NORMALPRIO_MAX);
+  }
   return AOS_OK;
 }
 static ut_l3g4200ddata_t _utL3g4200dData = {
@@ -621,11 +1207,16 @@ static int _utShellCmdCb_AlldLis331dlh(BaseSequentialStream* stream, int argc, c
 {
   (void)argc;
   (void)argv;
+  const bool imu = (moduleSvcImu.thread != NULL);
+  svcImuStop(&moduleSvcImu);
   aosIntEnable(&moduleIntDriver, MODULE_GPIO_INT_ACCELINT);
   spiStart(((ut_lis331dlhdata_t*)moduleUtAlldLis331dlh.data)->lisd->spid, ((ut_lis331dlhdata_t*)moduleUtAlldLis331dlh.data)->spiconf);
   aosUtRun(stream, &moduleUtAlldLis331dlh, NULL);
   spiStop(((ut_lis331dlhdata_t*)moduleUtAlldLis331dlh.data)->lisd->spid);
   aosIntDisable(&moduleIntDriver, MODULE_GPIO_INT_ACCELINT);
+  if (imu) {
+    svcImuStart(&moduleSvcImu, _svcImuWa, sizeof(_svcImuWa), AOS_THD_NORMALPRIO_MAX);
+  }
   return AOS_OK;
 }
 static ut_lis331dlhdata_t _utLis331dlhData = {
@@ -803,6 +1394,113 @@ aos_unittest_t moduleUtAlldVcnl4020 = {
   /* data           */ &_utVcnl4020Data,
 };
 
+/* IMU filter */
+static int _utShellCmdCb_SvcImuFilter(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  // the benchmark is rated for the static clock configuration
+  aosClockHold();
+  aosUtRun(stream, &moduleUtSvcImuFilter, NULL);
+  aosClockRelease();
+  return AOS_OK;
+}
+static ut_imufilterdata_t _utImuFilterData = {
+  /* iterations         */ 1000,
+  /* counter frequency  */ STM32_HCLK,
+};
+aos_unittest_t moduleUtSvcImuFilter = {
+  /* name           */ "IMU filter",
+  /* info           */ "orientation filter core",
+  /* test function  */ utSvcImuFilterFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:ImuFilter",
+    /* callback */ _utShellCmdCb_SvcImuFilter,
+    /* next     */ NULL,
+  },
+  /* data           */ &_utImuFilterData,
+};
+
+/* IMU calibration */
+static int _utShellCmdCb_SvcImuCalib(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcImuCalib, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcImuCalib = {
+  /* name           */ "IMU calibration",
+  /* info           */ "bias estimation and compass fit",
+  /* test function  */ utSvcImuCalibFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:ImuCalib",
+    /* callback */ _utShellCmdCb_SvcImuCalib,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
+/* key-value store */
+static int _utShellCmdCb_SvcKvStore(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcKvStore, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcKvStore = {
+  /* name           */ "key-value store",
+  /* info           */ "wear leveling and recovery",
+  /* test function  */ utSvcKvStoreFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:KvStore",
+    /* callback */ _utShellCmdCb_SvcKvStore,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
+/* CAN protocol */
+static int _utShellCmdCb_SvcCanProto(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcCanProto, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcCanProto = {
+  /* name           */ "CAN protocol",
+  /* info           */ "fragmentation and reassembly",
+  /* test function  */ utSvcCanProtoFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:CanProto",
+    /* callback */ _utShellCmdCb_SvcCanProto,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
+/* CAN filter */
+static int _utShellCmdCb_SvcCanFilter(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcCanFilter, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcCanFilter = {
+  /* name           */ "CAN filter",
+  /* info           */ "filter bank compilation",
+  /* test function  */ utSvcCanFilterFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:CanFilter",
+    /* callback */ _utShellCmdCb_SvcCanFilter,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
 #endif /* AMIROOS_CFG_TESTS_ENABLE == true */
 
 /** @} */
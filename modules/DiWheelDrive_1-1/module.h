@@ -130,6 +130,11 @@ extern QEIConfig moduleHalQeiConfig;
  */
 #define MODULE_HAL_QEI_INCREMENTS_PER_REVOLUTION  (apalQEICount_t)(2 * 2 * 16 * 22)
 
+/**
+ * @brief   Timer driver to trigger the motor control loop.
+ */
+#define MODULE_HAL_GPT_MOTORCONTROL             GPTD1
+
 /**
  * @brief   Serial driver of the programmer interface.
  */
@@ -358,6 +363,30 @@ extern const char* moduleShellPrompt;
   qeiInit();                                                                  \
 }
 
+/**
+ * @brief   Additional OS initialization hook.
+ */
+#define MODULE_INIT_OS_EXTRA() {                                              \
+  moduleServicesInit();                                                       \
+}
+
+/**
+ * @brief   Services initialization hook.
+ */
+#define MODULE_INIT_SERVICES() {                                              \
+  moduleServicesStart();                                                      \
+  /* register teardown tasks */                                               \
+  moduleTeardownInit();                                                       \
+}
+
+/**
+ * @brief   System configuration hook.
+ * @details Persists the shell configuration and the date/time after they were modified via the shell.
+ */
+#define MODULE_SYSTEM_CONFIG_HOOK() {                                         \
+  svcSettingsSave(&moduleSvcSettings);                                        \
+}
+
 /**
  * @brief   Unit test initialization hook.
  */
@@ -374,6 +403,11 @@ extern const char* moduleShellPrompt;
   aosShellAddCommand(&aos.shell, &moduleUtAlldPca9544a.shellcmd);             \
   aosShellAddCommand(&aos.shell, &moduleUtAlldTps62113.shellcmd);             \
   aosShellAddCommand(&aos.shell, &moduleUtAlldVcnl4020.shellcmd);             \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcImuFilter.shellcmd);             \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcImuCalib.shellcmd);              \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcKvStore.shellcmd);               \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcCanProto.shellcmd);              \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcCanFilter.shellcmd);             \
 }
 
 /**
@@ -402,23 +436,6 @@ extern const char* moduleShellPrompt;
   qeiEnable(&MODULE_HAL_QEI_RIGHT_WHEEL);                                     \
 }
 
-/**
- * @brief   Periphery communication interface deinitialization hook.
- */
-#define MODULE_SHUTDOWN_PERIPHERY_COMM() {                                    \
-  /* PWM */                                                                   \
-  pwmStop(&MODULE_HAL_PWM_DRIVE);                                             \
-  /* QEI */                                                                   \
-  qeiDisable(&MODULE_HAL_QEI_LEFT_WHEEL);                                     \
-  qeiDisable(&MODULE_HAL_QEI_RIGHT_WHEEL);                                    \
-  qeiStop(&MODULE_HAL_QEI_LEFT_WHEEL);                                        \
-  qeiStop(&MODULE_HAL_QEI_RIGHT_WHEEL);                                       \
-  /* I2C */                                                                   \
-  i2cStop(&MODULE_HAL_I2C_COMPASS);                                           \
-  i2cStop(&MODULE_HAL_I2C_PROX_EEPROM_PWRMTR);                                \
-  /* don't stop the serial driver so messages can still be printed */         \
-}
-
 /** @} */
 
 /*===========================================================================*/
@@ -535,6 +552,210 @@ extern VCNL4020Driver moduleLldProximity;
 
 /** @} */
 
+/*===========================================================================*/
+/**
+ * @name Services
+ * @{
+ */
+/*===========================================================================*/
+#include <svc_eeprom.h>
+#include <svc_canbus.h>
+#include <svc_cantx.h>
+#include <svc_cpufreq.h>
+#include <svc_diffdrive.h>
+#include <svc_imu.h>
+#include <svc_odometry.h>
+#include <svc_settings.h>
+#include <svc_timesync.h>
+
+/**
+ * @brief   Delay of the asynchronous EEPROM flush in microseconds.
+ * @details Writes within this interval are merged into a single write cycle per page.
+ */
+#define MODULE_SVC_EEPROM_DELAY                 (100 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Stack size of the EEPROM flush thread.
+ */
+#define MODULE_SVC_EEPROM_STACKSIZE             256
+
+/**
+ * @brief   EEPROM cache.
+ */
+extern svc_eeprom_t moduleSvcEeprom;
+
+/**
+ * @brief   EEPROM address of the persistent settings (behind the IMU calibration).
+ */
+#define MODULE_SVC_SETTINGS_ADDRESS             (MODULE_SVC_IMU_EEPROMADDRESS + SVC_IMUCALIB_SERIALIZED_SIZE)
+
+/**
+ * @brief   Size of the persistent settings region in bytes.
+ */
+#define MODULE_SVC_SETTINGS_SIZE                (SVC_EEPROM_SIZE - MODULE_SVC_SETTINGS_ADDRESS)
+
+/**
+ * @brief   Persistent settings.
+ */
+extern svc_settings_t moduleSvcSettings;
+
+/**
+ * @brief   Number of control frames the CAN transmit scheduler can queue.
+ */
+#define MODULE_SVC_CANTX_CONTROLQUEUE           4
+
+/**
+ * @brief   Number of data frames the CAN transmit scheduler can queue.
+ */
+#define MODULE_SVC_CANTX_DATAQUEUE              8
+
+/**
+ * @brief   Number of bulk frames the CAN transmit scheduler can queue.
+ */
+#define MODULE_SVC_CANTX_BULKQUEUE              8
+
+/**
+ * @brief   Time in microseconds after which queued bulk frames are considered stale and dropped.
+ */
+#define MODULE_SVC_CANTX_BULKLIFETIME           (100 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Stack size of the CAN transmit thread.
+ */
+#define MODULE_SVC_CANTX_STACKSIZE              256
+
+/**
+ * @brief   CAN transmit scheduler.
+ */
+extern svc_cantx_t moduleSvcCanTx;
+
+/**
+ * @brief   Number of messages in the pool of the CAN bus service.
+ */
+#define MODULE_SVC_CANBUS_POOLSIZE              8
+
+/**
+ * @brief   Stack size of the CAN bus thread.
+ */
+#define MODULE_SVC_CANBUS_STACKSIZE             256
+
+/**
+ * @brief   CAN publish/subscribe service.
+ */
+extern svc_canbus_t moduleSvcCanBus;
+
+/**
+ * @brief   Stack size of the time synchronization thread.
+ */
+#define MODULE_SVC_TIMESYNC_STACKSIZE           256
+
+/**
+ * @brief   Time synchronization via CAN.
+ */
+extern svc_timesync_t moduleSvcTimeSync;
+
+/**
+ * @brief   Timer frequency of the motor control loop in Hz.
+ */
+#define MODULE_SVC_DIFFDRIVE_GPTFREQUENCY       1000000
+
+/**
+ * @brief   Motor control loop rate in Hz.
+ */
+#define MODULE_SVC_DIFFDRIVE_RATE               1000
+
+/**
+ * @brief   Wheel diameter in meters.
+ */
+#define MODULE_SVC_DIFFDRIVE_WHEELDIAMETER      0.05571f
+
+/**
+ * @brief   Distance between the wheels in meters.
+ */
+#define MODULE_SVC_DIFFDRIVE_WHEELBASE          0.069f
+
+/**
+ * @brief   Differential drive controller service.
+ */
+extern svc_diffdrive_t moduleSvcDiffDrive;
+
+/**
+ * @brief   Weight of the gyroscope yaw rate for the odometry heading.
+ */
+#define MODULE_SVC_ODOMETRY_GYROWEIGHT          0.9f
+
+/**
+ * @brief   Maximum age of a yaw rate measurement for the odometry in microseconds.
+ */
+#define MODULE_SVC_ODOMETRY_GYROTIMEOUT         (50 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Odometry service.
+ */
+extern svc_odometry_t moduleSvcOdometry;
+
+/**
+ * @brief   IMU filter period in microseconds (matches the gyroscope data rate of 100 Hz).
+ */
+#define MODULE_SVC_IMU_PERIOD                   (10 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Number of gyroscope samples to estimate the bias at startup (one second).
+ */
+#define MODULE_SVC_IMU_BIASSAMPLES              100
+
+/**
+ * @brief   EEPROM address of the persistent IMU calibration.
+ */
+#define MODULE_SVC_IMU_EEPROMADDRESS            0x00
+
+/**
+ * @brief   Stack size of the IMU thread.
+ */
+#define MODULE_SVC_IMU_STACKSIZE                768
+
+/**
+ * @brief   IMU fusion service.
+ */
+extern svc_imu_t moduleSvcImu;
+
+/**
+ * @brief   Period of the load measurement of the CPU frequency governor in microseconds.
+ */
+#define MODULE_SVC_CPUFREQ_PERIOD               (10 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Load in permille, above which the core clock is raised to the maximum.
+ */
+#define MODULE_SVC_CPUFREQ_UP                   700
+
+/**
+ * @brief   Load in permille, which must not be reached at the next slower clock level to lower the core clock.
+ */
+#define MODULE_SVC_CPUFREQ_DOWN                 500
+
+/**
+ * @brief   Stack size of the CPU frequency governor thread.
+ */
+#define MODULE_SVC_CPUFREQ_STACKSIZE            256
+
+/**
+ * @brief   CPU frequency governor.
+ */
+extern svc_cpufreq_t moduleSvcCpuFreq;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void moduleServicesInit(void);
+  void moduleServicesStart(void);
+  void moduleTeardownInit(void);
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
 /*===========================================================================*/
 /**
  * @name Unit tests (UT)
@@ -553,6 +774,11 @@ extern VCNL4020Driver moduleLldProximity;
 #include <ut_alld_pca9544a.h>
 #include <ut_alld_tps62113.h>
 #include <ut_alld_vcnl4020.h>
+#include <ut_svc_canfilter.h>
+#include <ut_svc_canproto.h>
+#include <ut_svc_imucalib.h>
+#include <ut_svc_imufilter.h>
+#include <ut_svc_kvstore.h>
 
 /**
  * @brief   A3906 (motor driver) unit test object.
@@ -609,6 +835,31 @@ extern aos_unittest_t moduleUtAlldTps62113;
  */
 extern aos_unittest_t moduleUtAlldVcnl4020;
 
+/**
+ * @brief   IMU filter unit test object.
+ */
+extern aos_unittest_t moduleUtSvcImuFilter;
+
+/**
+ * @brief   IMU calibration unit test object.
+ */
+extern aos_unittest_t moduleUtSvcImuCalib;
+
+/**
+ * @brief   Key-value store unit test object.
+ */
+extern aos_unittest_t moduleUtSvcKvStore;
+
+/**
+ * @brief   CAN protocol unit test object.
+ */
+extern aos_unittest_t moduleUtSvcCanProto;
+
+/**
+ * @brief   CAN filter unit test object.
+ */
+extern aos_unittest_t moduleUtSvcCanFilter;
+
 #endif /* AMIROOS_CFG_TESTS_ENABLE == true */
 
 /** @} */
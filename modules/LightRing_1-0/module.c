@@ -49,7 +49,7 @@ static void _modulePalIsrCallback(void *args) {
 /*===========================================================================*/
 
 CANConfig moduleHalCanConfig = {
-  /* mcr  */ CAN_MCR_ABOM | CAN_MCR_AWUM | CAN_MCR_TXFP,
+  /* mcr  */ CAN_MCR_ABOM | CAN_MCR_AWUM,
   /* btr  */ CAN_BTR_SJW(1) | CAN_BTR_TS2(2) | CAN_BTR_TS1(13) | CAN_BTR_BRP(1),
 };
 
@@ -196,6 +196,26 @@ apalGpio_t moduleGpioSysSync = {
 const char* moduleShellPrompt = "LightRing";
 #endif
 
+/**
+ * @brief   Clock levels.
+ * @details The APB prescalers compensate the AHB prescaler, so all peripheral clocks are identical on each level.
+ *          Since the timer clocks are doubled only for APB prescalers other than 1, they are halved on the slower level.
+ */
+static const aos_clocklevel_t _clockLevels[2] = {
+  /* 72MHz */ {
+    /* CFGR     */ STM32_HPRE | STM32_PPRE1 | STM32_PPRE2,
+    /* HCLK     */ STM32_HCLK,
+    /* TIMCLK1  */ STM32_TIMCLK1,
+    /* TIMCLK2  */ STM32_TIMCLK2,
+  },
+  /* 36MHz */ {
+    /* CFGR     */ STM32_HPRE_DIV2 | STM32_PPRE1_DIV1 | STM32_PPRE2_DIV1,
+    /* HCLK     */ STM32_HCLK / 2,
+    /* TIMCLK1  */ STM32_TIMCLK1 / 2,
+    /* TIMCLK2  */ STM32_TIMCLK2 / 2,
+  },
+};
+
 /** @} */
 
 /*===========================================================================*/
@@ -287,6 +307,414 @@ TPS2051BDriver moduleLldPowerSwitchLaser = {
 
 /** @} */
 
+/*===========================================================================*/
+/**
+ * @name Services
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   EEPROM flush thread working area.
+ */
+static THD_WORKING_AREA(_svcEepromWa, MODULE_SVC_EEPROM_STACKSIZE);
+
+/**
+ * @brief   EEPROM cache configuration.
+ */
+static const svc_eeprom_config_t _svcEepromConfig = {
+  /* driver   */ &moduleLldEeprom,
+  /* timeout  */ MICROSECONDS_PER_SECOND,
+  /* delay    */ MODULE_SVC_EEPROM_DELAY,
+};
+
+svc_eeprom_t moduleSvcEeprom;
+
+/**
+ * @brief   Persistent settings configuration.
+ */
+static const svc_settings_config_t _svcSettingsConfig = {
+  /* EEPROM   */ &moduleSvcEeprom,
+  /* address  */ MODULE_SVC_SETTINGS_ADDRESS,
+  /* size     */ MODULE_SVC_SETTINGS_SIZE,
+};
+
+svc_settings_t moduleSvcSettings;
+
+/**
+ * @brief   CAN transmit thread working area.
+ */
+static THD_WORKING_AREA(_svcCanTxWa, MODULE_SVC_CANTX_STACKSIZE);
+
+/**
+ * @brief   Queue of control frames.
+ */
+static svc_cantx_entry_t _svcCanTxControlQueue[MODULE_SVC_CANTX_CONTROLQUEUE];
+
+/**
+ * @brief   Queue of data frames.
+ */
+static svc_cantx_entry_t _svcCanTxDataQueue[MODULE_SVC_CANTX_DATAQUEUE];
+
+/**
+ * @brief   Queue of bulk frames.
+ */
+static svc_cantx_entry_t _svcCanTxBulkQueue[MODULE_SVC_CANTX_BULKQUEUE];
+
+/**
+ * @brief   CAN transmit scheduler configuration.
+ */
+static const svc_cantx_config_t _svcCanTxConfig = {
+  /* driver  */ &MODULE_HAL_CAN,
+  /* classes */ {
+    /* control */ {
+      /* entries  */ _svcCanTxControlQueue,
+      /* size     */ MODULE_SVC_CANTX_CONTROLQUEUE,
+      /* lifetime */ 0,
+    },
+    /* data    */ {
+      /* entries  */ _svcCanTxDataQueue,
+      /* size     */ MODULE_SVC_CANTX_DATAQUEUE,
+      /* lifetime */ 0,
+    },
+    /* bulk    */ {
+      /* entries  */ _svcCanTxBulkQueue,
+      /* size     */ MODULE_SVC_CANTX_BULKQUEUE,
+      /* lifetime */ MODULE_SVC_CANTX_BULKLIFETIME,
+    },
+  },
+};
+
+svc_cantx_t moduleSvcCanTx;
+
+/**
+ * @brief   CAN bus thread working area.
+ */
+static THD_WORKING_AREA(_svcCanBusWa, MODULE_SVC_CANBUS_STACKSIZE);
+
+/**
+ * @brief   Message pool of the CAN bus service.
+ */
+static svc_canbus_message_t _svcCanBusMessages[MODULE_SVC_CANBUS_POOLSIZE];
+
+/**
+ * @brief   CAN bus service configuration.
+ */
+static const svc_canbus_config_t _svcCanBusConfig = {
+  /* driver    */ &MODULE_HAL_CAN,
+  /* scheduler */ &moduleSvcCanTx,
+  /* messages  */ _svcCanBusMessages,
+  /* number    */ MODULE_SVC_CANBUS_POOLSIZE,
+};
+
+svc_canbus_t moduleSvcCanBus;
+
+/**
+ * @brief   Time synchronization thread working area.
+ */
+static THD_WORKING_AREA(_svcTimeSyncWa, MODULE_SVC_TIMESYNC_STACKSIZE);
+
+/**
+ * @brief   Time synchronization service configuration.
+ */
+static const svc_timesync_config_t _svcTimeSyncConfig = {
+  /* bus        */ &moduleSvcCanBus,
+  /* sync flags */ MODULE_SSSP_EVENTFLAGS_SYNC,
+};
+
+svc_timesync_t moduleSvcTimeSync;
+
+/**
+ * @brief   Frame buffer thread working area.
+ */
+static THD_WORKING_AREA(_svcFrameBufferWa, MODULE_SVC_FRAMEBUFFER_STACKSIZE);
+
+/**
+ * @brief   Frame buffer configuration.
+ */
+static const svc_framebuffer_config_t _svcFrameBufferConfig = {
+  /* driver   */ &moduleLldLedPwm,
+  /* SPI      */ &MODULE_HAL_SPI_LIGHT,
+  /* period   */ MODULE_SVC_FRAMEBUFFER_PERIOD,
+};
+
+svc_framebuffer_t moduleSvcFrameBuffer;
+
+/**
+ * @brief   Animation thread working area.
+ */
+static THD_WORKING_AREA(_svcLightAnimWa, MODULE_SVC_LIGHTANIM_STACKSIZE);
+
+/**
+ * @brief   Animation configuration.
+ */
+static const svc_lightanim_config_t _svcLightAnimConfig = {
+  /* frame buffer */ &moduleSvcFrameBuffer,
+  /* brightness   */ MODULE_SVC_LIGHTANIM_BRIGHTNESS,
+  /* budget       */ MODULE_SVC_LIGHTANIM_BUDGET,
+};
+
+svc_lightanim_t moduleSvcLightAnim;
+
+/**
+ * @brief   CPU frequency governor thread working area.
+ */
+static THD_WORKING_AREA(_svcCpuFreqWa, MODULE_SVC_CPUFREQ_STACKSIZE);
+
+/**
+ * @brief   CPU frequency governor configuration.
+ */
+static const svc_cpufreq_config_t _svcCpuFreqConfig = {
+  /* period */ MODULE_SVC_CPUFREQ_PERIOD,
+  /* up     */ MODULE_SVC_CPUFREQ_UP,
+  /* down   */ MODULE_SVC_CPUFREQ_DOWN,
+};
+
+svc_cpufreq_t moduleSvcCpuFreq;
+
+#if (AMIROOS_CFG_SHELL_ENABLE == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Callback function for the module:eeprom shell command.
+ */
+static int _svcShellCmdCb_Eeprom(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcEepromShellCmd(&moduleSvcEeprom, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the EEPROM cache.
+ */
+static aos_shellcommand_t _svcShellCmdEeprom = {
+  /* name     */ "module:eeprom",
+  /* callback */ _svcShellCmdCb_Eeprom,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:settings shell command.
+ */
+static int _svcShellCmdCb_Settings(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcSettingsShellCmd(&moduleSvcSettings, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the persistent settings.
+ */
+static aos_shellcommand_t _svcShellCmdSettings = {
+  /* name     */ "module:settings",
+  /* callback */ _svcShellCmdCb_Settings,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:canbus shell command.
+ */
+static int _svcShellCmdCb_CanBus(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcCanBusShellCmd(&moduleSvcCanBus, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the CAN publish/subscribe service.
+ */
+static aos_shellcommand_t _svcShellCmdCanBus = {
+  /* name     */ "module:canbus",
+  /* callback */ _svcShellCmdCb_CanBus,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:cantx shell command.
+ */
+static int _svcShellCmdCb_CanTx(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcCanTxShellCmd(&moduleSvcCanTx, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the CAN transmit scheduler.
+ */
+static aos_shellcommand_t _svcShellCmdCanTx = {
+  /* name     */ "module:cantx",
+  /* callback */ _svcShellCmdCb_CanTx,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:timesync shell command.
+ */
+static int _svcShellCmdCb_TimeSync(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcTimeSyncShellCmd(&moduleSvcTimeSync, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the time synchronization.
+ */
+static aos_shellcommand_t _svcShellCmdTimeSync = {
+  /* name     */ "module:timesync",
+  /* callback */ _svcShellCmdCb_TimeSync,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:lights shell command.
+ */
+static int _svcShellCmdCb_FrameBuffer(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcFrameBufferShellCmd(&moduleSvcFrameBuffer, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to control the LED frame buffer.
+ */
+static aos_shellcommand_t _svcShellCmdFrameBuffer = {
+  /* name     */ "module:lights",
+  /* callback */ _svcShellCmdCb_FrameBuffer,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:animation shell command.
+ */
+static int _svcShellCmdCb_LightAnim(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcLightAnimShellCmd(&moduleSvcLightAnim, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to control the LED animations.
+ */
+static aos_shellcommand_t _svcShellCmdLightAnim = {
+  /* name     */ "module:animation",
+  /* callback */ _svcShellCmdCb_LightAnim,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:cpufreq shell command.
+ */
+static int _svcShellCmdCb_CpuFreq(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcCpuFreqShellCmd(&moduleSvcCpuFreq, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the CPU frequency governor.
+ */
+static aos_shellcommand_t _svcShellCmdCpuFreq = {
+  /* name     */ "module:cpufreq",
+  /* callback */ _svcShellCmdCb_CpuFreq,
+  /* next     */ NULL,
+};
+#endif
+
+/**
+ * @brief   Initializes all services.
+ */
+void moduleServicesInit(void)
+{
+  svcEepromInit(&moduleSvcEeprom, &_svcEepromConfig);
+  svcSettingsInit(&moduleSvcSettings, &_svcSettingsConfig);
+  svcCanTxInit(&moduleSvcCanTx, &_svcCanTxConfig);
+  svcCanBusInit(&moduleSvcCanBus, &_svcCanBusConfig);
+  svcTimeSyncInit(&moduleSvcTimeSync, &_svcTimeSyncConfig);
+  svcFrameBufferInit(&moduleSvcFrameBuffer, &_svcFrameBufferConfig);
+  svcLightAnimInit(&moduleSvcLightAnim, &_svcLightAnimConfig);
+  aosClockInit(_clockLevels, sizeof(_clockLevels) / sizeof(_clockLevels[0]));
+  svcCpuFreqInit(&moduleSvcCpuFreq, &_svcCpuFreqConfig);
+#if (AMIROOS_CFG_SHELL_ENABLE == true)
+  aosShellAddCommand(&aos.shell, &_svcShellCmdEeprom);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdSettings);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdCanBus);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdCanTx);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdTimeSync);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdFrameBuffer);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdLightAnim);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdCpuFreq);
+#endif
+
+  return;
+}
+
+/**
+ * @brief   Starts all services.
+ */
+void moduleServicesStart(void)
+{
+  // the cache is loaded synchronously, so services can read the EEPROM right away
+  svcEepromStart(&moduleSvcEeprom, _svcEepromWa, sizeof(_svcEepromWa), AOS_THD_NORMALPRIO_MIN);
+  svcSettingsStart(&moduleSvcSettings);
+  // the transmit thread refills the mailboxes as soon as they are empty, so it preempts all transmitting threads
+  svcCanTxStart(&moduleSvcCanTx, _svcCanTxWa, sizeof(_svcCanTxWa), AOS_THD_RTPRIO_MIN);
+  // the receive FIFOs hold three frames each, so they must be drained with high priority
+  svcCanBusStart(&moduleSvcCanBus, _svcCanBusWa, sizeof(_svcCanBusWa), AOS_THD_HIGHPRIO_MIN);
+  svcTimeSyncStart(&moduleSvcTimeSync, _svcTimeSyncWa, sizeof(_svcTimeSyncWa), AOS_THD_HIGHPRIO_MAX);
+  svcFrameBufferStart(&moduleSvcFrameBuffer, _svcFrameBufferWa, sizeof(_svcFrameBufferWa), AOS_THD_NORMALPRIO_MAX);
+  svcLightAnimStart(&moduleSvcLightAnim, _svcLightAnimWa, sizeof(_svcLightAnimWa), AOS_THD_NORMALPRIO_MAX);
+  // started last, so all services are initialized at full speed
+  svcCpuFreqStart(&moduleSvcCpuFreq, _svcCpuFreqWa, sizeof(_svcCpuFreqWa), AOS_THD_HIGHPRIO_MIN);
+
+  return;
+}
+
+/**
+ * @brief   Teardown tasks of all services and periphery communication interfaces.
+ */
+static struct {
+  aos_teardown_t eeprom;       /**< The eeprom service.                  */
+  aos_teardown_t settings;     /**< The settings service.                */
+  aos_teardown_t cantx;        /**< The cantx service.                   */
+  aos_teardown_t canbus;       /**< The canbus service.                  */
+  aos_teardown_t timesync;     /**< The timesync service.                */
+  aos_teardown_t framebuffer;  /**< The framebuffer service.             */
+  aos_teardown_t lightanim;    /**< The lightanim service.               */
+  aos_teardown_t cpufreq;      /**< The cpufreq service.                 */
+  aos_teardown_t spilight;     /**< The @p MODULE_HAL_SPI_LIGHT driver.  */
+  aos_teardown_t i2ceeprom;    /**< The @p MODULE_HAL_I2C_EEPROM driver. */
+} _teardown;
+
+/**
+ * @brief   Registers the teardown tasks of all services and periphery communication interfaces.
+ * @details Services, which access other services, are stopped before them.
+ *          Independent tasks are executed concurrently on shutdown.
+ */
+void moduleTeardownInit(void)
+{
+  // services
+  aosTeardownInit(&_teardown.eeprom, "eeprom", svcEepromTeardown, &moduleSvcEeprom, AOS_TEARDOWN_SERVICES, 10 * MICROSECONDS_PER_MILLISECOND);
+  aosTeardownRegister(&_teardown.eeprom);
+  aosTeardownInit(&_teardown.settings, "settings", svcSettingsTeardown, &moduleSvcSettings, AOS_TEARDOWN_SERVICES, MICROSECONDS_PER_MILLISECOND);
+  aosTeardownRegister(&_teardown.settings);
+  aosTeardownInit(&_teardown.cantx, "cantx", svcCanTxTeardown, &moduleSvcCanTx, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.cantx);
+  aosTeardownInit(&_teardown.canbus, "canbus", svcCanBusTeardown, &moduleSvcCanBus, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.canbus);
+  aosTeardownInit(&_teardown.timesync, "timesync", svcTimeSyncTeardown, &moduleSvcTimeSync, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.timesync);
+  aosTeardownInit(&_teardown.framebuffer, "framebuffer", svcFrameBufferTeardown, &moduleSvcFrameBuffer, AOS_TEARDOWN_SERVICES, MODULE_SVC_FRAMEBUFFER_PERIOD);
+  aosTeardownRegister(&_teardown.framebuffer);
+  aosTeardownInit(&_teardown.lightanim, "lightanim", svcLightAnimTeardown, &moduleSvcLightAnim, AOS_TEARDOWN_SERVICES, 2 * MODULE_SVC_FRAMEBUFFER_PERIOD);
+  aosTeardownRegister(&_teardown.lightanim);
+  aosTeardownInit(&_teardown.cpufreq, "cpufreq", svcCpuFreqTeardown, &moduleSvcCpuFreq, AOS_TEARDOWN_SERVICES, MODULE_SVC_CPUFREQ_PERIOD);
+  aosTeardownRegister(&_teardown.cpufreq);
+  aosTeardownDepends(&_teardown.eeprom, &_teardown.settings);
+  aosTeardownDepends(&_teardown.framebuffer, &_teardown.lightanim);
+  aosTeardownDepends(&_teardown.canbus, &_teardown.timesync);
+  aosTeardownDepends(&_teardown.cantx, &_teardown.canbus);
+  // periphery communication interfaces
+  aosTeardownInit(&_teardown.spilight, "spi", aosTeardownSpi, &MODULE_HAL_SPI_LIGHT, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.spilight);
+  aosTeardownInit(&_teardown.i2ceeprom, "i2c", aosTeardownI2c, &MODULE_HAL_I2C_EEPROM, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.i2ceeprom);
+  // don't stop the serial driver so messages can still be printed
+
+  return;
+}
+
+/** @} */
+
 /*===========================================================================*/
 /**
  * @name Unit tests (UT)
@@ -300,7 +728,13 @@ static int _utShellCmdCb_AlldAt24c01bn(BaseSequentialStream* stream, int argc, c
 {
   (void)argc;
   (void)argv;
+  // the test accesses the device directly, so the cache is flushed before and reloaded afterwards
+  const bool cache = (moduleSvcEeprom.thread != NULL);
+  svcEepromStop(&moduleSvcEeprom);
   aosUtRun(stream, &moduleUtAlldAt24c01bn, NULL);
+  if (cache) {
+    svcEepromStart(&moduleSvcEeprom, _svcEepromWa, sizeof(_svcEepromWa), AOS_THD_NORMALPRIO_MIN);
+  }
   return AOS_OK;
 }
 static ut_at24c01bndata_t _utAt24c01bnData = {
@@ -324,7 +758,12 @@ static int _utShellCmdCb_Tlc5947(BaseSequentialStream* stream, int argc, char* a
 {
   (void)argc;
   (void)argv;
+  const bool framebuffer = (moduleSvcFrameBuffer.thread != NULL);
+  svcFrameBufferStop(&moduleSvcFrameBuffer);
   aosUtRun(stream, &moduleUtAlldTlc5947, NULL);
+  if (framebuffer) {
+    svcFrameBufferStart(&moduleSvcFrameBuffer, _svcFrameBufferWa, sizeof(_svcFrameBufferWa), AOS_THD_NORMALPRIO_MAX);
+  }
   return AOS_OK;
 }
 aos_unittest_t moduleUtAlldTlc5947 = {
@@ -359,6 +798,93 @@ aos_unittest_t moduleUtAlldTps2051bdbv = {
   /* data           */ &moduleLldPowerSwitchLaser,
 };
 
+/* LED animation scripts */
+static int _utShellCmdCb_SvcLightScript(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  // the benchmark is rated for the static clock configuration
+  aosClockHold();
+  aosUtRun(stream, &moduleUtSvcLightScript, NULL);
+  aosClockRelease();
+  return AOS_OK;
+}
+static ut_lightscriptdata_t _utLightScriptData = {
+  /* iterations         */ 1000,
+  /* counter frequency  */ STM32_HCLK,
+};
+aos_unittest_t moduleUtSvcLightScript = {
+  /* name           */ "light script",
+  /* info           */ "LED animation core",
+  /* test function  */ utSvcLightScriptFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:LightScript",
+    /* callback */ _utShellCmdCb_SvcLightScript,
+    /* next     */ NULL,
+  },
+  /* data           */ &_utLightScriptData,
+};
+
+/* key-value store */
+static int _utShellCmdCb_SvcKvStore(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcKvStore, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcKvStore = {
+  /* name           */ "key-value store",
+  /* info           */ "wear leveling and recovery",
+  /* test function  */ utSvcKvStoreFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:KvStore",
+    /* callback */ _utShellCmdCb_SvcKvStore,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
+/* CAN protocol */
+static int _utShellCmdCb_SvcCanProto(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcCanProto, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcCanProto = {
+  /* name           */ "CAN protocol",
+  /* info           */ "fragmentation and reassembly",
+  /* test function  */ utSvcCanProtoFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:CanProto",
+    /* callback */ _utShellCmdCb_SvcCanProto,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
+/* CAN filter */
+static int _utShellCmdCb_SvcCanFilter(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcCanFilter, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcCanFilter = {
+  /* name           */ "CAN filter",
+  /* info           */ "filter bank compilation",
+  /* test function  */ utSvcCanFilterFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:CanFilter",
+    /* callback */ _utShellCmdCb_SvcCanFilter,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
 #endif /* AMIROOS_CFG_TESTS_ENABLE == true */
 
 /** @} */
@@ -224,6 +224,30 @@ extern apalGpio_t moduleGpioSysSync;
 extern const char* moduleShellPrompt;
 #endif
 
+/**
+ * @brief   Additional OS initialization hook.
+ */
+#define MODULE_INIT_OS_EXTRA() {                                              \
+  moduleServicesInit();                                                       \
+}
+
+/**
+ * @brief   Services initialization hook.
+ */
+#define MODULE_INIT_SERVICES() {                                              \
+  moduleServicesStart();                                                      \
+  /* register teardown tasks */                                               \
+  moduleTeardownInit();                                                       \
+}
+
+/**
+ * @brief   System configuration hook.
+ * @details Persists the shell configuration and the date/time after they were modified via the shell.
+ */
+#define MODULE_SYSTEM_CONFIG_HOOK() {                                         \
+  svcSettingsSave(&moduleSvcSettings);                                        \
+}
+
 /**
  * @brief   Unit test initialization hook.
  */
@@ -232,6 +256,10 @@ extern const char* moduleShellPrompt;
   aosShellAddCommand(&aos.shell, &moduleUtAlldAt24c01bn.shellcmd);            \
   aosShellAddCommand(&aos.shell, &moduleUtAlldTlc5947.shellcmd);              \
   aosShellAddCommand(&aos.shell, &moduleUtAlldTps2051bdbv.shellcmd);          \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcLightScript.shellcmd);           \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcKvStore.shellcmd);               \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcCanProto.shellcmd);              \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcCanFilter.shellcmd);             \
 }
 
 /**
@@ -248,17 +276,6 @@ extern const char* moduleShellPrompt;
   spiStart(&MODULE_HAL_SPI_LIGHT, &moduleHalSpiLightConfig);                  \
 }
 
-/**
- * @brief   Periphery communication interface deinitialization hook.
- */
-#define MODULE_SHUTDOWN_PERIPHERY_COMM() {                                    \
-  /* SPI */                                                                   \
-  spiStop(&MODULE_HAL_SPI_LIGHT);                                             \
-  /* I2C */                                                                   \
-  i2cStop(&MODULE_HAL_I2C_EEPROM);                                            \
-  /* don't stop the serial driver so messages can still be printed */         \
-}
-
 /** @} */
 
 /*===========================================================================*/
@@ -327,6 +344,179 @@ extern TPS2051BDriver moduleLldPowerSwitchLaser;
 
 /** @} */
 
+/*===========================================================================*/
+/**
+ * @name Services
+ * @{
+ */
+/*===========================================================================*/
+#include <svc_eeprom.h>
+#include <svc_canbus.h>
+#include <svc_cantx.h>
+#include <svc_cpufreq.h>
+#include <svc_framebuffer.h>
+#include <svc_lightanim.h>
+#include <svc_settings.h>
+#include <svc_timesync.h>
+
+/**
+ * @brief   Delay of the asynchronous EEPROM flush in microseconds.
+ * @details Writes within this interval are merged into a single write cycle per page.
+ */
+#define MODULE_SVC_EEPROM_DELAY                 (100 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Stack size of the EEPROM flush thread.
+ */
+#define MODULE_SVC_EEPROM_STACKSIZE             256
+
+/**
+ * @brief   EEPROM cache.
+ */
+extern svc_eeprom_t moduleSvcEeprom;
+
+/**
+ * @brief   EEPROM address of the persistent settings.
+ */
+#define MODULE_SVC_SETTINGS_ADDRESS             0x00
+
+/**
+ * @brief   Size of the persistent settings region in bytes.
+ */
+#define MODULE_SVC_SETTINGS_SIZE                (SVC_EEPROM_SIZE - MODULE_SVC_SETTINGS_ADDRESS)
+
+/**
+ * @brief   Persistent settings.
+ */
+extern svc_settings_t moduleSvcSettings;
+
+/**
+ * @brief   Number of control frames the CAN transmit scheduler can queue.
+ */
+#define MODULE_SVC_CANTX_CONTROLQUEUE           4
+
+/**
+ * @brief   Number of data frames the CAN transmit scheduler can queue.
+ */
+#define MODULE_SVC_CANTX_DATAQUEUE              8
+
+/**
+ * @brief   Number of bulk frames the CAN transmit scheduler can queue.
+ */
+#define MODULE_SVC_CANTX_BULKQUEUE              8
+
+/**
+ * @brief   Time in microseconds after which queued bulk frames are considered stale and dropped.
+ */
+#define MODULE_SVC_CANTX_BULKLIFETIME           (100 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Stack size of the CAN transmit thread.
+ */
+#define MODULE_SVC_CANTX_STACKSIZE              256
+
+/**
+ * @brief   CAN transmit scheduler.
+ */
+extern svc_cantx_t moduleSvcCanTx;
+
+/**
+ * @brief   Number of messages in the pool of the CAN bus service.
+ */
+#define MODULE_SVC_CANBUS_POOLSIZE              8
+
+/**
+ * @brief   Stack size of the CAN bus thread.
+ */
+#define MODULE_SVC_CANBUS_STACKSIZE             256
+
+/**
+ * @brief   CAN publish/subscribe service.
+ */
+extern svc_canbus_t moduleSvcCanBus;
+
+/**
+ * @brief   Stack size of the time synchronization thread.
+ */
+#define MODULE_SVC_TIMESYNC_STACKSIZE           256
+
+/**
+ * @brief   Time synchronization via CAN.
+ */
+extern svc_timesync_t moduleSvcTimeSync;
+
+/**
+ * @brief   Refresh period of the LED frame buffer in microseconds (125Hz).
+ */
+#define MODULE_SVC_FRAMEBUFFER_PERIOD           (8 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Stack size of the frame buffer thread.
+ */
+#define MODULE_SVC_FRAMEBUFFER_STACKSIZE        256
+
+/**
+ * @brief   Initial global brightness of the LED animations.
+ */
+#define MODULE_SVC_LIGHTANIM_BRIGHTNESS         255
+
+/**
+ * @brief   CPU time budget to render an animation frame in microseconds (1/8 of the refresh period).
+ */
+#define MODULE_SVC_LIGHTANIM_BUDGET             (MODULE_SVC_FRAMEBUFFER_PERIOD / 8)
+
+/**
+ * @brief   Stack size of the animation thread.
+ */
+#define MODULE_SVC_LIGHTANIM_STACKSIZE          256
+
+/**
+ * @brief   LED frame buffer.
+ */
+extern svc_framebuffer_t moduleSvcFrameBuffer;
+
+/**
+ * @brief   LED animation engine.
+ */
+extern svc_lightanim_t moduleSvcLightAnim;
+
+/**
+ * @brief   Period of the load measurement of the CPU frequency governor in microseconds.
+ */
+#define MODULE_SVC_CPUFREQ_PERIOD               (10 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Load in permille, above which the core clock is raised to the maximum.
+ */
+#define MODULE_SVC_CPUFREQ_UP                   700
+
+/**
+ * @brief   Load in permille, which must not be reached at the next slower clock level to lower the core clock.
+ */
+#define MODULE_SVC_CPUFREQ_DOWN                 500
+
+/**
+ * @brief   Stack size of the CPU frequency governor thread.
+ */
+#define MODULE_SVC_CPUFREQ_STACKSIZE            256
+
+/**
+ * @brief   CPU frequency governor.
+ */
+extern svc_cpufreq_t moduleSvcCpuFreq;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void moduleServicesInit(void);
+  void moduleServicesStart(void);
+  void moduleTeardownInit(void);
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
 /*===========================================================================*/
 /**
  * @name Unit tests (UT)
@@ -337,6 +527,10 @@ extern TPS2051BDriver moduleLldPowerSwitchLaser;
 #include <ut_alld_at24c01bn-sh-b.h>
 #include <ut_alld_tlc5947.h>
 #include <ut_alld_tps2051bdbv.h>
+#include <ut_svc_canfilter.h>
+#include <ut_svc_canproto.h>
+#include <ut_svc_kvstore.h>
+#include <ut_svc_lightscript.h>
 
 /**
  * @brief   EEPROM unit test object.
@@ -353,6 +547,26 @@ extern aos_unittest_t moduleUtAlldTlc5947;
  */
 extern aos_unittest_t moduleUtAlldTps2051bdbv;
 
+/**
+ * @brief   LED animation script unit test object.
+ */
+extern aos_unittest_t moduleUtSvcLightScript;
+
+/**
+ * @brief   Key-value store unit test object.
+ */
+extern aos_unittest_t moduleUtSvcKvStore;
+
+/**
+ * @brief   CAN protocol unit test object.
+ */
+extern aos_unittest_t moduleUtSvcCanProto;
+
+/**
+ * @brief   CAN filter unit test object.
+ */
+extern aos_unittest_t moduleUtSvcCanFilter;
+
 #endif /* AMIROOS_CFG_TESTS_ENABLE == true */
 
 /** @} */
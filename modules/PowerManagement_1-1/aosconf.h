@@ -127,6 +127,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
   #define AMIROOS_CFG_SSSP_SIGNALDELAY          OS_CFG_SSSP_SIGNALDELAY
 #endif
 
+/**
+ * @brief   Flag to enable the accelerated enumeration of the module stack.
+ * @details The SSSP master offers the enumeration to all modules first and falls back to the sequential initialization
+ *          if any module of the stack does not support it.
+ *          Module IDs are assigned in a single round according to the unique device IDs of the MCUs in this case,
+ *          so they are unique, but do not reflect the position of the module in the stack.
+ * @note    Disabled by default, since applications may rely on IDs in stack order.
+ *          It only accelerates the startup if enabled for all modules of the stack via OS_CFG_SSSP_FASTENUMERATION.
+ */
+#if !defined(OS_CFG_SSSP_FASTENUMERATION)
+  #define AMIROOS_CFG_SSSP_FASTENUMERATION      false
+#else
+  #define AMIROOS_CFG_SSSP_FASTENUMERATION      OS_CFG_SSSP_FASTENUMERATION
+#endif
+
 /**
  * @brief   Time boundary for robot wide clock synchronization in microseconds.
  * @details Whenever the SSSP S (snychronization) signal gets logically deactivated,
@@ -210,5 +225,117 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 /** @} */
 
+/*===========================================================================*/
+/**
+ * @name Snapshot cache options
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   Snapshot refresher thread stack size.
+ */
+#if !defined(OS_CFG_SNAPSHOT_STACKSIZE)
+  #define AMIROOS_CFG_SNAPSHOT_STACKSIZE        512
+#else
+  #define AMIROOS_CFG_SNAPSHOT_STACKSIZE        OS_CFG_SNAPSHOT_STACKSIZE
+#endif
+
+/**
+ * @brief   Snapshot refresher thread priority.
+ * @details Thread priorities are specified as an integer value.
+ *          Predefined ranges are:
+ *            lowest  ┌ THD_LOWPRIO_MIN
+ *                    │ ...
+ *                    └ THD_LOWPRIO_MAX
+ *                    ┌ THD_NORMALPRIO_MIN
+ *                    │ ...
+ *                    └ THD_NORMALPRIO_MAX
+ *                    ┌ THD_HIGHPRIO_MIN
+ *                    │ ...
+ *                    └ THD_HIGHPRIO_MAX
+ *                    ┌ THD_RTPRIO_MIN
+ *                    │ ...
+ *            highest └ THD_RTPRIO_MAX
+ */
+#if !defined(OS_CFG_SNAPSHOT_THREADPRIO)
+  #define AMIROOS_CFG_SNAPSHOT_THREADPRIO       AOS_THD_LOWPRIO_MAX
+#else
+  #define AMIROOS_CFG_SNAPSHOT_THREADPRIO       OS_CFG_SNAPSHOT_THREADPRIO
+#endif
+
+/** @} */
+
+/*===========================================================================*/
+/**
+ * @name Shutdown options
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of worker threads to execute independent teardown tasks concurrently during shutdown.
+ * @details The thread, which initiates the shutdown, always works on the tasks as well.
+ *          A value of 0 executes all tasks sequentially in the order of their dependencies.
+ */
+#if !defined(OS_CFG_TEARDOWN_WORKERS)
+  #define AMIROOS_CFG_TEARDOWN_WORKERS          2
+#else
+  #define AMIROOS_CFG_TEARDOWN_WORKERS          OS_CFG_TEARDOWN_WORKERS
+#endif
+
+/**
+ * @brief   Teardown worker thread stack size.
+ */
+#if !defined(OS_CFG_TEARDOWN_STACKSIZE)
+  #define AMIROOS_CFG_TEARDOWN_STACKSIZE        512
+#else
+  #define AMIROOS_CFG_TEARDOWN_STACKSIZE        OS_CFG_TEARDOWN_STACKSIZE
+#endif
+
+/** @} */
+
+/*===========================================================================*/
+/**
+ * @name Idle options
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   Flag to enable STOP mode while the system is idle.
+ * @details STOP mode halts all high-speed clocks, so it must only be enabled if all drivers, which are active while the
+ *          system is idle, tolerate this or prevent STOP mode via aosIdleHold() or aosIdleDeferI().
+ *          The RTC wakeup timer terminates STOP mode at the next deadline.
+ */
+#if !defined(OS_CFG_IDLE_STOP)
+  #define AMIROOS_CFG_IDLE_STOP                 false
+#else
+  #define AMIROOS_CFG_IDLE_STOP                 OS_CFG_IDLE_STOP
+#endif
+
+/**
+ * @brief   Minimum predicted time in STOP mode in microseconds.
+ * @details Shorter idle periods are spent in sleep mode, since the wakeup latency would outweigh the savings.
+ */
+#if !defined(OS_CFG_IDLE_STOP_MINIMUM)
+  #define AMIROOS_CFG_IDLE_STOP_MINIMUM         10000
+#else
+  #define AMIROOS_CFG_IDLE_STOP_MINIMUM         OS_CFG_IDLE_STOP_MINIMUM
+#endif
+
+/**
+ * @brief   Time in microseconds after any CAN traffic, during which STOP mode is prevented.
+ * @details Frames, which arrive while the system is in STOP mode, only wake it up but are lost, since the CAN clock is
+ *          halted. Since CAN traffic is bursty, STOP mode is entered only after the bus was quiet for this time.
+ */
+#if !defined(OS_CFG_IDLE_STOP_CANQUIET)
+  #define AMIROOS_CFG_IDLE_STOP_CANQUIET        100000
+#else
+  #define AMIROOS_CFG_IDLE_STOP_CANQUIET        OS_CFG_IDLE_STOP_CANQUIET
+#endif
+
+/** @} */
+
 #endif /* _AOSCONF_H_ */
 
@@ -656,7 +656,8 @@
  * @details This hook is continuously invoked by the idle thread loop.
  */
 #define CH_CFG_IDLE_LOOP_HOOK() {                                           \
-  /* Idle loop code here.*/                                                 \
+  extern void aosIdleLoop(void);                                            \
+  aosIdleLoop();                                                            \
 }
 
 /**
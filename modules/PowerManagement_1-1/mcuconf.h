@@ -71,7 +71,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define STM32_PLLI2SR_VALUE                 5
 #define STM32_PVD_ENABLE                    FALSE
 #define STM32_PLS                           STM32_PLS_LEV0
-#define STM32_BKPRAM_ENABLE                 FALSE
+#define STM32_BKPRAM_ENABLE                 TRUE
 
 /*
  * ADC driver system settings.
@@ -358,5 +358,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define STM32_QEI_USE_TIM4                  FALSE
 #define STM32_QEI_USE_TIM5                  FALSE
 #define STM32_QEI_USE_TIM8                  FALSE
+#define STM32_QEI_TIM1_IRQ_PRIORITY         7
+#define STM32_QEI_TIM2_IRQ_PRIORITY         7
+#define STM32_QEI_TIM3_IRQ_PRIORITY         7
+#define STM32_QEI_TIM4_IRQ_PRIORITY         7
+#define STM32_QEI_TIM5_IRQ_PRIORITY         7
+#define STM32_QEI_TIM8_IRQ_PRIORITY         7
 
 #endif /* _MCUCONF_H_ */
@@ -65,7 +65,7 @@ ADCConversionGroup moduleHalAdcVsysConversionGroup = {
 };
 
 CANConfig moduleHalCanConfig = {
-  /* mcr  */ CAN_MCR_ABOM | CAN_MCR_AWUM | CAN_MCR_TXFP,
+  /* mcr  */ CAN_MCR_ABOM | CAN_MCR_AWUM,
   /* btr  */ CAN_BTR_SJW(1) | CAN_BTR_TS2(3) | CAN_BTR_TS1(15) | CAN_BTR_BRP(1),
 };
 
@@ -379,6 +379,204 @@ apalGpio_t moduleGpioChargeEn2 = {
 const char* moduleShellPrompt = "PowerManagement";
 #endif
 
+/**
+ * @brief   Clock levels.
+ * @details The APB prescalers compensate the AHB prescaler, so all peripheral clocks are identical on each level.
+ *          The clock of the APB1 timers is kept as well, while the APB2 timers (which are not used) run at half speed on
+ *          the slower level.
+ */
+static const aos_clocklevel_t _clockLevels[2] = {
+  /* 168MHz */ {
+    /* CFGR     */ STM32_HPRE | STM32_PPRE1 | STM32_PPRE2,
+    /* HCLK     */ STM32_HCLK,
+    /* TIMCLK1  */ STM32_TIMCLK1,
+    /* TIMCLK2  */ STM32_TIMCLK2,
+  },
+  /* 84MHz */ {
+    /* CFGR     */ STM32_HPRE_DIV2 | STM32_PPRE1_DIV2 | STM32_PPRE2_DIV1,
+    /* HCLK     */ STM32_HCLK / 2,
+    /* TIMCLK1  */ STM32_TIMCLK1,
+    /* TIMCLK2  */ STM32_TIMCLK2 / 2,
+  },
+};
+
+#if (AMIROOS_CFG_IDLE_STOP == true) || defined(__DOXYGEN__)
+/**
+ * @brief   State of the STOP mode hook.
+ */
+static struct {
+  /**
+   * @brief   Duration of a RTC subsecond tick in microseconds (Q16).
+   * @details The frequency of the LSI oscillator, which clocks the RTC, varies considerably, so it is calibrated against
+   *          the uptime while the system is awake.
+   */
+  uint32_t scale;
+
+  /**
+   * @brief   RTC ticks when the system woke up the last time.
+   */
+  uint32_t rtc;
+
+  /**
+   * @brief   Uptime when the system woke up the last time (including the compensated time in STOP mode).
+   */
+  aos_timestamp_t uptime;
+
+  /**
+   * @brief   Accumulated awake time since the last calibration.
+   */
+  struct {
+    /**
+     * @brief   Time in microseconds.
+     */
+    aos_timestamp_t us;
+
+    /**
+     * @brief   Time in RTC ticks.
+     */
+    uint32_t ticks;
+  } calibration;
+} _idleStop;
+
+/**
+ * @brief   Reads the RTC subsecond ticks since midnight.
+ *
+ * @param[in] prediv_s  Number of subsecond ticks per second.
+ *
+ * @return  Ticks since midnight.
+ */
+static uint32_t _idleStopRtcTicks(const uint32_t prediv_s)
+{
+  // reading SSR locks the calendar shadow registers until DR is read
+  const uint32_t ssr = RTC->SSR;
+  const uint32_t tr = RTC->TR;
+  (void)RTC->DR;
+
+  const uint32_t seconds = (((((tr & RTC_TR_HT) >> 20) * 10) + ((tr & RTC_TR_HU) >> 16)) * 3600) +
+                           (((((tr & RTC_TR_MNT) >> 12) * 10) + ((tr & RTC_TR_MNU) >> 8)) * 60) +
+                           ((((tr & RTC_TR_ST) >> 4) * 10) + (tr & RTC_TR_SU));
+  return (seconds * prediv_s) + (prediv_s - 1 - ssr);
+}
+
+/**
+ * @brief   Checks whether any enabled interrupt is pending.
+ *
+ * @return  Flag, whether an interrupt is pending.
+ */
+static bool _idleStopIrqPending(void)
+{
+  for (uint8_t i = 0; i < sizeof(NVIC->ISPR) / sizeof(NVIC->ISPR[0]); ++i) {
+    if (NVIC->ISPR[i] & NVIC->ISER[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief   Enters STOP mode for at most the specified duration.
+ * @details The RTC wakeup timer (EXTI line 22), a falling edge on CAN_RX (EXTI line 11) or any interrupt terminates
+ *          STOP mode.
+ *          CAN frames, which arrive before the clocks were restored, are lost. Any further frame of the burst is received
+ *          again and prevents STOP mode for AMIROOS_CFG_IDLE_STOP_CANQUIET.
+ *          The time spent in STOP mode is measured by the RTC, whose LSI clock is calibrated against the uptime while
+ *          the system is awake.
+ * @note    Must be called with interrupts disabled.
+ *
+ * @param[in] duration  Maximum time to spend in STOP mode in microseconds.
+ *
+ * @return  Time spent in STOP mode in microseconds.
+ */
+aos_interval_t moduleIdleStop(aos_interval_t duration)
+{
+  const uint32_t prediv_a = ((RTC->PRER & RTC_PRER_PREDIV_A) >> 16) + 1;
+  const uint32_t prediv_s = (RTC->PRER & RTC_PRER_PREDIV_S) + 1;
+  const uint32_t day = 24 * 60 * 60 * prediv_s;
+  aos_timestamp_t uptime;
+  uint64_t wut;
+  uint32_t exticr;
+
+  // accumulate the awake time since the last wakeup and calibrate once enough time was accumulated
+  const uint32_t start = _idleStopRtcTicks(prediv_s);
+  aosSysGetUptimeX(&uptime);
+  if (_idleStop.scale == 0) {
+    _idleStop.scale = (uint32_t)(((uint64_t)MICROSECONDS_PER_SECOND << 16) / prediv_s);
+  } else if (uptime > _idleStop.uptime) {
+    _idleStop.calibration.us += uptime - _idleStop.uptime;
+    _idleStop.calibration.ticks += (start + day - _idleStop.rtc) % day;
+    if (_idleStop.calibration.ticks >= prediv_s) {
+      const uint32_t nominal = (uint32_t)(((uint64_t)MICROSECONDS_PER_SECOND << 16) / prediv_s);
+      const uint32_t scale = (uint32_t)(((uint64_t)_idleStop.calibration.us << 16) / _idleStop.calibration.ticks);
+      // implausible samples (e.g. after the RTC was set) are ignored
+      if (scale > nominal / 2 && scale < nominal * 2) {
+        _idleStop.scale = _idleStop.scale - (_idleStop.scale / 4) + (scale / 4);
+      }
+      _idleStop.calibration.us = 0;
+      _idleStop.calibration.ticks = 0;
+    }
+  }
+
+  // the wakeup timer is clocked with RTCCLK/16
+  wut = ((uint64_t)duration << 16) / (((uint64_t)_idleStop.scale * 16) / prediv_a);
+  wut = (wut < 1) ? 1 : (wut > (RTC_WUTR_WUT + 1)) ? (RTC_WUTR_WUT + 1) : wut;
+  RTC->WPR = 0xCA;
+  RTC->WPR = 0x53;
+  RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+  while ((RTC->ISR & RTC_ISR_WUTWF) == 0) {
+    continue;
+  }
+  RTC->WUTR = (uint32_t)wut - 1;
+  RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUTIE | RTC_CR_WUTE;
+  RTC->WPR = 0xFF;
+  EXTI->PR = EXTI_PR_PR22;
+  EXTI->RTSR |= EXTI_RTSR_TR22;
+  EXTI->EMR |= EXTI_EMR_MR22;
+  // the start of frame bit of any CAN traffic is a falling edge on CAN_RX (port A)
+  exticr = SYSCFG->EXTICR[GPIOA_CAN_RX / 4];
+  SYSCFG->EXTICR[GPIOA_CAN_RX / 4] = exticr & ~(0x0FU << ((GPIOA_CAN_RX % 4) * 4));
+  EXTI->PR = (1U << GPIOA_CAN_RX);
+  EXTI->FTSR |= (1U << GPIOA_CAN_RX);
+  EXTI->EMR |= (1U << GPIOA_CAN_RX);
+
+  // enter STOP mode with the regulator in low-power mode
+  PWR->CR = (PWR->CR & ~PWR_CR_PDDS) | PWR_CR_LPDS | PWR_CR_CWUF;
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk | SCB_SCR_SEVONPEND_Msk;
+  // clear the event register, so WFE returns on the wakeup event or a new interrupt only
+  __SEV();
+  __WFE();
+  if (!_idleStopIrqPending()) {
+    __WFE();
+  }
+  SCB->SCR &= ~(SCB_SCR_SLEEPDEEP_Msk | SCB_SCR_SEVONPEND_Msk);
+
+  // the system runs from HSI after STOP mode
+  stm32_clock_init();
+  aosClockReapplyX();
+
+  // disable the wakeup timer and resynchronize the calendar shadow registers
+  RTC->WPR = 0xCA;
+  RTC->WPR = 0x53;
+  RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+  RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_RSF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+  RTC->WPR = 0xFF;
+  EXTI->EMR &= ~(EXTI_EMR_MR22 | (1U << GPIOA_CAN_RX));
+  EXTI->FTSR &= ~(1U << GPIOA_CAN_RX);
+  EXTI->PR = EXTI_PR_PR22 | (1U << GPIOA_CAN_RX);
+  SYSCFG->EXTICR[GPIOA_CAN_RX / 4] = exticr;
+  while ((RTC->ISR & RTC_ISR_RSF) == 0) {
+    continue;
+  }
+
+  _idleStop.rtc = _idleStopRtcTicks(prediv_s);
+  duration = (aos_interval_t)(((uint64_t)((_idleStop.rtc + day - start) % day) * _idleStop.scale) >> 16);
+  // the uptime will be compensated by the time spent in STOP mode
+  aosSysGetUptimeX(&uptime);
+  _idleStop.uptime = uptime + duration;
+
+  return duration;
+}
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -597,6 +795,717 @@ VCNL4020Driver moduleLldProximity2 = {
 
 /** @} */
 
+/*===========================================================================*/
+/**
+ * @name Snapshots
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   Reads all registers of an INA219 power monitor in a single transaction.
+ *
+ * @param[out] dst      Pointer to a module_ina219snapshot_t object.
+ * @param[in]  ina219   Pointer to the INA219 driver.
+ *
+ * @return  The status of the bus transaction.
+ */
+static apalExitStatus_t _snapshotIna219ReadCb(void* dst, void* ina219)
+{
+  return ina219_lld_read_register((INA219Driver*)ina219, INA219_LLD_REGISTER_CONFIGURATION, ((module_ina219snapshot_t*)dst)->registers, sizeof(((module_ina219snapshot_t*)dst)->registers) / sizeof(uint16_t), MODULE_SNAPSHOT_I2C_TIMEOUT);
+}
+
+/**
+ * @brief   Reads the frequently accessed standard commands of a BQ27500 fuel gauge in a single transaction.
+ *
+ * @param[out] dst      Pointer to a svc_battery_registers_t object.
+ * @param[in]  bq27500  Pointer to the BQ27500 driver.
+ *
+ * @return  The status of the bus transaction.
+ */
+static apalExitStatus_t _snapshotBq27500ReadCb(void* dst, void* bq27500)
+{
+  return svcBatteryReadRegisters((BQ27500Driver*)bq27500, (svc_battery_registers_t*)dst, MODULE_SNAPSHOT_I2C_TIMEOUT);
+}
+
+static module_ina219snapshot_t _snapshotPowerMonitorVddData;
+static module_ina219snapshot_t _snapshotPowerMonitorVio18Data;
+static module_ina219snapshot_t _snapshotPowerMonitorVio33Data;
+static module_ina219snapshot_t _snapshotPowerMonitorVsys42Data;
+static module_ina219snapshot_t _snapshotPowerMonitorVio50Data;
+static svc_battery_registers_t _snapshotFuelGaugeFrontData;
+static svc_battery_registers_t _snapshotFuelGaugeRearData;
+
+aos_snapshot_t moduleSnapshotPowerMonitorVdd;
+aos_snapshot_t moduleSnapshotPowerMonitorVio18;
+aos_snapshot_t moduleSnapshotPowerMonitorVio33;
+aos_snapshot_t moduleSnapshotPowerMonitorVsys42;
+aos_snapshot_t moduleSnapshotPowerMonitorVio50;
+aos_snapshot_t moduleSnapshotFuelGaugeFront;
+aos_snapshot_t moduleSnapshotFuelGaugeRear;
+
+/**
+ * @brief   Initializes and registers all snapshots.
+ */
+void moduleSnapshotsInit(void)
+{
+  aosSnapshotInit(&moduleSnapshotPowerMonitorVdd, "PowerMonitorVDD", _snapshotIna219ReadCb, &moduleLldPowerMonitorVdd, &_snapshotPowerMonitorVddData, sizeof(module_ina219snapshot_t), MODULE_SNAPSHOT_INA219_MININTERVAL, MODULE_SNAPSHOT_INA219_REFRESH);
+  aosSnapshotInit(&moduleSnapshotPowerMonitorVio18, "PowerMonitorVIO18", _snapshotIna219ReadCb, &moduleLldPowerMonitorVio18, &_snapshotPowerMonitorVio18Data, sizeof(module_ina219snapshot_t), MODULE_SNAPSHOT_INA219_MININTERVAL, MODULE_SNAPSHOT_INA219_REFRESH);
+  aosSnapshotInit(&moduleSnapshotPowerMonitorVio33, "PowerMonitorVIO33", _snapshotIna219ReadCb, &moduleLldPowerMonitorVio33, &_snapshotPowerMonitorVio33Data, sizeof(module_ina219snapshot_t), MODULE_SNAPSHOT_INA219_MININTERVAL, MODULE_SNAPSHOT_INA219_REFRESH);
+  aosSnapshotInit(&moduleSnapshotPowerMonitorVsys42, "PowerMonitorVSYS42", _snapshotIna219ReadCb, &moduleLldPowerMonitorVsys42, &_snapshotPowerMonitorVsys42Data, sizeof(module_ina219snapshot_t), MODULE_SNAPSHOT_INA219_MININTERVAL, MODULE_SNAPSHOT_INA219_REFRESH);
+  aosSnapshotInit(&moduleSnapshotPowerMonitorVio50, "PowerMonitorVIO50", _snapshotIna219ReadCb, &moduleLldPowerMonitorVio50, &_snapshotPowerMonitorVio50Data, sizeof(module_ina219snapshot_t), MODULE_SNAPSHOT_INA219_MININTERVAL, MODULE_SNAPSHOT_INA219_REFRESH);
+  aosSnapshotInit(&moduleSnapshotFuelGaugeFront, "FuelGaugeFront", _snapshotBq27500ReadCb, &moduleLldFuelGaugeFront, &_snapshotFuelGaugeFrontData, sizeof(svc_battery_registers_t), MODULE_SNAPSHOT_BQ27500_MININTERVAL, MODULE_SNAPSHOT_BQ27500_REFRESH);
+  aosSnapshotInit(&moduleSnapshotFuelGaugeRear, "FuelGaugeRear", _snapshotBq27500ReadCb, &moduleLldFuelGaugeRear, &_snapshotFuelGaugeRearData, sizeof(svc_battery_registers_t), MODULE_SNAPSHOT_BQ27500_MININTERVAL, MODULE_SNAPSHOT_BQ27500_REFRESH);
+
+  aosSnapshotRegister(&moduleSnapshotPowerMonitorVdd);
+  aosSnapshotRegister(&moduleSnapshotPowerMonitorVio18);
+  aosSnapshotRegister(&moduleSnapshotPowerMonitorVio33);
+  aosSnapshotRegister(&moduleSnapshotPowerMonitorVsys42);
+  aosSnapshotRegister(&moduleSnapshotPowerMonitorVio50);
+  aosSnapshotRegister(&moduleSnapshotFuelGaugeFront);
+  aosSnapshotRegister(&moduleSnapshotFuelGaugeRear);
+
+  return;
+}
+
+/** @} */
+
+/*===========================================================================*/
+/**
+ * @name Services
+ * @{
+ */
+/*===========================================================================*/
+
+/**
+ * @brief   EEPROM flush thread working area.
+ */
+static THD_WORKING_AREA(_svcEepromWa, MODULE_SVC_EEPROM_STACKSIZE);
+
+/**
+ * @brief   EEPROM cache configuration.
+ */
+static const svc_eeprom_config_t _svcEepromConfig = {
+  /* driver   */ &moduleLldEeprom,
+  /* timeout  */ MICROSECONDS_PER_SECOND,
+  /* delay    */ MODULE_SVC_EEPROM_DELAY,
+};
+
+svc_eeprom_t moduleSvcEeprom;
+
+/**
+ * @brief   Persistent settings configuration.
+ */
+static const svc_settings_config_t _svcSettingsConfig = {
+  /* EEPROM   */ &moduleSvcEeprom,
+  /* address  */ MODULE_SVC_SETTINGS_ADDRESS,
+  /* size     */ MODULE_SVC_SETTINGS_SIZE,
+};
+
+svc_settings_t moduleSvcSettings;
+
+/**
+ * @brief   CAN transmit thread working area.
+ */
+static THD_WORKING_AREA(_svcCanTxWa, MODULE_SVC_CANTX_STACKSIZE);
+
+/**
+ * @brief   Queue of control frames.
+ */
+static svc_cantx_entry_t _svcCanTxControlQueue[MODULE_SVC_CANTX_CONTROLQUEUE];
+
+/**
+ * @brief   Queue of data frames.
+ */
+static svc_cantx_entry_t _svcCanTxDataQueue[MODULE_SVC_CANTX_DATAQUEUE];
+
+/**
+ * @brief   Queue of bulk frames.
+ */
+static svc_cantx_entry_t _svcCanTxBulkQueue[MODULE_SVC_CANTX_BULKQUEUE];
+
+/**
+ * @brief   CAN transmit scheduler configuration.
+ */
+static const svc_cantx_config_t _svcCanTxConfig = {
+  /* driver  */ &MODULE_HAL_CAN,
+  /* classes */ {
+    /* control */ {
+      /* entries  */ _svcCanTxControlQueue,
+      /* size     */ MODULE_SVC_CANTX_CONTROLQUEUE,
+      /* lifetime */ 0,
+    },
+    /* data    */ {
+      /* entries  */ _svcCanTxDataQueue,
+      /* size     */ MODULE_SVC_CANTX_DATAQUEUE,
+      /* lifetime */ 0,
+    },
+    /* bulk    */ {
+      /* entries  */ _svcCanTxBulkQueue,
+      /* size     */ MODULE_SVC_CANTX_BULKQUEUE,
+      /* lifetime */ MODULE_SVC_CANTX_BULKLIFETIME,
+    },
+  },
+};
+
+svc_cantx_t moduleSvcCanTx;
+
+/**
+ * @brief   CAN bus thread working area.
+ */
+static THD_WORKING_AREA(_svcCanBusWa, MODULE_SVC_CANBUS_STACKSIZE);
+
+/**
+ * @brief   Message pool of the CAN bus service.
+ */
+static svc_canbus_message_t _svcCanBusMessages[MODULE_SVC_CANBUS_POOLSIZE];
+
+/**
+ * @brief   CAN bus service configuration.
+ */
+static const svc_canbus_config_t _svcCanBusConfig = {
+  /* driver    */ &MODULE_HAL_CAN,
+  /* scheduler */ &moduleSvcCanTx,
+  /* messages  */ _svcCanBusMessages,
+  /* number    */ MODULE_SVC_CANBUS_POOLSIZE,
+};
+
+svc_canbus_t moduleSvcCanBus;
+
+/**
+ * @brief   Time synchronization thread working area.
+ */
+static THD_WORKING_AREA(_svcTimeSyncWa, MODULE_SVC_TIMESYNC_STACKSIZE);
+
+/**
+ * @brief   Time synchronization service configuration.
+ */
+static const svc_timesync_config_t _svcTimeSyncConfig = {
+  /* bus        */ &moduleSvcCanBus,
+  /* sync flags */ MODULE_SSSP_EVENTFLAGS_SYNC,
+};
+
+svc_timesync_t moduleSvcTimeSync;
+
+/**
+ * @brief   Battery thread working area.
+ */
+static THD_WORKING_AREA(_svcBatteryWa, MODULE_SVC_BATTERY_STACKSIZE);
+
+/**
+ * @brief   Battery packs monitored by the battery service.
+ */
+static svc_battery_pack_t _svcBatteryPacks[] = {
+  {
+    /* name         */ "front",
+    /* snapshot     */ &moduleSnapshotFuelGaugeFront,
+  },
+  {
+    /* name         */ "rear",
+    /* snapshot     */ &moduleSnapshotFuelGaugeRear,
+  },
+};
+
+/**
+ * @brief   Battery service configuration.
+ */
+static const svc_battery_config_t _svcBatteryConfig = {
+  /* packs            */ _svcBatteryPacks,
+  /* number           */ sizeof(_svcBatteryPacks) / sizeof(_svcBatteryPacks[0]),
+  /* period           */ MODULE_SVC_BATTERY_PERIOD,
+  /* tau              */ MODULE_SVC_BATTERY_TAU,
+  /* event source     */ &aos.events.io,
+  /* event flags      */ {
+    /* low      */ MODULE_OS_IOEVENTFLAGS_BATTERYLOW,
+    /* critical */ MODULE_OS_IOEVENTFLAGS_BATTERYCRITICAL,
+    /* normal   */ MODULE_OS_IOEVENTFLAGS_BATTERYNORMAL,
+  },
+  /* thresholds       */ {
+    /* low        */ MODULE_SVC_BATTERY_LOWTHRESHOLD,
+    /* critical   */ MODULE_SVC_BATTERY_CRITICALTHRESHOLD,
+    /* hysteresis */ MODULE_SVC_BATTERY_HYSTERESIS,
+  },
+};
+
+svc_battery_t moduleSvcBattery;
+
+/**
+ * @brief   Power monitor thread working area.
+ */
+static THD_WORKING_AREA(_svcPowerMonitorWa, MODULE_SVC_POWERMONITOR_STACKSIZE);
+
+/**
+ * @brief   Power rails monitored by the power monitor service.
+ * @details The shunt resistance of 0.1 Ohm is taken from the INA219 unit test (ut_alld_ina219.c), the only reference
+ *          in this repository. It is assumed for all rails, since the schematic is not available here.
+ *          The maximum currents are estimates based on the consumers of each rail, not values from the schematic. They
+ *          are only passed to the calibration of the INA219 driver. The resolution does not depend on them, since
+ *          svcPowerMonitorConfigure() applies the fixed current LSB SVC_POWERMONITOR_CURRENT_LSB_UA (100 uA) to every
+ *          rail. The measurable current is limited by the shunt voltage range of 320 mV (3.2 A at 0.1 Ohm).
+ * @note    These values must be verified against the PowerManagement v1.1 schematic.
+ */
+static svc_powermonitor_rail_t _svcPowerMonitorRails[] = {
+  {
+    /* name         */ "VDD",
+    /* driver       */ &moduleLldPowerMonitorVdd,
+    /* snapshot     */ &moduleSnapshotPowerMonitorVdd,
+    /* shunt        */ 0.1f,
+    /* max current  */ 0.5f,
+  },
+  {
+    /* name         */ "VIO1.8",
+    /* driver       */ &moduleLldPowerMonitorVio18,
+    /* snapshot     */ &moduleSnapshotPowerMonitorVio18,
+    /* shunt        */ 0.1f,
+    /* max current  */ 0.5f,
+  },
+  {
+    /* name         */ "VIO3.3",
+    /* driver       */ &moduleLldPowerMonitorVio33,
+    /* snapshot     */ &moduleSnapshotPowerMonitorVio33,
+    /* shunt        */ 0.1f,
+    /* max current  */ 0.5f,
+  },
+  {
+    /* name         */ "VSYS4.2",
+    /* driver       */ &moduleLldPowerMonitorVsys42,
+    /* snapshot     */ &moduleSnapshotPowerMonitorVsys42,
+    /* shunt        */ 0.1f,
+    /* max current  */ 3.0f,
+  },
+  {
+    /* name         */ "VIO5.0",
+    /* driver       */ &moduleLldPowerMonitorVio50,
+    /* snapshot     */ &moduleSnapshotPowerMonitorVio50,
+    /* shunt        */ 0.1f,
+    /* max current  */ 1.0f,
+  },
+};
+
+svc_powermonitor_t moduleSvcPowerMonitor;
+
+/**
+ * @brief   Proximity (I2C 1) thread working area.
+ */
+static THD_WORKING_AREA(_svcProximity1Wa, MODULE_SVC_PROXIMITY_STACKSIZE);
+
+/**
+ * @brief   Proximity (I2C 2) thread working area.
+ */
+static THD_WORKING_AREA(_svcProximity2Wa, MODULE_SVC_PROXIMITY_STACKSIZE);
+
+/**
+ * @brief   Proximity sensors behind the I2C 1 multiplexer.
+ */
+static const svc_proximity_sensor_t _svcProximity1Sensors[] = {
+  {
+    /* name     */ "SSE",
+    /* channel  */ PCA9544A_LLD_CH0,
+  },
+  {
+    /* name     */ "SSW",
+    /* channel  */ PCA9544A_LLD_CH1,
+  },
+  {
+    /* name     */ "WNW",
+    /* channel  */ PCA9544A_LLD_CH2,
+  },
+  {
+    /* name     */ "WSW",
+    /* channel  */ PCA9544A_LLD_CH3,
+  },
+};
+
+/**
+ * @brief   Proximity sensors behind the I2C 2 multiplexer.
+ */
+static const svc_proximity_sensor_t _svcProximity2Sensors[] = {
+  {
+    /* name     */ "NNW",
+    /* channel  */ PCA9544A_LLD_CH0,
+  },
+  {
+    /* name     */ "NNE",
+    /* channel  */ PCA9544A_LLD_CH1,
+  },
+  {
+    /* name     */ "ESE",
+    /* channel  */ PCA9544A_LLD_CH2,
+  },
+  {
+    /* name     */ "ENE",
+    /* channel  */ PCA9544A_LLD_CH3,
+  },
+};
+
+/**
+ * @brief   Proximity service configuration (I2C 1).
+ */
+static const svc_proximity_config_t _svcProximity1Config = {
+  /* multiplexer      */ &moduleLldI2cMultiplexer1,
+  /* driver           */ &moduleLldProximity1,
+  /* sensors          */ _svcProximity1Sensors,
+  /* number           */ sizeof(_svcProximity1Sensors) / sizeof(_svcProximity1Sensors[0]),
+  /* int driver       */ &moduleIntDriver,
+  /* int channel      */ MODULE_GPIO_INT_IRINT2,
+  /* event source     */ &aos.events.io,
+  /* event flags      */ MODULE_OS_IOEVENTFLAGS_IRINT2,
+  /* rate             */ MODULE_SVC_PROXIMITY_RATE,
+  /* ambient factor   */ MODULE_SVC_PROXIMITY_AMBIENTFACTOR,
+  /* watchdog         */ MODULE_SVC_PROXIMITY_WATCHDOG,
+  /* timeout          */ MODULE_SNAPSHOT_I2C_TIMEOUT,
+};
+
+/**
+ * @brief   Proximity service configuration (I2C 2).
+ */
+static const svc_proximity_config_t _svcProximity2Config = {
+  /* multiplexer      */ &moduleLldI2cMultiplexer2,
+  /* driver           */ &moduleLldProximity2,
+  /* sensors          */ _svcProximity2Sensors,
+  /* number           */ sizeof(_svcProximity2Sensors) / sizeof(_svcProximity2Sensors[0]),
+  /* int driver       */ &moduleIntDriver,
+  /* int channel      */ MODULE_GPIO_INT_IRINT1,
+  /* event source     */ &aos.events.io,
+  /* event flags      */ MODULE_OS_IOEVENTFLAGS_IRINT1,
+  /* rate             */ MODULE_SVC_PROXIMITY_RATE,
+  /* ambient factor   */ MODULE_SVC_PROXIMITY_AMBIENTFACTOR,
+  /* watchdog         */ MODULE_SVC_PROXIMITY_WATCHDOG,
+  /* timeout          */ MODULE_SNAPSHOT_I2C_TIMEOUT,
+};
+
+svc_proximity_t moduleSvcProximity1;
+
+svc_proximity_t moduleSvcProximity2;
+
+/**
+ * @brief   Circular DMA buffer for VSYS sampling.
+ */
+static adcsample_t _svcVsysBuffer[MODULE_SVC_VSYS_BUFFERDEPTH];
+
+svc_vsys_t moduleSvcVsys;
+
+/**
+ * @brief   CPU frequency governor thread working area.
+ */
+static THD_WORKING_AREA(_svcCpuFreqWa, MODULE_SVC_CPUFREQ_STACKSIZE);
+
+/**
+ * @brief   CPU frequency governor configuration.
+ */
+static const svc_cpufreq_config_t _svcCpuFreqConfig = {
+  /* period */ MODULE_SVC_CPUFREQ_PERIOD,
+  /* up     */ MODULE_SVC_CPUFREQ_UP,
+  /* down   */ MODULE_SVC_CPUFREQ_DOWN,
+};
+
+svc_cpufreq_t moduleSvcCpuFreq;
+
+#if (AMIROOS_CFG_SHELL_ENABLE == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Callback function for the module:eeprom shell command.
+ */
+static int _svcShellCmdCb_Eeprom(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcEepromShellCmd(&moduleSvcEeprom, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the EEPROM cache.
+ */
+static aos_shellcommand_t _svcShellCmdEeprom = {
+  /* name     */ "module:eeprom",
+  /* callback */ _svcShellCmdCb_Eeprom,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:settings shell command.
+ */
+static int _svcShellCmdCb_Settings(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcSettingsShellCmd(&moduleSvcSettings, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the persistent settings.
+ */
+static aos_shellcommand_t _svcShellCmdSettings = {
+  /* name     */ "module:settings",
+  /* callback */ _svcShellCmdCb_Settings,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:canbus shell command.
+ */
+static int _svcShellCmdCb_CanBus(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcCanBusShellCmd(&moduleSvcCanBus, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the CAN publish/subscribe service.
+ */
+static aos_shellcommand_t _svcShellCmdCanBus = {
+  /* name     */ "module:canbus",
+  /* callback */ _svcShellCmdCb_CanBus,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:cantx shell command.
+ */
+static int _svcShellCmdCb_CanTx(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcCanTxShellCmd(&moduleSvcCanTx, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the CAN transmit scheduler.
+ */
+static aos_shellcommand_t _svcShellCmdCanTx = {
+  /* name     */ "module:cantx",
+  /* callback */ _svcShellCmdCb_CanTx,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:timesync shell command.
+ */
+static int _svcShellCmdCb_TimeSync(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcTimeSyncShellCmd(&moduleSvcTimeSync, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the time synchronization.
+ */
+static aos_shellcommand_t _svcShellCmdTimeSync = {
+  /* name     */ "module:timesync",
+  /* callback */ _svcShellCmdCb_TimeSync,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:battery shell command.
+ */
+static int _svcShellCmdCb_Battery(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcBatteryShellCmd(&moduleSvcBattery, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to print the battery state.
+ */
+static aos_shellcommand_t _svcShellCmdBattery = {
+  /* name     */ "module:battery",
+  /* callback */ _svcShellCmdCb_Battery,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:power shell command.
+ */
+static int _svcShellCmdCb_PowerMonitor(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcPowerMonitorShellCmd(&moduleSvcPowerMonitor, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to print power monitor data.
+ */
+static aos_shellcommand_t _svcShellCmdPowerMonitor = {
+  /* name     */ "module:power",
+  /* callback */ _svcShellCmdCb_PowerMonitor,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:proximity shell command.
+ */
+static int _svcShellCmdCb_Proximity(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  const int retval = svcProximityShellCmd(&moduleSvcProximity1, stream, argc, argv);
+  // print the help text only once
+  return (argc > 1) ? retval : svcProximityShellCmd(&moduleSvcProximity2, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to print the proximity readings.
+ */
+static aos_shellcommand_t _svcShellCmdProximity = {
+  /* name     */ "module:proximity",
+  /* callback */ _svcShellCmdCb_Proximity,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:vsys shell command.
+ */
+static int _svcShellCmdCb_Vsys(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcVsysShellCmd(&moduleSvcVsys, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to print the system voltage.
+ */
+static aos_shellcommand_t _svcShellCmdVsys = {
+  /* name     */ "module:vsys",
+  /* callback */ _svcShellCmdCb_Vsys,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Callback function for the module:cpufreq shell command.
+ */
+static int _svcShellCmdCb_CpuFreq(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  return svcCpuFreqShellCmd(&moduleSvcCpuFreq, stream, argc, argv);
+}
+
+/**
+ * @brief   Shell command to inspect the CPU frequency governor.
+ */
+static aos_shellcommand_t _svcShellCmdCpuFreq = {
+  /* name     */ "module:cpufreq",
+  /* callback */ _svcShellCmdCb_CpuFreq,
+  /* next     */ NULL,
+};
+#endif
+
+/**
+ * @brief   Initializes all services.
+ */
+void moduleServicesInit(void)
+{
+  svcEepromInit(&moduleSvcEeprom, &_svcEepromConfig);
+  svcSettingsInit(&moduleSvcSettings, &_svcSettingsConfig);
+  svcCanTxInit(&moduleSvcCanTx, &_svcCanTxConfig);
+  svcCanBusInit(&moduleSvcCanBus, &_svcCanBusConfig);
+  svcTimeSyncInit(&moduleSvcTimeSync, &_svcTimeSyncConfig);
+  svcBatteryInit(&moduleSvcBattery, &_svcBatteryConfig);
+  svcPowerMonitorInit(&moduleSvcPowerMonitor, _svcPowerMonitorRails, sizeof(_svcPowerMonitorRails) / sizeof(_svcPowerMonitorRails[0]), MODULE_SVC_POWERMONITOR_INTERVAL, MODULE_SVC_POWERMONITOR_WINDOW, MODULE_SNAPSHOT_I2C_TIMEOUT);
+  svcVsysInit(&moduleSvcVsys, &MODULE_HAL_ADC_VSYS, &moduleHalAdcVsysConversionGroup, _svcVsysBuffer, MODULE_SVC_VSYS_BUFFERDEPTH, MODULE_SVC_VSYS_SCALE);
+  svcProximityInit(&moduleSvcProximity1, &_svcProximity1Config);
+  svcProximityInit(&moduleSvcProximity2, &_svcProximity2Config);
+  aosClockInit(_clockLevels, sizeof(_clockLevels) / sizeof(_clockLevels[0]));
+  svcCpuFreqInit(&moduleSvcCpuFreq, &_svcCpuFreqConfig);
+#if (AMIROOS_CFG_SHELL_ENABLE == true)
+  aosShellAddCommand(&aos.shell, &_svcShellCmdEeprom);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdSettings);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdCanBus);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdCanTx);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdTimeSync);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdBattery);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdPowerMonitor);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdProximity);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdVsys);
+  aosShellAddCommand(&aos.shell, &_svcShellCmdCpuFreq);
+#endif
+
+  return;
+}
+
+/**
+ * @brief   Starts all services.
+ */
+void moduleServicesStart(void)
+{
+  // the cache is loaded synchronously, so services can read the EEPROM right away
+  svcEepromStart(&moduleSvcEeprom, _svcEepromWa, sizeof(_svcEepromWa), AOS_THD_NORMALPRIO_MIN);
+  svcSettingsStart(&moduleSvcSettings);
+  // the transmit thread refills the mailboxes as soon as they are empty, so it preempts all transmitting threads
+  svcCanTxStart(&moduleSvcCanTx, _svcCanTxWa, sizeof(_svcCanTxWa), AOS_THD_RTPRIO_MIN);
+  // the receive FIFOs hold three frames each, so they must be drained with high priority
+  svcCanBusStart(&moduleSvcCanBus, _svcCanBusWa, sizeof(_svcCanBusWa), AOS_THD_HIGHPRIO_MIN);
+  svcTimeSyncStart(&moduleSvcTimeSync, _svcTimeSyncWa, sizeof(_svcTimeSyncWa), AOS_THD_HIGHPRIO_MAX);
+  if (svcPowerMonitorConfigure(&moduleSvcPowerMonitor) != APAL_STATUS_SUCCESS) {
+    aosprintf("WARNING: power monitor configuration failed\n");
+  }
+  svcPowerMonitorStart(&moduleSvcPowerMonitor, _svcPowerMonitorWa, sizeof(_svcPowerMonitorWa), AOS_THD_LOWPRIO_MAX);
+  svcBatteryStart(&moduleSvcBattery, _svcBatteryWa, sizeof(_svcBatteryWa), AOS_THD_LOWPRIO_MAX);
+  svcVsysSetThresholds(&moduleSvcVsys, MODULE_SVC_VSYS_LOWTHRESHOLD, MODULE_SVC_VSYS_HIGHTHRESHOLD, MODULE_SVC_VSYS_HYSTERESIS);
+  svcVsysStart(&moduleSvcVsys);
+  svcProximityStart(&moduleSvcProximity1, _svcProximity1Wa, sizeof(_svcProximity1Wa), AOS_THD_NORMALPRIO_MIN);
+  svcProximityStart(&moduleSvcProximity2, _svcProximity2Wa, sizeof(_svcProximity2Wa), AOS_THD_NORMALPRIO_MIN);
+  // started last, so all services are initialized at full speed
+  svcCpuFreqStart(&moduleSvcCpuFreq, _svcCpuFreqWa, sizeof(_svcCpuFreqWa), AOS_THD_HIGHPRIO_MIN);
+
+  return;
+}
+
+/**
+ * @brief   Teardown tasks of all services and periphery communication interfaces.
+ */
+static struct {
+  aos_teardown_t eeprom;        /**< The eeprom service.                                                        */
+  aos_teardown_t settings;      /**< The settings service.                                                      */
+  aos_teardown_t cantx;         /**< The cantx service.                                                         */
+  aos_teardown_t canbus;        /**< The canbus service.                                                        */
+  aos_teardown_t timesync;      /**< The timesync service.                                                      */
+  aos_teardown_t powermonitor;  /**< The powermonitor service.                                                  */
+  aos_teardown_t battery;       /**< The battery service.                                                       */
+  aos_teardown_t vsys;          /**< The vsys service.                                                          */
+  aos_teardown_t proximity1;    /**< The proximity1 service.                                                    */
+  aos_teardown_t proximity2;    /**< The proximity2 service.                                                    */
+  aos_teardown_t cpufreq;       /**< The cpufreq service.                                                       */
+  aos_teardown_t pwmbuzzer;     /**< The @p MODULE_HAL_PWM_BUZZER driver.                                       */
+  aos_teardown_t adcvsys;       /**< The @p MODULE_HAL_ADC_VSYS driver.                                         */
+  aos_teardown_t i2crear;       /**< The @p MODULE_HAL_I2C_PROX_PM18_PM33_GAUGEREAR driver.                     */
+  aos_teardown_t i2cfront;      /**< The @p MODULE_HAL_I2C_PROX_PM42_PM50_PMVDD_EEPROM_TOUCH_GAUGEFRONT driver. */
+} _teardown;
+
+/**
+ * @brief   Registers the teardown tasks of all services and periphery communication interfaces.
+ * @details Services, which access other services, are stopped before them.
+ *          Independent tasks are executed concurrently on shutdown.
+ */
+void moduleTeardownInit(void)
+{
+  // services
+  aosTeardownInit(&_teardown.eeprom, "eeprom", svcEepromTeardown, &moduleSvcEeprom, AOS_TEARDOWN_SERVICES, 10 * MICROSECONDS_PER_MILLISECOND);
+  aosTeardownRegister(&_teardown.eeprom);
+  aosTeardownInit(&_teardown.settings, "settings", svcSettingsTeardown, &moduleSvcSettings, AOS_TEARDOWN_SERVICES, MICROSECONDS_PER_MILLISECOND);
+  aosTeardownRegister(&_teardown.settings);
+  aosTeardownInit(&_teardown.cantx, "cantx", svcCanTxTeardown, &moduleSvcCanTx, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.cantx);
+  aosTeardownInit(&_teardown.canbus, "canbus", svcCanBusTeardown, &moduleSvcCanBus, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.canbus);
+  aosTeardownInit(&_teardown.timesync, "timesync", svcTimeSyncTeardown, &moduleSvcTimeSync, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.timesync);
+  aosTeardownInit(&_teardown.powermonitor, "powermonitor", svcPowerMonitorTeardown, &moduleSvcPowerMonitor, AOS_TEARDOWN_SERVICES, MODULE_SVC_POWERMONITOR_INTERVAL);
+  aosTeardownRegister(&_teardown.powermonitor);
+  aosTeardownInit(&_teardown.battery, "battery", svcBatteryTeardown, &moduleSvcBattery, AOS_TEARDOWN_SERVICES, MODULE_SVC_BATTERY_PERIOD);
+  aosTeardownRegister(&_teardown.battery);
+  aosTeardownInit(&_teardown.vsys, "vsys", svcVsysTeardown, &moduleSvcVsys, AOS_TEARDOWN_SERVICES, 100);
+  aosTeardownRegister(&_teardown.vsys);
+  aosTeardownInit(&_teardown.proximity1, "proximity1", svcProximityTeardown, &moduleSvcProximity1, AOS_TEARDOWN_SERVICES, MODULE_SVC_PROXIMITY_WATCHDOG);
+  aosTeardownRegister(&_teardown.proximity1);
+  aosTeardownInit(&_teardown.proximity2, "proximity2", svcProximityTeardown, &moduleSvcProximity2, AOS_TEARDOWN_SERVICES, MODULE_SVC_PROXIMITY_WATCHDOG);
+  aosTeardownRegister(&_teardown.proximity2);
+  aosTeardownInit(&_teardown.cpufreq, "cpufreq", svcCpuFreqTeardown, &moduleSvcCpuFreq, AOS_TEARDOWN_SERVICES, MODULE_SVC_CPUFREQ_PERIOD);
+  aosTeardownRegister(&_teardown.cpufreq);
+  aosTeardownDepends(&_teardown.eeprom, &_teardown.settings);
+  aosTeardownDepends(&_teardown.canbus, &_teardown.timesync);
+  aosTeardownDepends(&_teardown.cantx, &_teardown.canbus);
+  // periphery communication interfaces
+  aosTeardownInit(&_teardown.pwmbuzzer, "buzzer", aosTeardownPwm, &MODULE_HAL_PWM_BUZZER, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.pwmbuzzer);
+  aosTeardownInit(&_teardown.adcvsys, "adc", aosTeardownAdc, &MODULE_HAL_ADC_VSYS, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.adcvsys);
+  aosTeardownInit(&_teardown.i2crear, "i2c rear", aosTeardownI2c, &MODULE_HAL_I2C_PROX_PM18_PM33_GAUGEREAR, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.i2crear);
+  aosTeardownInit(&_teardown.i2cfront, "i2c front", aosTeardownI2c, &MODULE_HAL_I2C_PROX_PM42_PM50_PMVDD_EEPROM_TOUCH_GAUGEFRONT, AOS_TEARDOWN_PERIPHERY, 10);
+  aosTeardownRegister(&_teardown.i2cfront);
+  // don't stop the serial driver so messages can still be printed
+
+  return;
+}
+
+/** @} */
+
 /*===========================================================================*/
 /**
  * @name Unit tests (UT)
@@ -611,7 +1520,10 @@ static int _utShellCmdCb_Adc(BaseSequentialStream* stream, int argc, char* argv[
 {
   (void)argc;
   (void)argv;
+  // the test needs exclusive access to the ADC
+  svcVsysStop(&moduleSvcVsys);
   aosUtRun(stream, &moduleUtAdcVsys, NULL);
+  svcVsysStart(&moduleSvcVsys);
   return AOS_OK;
 }
 static ut_adcdata_t _utAdcVsysData = {
@@ -635,7 +1547,13 @@ static int _utShellCmdCb_AlldAt24c01bn(BaseSequentialStream* stream, int argc, c
 {
   (void)argc;
   (void)argv;
+  // the test accesses the device directly, so the cache is flushed before and reloaded afterwards
+  const bool cache = (moduleSvcEeprom.thread != NULL);
+  svcEepromStop(&moduleSvcEeprom);
   aosUtRun(stream, &moduleUtAlldAt24c01bn, NULL);
+  if (cache) {
+    svcEepromStart(&moduleSvcEeprom, _svcEepromWa, sizeof(_svcEepromWa), AOS_THD_NORMALPRIO_MIN);
+  }
   return AOS_OK;
 }
 static ut_at24c01bndata_t _utAlldAt24c01bnData = {
@@ -928,15 +1846,25 @@ static int _utShellCmdCb_AlldPca5944a(BaseSequentialStream* stream, int argc, ch
   // evaluate arguments
   if (argc == 2) {
     if (strcmp(argv[1], "#1") == 0) {
+      const bool proximity = (moduleSvcProximity1.thread != NULL);
+      svcProximityStop(&moduleSvcProximity1);
       ((ut_pca9544adata_t*)moduleUtAlldPca9544a.data)->driver = &moduleLldI2cMultiplexer1;
       aosUtRun(stream, &moduleUtAlldPca9544a, "I2C bus #1");
       ((ut_pca9544adata_t*)moduleUtAlldPca9544a.data)->driver = NULL;
+      if (proximity) {
+        svcProximityStart(&moduleSvcProximity1, _svcProximity1Wa, sizeof(_svcProximity1Wa), AOS_THD_NORMALPRIO_MIN);
+      }
       return AOS_OK;
     }
     else if (strcmp(argv[1], "#2") == 0) {
+      const bool proximity = (moduleSvcProximity2.thread != NULL);
+      svcProximityStop(&moduleSvcProximity2);
       ((ut_pca9544adata_t*)moduleUtAlldPca9544a.data)->driver = &moduleLldI2cMultiplexer2;
       aosUtRun(stream, &moduleUtAlldPca9544a, "I2C bus #2");
       ((ut_pca9544adata_t*)moduleUtAlldPca9544a.data)->driver = NULL;
+      if (proximity) {
+        svcProximityStart(&moduleSvcProximity2, _svcProximity2Wa, sizeof(_svcProximity2Wa), AOS_THD_NORMALPRIO_MIN);
+      }
       return AOS_OK;
     }
   }
@@ -1075,23 +2003,39 @@ static int _utShellCmdCb_AlldVcnl4020(BaseSequentialStream* stream, int argc, ch
   }
   if (sensor != UNKNOWN) {
     PCA9544ADriver* mux = NULL;
+    svc_proximity_t* svc = NULL;
+    void* svcwa = NULL;
+    size_t svcwasize = 0;
+    bool svcrunning = false;
     switch (sensor) {
       case SSE:
       case SSW:
       case WSW:
       case WNW:
+        svc = &moduleSvcProximity1;
+        svcwa = _svcProximity1Wa;
+        svcwasize = sizeof(_svcProximity1Wa);
         mux = &moduleLldI2cMultiplexer1;
         ((ut_vcnl4020data_t*)moduleUtAlldVcnl4020.data)->vcnld = &moduleLldProximity1;
         ((ut_vcnl4020data_t*)moduleUtAlldVcnl4020.data)->evtflags = (1 << MODULE_GPIO_INT_IRINT2);
+        // the service uses the same sensors and interrupt
+        svcrunning = (svc->thread != NULL);
+        svcProximityStop(svc);
         aosIntEnable(&moduleIntDriver, MODULE_GPIO_INT_IRINT2);
         break;
       case NNW:
       case NNE:
       case ENE:
       case ESE:
+        svc = &moduleSvcProximity2;
+        svcwa = _svcProximity2Wa;
+        svcwasize = sizeof(_svcProximity2Wa);
         mux = &moduleLldI2cMultiplexer2;
         ((ut_vcnl4020data_t*)moduleUtAlldVcnl4020.data)->vcnld = &moduleLldProximity2;
         ((ut_vcnl4020data_t*)moduleUtAlldVcnl4020.data)->evtflags = (1 << MODULE_GPIO_INT_IRINT1);
+        // the service uses the same sensors and interrupt
+        svcrunning = (svc->thread != NULL);
+        svcProximityStop(svc);
         aosIntEnable(&moduleIntDriver, MODULE_GPIO_INT_IRINT1);
         break;
       default:
@@ -1151,6 +2095,9 @@ static int _utShellCmdCb_AlldVcnl4020(BaseSequentialStream* stream, int argc, ch
     }
     ((ut_vcnl4020data_t*)moduleUtAlldVcnl4020.data)->vcnld = NULL;
     ((ut_vcnl4020data_t*)moduleUtAlldVcnl4020.data)->evtflags = 0;
+    if (svcrunning) {
+      svcProximityStart(svc, svcwa, svcwasize, AOS_THD_NORMALPRIO_MIN);
+    }
     return AOS_OK;
   }
   // print help
@@ -1192,6 +2139,66 @@ aos_unittest_t moduleUtAlldVcnl4020 = {
   /* data           */ &_utAlldVcnl4020Data,
 };
 
+/* key-value store */
+static int _utShellCmdCb_SvcKvStore(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcKvStore, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcKvStore = {
+  /* name           */ "key-value store",
+  /* info           */ "wear leveling and recovery",
+  /* test function  */ utSvcKvStoreFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:KvStore",
+    /* callback */ _utShellCmdCb_SvcKvStore,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
+/* CAN protocol */
+static int _utShellCmdCb_SvcCanProto(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcCanProto, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcCanProto = {
+  /* name           */ "CAN protocol",
+  /* info           */ "fragmentation and reassembly",
+  /* test function  */ utSvcCanProtoFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:CanProto",
+    /* callback */ _utShellCmdCb_SvcCanProto,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
+/* CAN filter */
+static int _utShellCmdCb_SvcCanFilter(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  (void)argc;
+  (void)argv;
+  aosUtRun(stream, &moduleUtSvcCanFilter, NULL);
+  return AOS_OK;
+}
+aos_unittest_t moduleUtSvcCanFilter = {
+  /* name           */ "CAN filter",
+  /* info           */ "filter bank compilation",
+  /* test function  */ utSvcCanFilterFunc,
+  /* shell command  */ {
+    /* name     */ "unittest:CanFilter",
+    /* callback */ _utShellCmdCb_SvcCanFilter,
+    /* next     */ NULL,
+  },
+  /* data           */ NULL,
+};
+
 #endif /* AMIROOS_CFG_TESTS_ENABLE == true */
 
 /** @} */
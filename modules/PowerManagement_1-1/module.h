@@ -424,6 +424,56 @@ extern apalGpio_t moduleGpioChargeEn2;
  */
 #define MODULE_OS_IOEVENTFLAGS_SYSUARTUP        ((eventflags_t)1 << MODULE_GPIO_INT_SYSUARTUP)
 
+/**
+ * @brief   Event flag to be set when the combined battery charge dropped below the low threshold.
+ */
+#define MODULE_OS_IOEVENTFLAGS_BATTERYLOW       ((eventflags_t)1 << 16)
+
+/**
+ * @brief   Event flag to be set when the combined battery charge dropped below the critical threshold.
+ */
+#define MODULE_OS_IOEVENTFLAGS_BATTERYCRITICAL  ((eventflags_t)1 << 17)
+
+/**
+ * @brief   Event flag to be set when the combined battery charge recovered.
+ */
+#define MODULE_OS_IOEVENTFLAGS_BATTERYNORMAL    ((eventflags_t)1 << 18)
+
+/**
+ * @brief   Linker section of the persistent boot log (backup SRAM).
+ */
+#define MODULE_OS_BOOTLOG_SECTION               ".ram5"
+
+/**
+ * @brief   Linker section of the persistent shutdown report (backup SRAM).
+ */
+#define MODULE_OS_TEARDOWN_SECTION              ".ram5"
+
+#if (AMIROOS_CFG_IDLE_STOP == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Time to restore the clocks after STOP mode in microseconds.
+ * @details Includes the startup of the HSE oscillator and the locking of the PLL.
+ */
+#define MODULE_OS_IDLE_STOP_LATENCY             2000
+
+/**
+ * @brief   STOP mode hook.
+ * @details Enters STOP mode for at most the specified duration (in microseconds), restores the clocks and returns the
+ *          time spent in STOP mode (in microseconds).
+ */
+#define MODULE_OS_IDLE_STOP(duration)           moduleIdleStop(duration)
+
+#include <aos_time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  aos_interval_t moduleIdleStop(aos_interval_t duration);
+#ifdef __cplusplus
+}
+#endif
+#endif
+
 #if (AMIROOS_CFG_SHELL_ENABLE == true) || defined(__DOXYGEN__)
 /**
  * @brief   Shell prompt text.
@@ -431,6 +481,33 @@ extern apalGpio_t moduleGpioChargeEn2;
 extern const char* moduleShellPrompt;
 #endif
 
+/**
+ * @brief   Additional OS initialization hook.
+ */
+#define MODULE_INIT_OS_EXTRA() {                                              \
+  /* snapshot cache */                                                        \
+  moduleSnapshotsInit();                                                      \
+  /* services */                                                              \
+  moduleServicesInit();                                                       \
+}
+
+/**
+ * @brief   Services initialization hook.
+ */
+#define MODULE_INIT_SERVICES() {                                              \
+  moduleServicesStart();                                                      \
+  /* register teardown tasks */                                               \
+  moduleTeardownInit();                                                       \
+}
+
+/**
+ * @brief   System configuration hook.
+ * @details Persists the shell configuration and the date/time after they were modified via the shell.
+ */
+#define MODULE_SYSTEM_CONFIG_HOOK() {                                         \
+  svcSettingsSave(&moduleSvcSettings);                                        \
+}
+
 /**
  * @brief   Unit test initialization hook.
  */
@@ -449,6 +526,9 @@ extern const char* moduleShellPrompt;
   aosShellAddCommand(&aos.shell, &moduleUtAlldTps62113.shellcmd);             \
   aosShellAddCommand(&aos.shell, &moduleUtAlldTps62113Ina219.shellcmd);       \
   aosShellAddCommand(&aos.shell, &moduleUtAlldVcnl4020.shellcmd);             \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcKvStore.shellcmd);               \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcCanProto.shellcmd);              \
+  aosShellAddCommand(&aos.shell, &moduleUtSvcCanFilter.shellcmd);             \
 }
 
 /**
@@ -482,20 +562,6 @@ extern const char* moduleShellPrompt;
   pwmStart(&MODULE_HAL_PWM_BUZZER, &moduleHalPwmBuzzerConfig);                \
 }
 
-/**
- * @brief   Periphery communication interface deinitialization hook.
- */
-#define MODULE_SHUTDOWN_PERIPHERY_COMM() {                                    \
-  /* PWM */                                                                   \
-  pwmStop(&MODULE_HAL_PWM_BUZZER);                                            \
-  /* ADC */                                                                   \
-  adcStop(&MODULE_HAL_ADC_VSYS);                                              \
-  /* I2C */                                                                   \
-  i2cStop(&MODULE_HAL_I2C_PROX_PM18_PM33_GAUGEREAR);                          \
-  i2cStop(&MODULE_HAL_I2C_PROX_PM42_PM50_PMVDD_EEPROM_TOUCH_GAUGEFRONT);      \
-  /* don't stop the serial driver so messages can still be printed */         \
-}
-
 /** @} */
 
 /*===========================================================================*/
@@ -652,6 +718,354 @@ extern VCNL4020Driver moduleLldProximity2;
 
 /** @} */
 
+/*===========================================================================*/
+/**
+ * @name Snapshots
+ * @{
+ */
+/*===========================================================================*/
+#include <aos_snapshot.h>
+
+/**
+ * @brief   Timeout for snapshot bus transactions in microseconds.
+ */
+#define MODULE_SNAPSHOT_I2C_TIMEOUT             (10 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Minimum interval between two INA219 transactions in microseconds.
+ * @note    Matches the conversion time of the default configuration (12 bit, no averaging).
+ */
+#define MODULE_SNAPSHOT_INA219_MININTERVAL      (1 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Background refresh interval of the INA219 snapshots in microseconds.
+ * @note    The snapshots are refreshed by the power monitor service.
+ */
+#define MODULE_SNAPSHOT_INA219_REFRESH          0
+
+/**
+ * @brief   Minimum interval between two BQ27500 transactions in microseconds.
+ */
+#define MODULE_SNAPSHOT_BQ27500_MININTERVAL     (250 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Background refresh interval of the BQ27500 snapshots in microseconds.
+ * @note    The snapshots are refreshed by the battery service.
+ */
+#define MODULE_SNAPSHOT_BQ27500_REFRESH         0
+
+/**
+ * @brief   Cached register set of an INA219 power monitor.
+ */
+typedef struct {
+  /**
+   * @brief   All registers, indexed by ina219_lld_register_t.
+   */
+  uint16_t registers[6];
+} module_ina219snapshot_t;
+
+/**
+ * @brief   Power monitor (VDD) snapshot.
+ */
+extern aos_snapshot_t moduleSnapshotPowerMonitorVdd;
+
+/**
+ * @brief   Power monitor (VIO 1.8) snapshot.
+ */
+extern aos_snapshot_t moduleSnapshotPowerMonitorVio18;
+
+/**
+ * @brief   Power monitor (VIO 3.3) snapshot.
+ */
+extern aos_snapshot_t moduleSnapshotPowerMonitorVio33;
+
+/**
+ * @brief   Power monitor (VSYS 4.2) snapshot.
+ */
+extern aos_snapshot_t moduleSnapshotPowerMonitorVsys42;
+
+/**
+ * @brief   Power monitor (VIO 5.0) snapshot.
+ */
+extern aos_snapshot_t moduleSnapshotPowerMonitorVio50;
+
+/**
+ * @brief   Fuel gauge (front battery) snapshot (see svc_battery_registers_t).
+ */
+extern aos_snapshot_t moduleSnapshotFuelGaugeFront;
+
+/**
+ * @brief   Fuel gauge (rear battery) snapshot (see svc_battery_registers_t).
+ */
+extern aos_snapshot_t moduleSnapshotFuelGaugeRear;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void moduleSnapshotsInit(void);
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+/*===========================================================================*/
+/**
+ * @name Services
+ * @{
+ */
+/*===========================================================================*/
+#include <svc_eeprom.h>
+#include <svc_battery.h>
+#include <svc_canbus.h>
+#include <svc_cantx.h>
+#include <svc_cpufreq.h>
+#include <svc_powermonitor.h>
+#include <svc_proximity.h>
+#include <svc_settings.h>
+#include <svc_timesync.h>
+#include <svc_vsys.h>
+
+/**
+ * @brief   Delay of the asynchronous EEPROM flush in microseconds.
+ * @details Writes within this interval are merged into a single write cycle per page.
+ */
+#define MODULE_SVC_EEPROM_DELAY                 (100 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Stack size of the EEPROM flush thread.
+ */
+#define MODULE_SVC_EEPROM_STACKSIZE             256
+
+/**
+ * @brief   EEPROM cache.
+ */
+extern svc_eeprom_t moduleSvcEeprom;
+
+/**
+ * @brief   EEPROM address of the persistent settings.
+ */
+#define MODULE_SVC_SETTINGS_ADDRESS             0x00
+
+/**
+ * @brief   Size of the persistent settings region in bytes.
+ */
+#define MODULE_SVC_SETTINGS_SIZE                (SVC_EEPROM_SIZE - MODULE_SVC_SETTINGS_ADDRESS)
+
+/**
+ * @brief   Persistent settings.
+ */
+extern svc_settings_t moduleSvcSettings;
+
+/**
+ * @brief   Number of control frames the CAN transmit scheduler can queue.
+ */
+#define MODULE_SVC_CANTX_CONTROLQUEUE           4
+
+/**
+ * @brief   Number of data frames the CAN transmit scheduler can queue.
+ */
+#define MODULE_SVC_CANTX_DATAQUEUE              8
+
+/**
+ * @brief   Number of bulk frames the CAN transmit scheduler can queue.
+ */
+#define MODULE_SVC_CANTX_BULKQUEUE              8
+
+/**
+ * @brief   Time in microseconds after which queued bulk frames are considered stale and dropped.
+ */
+#define MODULE_SVC_CANTX_BULKLIFETIME           (100 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Stack size of the CAN transmit thread.
+ */
+#define MODULE_SVC_CANTX_STACKSIZE              256
+
+/**
+ * @brief   CAN transmit scheduler.
+ */
+extern svc_cantx_t moduleSvcCanTx;
+
+/**
+ * @brief   Number of messages in the pool of the CAN bus service.
+ */
+#define MODULE_SVC_CANBUS_POOLSIZE              8
+
+/**
+ * @brief   Stack size of the CAN bus thread.
+ */
+#define MODULE_SVC_CANBUS_STACKSIZE             256
+
+/**
+ * @brief   CAN publish/subscribe service.
+ */
+extern svc_canbus_t moduleSvcCanBus;
+
+/**
+ * @brief   Stack size of the time synchronization thread.
+ */
+#define MODULE_SVC_TIMESYNC_STACKSIZE           256
+
+/**
+ * @brief   Time synchronization via CAN.
+ */
+extern svc_timesync_t moduleSvcTimeSync;
+
+/**
+ * @brief   Refresh interval of the battery service in microseconds.
+ */
+#define MODULE_SVC_BATTERY_PERIOD               (1 * MICROSECONDS_PER_SECOND)
+
+/**
+ * @brief   Time constant of the current filter for the runtime prediction in microseconds.
+ */
+#define MODULE_SVC_BATTERY_TAU                  (60 * MICROSECONDS_PER_SECOND)
+
+/**
+ * @brief   Low threshold of the combined state of charge in percent.
+ */
+#define MODULE_SVC_BATTERY_LOWTHRESHOLD         20
+
+/**
+ * @brief   Critical threshold of the combined state of charge in percent.
+ */
+#define MODULE_SVC_BATTERY_CRITICALTHRESHOLD    5
+
+/**
+ * @brief   Hysteresis of the battery thresholds in percent.
+ */
+#define MODULE_SVC_BATTERY_HYSTERESIS           3
+
+/**
+ * @brief   Stack size of the battery thread.
+ */
+#define MODULE_SVC_BATTERY_STACKSIZE            512
+
+/**
+ * @brief   Battery service.
+ */
+extern svc_battery_t moduleSvcBattery;
+
+/**
+ * @brief   Interval between two power monitor samples in microseconds.
+ * @details With five rails, each rail is sampled every 100ms.
+ */
+#define MODULE_SVC_POWERMONITOR_INTERVAL        (20 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Length of the power monitor statistics window in microseconds.
+ */
+#define MODULE_SVC_POWERMONITOR_WINDOW          (10 * MICROSECONDS_PER_SECOND)
+
+/**
+ * @brief   Stack size of the power monitor thread.
+ */
+#define MODULE_SVC_POWERMONITOR_STACKSIZE       512
+
+/**
+ * @brief   Power monitor service.
+ */
+extern svc_powermonitor_t moduleSvcPowerMonitor;
+
+/**
+ * @brief   Proximity measurement rate of all sensors (maximum rate of the VCNL4020).
+ */
+#define MODULE_SVC_PROXIMITY_RATE               VCNL4020_LLD_PROXRATEREG_250_HZ
+
+/**
+ * @brief   Ambient light compensation factor of the proximity sensors (unsigned Q8.8, 0 to disable).
+ */
+#define MODULE_SVC_PROXIMITY_AMBIENTFACTOR      0
+
+/**
+ * @brief   Maximum time the proximity services wait for an interrupt in microseconds.
+ */
+#define MODULE_SVC_PROXIMITY_WATCHDOG           (20 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Stack size of the proximity threads.
+ */
+#define MODULE_SVC_PROXIMITY_STACKSIZE          384
+
+/**
+ * @brief   Proximity service for the sensors on I2C 1 (south and west).
+ */
+extern svc_proximity_t moduleSvcProximity1;
+
+/**
+ * @brief   Proximity service for the sensors on I2C 2 (north and east).
+ */
+extern svc_proximity_t moduleSvcProximity2;
+
+/**
+ * @brief   Number of samples in the circular VSYS DMA buffer.
+ * @details Each half (128 samples) is decimated to a single value, which results in an interrupt about every 3ms.
+ */
+#define MODULE_SVC_VSYS_BUFFERDEPTH             256
+
+/**
+ * @brief   Voltage represented by one LSB of the VSYS ADC (3.3V reference, 1:5 voltage divider).
+ */
+#define MODULE_SVC_VSYS_SCALE                   (3.3f * 5.0f / ((1 << 12) - 1))
+
+/**
+ * @brief   VSYS brown-out threshold in microvolts.
+ */
+#define MODULE_SVC_VSYS_LOWTHRESHOLD            6000000
+
+/**
+ * @brief   VSYS threshold in microvolts to detect external power.
+ */
+#define MODULE_SVC_VSYS_HIGHTHRESHOLD           9000000
+
+/**
+ * @brief   VSYS threshold hysteresis in microvolts.
+ */
+#define MODULE_SVC_VSYS_HYSTERESIS              200000
+
+/**
+ * @brief   Continuous VSYS acquisition service.
+ */
+extern svc_vsys_t moduleSvcVsys;
+
+/**
+ * @brief   Period of the load measurement of the CPU frequency governor in microseconds.
+ */
+#define MODULE_SVC_CPUFREQ_PERIOD               (10 * MICROSECONDS_PER_MILLISECOND)
+
+/**
+ * @brief   Load in permille, above which the core clock is raised to the maximum.
+ */
+#define MODULE_SVC_CPUFREQ_UP                   700
+
+/**
+ * @brief   Load in permille, which must not be reached at the next slower clock level to lower the core clock.
+ */
+#define MODULE_SVC_CPUFREQ_DOWN                 500
+
+/**
+ * @brief   Stack size of the CPU frequency governor thread.
+ */
+#define MODULE_SVC_CPUFREQ_STACKSIZE            256
+
+/**
+ * @brief   CPU frequency governor.
+ */
+extern svc_cpufreq_t moduleSvcCpuFreq;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void moduleServicesInit(void);
+  void moduleServicesStart(void);
+  void moduleTeardownInit(void);
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
 /*===========================================================================*/
 /**
  * @name Unit tests (UT)
@@ -672,6 +1086,9 @@ extern VCNL4020Driver moduleLldProximity2;
 #include <ut_alld_tps62113.h>
 #include <ut_alld_tps62113_ina219.h>
 #include <ut_alld_vcnl4020.h>
+#include <ut_svc_canfilter.h>
+#include <ut_svc_canproto.h>
+#include <ut_svc_kvstore.h>
 
 /**
  * @brief   ADC unit test object.
@@ -738,6 +1155,21 @@ extern aos_unittest_t moduleUtAlldTps62113Ina219;
  */
 extern aos_unittest_t moduleUtAlldVcnl4020;
 
+/**
+ * @brief   Key-value store unit test object.
+ */
+extern aos_unittest_t moduleUtSvcKvStore;
+
+/**
+ * @brief   CAN protocol unit test object.
+ */
+extern aos_unittest_t moduleUtSvcCanProto;
+
+/**
+ * @brief   CAN filter unit test object.
+ */
+extern aos_unittest_t moduleUtSvcCanFilter;
+
 #endif /* AMIROOS_CFG_TESTS_ENABLE == true */
 
 /** @} */
@@ -72,10 +72,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "core/inc/aos_confcheck.h"
 
 /* core headers */
+#include "core/inc/aos_boot.h"
+#include "core/inc/aos_clock.h"
+#include "core/inc/aos_crc.h"
 #include "core/inc/aos_debug.h"
 #include <core/inc/aos_iostream.h>
+#include "core/inc/aos_qei.h"
 #include "core/inc/aos_shell.h"
+#include "core/inc/aos_snapshot.h"
 #include "core/inc/aos_system.h"
+#include "core/inc/aos_teardown.h"
+#include "core/inc/aos_idle.h"
 #include "core/inc/aos_thread.h"
 #include "core/inc/aos_time.h"
 #include "core/inc/aos_timer.h"
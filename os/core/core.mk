@@ -30,10 +30,16 @@ AMIROOS_CORE_DIR := $(dir $(lastword $(MAKEFILE_LIST)))
 AMIROOSCOREINC = $(AMIROOS_CORE_DIR)inc
 
 # C source files
-AMIROOSCORECSRC = $(AMIROOS_CORE_DIR)src/aos_debug.c \
+AMIROOSCORECSRC = $(AMIROOS_CORE_DIR)src/aos_boot.c \
+                  $(AMIROOS_CORE_DIR)src/aos_clock.c \
+                  $(AMIROOS_CORE_DIR)src/aos_crc.c \
+                  $(AMIROOS_CORE_DIR)src/aos_debug.c \
                   $(AMIROOS_CORE_DIR)src/aos_iostream.c \
                   $(AMIROOS_CORE_DIR)src/aos_shell.c \
+                  $(AMIROOS_CORE_DIR)src/aos_snapshot.c \
                   $(AMIROOS_CORE_DIR)src/aos_system.c \
+                  $(AMIROOS_CORE_DIR)src/aos_teardown.c \
+                  $(AMIROOS_CORE_DIR)src/aos_idle.c \
                   $(AMIROOS_CORE_DIR)src/aos_thread.c \
                   $(AMIROOS_CORE_DIR)src/aos_time.c \
                   $(AMIROOS_CORE_DIR)src/aos_timer.c \
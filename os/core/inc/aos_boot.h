@@ -0,0 +1,118 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_BOOT_H_
+#define _AMIROOS_BOOT_H_
+
+#include <aosconf.h>
+#include <hal.h>
+
+/**
+ * @brief   Events recorded by the boot profiler.
+ */
+typedef enum aos_bootevent {
+  AOS_BOOT_MAIN   = 0x00,   /**< Entry of main().                                 */
+  AOS_BOOT_HOOK   = 0x01,   /**< Initialization hook (value holds its index).     */
+  AOS_BOOT_STAGE  = 0x02,   /**< SSSP stage transition (value holds the stage).   */
+  AOS_BOOT_READY  = 0x03,   /**< Startup completed.                               */
+} aos_bootevent_t;
+
+#if (AMIROOS_CFG_PROFILE == true) || defined(__DOXYGEN__)
+
+/**
+ * @brief   Maximum number of events recorded per boot.
+ */
+#define AOS_BOOT_MAXEVENTS                      32
+
+/**
+ * @brief   Number of boots kept in the persistent history.
+ */
+#define AOS_BOOT_HISTORY                        4
+
+/**
+ * @brief   Recorded event.
+ */
+typedef struct aos_bootentry {
+  uint32_t time;    /**< Time since the entry of main() in microseconds.  */
+  uint8_t event;    /**< Type of the event (see aos_bootevent_t).         */
+  uint8_t value;    /**< Hook index or SSSP stage.                        */
+} aos_bootentry_t;
+
+/**
+ * @brief   Record of a single boot.
+ */
+typedef struct aos_bootrecord {
+  /**
+   * @brief   Sequence number of the boot.
+   */
+  uint32_t sequence;
+
+  /**
+   * @brief   Number of recorded events.
+   */
+  uint8_t count;
+
+  /**
+   * @brief   Number of events, which did not fit in the record.
+   */
+  uint8_t dropped;
+
+  /**
+   * @brief   Flag whether the startup was completed.
+   */
+  uint8_t complete;
+
+  /**
+   * @brief   CRC of the events (only valid for completed records).
+   */
+  uint8_t crc;
+
+  /**
+   * @brief   Recorded events.
+   */
+  aos_bootentry_t entries[AOS_BOOT_MAXEVENTS];
+} aos_bootrecord_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void aosBootInit(void);
+  void aosBootLogOpen(void);
+  void aosBootMark(aos_bootevent_t event, uint8_t value);
+  void aosBootPrintInfo(BaseSequentialStream* stream, bool history);
+#ifdef __cplusplus
+}
+#endif
+
+#else /* (AMIROOS_CFG_PROFILE != true) */
+
+#define aosBootInit() {                                   \
+}
+
+#define aosBootLogOpen() {                                \
+}
+
+#define aosBootMark(event, value) {                       \
+  (void)(event);                                          \
+  (void)(value);                                          \
+}
+
+#endif
+
+#endif /* _AMIROOS_BOOT_H_ */
@@ -0,0 +1,372 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_CANMSG_HPP_
+#define _AMIROOS_CANMSG_HPP_
+
+#include <hal.h>
+#include <stdint.h>
+
+/**
+ * @brief   Compile-time CAN message codecs.
+ * @details Message layouts are declared as types.
+ *          All offsets, sizes and masks are resolved at compile time, so that packing and unpacking reduce to a fixed
+ *          sequence of shifts and byte accesses without any loops or branches.
+ *          Layouts, which exceed the payload or overlap, are rejected by the compiler.
+ *          Multi-byte values are encoded little endian (least significant byte first).
+ */
+namespace amiroos {
+
+/**
+ * @brief   Internal helpers of the CAN message codecs.
+ */
+namespace canmsg {
+
+/**
+ * @brief   Unrolled little endian (de)serialization of @p N bytes.
+ *
+ * @tparam  N   Number of bytes.
+ */
+template <uint8_t N>
+struct Bytes
+{
+  template <typename T>
+  static inline void pack(uint8_t* dst, const T value)
+  {
+    Bytes<N - 1>::pack(dst, value);
+    dst[N - 1] = (uint8_t)(value >> (8 * (N - 1)));
+    return;
+  }
+
+  template <typename T>
+  static inline T unpack(const uint8_t* src)
+  {
+    return Bytes<N - 1>::template unpack<T>(src) | (T)((T)src[N - 1] << (8 * (N - 1)));
+  }
+};
+
+/**
+ * @brief   Recursion anchor of the unrolled (de)serialization.
+ */
+template <>
+struct Bytes<0>
+{
+  template <typename T>
+  static inline void pack(uint8_t*, const T)
+  {
+    return;
+  }
+
+  template <typename T>
+  static inline T unpack(const uint8_t*)
+  {
+    return 0;
+  }
+};
+
+/**
+ * @brief   Checks whether the given masks are pairwise disjoint.
+ *
+ * @tparam  M   Type of the masks.
+ *
+ * @param[in] masks   Array of masks.
+ * @param[in] n       Number of masks.
+ *
+ * @return  True if no two masks overlap, false otherwise.
+ */
+template <typename M>
+constexpr bool disjoint(const M* masks, const unsigned int n)
+{
+  M occupied = 0;
+  for (unsigned int m = 0; m < n; ++m) {
+    if ((occupied & masks[m]) != 0) {
+      return false;
+    }
+    occupied |= masks[m];
+  }
+  return true;
+}
+
+/**
+ * @brief   Computes the number of bytes spanned by a bit mask.
+ *
+ * @param[in] mask  The bit mask.
+ *
+ * @return  Number of bytes up to the most significant bit set.
+ */
+constexpr uint8_t bytes(const uint64_t mask)
+{
+  uint8_t n = 0;
+  while (n < 8 && (mask >> (8 * n)) != 0) {
+    ++n;
+  }
+  return n;
+}
+
+/**
+ * @brief   Checks whether type @p F is one of the types @p Fs.
+ */
+template <typename F, typename... Fs>
+struct contains
+{
+  static constexpr bool value = false;
+};
+
+template <typename F, typename... Fs>
+struct contains<F, F, Fs...>
+{
+  static constexpr bool value = true;
+};
+
+template <typename F, typename G, typename... Fs>
+struct contains<F, G, Fs...>
+{
+  static constexpr bool value = contains<F, Fs...>::value;
+};
+
+} /* namespace canmsg */
+
+/**
+ * @brief   Byte aligned field of a CAN payload.
+ *
+ * @tparam  OFFSET  Offset of the first byte within the payload.
+ * @tparam  SIZE    Number of bytes.
+ * @tparam  T       Unsigned integer type of the value.
+ */
+template <uint8_t OFFSET, uint8_t SIZE, typename T = uint32_t>
+struct CanField
+{
+  static_assert(SIZE > 0 && SIZE <= sizeof(T), "field size does not match the value type");
+  static_assert(OFFSET + SIZE <= 8, "field exceeds the CAN payload");
+
+  /**
+   * @brief   Type of the value.
+   */
+  typedef T type;
+
+  /**
+   * @brief   Offset of the first byte within the payload.
+   */
+  static constexpr uint8_t offset = OFFSET;
+
+  /**
+   * @brief   Number of bytes.
+   */
+  static constexpr uint8_t size = SIZE;
+
+  /**
+   * @brief   Bytes of the payload occupied by the field (one bit per byte).
+   */
+  static constexpr uint8_t mask = (uint8_t)(((1u << SIZE) - 1) << OFFSET);
+
+  /**
+   * @brief   Writes a value to the payload.
+   *
+   * @param[out] data   Pointer to the payload.
+   * @param[in]  value  Value to write. Excess bytes are truncated.
+   */
+  static inline void pack(uint8_t* data, const T value)
+  {
+    canmsg::Bytes<SIZE>::pack(&data[OFFSET], value);
+    return;
+  }
+
+  /**
+   * @brief   Reads a value from the payload.
+   *
+   * @param[in] data  Pointer to the payload.
+   *
+   * @return  The value.
+   */
+  static inline T unpack(const uint8_t* data)
+  {
+    return canmsg::Bytes<SIZE>::template unpack<T>(&data[OFFSET]);
+  }
+};
+
+/**
+ * @brief   Bit field of an encoded 64 bit word.
+ *
+ * @tparam  SHIFT   Position of the least significant bit.
+ * @tparam  WIDTH   Number of bits.
+ * @tparam  T       Integer type of the value.
+ */
+template <uint8_t SHIFT, uint8_t WIDTH, typename T = uint32_t>
+struct CanBitField
+{
+  static_assert(WIDTH > 0 && WIDTH <= 8 * sizeof(T), "bit field width does not match the value type");
+  static_assert(SHIFT + WIDTH <= 64, "bit field exceeds 64 bit");
+
+  /**
+   * @brief   Type of the value.
+   */
+  typedef T type;
+
+  /**
+   * @brief   Bits of the word occupied by the field.
+   */
+  static constexpr uint64_t mask = ((WIDTH == 64) ? ~(uint64_t)0 : (((uint64_t)1 << WIDTH) - 1)) << SHIFT;
+
+  /**
+   * @brief   Encodes a value to its position in the word. Excess bits are truncated.
+   *
+   * @param[in] value   Value to encode.
+   *
+   * @return  The encoded bits.
+   */
+  static constexpr uint64_t encode(const T value)
+  {
+    return ((uint64_t)value << SHIFT) & mask;
+  }
+
+  /**
+   * @brief   Decodes the value from a word.
+   *
+   * @param[in] word  The encoded word.
+   *
+   * @return  The decoded value.
+   */
+  static constexpr T decode(const uint64_t word)
+  {
+    return (T)((word & mask) >> SHIFT);
+  }
+};
+
+/**
+ * @brief   Layout of a word, which is composed of bit fields.
+ *
+ * @tparam  Fields  Bit fields (@p CanBitField) of the word.
+ */
+template <typename... Fields>
+struct CanWord
+{
+  static_assert(sizeof...(Fields) > 0, "word without fields");
+
+  /**
+   * @brief   Number of bytes required to hold all fields.
+   */
+  static constexpr uint8_t size = canmsg::bytes((Fields::mask | ...));
+
+  /**
+   * @brief   Encodes all fields at once.
+   *
+   * @param[in] values  Values of all fields in the order of declaration.
+   *
+   * @return  The encoded word.
+   */
+  static constexpr uint64_t encode(const typename Fields::type... values)
+  {
+    return (Fields::encode(values) | ...);
+  }
+
+private:
+  static constexpr uint64_t _masks[] = {Fields::mask...};
+  static_assert(canmsg::disjoint(_masks, sizeof...(Fields)), "bit fields overlap");
+};
+
+/**
+ * @brief   Layout of a standard data frame.
+ *
+ * @tparam  SID     Standard identifier of the message.
+ * @tparam  DLC     Data length code of the message.
+ * @tparam  Fields  Payload fields (@p CanField) of the message.
+ */
+template <uint16_t SID, uint8_t DLC, typename... Fields>
+struct CanMessage
+{
+  static_assert(SID <= 0x7FF, "invalid standard identifier");
+  static_assert(DLC <= 8, "invalid data length code");
+
+  /**
+   * @brief   Standard identifier of the message.
+   */
+  static constexpr uint16_t sid = SID;
+
+  /**
+   * @brief   Data length code of the message.
+   */
+  static constexpr uint8_t dlc = DLC;
+
+  /**
+   * @brief   Initializes the header of a frame to transmit.
+   *
+   * @param[out] frame  The frame to initialize.
+   */
+  static inline void prepare(CANTxFrame* frame)
+  {
+    frame->DLC = DLC;
+    frame->RTR = CAN_RTR_DATA;
+    frame->IDE = CAN_IDE_STD;
+    frame->SID = SID;
+    return;
+  }
+
+  /**
+   * @brief   Checks whether a received frame is an instance of the message.
+   *
+   * @param[in] frame   The received frame.
+   *
+   * @return  True if header and data length code match, false otherwise.
+   */
+  static inline bool match(const CANRxFrame* frame)
+  {
+    return frame->DLC == DLC && frame->RTR == CAN_RTR_DATA && frame->IDE == CAN_IDE_STD && frame->SID == SID;
+  }
+
+  /**
+   * @brief   Writes a field of the message to the payload.
+   *
+   * @tparam  F   The field to write.
+   *
+   * @param[out] data   Pointer to the payload.
+   * @param[in]  value  Value to write.
+   */
+  template <typename F>
+  static inline void pack(uint8_t* data, const typename F::type value)
+  {
+    static_assert(canmsg::contains<F, Fields...>::value, "field is not part of the message");
+    F::pack(data, value);
+    return;
+  }
+
+  /**
+   * @brief   Reads a field of the message from the payload.
+   *
+   * @tparam  F   The field to read.
+   *
+   * @param[in] data  Pointer to the payload.
+   *
+   * @return  The value.
+   */
+  template <typename F>
+  static inline typename F::type unpack(const uint8_t* data)
+  {
+    static_assert(canmsg::contains<F, Fields...>::value, "field is not part of the message");
+    return F::unpack(data);
+  }
+
+private:
+  static constexpr uint8_t _masks[] = {Fields::mask..., 0};
+  static_assert(canmsg::disjoint(_masks, sizeof...(Fields)), "payload fields overlap");
+  static_assert((((Fields::offset + Fields::size) <= DLC) && ... && true), "payload fields exceed the data length code");
+};
+
+} /* namespace amiroos */
+
+#endif /* _AMIROOS_CANMSG_HPP_ */
@@ -0,0 +1,115 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_CLOCK_H_
+#define _AMIROOS_CLOCK_H_
+
+#include <aosconf.h>
+#include <hal.h>
+#include <aos_time.h>
+#include <aos_types.h>
+
+/**
+ * @brief   Maximum number of clock levels.
+ */
+#define AOS_CLOCK_MAXLEVELS                     4
+
+/**
+ * @brief   Prescaler bits of the RCC CFGR register, which are changed by a clock level.
+ */
+#define AOS_CLOCK_CFGR_MASK                     (RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2)
+
+/**
+ * @brief   Clock level.
+ * @details All levels share the PLL configuration of the module and differ in the AHB and APB prescalers only.
+ *          The APB prescalers must compensate the AHB prescaler, so the peripheral clocks (and thus all baud rates,
+ *          I2C timings and ADC clocks) are identical on each level.
+ */
+typedef struct aos_clocklevel {
+  /**
+   * @brief   Prescaler bits of the RCC CFGR register (see @p AOS_CLOCK_CFGR_MASK).
+   */
+  uint32_t cfgr;
+
+  /**
+   * @brief   Resulting core clock (HCLK) in Hz.
+   */
+  uint32_t hclk;
+
+  /**
+   * @brief   Resulting clock of the timers on APB1 in Hz.
+   */
+  uint32_t timclk1;
+
+  /**
+   * @brief   Resulting clock of the timers on APB2 in Hz.
+   */
+  uint32_t timclk2;
+} aos_clocklevel_t;
+
+/**
+ * @brief   Clock change callback type.
+ * @details The callback is executed with the system locked right after the prescalers were changed and must adapt
+ *          all drivers, whose timing depends on the changed clocks.
+ *
+ * @param[in] level   The new clock level.
+ * @param[in] param   Pointer to a custom parameter.
+ */
+typedef void (*aos_clock_cb_t)(const aos_clocklevel_t* level, void* param);
+
+/**
+ * @brief   Clock change notifier.
+ */
+typedef struct aos_clocknotifier {
+  /**
+   * @brief   Callback to adapt the drivers.
+   */
+  aos_clock_cb_t callback;
+
+  /**
+   * @brief   Parameter for the callback.
+   */
+  void* cbparam;
+
+  /**
+   * @brief   Pointer to the next notifier in the list.
+   */
+  struct aos_clocknotifier* next;
+} aos_clocknotifier_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void aosClockInit(const aos_clocklevel_t* levels, uint8_t count);
+  void aosClockRegisterNotifier(aos_clocknotifier_t* notifier);
+  aos_status_t aosClockSwitch(uint8_t level);
+  void aosClockHold(void);
+  void aosClockRelease(void);
+  uint8_t aosClockGetLevelX(void);
+  uint8_t aosClockGetNumLevelsX(void);
+  const aos_clocklevel_t* aosClockGetLevelInfoX(uint8_t level);
+  uint32_t aosClockGetHclkX(void);
+  void aosClockSetTimerFrequencyX(stm32_tim_t* tim, uint32_t timclk, uint32_t frequency);
+  void aosClockReapplyX(void);
+  void aosClockPrintInfo(BaseSequentialStream* stream);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_CLOCK_H_ */
@@ -68,6 +68,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
   #error "AMIROOS_CFG_SSSP_SIGNALDELAY not defined in aosconf.h"
 #endif
 
+#ifndef AMIROOS_CFG_SSSP_FASTENUMERATION
+  #error "AMIROOS_CFG_SSSP_FASTENUMERATION not defined in aosconf.h"
+#endif
+
 #ifndef AMIROOS_CFG_SSSP_SYSSYNCPERIOD
   #error "AMIROOS_CFG_SSSP_SYSSYNCPERIOD not defined in aosconf.h"
 #endif
@@ -100,4 +104,44 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #endif /* AMIROOS_CFG_SHELL_ENABLE == true */
 
+/*
+ * Snapshot cache options
+ */
+
+#ifndef AMIROOS_CFG_SNAPSHOT_STACKSIZE
+  #error "AMIROOS_CFG_SNAPSHOT_STACKSIZE not defined in aosconf.h"
+#endif
+
+#ifndef AMIROOS_CFG_SNAPSHOT_THREADPRIO
+  #error "AMIROOS_CFG_SNAPSHOT_THREADPRIO not defined in aosconf.h"
+#endif
+
+/*
+ * Shutdown options
+ */
+
+#ifndef AMIROOS_CFG_TEARDOWN_WORKERS
+  #error "AMIROOS_CFG_TEARDOWN_WORKERS not defined in aosconf.h"
+#endif
+
+#ifndef AMIROOS_CFG_TEARDOWN_STACKSIZE
+  #error "AMIROOS_CFG_TEARDOWN_STACKSIZE not defined in aosconf.h"
+#endif
+
+/*
+ * Idle options
+ */
+
+#ifndef AMIROOS_CFG_IDLE_STOP
+  #error "AMIROOS_CFG_IDLE_STOP not defined in aosconf.h"
+#endif
+
+#ifndef AMIROOS_CFG_IDLE_STOP_MINIMUM
+  #error "AMIROOS_CFG_IDLE_STOP_MINIMUM not defined in aosconf.h"
+#endif
+
+#ifndef AMIROOS_CFG_IDLE_STOP_CANQUIET
+  #error "AMIROOS_CFG_IDLE_STOP_CANQUIET not defined in aosconf.h"
+#endif
+
 #endif /* _AMIROOS_CONFCHECK_H_ */
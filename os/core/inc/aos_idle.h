@@ -0,0 +1,69 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_IDLE_H_
+#define _AMIROOS_IDLE_H_
+
+#include <aosconf.h>
+#include <hal.h>
+#include <aos_time.h>
+
+/**
+ * @brief   Number of idle modes.
+ */
+#define AOS_IDLE_MODES                          3
+
+/**
+ * @brief   Modes the system can enter while idle, ordered by increasing depth.
+ */
+typedef enum aos_idlemode {
+  AOS_IDLE_RUN    = 0,  /**< The core keeps running.                                                       */
+  AOS_IDLE_SLEEP  = 1,  /**< The core clock is halted, peripherals and the system timer keep running.    */
+  AOS_IDLE_STOP   = 2,  /**< All high-speed clocks are halted, only the low-speed oscillators keep running. */
+} aos_idlemode_t;
+
+/**
+ * @brief   Residency statistics of an idle mode.
+ */
+typedef struct aos_idleresidency {
+  /**
+   * @brief   Number of times the mode was entered.
+   */
+  uint32_t entries;
+
+  /**
+   * @brief   Accumulated time spent in the mode in microseconds.
+   */
+  aos_timestamp_t time;
+} aos_idleresidency_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void aosIdleHold(aos_idlemode_t mode);
+  void aosIdleRelease(aos_idlemode_t mode);
+  void aosIdleDeferI(aos_idlemode_t mode, aos_interval_t interval);
+  void aosIdleLoop(void);
+  void aosIdleGetTimeX(aos_timestamp_t* time);
+  void aosIdlePrintInfo(BaseSequentialStream* stream);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_IDLE_H_ */
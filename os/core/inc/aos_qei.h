@@ -0,0 +1,118 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_QEI_H_
+#define _AMIROOS_QEI_H_
+
+#include <hal.h>
+#if (HAL_USE_QEI == TRUE)
+#include <hal_qei.h>
+#endif
+
+#if ((HAL_USE_QEI == TRUE) && (QEI_USE_EXTENDED_POSITION == TRUE)) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <aos_time.h>
+
+/**
+ * @brief   Encoder position captured together with the system uptime.
+ */
+typedef struct aos_qeicapture {
+  /**
+   * @brief   Extended (64 bit) encoder position.
+   */
+  qeiextcnt_t position;
+
+  /**
+   * @brief   System uptime when the position was captured.
+   */
+  aos_timestamp_t uptime;
+} aos_qeicapture_t;
+
+/**
+ * @brief   Captures the extended position of multiple encoders at the same instant.
+ * @details All positions share the same uptime, which makes them suitable for odometry.
+ *
+ * @param[in]  qei      Array of QEI drivers.
+ * @param[out] capture  Array to store the captures to.
+ * @param[in]  n        Number of elements in both arrays.
+ */
+static inline void aosQeiCaptureMultipleI(QEIDriver* const qei[], aos_qeicapture_t capture[], size_t n)
+{
+  aosDbgCheck(qei != NULL);
+  aosDbgCheck(capture != NULL);
+
+  aos_timestamp_t uptime;
+
+  aosSysGetUptimeX(&uptime);
+  for (size_t i = 0; i < n; ++i) {
+    capture[i].position = qeiGetPositionExtendedI(qei[i]);
+    capture[i].uptime = uptime;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Captures the extended position of an encoder and the system uptime atomically.
+ *
+ * @param[in]  qei      QEI driver.
+ * @param[out] capture  Pointer to store the capture to.
+ */
+static inline void aosQeiCaptureI(QEIDriver* qei, aos_qeicapture_t* capture)
+{
+  aosQeiCaptureMultipleI(&qei, capture, 1);
+
+  return;
+}
+
+/**
+ * @brief   Captures the extended position of an encoder and the system uptime atomically.
+ *
+ * @param[in]  qei      QEI driver.
+ * @param[out] capture  Pointer to store the capture to.
+ */
+static inline void aosQeiCapture(QEIDriver* qei, aos_qeicapture_t* capture)
+{
+  chSysLock();
+  aosQeiCaptureI(qei, capture);
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Captures the extended position of multiple encoders at the same instant.
+ *
+ * @param[in]  qei      Array of QEI drivers.
+ * @param[out] capture  Array to store the captures to.
+ * @param[in]  n        Number of elements in both arrays.
+ */
+static inline void aosQeiCaptureMultiple(QEIDriver* const qei[], aos_qeicapture_t capture[], size_t n)
+{
+  chSysLock();
+  aosQeiCaptureMultipleI(qei, capture, n);
+  chSysUnlock();
+
+  return;
+}
+
+#endif /* (HAL_USE_QEI == TRUE) && (QEI_USE_EXTENDED_POSITION == TRUE) */
+
+#endif /* _AMIROOS_QEI_H_ */
@@ -0,0 +1,153 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SNAPSHOT_H_
+#define _AMIROOS_SNAPSHOT_H_
+
+#include <aosconf.h>
+#include <hal.h>
+#include <amiro-lld.h>
+#include <aos_time.h>
+
+/**
+ * @brief   Maximum age value to always accept any valid cached data.
+ */
+#define AOS_SNAPSHOT_MAXAGE_ANY       ((aos_interval_t)~0)
+
+/**
+ * @brief   Snapshot read callback type.
+ * @details The callback performs the actual (slow) bus transaction and writes the result to @p dst.
+ *
+ * @param[out] dst    Buffer to write the read data to.
+ * @param[in]  param  Pointer to a custom parameter (e.g. a driver object).
+ *
+ * @return  The status of the bus transaction.
+ */
+typedef apalExitStatus_t (*aos_snapshot_readcb_t)(void* dst, void* param);
+
+/**
+ * @brief   Snapshot structure.
+ * @details A snapshot caches the result of a read operation from a slow device (e.g. via I2C).
+ *          Concurrent readers are serialized by a mutex, so that only the first reader of stale data performs a bus transaction.
+ */
+typedef struct aos_snapshot {
+  /**
+   * @brief   Name of the snapshot.
+   */
+  const char* name;
+
+  /**
+   * @brief   Callback to read the data from the device.
+   */
+  aos_snapshot_readcb_t readcb;
+
+  /**
+   * @brief   Parameter for the read callback.
+   */
+  void* cbparam;
+
+  /**
+   * @brief   Buffer holding the cached data.
+   */
+  void* buffer;
+
+  /**
+   * @brief   Size of the cached data in bytes.
+   */
+  size_t size;
+
+  /**
+   * @brief   Minimum interval between two bus transactions in microseconds.
+   * @details Requests for fresher data are served from the cache nevertheless.
+   */
+  aos_interval_t mininterval;
+
+  /**
+   * @brief   Interval in microseconds, in which the background refresher updates the snapshot.
+   * @details A value of 0 disables background refreshing.
+   */
+  aos_interval_t refresh;
+
+  /**
+   * @brief   Mutex to serialize access to the snapshot.
+   */
+  mutex_t lock;
+
+  /**
+   * @brief   System uptime of the last successful bus transaction.
+   */
+  aos_timestamp_t timestamp;
+
+  /**
+   * @brief   System uptime of the last bus transaction attempt.
+   */
+  aos_timestamp_t lastattempt;
+
+  /**
+   * @brief   Status of the last bus transaction.
+   */
+  apalExitStatus_t status;
+
+  /**
+   * @brief   Flag indicating whether the buffer holds valid data.
+   */
+  bool valid;
+
+#if (AMIROOS_CFG_PROFILE == true) || defined(__DOXYGEN__)
+  /**
+   * @brief   Access statistics.
+   */
+  struct {
+    /**
+     * @brief   Number of reads served from the cache.
+     */
+    uint32_t hits;
+
+    /**
+     * @brief   Number of bus transactions.
+     */
+    uint32_t transactions;
+
+    /**
+     * @brief   Number of failed bus transactions.
+     */
+    uint32_t errors;
+  } stats;
+#endif
+
+  /**
+   * @brief   Pointer to the next snapshot in the list of registered snapshots.
+   */
+  struct aos_snapshot* next;
+} aos_snapshot_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void aosSnapshotInit(aos_snapshot_t* snapshot, const char* name, aos_snapshot_readcb_t readcb, void* cbparam, void* buffer, size_t size, aos_interval_t mininterval, aos_interval_t refresh);
+  apalExitStatus_t aosSnapshotRead(aos_snapshot_t* snapshot, void* dst, aos_interval_t maxage, aos_timestamp_t* timestamp);
+  void aosSnapshotInvalidate(aos_snapshot_t* snapshot);
+  void aosSnapshotRegister(aos_snapshot_t* snapshot);
+  void aosSnapshotRefresherStart(void);
+  void aosSnapshotRefresherStop(void);
+  void aosSnapshotPrintInfo(BaseSequentialStream* stream);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_SNAPSHOT_H_ */
@@ -186,6 +186,11 @@ extern "C" {
   void aosSysStart(void);
   eventmask_t aosSysSsspStartupOsInitSyncCheck(event_listener_t* syncEvtListener);
   void aosSysGetUptimeX(aos_timestamp_t* ut);
+  void aosSysCompensateUptimeX(aos_interval_t offset);
+  uint32_t aosSysGetSyncEdge(aos_timestamp_t* edge);
+#if (AMIROOS_CFG_SSSP_MASTER != true)
+  void aosSysSyncReference(aos_timestamp_t master);
+#endif
   void aosSysGetDateTime(struct tm* dt);
   void aosSysSetDateTime(struct tm* dt);
   void aosSysShutdownInit(aos_shutdown_t shutdown);
@@ -0,0 +1,190 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_TEARDOWN_H_
+#define _AMIROOS_TEARDOWN_H_
+
+#include <aosconf.h>
+#include <hal.h>
+#include <aos_time.h>
+#include <aos_system.h>
+#if defined(HAL_USE_QEI) && (HAL_USE_QEI == TRUE)
+#include <hal_qei.h>
+#endif
+
+/**
+ * @brief   Maximum number of registered teardown tasks.
+ */
+#define AOS_TEARDOWN_MAXTASKS                   32
+
+/**
+ * @brief   Number of teardown phases.
+ */
+#define AOS_TEARDOWN_PHASES                     3
+
+/**
+ * @brief   Phases of the shutdown sequence.
+ * @details The phases are executed one after another, so that the shutdown hooks of the main function keep their
+ *          position. Within a phase all tasks, whose prerequisites are met, may run concurrently.
+ */
+typedef enum aos_teardownphase {
+  AOS_TEARDOWN_SERVICES   = 0,  /**< Module services.                     */
+  AOS_TEARDOWN_SYSTEM     = 1,  /**< System threads.                      */
+  AOS_TEARDOWN_PERIPHERY  = 2,  /**< Periphery communication interfaces.  */
+} aos_teardownphase_t;
+
+/**
+ * @brief   Teardown callback type.
+ *
+ * @param[in] param   Pointer to a custom parameter (e.g. a service object).
+ */
+typedef void (*aos_teardown_cb_t)(void* param);
+
+/**
+ * @brief   Teardown task.
+ * @details A task stops a single service, thread or driver during shutdown.
+ *          Tasks can depend on other tasks of the same or an earlier phase, which must be completed before.
+ */
+typedef struct aos_teardown {
+  /**
+   * @brief   Name of the task.
+   */
+  const char* name;
+
+  /**
+   * @brief   Callback to stop the service, thread or driver.
+   */
+  aos_teardown_cb_t callback;
+
+  /**
+   * @brief   Parameter for the callback.
+   */
+  void* cbparam;
+
+  /**
+   * @brief   Phase, in which the task is executed.
+   */
+  aos_teardownphase_t phase;
+
+  /**
+   * @brief   Estimated duration of the task in microseconds.
+   * @details Among all executable tasks the one with the longest estimated path to the end of its phase is started
+   *          first.
+   */
+  aos_interval_t estimate;
+
+  /**
+   * @brief   Bitmask of the tasks, which must be completed before this task.
+   */
+  uint32_t prerequisites;
+
+  /**
+   * @brief   Estimated duration of the longest path from this task to the end of its phase.
+   */
+  aos_interval_t rank;
+
+  /**
+   * @brief   Measured duration of the task in microseconds.
+   */
+  aos_interval_t duration;
+
+  /**
+   * @brief   Index of the task (assigned on registration).
+   */
+  uint8_t id;
+
+} aos_teardown_t;
+
+/**
+ * @brief   Summary of a shutdown.
+ * @details The summary of the last shutdown is kept in persistent memory, so it can be inspected after the restart.
+ */
+typedef struct aos_teardownreport {
+  /**
+   * @brief   Magic value to detect an uninitialized report.
+   */
+  uint32_t magic;
+
+  /**
+   * @brief   Time from the initialization of the shutdown to the handover to the bootloader in microseconds.
+   */
+  uint32_t total;
+
+  /**
+   * @brief   Duration of each phase in microseconds.
+   */
+  uint32_t phases[AOS_TEARDOWN_PHASES];
+
+  /**
+   * @brief   Sum of the durations of all tasks in microseconds.
+   * @details This is the duration a strictly sequential teardown would have taken.
+   */
+  uint32_t sequential;
+
+  /**
+   * @brief   Type of the shutdown (see aos_shutdown_t).
+   */
+  uint8_t shutdown;
+
+  /**
+   * @brief   Number of executed tasks.
+   */
+  uint8_t tasks;
+
+  /**
+   * @brief   Number of workers (including the calling thread).
+   */
+  uint8_t workers;
+
+  /**
+   * @brief   CRC of the report.
+   */
+  uint8_t crc;
+} aos_teardownreport_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void aosTeardownInit(aos_teardown_t* task, const char* name, aos_teardown_cb_t callback, void* cbparam, aos_teardownphase_t phase, aos_interval_t estimate);
+  void aosTeardownDepends(aos_teardown_t* task, const aos_teardown_t* prerequisite);
+  void aosTeardownRegister(aos_teardown_t* task);
+  void aosTeardownStart(aos_shutdown_t shutdown);
+  void aosTeardownRun(aos_teardownphase_t phase);
+  void aosTeardownFinish(void);
+  void aosTeardownPrintInfo(BaseSequentialStream* stream);
+#if (HAL_USE_ADC == TRUE) || defined(__DOXYGEN__)
+  void aosTeardownAdc(void* driver);
+#endif
+#if (HAL_USE_I2C == TRUE) || defined(__DOXYGEN__)
+  void aosTeardownI2c(void* driver);
+#endif
+#if (HAL_USE_PWM == TRUE) || defined(__DOXYGEN__)
+  void aosTeardownPwm(void* driver);
+#endif
+#if (defined(HAL_USE_QEI) && (HAL_USE_QEI == TRUE)) || defined(__DOXYGEN__)
+  void aosTeardownQei(void* driver);
+#endif
+#if (HAL_USE_SPI == TRUE) || defined(__DOXYGEN__)
+  void aosTeardownSpi(void* driver);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_TEARDOWN_H_ */
@@ -0,0 +1,298 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <aos_boot.h>
+
+#if (AMIROOS_CFG_PROFILE == true) || defined(__DOXYGEN__)
+
+#include <aos_clock.h>
+#include <aos_crc.h>
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <module.h>
+#include <string.h>
+
+/**
+ * @brief   Magic value of a valid boot log.
+ */
+#define BOOT_LOG_MAGIC                0x544F4F42
+
+/**
+ * @brief   Cycles of the core clock per microsecond.
+ */
+#define BOOT_CYCLES_PER_US            (STM32_HCLK / 1000000)
+
+/**
+ * @brief   Width of the event column of the boot table.
+ */
+#define BOOT_INFO_EVENTWIDTH          16
+
+/**
+ * @brief   Section of the persistent boot log.
+ * @details Modules with backup RAM should place the log there.
+ *          By default the log is placed in the part of the RAM, which is not initialized at startup, so it survives
+ *          resets, but no power loss.
+ */
+#if !defined(MODULE_OS_BOOTLOG_SECTION)
+#define MODULE_OS_BOOTLOG_SECTION     ".ram0"
+#endif
+
+/**
+ * @brief   Persistent log of the last boots.
+ */
+typedef struct boot_log {
+  /**
+   * @brief   Magic value to detect an uninitialized log.
+   */
+  uint32_t magic;
+
+  /**
+   * @brief   Sequence number of the latest boot.
+   */
+  uint32_t sequence;
+
+  /**
+   * @brief   Index of the record to be used by the next boot.
+   */
+  uint8_t next;
+
+  /**
+   * @brief   Ring buffer of boot records.
+   */
+  aos_bootrecord_t records[AOS_BOOT_HISTORY];
+} boot_log_t;
+
+/**
+ * @brief   Persistent boot log.
+ */
+static boot_log_t _log __attribute__((section(MODULE_OS_BOOTLOG_SECTION)));
+
+/**
+ * @brief   Boot profiler state.
+ */
+static struct {
+  /**
+   * @brief   Record of the current boot.
+   */
+  aos_bootrecord_t record;
+
+  /**
+   * @brief   Record of the current boot in the persistent log or NULL if the log was not opened yet.
+   */
+  aos_bootrecord_t* persistent;
+
+  /**
+   * @brief   Accumulated cycles since the entry of main().
+   */
+  uint64_t cycles;
+
+  /**
+   * @brief   Cycle counter value of the last event.
+   */
+  uint32_t last;
+
+  /**
+   * @brief   Last recorded SSSP stage.
+   */
+  uint8_t stage;
+} _boot;
+
+/**
+ * @brief   Calculates the CRC of the events of a record.
+ *
+ * @param[in] record  The record.
+ *
+ * @return  The CRC value.
+ */
+static inline uint8_t _recordCrc(const aos_bootrecord_t* record)
+{
+  return aosCrc8((const uint8_t*)record->entries, record->count * sizeof(aos_bootentry_t));
+}
+
+/**
+ * @brief   Prints the events of a record.
+ *
+ * @param[in] stream  The stream to print to.
+ * @param[in] record  The record to print.
+ */
+static void _printRecord(BaseSequentialStream* stream, const aos_bootrecord_t* record)
+{
+  char label[BOOT_INFO_EVENTWIDTH];
+  uint32_t previous = 0;
+
+  chprintf(stream, "boot #%u (%s)\n", record->sequence, record->complete ? "complete" : "incomplete");
+  chprintf(stream, "%-*s%12s%12s\n", BOOT_INFO_EVENTWIDTH, "event", "time [us]", "delta [us]");
+  for (uint8_t e = 0; e < record->count; ++e) {
+    const aos_bootentry_t* entry = &record->entries[e];
+    switch (entry->event) {
+      case AOS_BOOT_MAIN:
+        chsnprintf(label, sizeof(label), "main");
+        break;
+      case AOS_BOOT_HOOK:
+        chsnprintf(label, sizeof(label), "hook %u", entry->value);
+        break;
+      case AOS_BOOT_STAGE:
+        if ((entry->value & 0xF0) == 0x10) {
+          // startup stages are encoded as 0b0001SSss (stage and substage)
+          chsnprintf(label, sizeof(label), "startup %u-%u", ((entry->value >> 2) & 0x03) + 1, (entry->value & 0x03) + 1);
+        } else if (entry->value == AOS_SSSP_OPERATION) {
+          chsnprintf(label, sizeof(label), "operation");
+        } else {
+          chsnprintf(label, sizeof(label), "stage 0x%02X", entry->value);
+        }
+        break;
+      case AOS_BOOT_READY:
+        chsnprintf(label, sizeof(label), "ready");
+        break;
+      default:
+        chsnprintf(label, sizeof(label), "unknown (0x%02X)", entry->event);
+        break;
+    }
+    chprintf(stream, "%-*s%12u%12u\n", BOOT_INFO_EVENTWIDTH, label, entry->time, entry->time - previous);
+    previous = entry->time;
+  }
+  if (record->dropped > 0) {
+    chprintf(stream, "(%u events dropped)\n", record->dropped);
+  }
+
+  return;
+}
+
+/**
+ * @brief   Initializes the boot profiler and records the entry of main().
+ * @details The DWT cycle counter is used as time base, since no other timer is running this early.
+ *          Must be called first thing in main().
+ */
+void aosBootInit(void)
+{
+  // enable and reset the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  memset(&_boot, 0, sizeof(_boot));
+  aosBootMark(AOS_BOOT_MAIN, 0);
+
+  return;
+}
+
+/**
+ * @brief   Opens the persistent boot log and allocates a record for the current boot.
+ * @details The log is validated and reset if it is inconsistent (e.g. after a power loss).
+ *          The oldest record is overwritten and all events recorded so far are copied.
+ *          Must be called after the HAL was initialized, since backup RAM may not be accessible before.
+ */
+void aosBootLogOpen(void)
+{
+  // validate the log
+  if (_log.magic != BOOT_LOG_MAGIC || _log.next >= AOS_BOOT_HISTORY) {
+    memset(&_log, 0, sizeof(_log));
+    _log.magic = BOOT_LOG_MAGIC;
+  }
+  for (uint8_t r = 0; r < AOS_BOOT_HISTORY; ++r) {
+    aos_bootrecord_t* record = &_log.records[r];
+    if (record->count > AOS_BOOT_MAXEVENTS || (record->complete && record->crc != _recordCrc(record))) {
+      memset(record, 0, sizeof(aos_bootrecord_t));
+    }
+  }
+
+  // allocate the oldest record
+  _boot.persistent = &_log.records[_log.next];
+  _log.next = (_log.next + 1) % AOS_BOOT_HISTORY;
+  _boot.record.sequence = ++_log.sequence;
+  *_boot.persistent = _boot.record;
+
+  return;
+}
+
+/**
+ * @brief   Records a boot event.
+ * @details SSSP stages are only recorded on transitions, so this function may be called repeatedly with the same stage.
+ *          Completing the startup seals the record with a CRC.
+ * @note    Must only be called by the main thread during startup.
+ *
+ * @param[in] event   The event to record.
+ * @param[in] value   The hook index or SSSP stage.
+ */
+void aosBootMark(aos_bootevent_t event, uint8_t value)
+{
+  // SSSP stages are only recorded on transitions
+  if (event == AOS_BOOT_STAGE) {
+    if (value == _boot.stage) {
+      return;
+    }
+    _boot.stage = value;
+  }
+
+  // accumulate the cycle counter, so it may overflow between two events (cycles at a reduced core clock are scaled)
+  const uint32_t now = DWT->CYCCNT;
+  _boot.cycles += ((uint64_t)(uint32_t)(now - _boot.last) * STM32_HCLK) / aosClockGetHclkX();
+  _boot.last = now;
+
+  // record the event
+  if (_boot.record.count < AOS_BOOT_MAXEVENTS) {
+    aos_bootentry_t* entry = &_boot.record.entries[_boot.record.count];
+    entry->time = (uint32_t)(_boot.cycles / BOOT_CYCLES_PER_US);
+    entry->event = event;
+    entry->value = value;
+    ++_boot.record.count;
+  } else if (_boot.record.dropped < UINT8_MAX) {
+    ++_boot.record.dropped;
+  }
+  if (event == AOS_BOOT_READY) {
+    _boot.record.complete = true;
+    _boot.record.crc = _recordCrc(&_boot.record);
+  }
+
+  // update the persistent record
+  if (_boot.persistent != NULL) {
+    *_boot.persistent = _boot.record;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Prints the events of the current boot or of all boots in the persistent log.
+ *
+ * @param[in] stream    The stream to print to.
+ * @param[in] history   Flag whether to print the persistent log (oldest boot first).
+ */
+void aosBootPrintInfo(BaseSequentialStream* stream, bool history)
+{
+  aosDbgCheck(stream != NULL);
+
+  if (!history) {
+    _printRecord(stream, &_boot.record);
+  } else if (_boot.persistent == NULL) {
+    chprintf(stream, "boot log not available\n");
+  } else {
+    for (uint8_t r = 0; r < AOS_BOOT_HISTORY; ++r) {
+      const aos_bootrecord_t* record = &_log.records[(_log.next + r) % AOS_BOOT_HISTORY];
+      if (record->sequence != 0) {
+        _printRecord(stream, record);
+      }
+    }
+  }
+
+  return;
+}
+
+#endif /* (AMIROOS_CFG_PROFILE == true) */
@@ -0,0 +1,386 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <aos_clock.h>
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Timer of the system tick driver.
+ * @note    All supported timers are clocked by APB1.
+ */
+#if (STM32_ST_USE_TIMER == 2) || defined(__DOXYGEN__)
+#define CLOCK_ST_TIM                  STM32_TIM2
+#elif (STM32_ST_USE_TIMER == 3)
+#define CLOCK_ST_TIM                  STM32_TIM3
+#elif (STM32_ST_USE_TIMER == 4)
+#define CLOCK_ST_TIM                  STM32_TIM4
+#elif (STM32_ST_USE_TIMER == 5)
+#define CLOCK_ST_TIM                  STM32_TIM5
+#else
+#error "timer of the system tick driver not supported by the clock manager"
+#endif
+
+/**
+ * @brief   Clock manager state.
+ */
+static struct {
+  /**
+   * @brief   List of clock levels, ordered by decreasing core clock.
+   * @details Is NULL as long as the clock manager was not initialized.
+   */
+  const aos_clocklevel_t* levels;
+
+  /**
+   * @brief   Number of clock levels.
+   */
+  uint8_t count;
+
+  /**
+   * @brief   Index of the active clock level.
+   */
+  uint8_t level;
+
+  /**
+   * @brief   Number of holds of the fastest level.
+   */
+  uint16_t holds;
+
+  /**
+   * @brief   List of clock change notifiers.
+   */
+  aos_clocknotifier_t* notifiers;
+
+  /**
+   * @brief   Number of level switches.
+   */
+  uint32_t switches;
+
+  /**
+   * @brief   Uptime when the active level was entered.
+   */
+  aos_timestamp_t since;
+
+  /**
+   * @brief   Accumulated time spent in each level (except the time since the active one was entered).
+   */
+  aos_timestamp_t residency[AOS_CLOCK_MAXLEVELS];
+
+  /**
+   * @brief   Time in nanoseconds, which the system timer lost on switches and was not compensated yet.
+   */
+  uint32_t lost;
+} _clock;
+
+/**
+ * @brief   Converts realtime counter ticks to nanoseconds.
+ *
+ * @param[in] ticks   Realtime counter ticks.
+ * @param[in] hclk    Frequency of the realtime counter in Hz.
+ *
+ * @return  The time in nanoseconds.
+ */
+static inline uint32_t _rtc2ns(const rtcnt_t ticks, const uint32_t hclk)
+{
+  return (uint32_t)(((uint64_t)ticks * 1000000000) / hclk);
+}
+
+/**
+ * @brief   Switches to another clock level and notifies all drivers.
+ * @details If the clock of the system timer changes, its prescaler is reset right after a tick.
+ *          The fraction of the tick, which is lost thereby, is measured by the realtime counter and compensated in the
+ *          uptime, so time accounting stays exact.
+ *
+ * @param[in] level   Index of the new level.
+ */
+static void _switchS(const uint8_t level)
+{
+  const aos_clocklevel_t* const from = &_clock.levels[_clock.level];
+  const aos_clocklevel_t* const to = &_clock.levels[level];
+  aos_timestamp_t uptime;
+
+  aosSysGetUptimeX(&uptime);
+  _clock.residency[_clock.level] += uptime - _clock.since;
+  _clock.since = uptime;
+
+  if (to->timclk1 != from->timclk1) {
+    // wait for a tick, so only a small fraction of the next one is lost
+    const uint32_t cnt = CLOCK_ST_TIM->CNT;
+    while (CLOCK_ST_TIM->CNT == cnt) {
+      continue;
+    }
+    const rtcnt_t tick = chSysGetRealtimeCounterX();
+    RCC->CFGR = (RCC->CFGR & ~AOS_CLOCK_CFGR_MASK) | to->cfgr;
+    const rtcnt_t cfgr = chSysGetRealtimeCounterX();
+    aosClockSetTimerFrequencyX(CLOCK_ST_TIM, to->timclk1, CH_CFG_ST_FREQUENCY);
+    const rtcnt_t reset = chSysGetRealtimeCounterX();
+    // the realtime counter runs at the old core clock until the prescalers were changed
+    _clock.lost += _rtc2ns(cfgr - tick, from->hclk) + _rtc2ns(reset - cfgr, to->hclk);
+    if (_clock.lost >= 1000) {
+      aosSysCompensateUptimeX(_clock.lost / 1000);
+      _clock.lost %= 1000;
+    }
+  } else {
+    RCC->CFGR = (RCC->CFGR & ~AOS_CLOCK_CFGR_MASK) | to->cfgr;
+  }
+  _clock.level = level;
+  ++_clock.switches;
+
+  for (aos_clocknotifier_t* notifier = _clock.notifiers; notifier != NULL; notifier = notifier->next) {
+    notifier->callback(to, notifier->cbparam);
+  }
+
+  return;
+}
+
+/**
+ * @brief   Initializes the clock manager.
+ * @details The system keeps running at the first level, which must match the static clock configuration.
+ *
+ * @param[in] levels  List of clock levels, ordered by decreasing core clock.
+ * @param[in] count   Number of clock levels.
+ */
+void aosClockInit(const aos_clocklevel_t* levels, uint8_t count)
+{
+  aosDbgCheck(levels != NULL);
+  aosDbgCheck(count > 0 && count <= AOS_CLOCK_MAXLEVELS);
+  aosDbgAssert(levels[0].hclk == STM32_HCLK && levels[0].cfgr == (RCC->CFGR & AOS_CLOCK_CFGR_MASK));
+
+  for (uint8_t level = 1; level < count; ++level) {
+    aosDbgAssert(levels[level].hclk < levels[level - 1].hclk);
+    aosDbgAssert((levels[level].cfgr & ~AOS_CLOCK_CFGR_MASK) == 0);
+  }
+
+  memset(&_clock, 0, sizeof(_clock));
+  _clock.levels = levels;
+  _clock.count = count;
+
+  return;
+}
+
+/**
+ * @brief   Registers a notifier, which is called on each clock change.
+ *
+ * @param[in] notifier  The notifier to register.
+ */
+void aosClockRegisterNotifier(aos_clocknotifier_t* notifier)
+{
+  aosDbgCheck(notifier != NULL);
+  aosDbgCheck(notifier->callback != NULL);
+
+  chSysLock();
+  notifier->next = _clock.notifiers;
+  _clock.notifiers = notifier;
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Switches to a clock level.
+ * @details As long as the fastest level is held, the switch is deferred.
+ *
+ * @param[in] level   Index of the level.
+ *
+ * @return  The status of the switch.
+ * @retval  AOS_OK        The level is active.
+ * @retval  AOS_WARNING   The fastest level is held.
+ */
+aos_status_t aosClockSwitch(uint8_t level)
+{
+  aosDbgCheck(_clock.levels != NULL);
+  aosDbgCheck(level < _clock.count);
+
+  aos_status_t status = AOS_OK;
+
+  chSysLock();
+  if (level > 0 && _clock.holds > 0) {
+    level = 0;
+    status = AOS_WARNING;
+  }
+  if (level != _clock.level) {
+    _switchS(level);
+  }
+  chSysUnlock();
+
+  return status;
+}
+
+/**
+ * @brief   Switches to the fastest level and keeps it until released.
+ * @details Code with deadlines, which were dimensioned for the static clock configuration, should hold the fastest
+ *          level while it is active.
+ *          Holds are counted, so the level is released as soon as every hold was released.
+ */
+void aosClockHold(void)
+{
+  chSysLock();
+  aosDbgAssert(_clock.holds < UINT16_MAX);
+  ++_clock.holds;
+  if (_clock.levels != NULL && _clock.level != 0) {
+    _switchS(0);
+  }
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Releases a hold of the fastest level.
+ */
+void aosClockRelease(void)
+{
+  chSysLock();
+  aosDbgAssert(_clock.holds > 0);
+  --_clock.holds;
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Retrieves the index of the active clock level.
+ *
+ * @return  Index of the active level.
+ */
+uint8_t aosClockGetLevelX(void)
+{
+  return _clock.level;
+}
+
+/**
+ * @brief   Retrieves the number of clock levels.
+ *
+ * @return  Number of clock levels or 0 if the clock manager was not initialized.
+ */
+uint8_t aosClockGetNumLevelsX(void)
+{
+  return _clock.count;
+}
+
+/**
+ * @brief   Retrieves the configuration of a clock level.
+ *
+ * @param[in] level   Index of the level.
+ *
+ * @return  The clock level.
+ */
+const aos_clocklevel_t* aosClockGetLevelInfoX(uint8_t level)
+{
+  aosDbgCheck(level < _clock.count);
+
+  return &_clock.levels[level];
+}
+
+/**
+ * @brief   Retrieves the current core clock.
+ * @details This is the frequency of the realtime counter, which must be used instead of @p STM32_HCLK to convert
+ *          its ticks.
+ *
+ * @return  The core clock in Hz.
+ */
+uint32_t aosClockGetHclkX(void)
+{
+  return (_clock.levels != NULL) ? _clock.levels[_clock.level].hclk : STM32_HCLK;
+}
+
+/**
+ * @brief   Sets the tick frequency of a running timer.
+ * @details The prescaler is reloaded immediately without an update interrupt and the counter keeps its value.
+ * @note    Must be called with interrupts disabled.
+ *
+ * @param[in] tim         The timer.
+ * @param[in] timclk      Clock of the timer in Hz.
+ * @param[in] frequency   Tick frequency in Hz.
+ */
+void aosClockSetTimerFrequencyX(stm32_tim_t* tim, uint32_t timclk, uint32_t frequency)
+{
+  aosDbgCheck(tim != NULL);
+  aosDbgCheck(frequency > 0 && timclk % frequency == 0 && timclk / frequency <= 0x10000);
+
+  const uint32_t cr1 = tim->CR1;
+
+  tim->CR1 = cr1 | TIM_CR1_URS;
+  tim->PSC = (timclk / frequency) - 1;
+  const uint32_t cnt = tim->CNT;
+  tim->EGR = TIM_EGR_UG;
+  tim->CNT = cnt;
+  tim->CR1 = cr1;
+
+  return;
+}
+
+/**
+ * @brief   Reapplies the prescalers of the active level.
+ * @details Must be called when the clock tree was reinitialized to the static configuration, e.g. after STOP mode.
+ * @note    Must be called with interrupts disabled.
+ */
+void aosClockReapplyX(void)
+{
+  if (_clock.levels != NULL) {
+    RCC->CFGR = (RCC->CFGR & ~AOS_CLOCK_CFGR_MASK) | _clock.levels[_clock.level].cfgr;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Prints all clock levels and their residency.
+ *
+ * @param[in] stream  Stream to print to.
+ */
+void aosClockPrintInfo(BaseSequentialStream* stream)
+{
+  aosDbgCheck(stream != NULL);
+
+  aos_timestamp_t residency[AOS_CLOCK_MAXLEVELS];
+  aos_timestamp_t uptime;
+  uint32_t switches;
+  uint16_t holds;
+  uint8_t active;
+
+  if (_clock.levels == NULL) {
+    chprintf(stream, "static clock configuration (%uMHz)\n", STM32_HCLK / 1000000);
+    return;
+  }
+
+  chSysLock();
+  aosSysGetUptimeX(&uptime);
+  memcpy(residency, _clock.residency, sizeof(residency));
+  residency[_clock.level] += uptime - _clock.since;
+  switches = _clock.switches;
+  holds = _clock.holds;
+  active = _clock.level;
+  chSysUnlock();
+
+  chprintf(stream, "%-8s%8s%12s%12s%16s%10s\n", "level", "HCLK", "TIMCLK1", "TIMCLK2", "time [ms]", "share");
+  for (uint8_t level = 0; level < _clock.count; ++level) {
+    const uint32_t permille = (uptime > 0) ? (uint32_t)(residency[level] * 1000 / uptime) : 0;
+    chprintf(stream, "%c%-7u%5uMHz%9uMHz%9uMHz%16u%6u.%u %%\n",
+             (level == active) ? '*' : ' ', level,
+             _clock.levels[level].hclk / 1000000, _clock.levels[level].timclk1 / 1000000, _clock.levels[level].timclk2 / 1000000,
+             (uint32_t)(residency[level] / MICROSECONDS_PER_MILLISECOND), permille / 10, permille % 10);
+  }
+  chprintf(stream, "%u switches, %u holds\n", switches, holds);
+
+  return;
+}
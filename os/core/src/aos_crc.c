@@ -0,0 +1,42 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <aos_crc.h>
+
+/**
+ * @brief   Calculates a CRC-8 (polynomial 0x07, initial value 0x00).
+ *
+ * @param[in] data  Data to calculate the checksum of.
+ * @param[in] n     Number of bytes.
+ *
+ * @return  The checksum.
+ */
+uint8_t aosCrc8(const uint8_t* data, size_t n)
+{
+  uint8_t crc = 0x00;
+
+  for (size_t i = 0; i < n; ++i) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+
+  return crc;
+}
@@ -0,0 +1,299 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <aos_idle.h>
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <module.h>
+
+#if (AMIROOS_CFG_IDLE_STOP == true) && !defined(MODULE_OS_IDLE_STOP)
+#error "AMIROOS_CFG_IDLE_STOP requires the module to define MODULE_OS_IDLE_STOP and MODULE_OS_IDLE_STOP_LATENCY"
+#endif
+
+#if (AMIROOS_CFG_IDLE_STOP == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Timer of the system tick driver, which is halted in STOP mode.
+ */
+#if (STM32_ST_USE_TIMER == 2)
+#define IDLE_ST_TIM                   STM32_TIM2
+#elif (STM32_ST_USE_TIMER == 3)
+#define IDLE_ST_TIM                   STM32_TIM3
+#elif (STM32_ST_USE_TIMER == 4)
+#define IDLE_ST_TIM                   STM32_TIM4
+#elif (STM32_ST_USE_TIMER == 5)
+#define IDLE_ST_TIM                   STM32_TIM5
+#else
+#error "timer of the system tick driver not supported by the idle manager"
+#endif
+#endif
+
+/**
+ * @brief   Idle manager state.
+ */
+static struct {
+  /**
+   * @brief   Number of holds per mode.
+   * @details A hold prevents the system from entering the mode or any deeper mode.
+   */
+  uint16_t holds[AOS_IDLE_MODES];
+
+  /**
+   * @brief   Deferral timers per mode.
+   * @details While a timer is armed, the mode and any deeper mode are prevented.
+   *          Expiry also wakes the idle thread, so it reconsiders the mode.
+   */
+  virtual_timer_t defer[AOS_IDLE_MODES];
+
+  /**
+   * @brief   Residency statistics per mode.
+   * @details The statistics of the run mode are not tracked, but derived from the uptime.
+   */
+  aos_idleresidency_t residency[AOS_IDLE_MODES];
+} _idle;
+
+/**
+ * @brief   Names of the idle modes.
+ */
+static const char* const _modenames[AOS_IDLE_MODES] = {
+  "run",
+  "sleep",
+  "stop",
+};
+
+/**
+ * @brief   Callback of the deferral timers.
+ * @details Nothing needs to be done, since the expiry wakes the idle thread anyway.
+ *
+ * @param[in] par   Unused.
+ */
+static void _deferCallback(void* par)
+{
+  (void)par;
+
+  return;
+}
+
+#if (AMIROOS_CFG_IDLE_STOP == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Advances the system time by the time spent in STOP mode.
+ * @details The counter of the system timer is advanced, so virtual timers expire in time.
+ *          Since the compare match would be missed if the counter skipped the next deadline, it is advanced to the
+ *          deadline at most and the remainder is compensated in the uptime.
+ * @note    Must be called with interrupts disabled.
+ *
+ * @param[in] entry     System time when the next deadline was determined.
+ * @param[in] armed     Flag, whether any virtual timer is armed.
+ * @param[in] next      Interval from @p entry to the next deadline.
+ * @param[in] duration  Time spent in STOP mode in microseconds.
+ */
+static void _advanceSystemTimeX(const systime_t entry, const bool armed, const sysinterval_t next, const aos_interval_t duration)
+{
+  const sysinterval_t elapsed = chTimeDiffX(entry, chVTGetSystemTimeX());
+  sysinterval_t ticks = TIME_US2I(duration);
+
+  if (armed) {
+    const sysinterval_t limit = (next > elapsed + 1) ? (next - elapsed - 1) : 0;
+    if (ticks > limit) {
+      ticks = limit;
+    }
+  }
+  IDLE_ST_TIM->CNT += ticks;
+
+  if (duration > TIME_I2US(ticks)) {
+    aosSysCompensateUptimeX(duration - TIME_I2US(ticks));
+  }
+
+  return;
+}
+#endif
+
+/**
+ * @brief   Prevents the system from entering an idle mode or any deeper mode.
+ * @details Holds are counted, so the mode is allowed again as soon as every hold was released.
+ *
+ * @param[in] mode  The shallowest mode to prevent.
+ */
+void aosIdleHold(aos_idlemode_t mode)
+{
+  aosDbgCheck(mode > AOS_IDLE_RUN && mode < AOS_IDLE_MODES);
+
+  chSysLock();
+  aosDbgAssert(_idle.holds[mode] < UINT16_MAX);
+  ++_idle.holds[mode];
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Releases a hold of an idle mode.
+ *
+ * @param[in] mode  The mode, which was passed to aosIdleHold().
+ */
+void aosIdleRelease(aos_idlemode_t mode)
+{
+  aosDbgCheck(mode > AOS_IDLE_RUN && mode < AOS_IDLE_MODES);
+
+  chSysLock();
+  aosDbgAssert(_idle.holds[mode] > 0);
+  --_idle.holds[mode];
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Prevents the system from entering an idle mode or any deeper mode for some time.
+ * @details In contrast to a hold, no release is required. Each call restarts the interval, so it can be used to
+ *          detect quiet periods of bursty activity.
+ *
+ * @param[in] mode      The shallowest mode to prevent.
+ * @param[in] interval  Time in microseconds, during which the mode is prevented.
+ */
+void aosIdleDeferI(aos_idlemode_t mode, aos_interval_t interval)
+{
+  aosDbgCheck(mode > AOS_IDLE_RUN && mode < AOS_IDLE_MODES);
+
+  chVTSetI(&_idle.defer[mode], (TIME_US2I(interval) > 0) ? TIME_US2I(interval) : 1, _deferCallback, NULL);
+
+  return;
+}
+
+/**
+ * @brief   Puts the system into the deepest allowed low-power mode until the next interrupt.
+ * @details The next deadline of all virtual timers (including all AMiRo-OS timers) determines, whether STOP mode is
+ *          worth its wakeup latency.
+ *          Interrupts are disabled via PRIMASK while the mode is active, so they still terminate it, but are served
+ *          only after the clocks were restored and the system time was compensated.
+ * @note    This function is called by the idle loop hook of the kernel and must not be called by any other thread.
+ */
+void aosIdleLoop(void)
+{
+  aos_idlemode_t mode;
+  sysinterval_t next = 0;
+  systime_t entry;
+  aos_interval_t duration;
+
+  chSysLock();
+  const bool armed = chVTGetTimersStateI(&next);
+  (void)armed;
+  mode = (_idle.holds[AOS_IDLE_SLEEP] == 0 && !chVTIsArmedI(&_idle.defer[AOS_IDLE_SLEEP])) ? AOS_IDLE_SLEEP : AOS_IDLE_RUN;
+#if (AMIROOS_CFG_IDLE_STOP == true)
+  if (mode == AOS_IDLE_SLEEP && _idle.holds[AOS_IDLE_STOP] == 0 && !chVTIsArmedI(&_idle.defer[AOS_IDLE_STOP]) &&
+      (!armed || TIME_I2US(next) >= MODULE_OS_IDLE_STOP_LATENCY + AMIROOS_CFG_IDLE_STOP_MINIMUM)) {
+    mode = AOS_IDLE_STOP;
+  }
+#endif
+  if (mode == AOS_IDLE_RUN) {
+    chSysUnlock();
+    return;
+  }
+  __disable_irq();
+  chSysUnlock();
+  entry = chVTGetSystemTimeX();
+
+#if (AMIROOS_CFG_IDLE_STOP == true)
+  if (mode == AOS_IDLE_STOP) {
+    // wake up early enough to restore the clocks before the deadline
+    duration = MODULE_OS_IDLE_STOP(armed ? (TIME_I2US(next) - MODULE_OS_IDLE_STOP_LATENCY) : ~(aos_interval_t)0);
+    _advanceSystemTimeX(entry, armed, next, duration);
+  } else
+#endif
+  {
+    __WFI();
+    duration = TIME_I2US(chTimeDiffX(entry, chVTGetSystemTimeX()));
+  }
+
+  ++_idle.residency[mode].entries;
+  _idle.residency[mode].time += duration;
+  __enable_irq();
+
+  return;
+}
+
+/**
+ * @brief   Retrieves the total time spent in any idle mode.
+ * @details Together with the uptime this yields the load of the core.
+ * @note    Must be called with interrupts disabled, unless the caller is a thread, which the idle thread cannot
+ *          preempt.
+ *
+ * @param[out] time   Accumulated time of all idle modes in microseconds.
+ */
+void aosIdleGetTimeX(aos_timestamp_t* time)
+{
+  aosDbgCheck(time != NULL);
+
+  *time = 0;
+  for (uint8_t mode = AOS_IDLE_SLEEP; mode < AOS_IDLE_MODES; ++mode) {
+    *time += _idle.residency[mode].time;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Prints the residency of all idle modes and the current holds.
+ *
+ * @param[in] stream  Stream to print to.
+ */
+void aosIdlePrintInfo(BaseSequentialStream* stream)
+{
+  aosDbgCheck(stream != NULL);
+
+  aos_idleresidency_t residency[AOS_IDLE_MODES];
+  uint16_t holds[AOS_IDLE_MODES];
+  aos_timestamp_t uptime;
+
+  chSysLock();
+  aosSysGetUptimeX(&uptime);
+  for (uint8_t mode = 0; mode < AOS_IDLE_MODES; ++mode) {
+    residency[mode] = _idle.residency[mode];
+    holds[mode] = _idle.holds[mode];
+  }
+  chSysUnlock();
+
+  // the core runs whenever it is in no other mode
+  residency[AOS_IDLE_RUN].time = uptime;
+  for (uint8_t mode = AOS_IDLE_SLEEP; mode < AOS_IDLE_MODES; ++mode) {
+    residency[AOS_IDLE_RUN].time -= (residency[mode].time < residency[AOS_IDLE_RUN].time) ? residency[mode].time : residency[AOS_IDLE_RUN].time;
+  }
+
+  chprintf(stream, "%-12s%12s%16s%10s%8s\n", "mode", "entries", "time [ms]", "share", "holds");
+  for (uint8_t mode = 0; mode < AOS_IDLE_MODES; ++mode) {
+    const uint32_t permille = (uptime > 0) ? (uint32_t)(residency[mode].time * 1000 / uptime) : 0;
+    chprintf(stream, "%-12s", _modenames[mode]);
+    if (mode == AOS_IDLE_RUN) {
+      chprintf(stream, "%12s", "-");
+    } else {
+      chprintf(stream, "%12u", residency[mode].entries);
+    }
+    chprintf(stream, "%16u%6u.%u %%", (uint32_t)(residency[mode].time / MICROSECONDS_PER_MILLISECOND), permille / 10, permille % 10);
+    if (mode == AOS_IDLE_RUN) {
+      chprintf(stream, "%8s\n", "-");
+    } else {
+      chprintf(stream, "%8u\n", holds[mode]);
+    }
+  }
+#if (AMIROOS_CFG_IDLE_STOP != true)
+  chprintf(stream, "stop mode is disabled\n");
+#endif
+
+  return;
+}
@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <amiroos.h>
 #include <module.h>
+#include <aos_canmsg.hpp>
 
 /*
  * hook to add further includes
@@ -71,6 +72,155 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #define CALENDERSYNC_CANMSGID                   0x004
 
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true) || defined(__DOXYGEN__)
+
+#if !defined(UID_BASE)
+#error "the fast SSSP enumeration requires the unique device ID of the MCU (UID_BASE)"
+#endif
+
+/**
+ * @brief   CAN message identifier for the offer of the fast enumeration by the SSSP master.
+ * @details The message carries the major and minor SSSP version and the version of the fast enumeration.
+ */
+#define SSSP_STACKINIT_CANMSGID_OFFER           0x005
+
+/**
+ * @brief   CAN message identifier for the completed census of the fast enumeration.
+ * @details The message is transmitted by the last module of the stack, when all modules below support the offer.
+ */
+#define SSSP_STACKINIT_CANMSGID_CENSUS          0x006
+
+/**
+ * @brief   CAN message identifier for the confirmation of the fast enumeration by the SSSP master.
+ */
+#define SSSP_STACKINIT_CANMSGID_GO              0x007
+
+/**
+ * @brief   CAN message identifier for the number of modules, which claimed an ID during the fast enumeration.
+ */
+#define SSSP_STACKINIT_CANMSGID_COMMIT          0x008
+
+/**
+ * @brief   Version of the fast enumeration, which must match for all modules.
+ */
+#define SSSP_FASTENUM_VERSION                   1
+
+/**
+ * @brief   Time (in microseconds) the SSSP master waits for the census to complete.
+ * @details Must be considerably shorter than the SSSP timeout, so the sequential initialization can still be initiated.
+ */
+#define SSSP_FASTENUM_NEGOTIATIONWINDOW         (2 * AMIROOS_CFG_SSSP_SIGNALDELAY)
+
+/**
+ * @brief   Time (in microseconds) to collect the claims of all modules.
+ * @details A claim occupies the bus for about 160 bit times, so at 1 Mbit/s the window suffices for more than ten
+ *          modules.
+ */
+#define SSSP_FASTENUM_CLAIMWINDOW               (2 * AMIROOS_CFG_SSSP_SIGNALDELAY)
+
+#endif /* (AMIROOS_CFG_SSSP_FASTENUMERATION == true) */
+
+/**
+ * @brief   Module ID field of the SSSP stack initialization sequence.
+ */
+typedef amiroos::CanField<0, 4, uint32_t> SsspModuleIdField;
+
+/**
+ * @brief   Initialization message of the SSSP stack initialization sequence.
+ */
+typedef amiroos::CanMessage<SSSP_STACKINIT_CANMSGID_INIT, 0> SsspInitMessage;
+
+/**
+ * @brief   Module ID message of the SSSP stack initialization sequence.
+ */
+typedef amiroos::CanMessage<SSSP_STACKINIT_CANMSGID_MODULEID, 4, SsspModuleIdField> SsspModuleIdMessage;
+
+/**
+ * @brief   Abortion message of the SSSP stack initialization sequence.
+ */
+typedef amiroos::CanMessage<SSSP_STACKINIT_CANMSGID_ABORT, 0> SsspAbortMessage;
+
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true) || defined(__DOXYGEN__)
+
+/**
+ * @brief   SSSP major version field of the fast enumeration offer.
+ */
+typedef amiroos::CanField<0, 1, uint8_t> SsspOfferMajorField;
+
+/**
+ * @brief   SSSP minor version field of the fast enumeration offer.
+ */
+typedef amiroos::CanField<1, 1, uint8_t> SsspOfferMinorField;
+
+/**
+ * @brief   Fast enumeration version field of the fast enumeration offer.
+ */
+typedef amiroos::CanField<2, 1, uint8_t> SsspOfferVersionField;
+
+/**
+ * @brief   Offer message of the fast enumeration.
+ */
+typedef amiroos::CanMessage<SSSP_STACKINIT_CANMSGID_OFFER, 3, SsspOfferMajorField, SsspOfferMinorField, SsspOfferVersionField> SsspOfferMessage;
+
+/**
+ * @brief   Census message of the fast enumeration.
+ */
+typedef amiroos::CanMessage<SSSP_STACKINIT_CANMSGID_CENSUS, 0> SsspCensusMessage;
+
+/**
+ * @brief   Confirmation message of the fast enumeration.
+ */
+typedef amiroos::CanMessage<SSSP_STACKINIT_CANMSGID_GO, 0> SsspGoMessage;
+
+/**
+ * @brief   Number of claims field of the fast enumeration commit.
+ */
+typedef amiroos::CanField<0, 2, uint16_t> SsspCommitClaimsField;
+
+/**
+ * @brief   Commit message of the fast enumeration.
+ */
+typedef amiroos::CanMessage<SSSP_STACKINIT_CANMSGID_COMMIT, 2, SsspCommitClaimsField> SsspCommitMessage;
+
+#endif /* (AMIROOS_CFG_SSSP_FASTENUMERATION == true) */
+
+/**
+ * @brief   Encoded date/time field of the calendar synchronization.
+ */
+typedef amiroos::CanField<0, 8, uint64_t> CalendarSyncField;
+
+/**
+ * @brief   Calendar synchronization message.
+ */
+typedef amiroos::CanMessage<CALENDERSYNC_CANMSGID, 8, CalendarSyncField> CalendarSyncMessage;
+
+/**
+ * @brief   Encoding of a TM value in the calendar synchronization message.
+ *
+ * @details Contents of the TM struct are mapped as follows:
+ *            bits  |63     62|61      53|52    50|49         26|25     22|21     17|16     12|11      6|5       0|
+ *            #bits |       2 |        9 |      3 |          24 |       4 |       5 |       5 |       6 |       6 |
+ *            value |   isdst |     yday |   wday |        year |     mon |    mday |    hour |     min |     sec |
+ *            range | special | [0, 365] | [0, 6] | [1900, ...] | [0, 11] | [1, 31] | [0, 23] | [0, 59] | [0, 61] |
+ *          The Daylight Saving Time Flag (isdsst) is encoded as follows:
+ *            DST not in effect         -> 0
+ *            DST in effect             -> 1
+ *            no information available  -> 2
+ */
+namespace calendar {
+  typedef amiroos::CanBitField<0, 6, int> Sec;
+  typedef amiroos::CanBitField<6, 6, int> Min;
+  typedef amiroos::CanBitField<12, 5, int> Hour;
+  typedef amiroos::CanBitField<17, 5, int> Mday;
+  typedef amiroos::CanBitField<22, 4, int> Mon;
+  typedef amiroos::CanBitField<26, 24, int> Year;
+  typedef amiroos::CanBitField<50, 3, int> Wday;
+  typedef amiroos::CanBitField<53, 9, int> Yday;
+  typedef amiroos::CanBitField<62, 2, int> Isdst;
+  typedef amiroos::CanWord<Sec, Min, Hour, Mday, Mon, Year, Wday, Yday, Isdst> Word;
+  static_assert(Word::size <= CalendarSyncField::size, "calendar encoding exceeds the message");
+}
+
 /**
  * @brief   Listener object for I/O events.
  */
@@ -95,6 +245,17 @@ static AosShellChannel _stdshellchannel;
 #endif
 #endif
 
+/**
+ * @brief   Timing of the SSSP module stack initialization sequence (startup stage 3).
+ */
+static struct {
+  aos_timestamp_t start;        /**< Uptime when stage 3 was entered.                 */
+  aos_timestamp_t negotiated;   /**< Uptime when the enumeration mode was determined. */
+  aos_timestamp_t enumerated;   /**< Uptime when the module ID was assigned.          */
+  aos_timestamp_t finished;     /**< Uptime when stage 3 was completed.               */
+  bool fast;                    /**< Flag whether the fast enumeration was used.      */
+} _ssspTiming;
+
 /*
  * hook to add further static variables
  */
@@ -135,82 +296,27 @@ static void _ssspTimerCallback(void* par)
   return;
 }
 
-/**
- * @brief   Helper function to serialize data.
- *
- * @param[out]  dst   Pointer to the output buffer.
- * @param[in]   src   Data to be serialized.
- * @param[in]   n     Number of bytes to serialize.
- */
-inline void _serialize(uint8_t* dst, const uint64_t src, const uint8_t n)
-{
-  aosDbgCheck(dst != NULL);
-  aosDbgCheck(n > 0 && n <= 8);
-
-  for (uint8_t byte = 0; byte < n; ++byte) {
-    dst[byte] = (uint8_t)((src >> (byte * 8)) & 0xFF);
-  }
-
-  return;
-}
-
-/**
- * @brief   Helper function to deserialize data.
- *
- * @param[in] src   Pointer to the buffer of data to be deserialzed.
- * @param[in] n     Number of bytes to deserialize.
- *
- * @return    The deserialized 32 bit data.
- */
-inline uint64_t _deserialize(uint8_t* src, const uint8_t n)
-{
-  aosDbgCheck(src != NULL);
-  aosDbgCheck(n > 0 && n <= 8);
-
-  uint64_t result = 0;
-  for (uint8_t byte = 0; byte < n; ++byte) {
-    result |= ((uint64_t)src[byte]) << (byte * 8);
-  }
-
-  return result;
-}
-
 /**
  * @brief   Converter function to encode a TM value to a single unsigned 64 bit integer.
  *
- * @details Contents of the TM struct are mapped as follows:
- *            bits  |63     62|61      53|52    50|49         26|25     22|21     17|16     12|11      6|5       0|
- *            #bits |       2 |        9 |      3 |          24 |       4 |       5 |       5 |       6 |       6 |
- *            value |   isdst |     yday |   wday |        year |     mon |    mday |    hour |     min |     sec |
- *            range | special | [0, 365] | [0, 6] | [1900, ...] | [0, 11] | [1, 31] | [0, 23] | [0, 59] | [0, 61] |
- *          The Daylight Saving Time Flag (isdsst) is encoded as follows:
- *            DST not in effect         -> 0
- *            DST in effect             -> 1
- *            no information available  -> 2
+ * @details For information on the encoding, please refer to the @p calendar namespace.
  *
  * @param[in] src   Pointer to the TM struct to encode.
  *
  * @return  An unsigned 64 bit integer, which holds the encoded time value.
  */
-inline uint64_t _TM2U64(struct tm* src)
+inline uint64_t _TM2U64(const struct tm* src)
 {
   aosDbgCheck(src != NULL);
 
-  return (((uint64_t)(src->tm_sec  & 0x0000003F) << (0))               |
-          ((uint64_t)(src->tm_min  & 0x0000003F) << (6))               |
-          ((uint64_t)(src->tm_hour & 0x0000001F) << (12))              |
-          ((uint64_t)(src->tm_mday & 0x0000001F) << (17))              |
-          ((uint64_t)(src->tm_mon  & 0x0000000F) << (22))              |
-          ((uint64_t)(src->tm_year & 0x00FFFFFF) << (26))              |
-          ((uint64_t)(src->tm_wday & 0x00000007) << (50))              |
-          ((uint64_t)(src->tm_yday & 0x000001FF) << (53))              |
-          ((uint64_t)((src->tm_isdst == 0) ? 0 : (src->tm_isdst > 0) ? 1 : 2) << (62)));
+  return calendar::Word::encode(src->tm_sec, src->tm_min, src->tm_hour, src->tm_mday, src->tm_mon, src->tm_year,
+                                src->tm_wday, src->tm_yday, (src->tm_isdst == 0) ? 0 : (src->tm_isdst > 0) ? 1 : 2);
 }
 
 /**
  * @brief   Converter functiomn to retrieve the encoded TM value from an unsigned 64 bit integer.
  *
- * @details For information on the encoding, please refer to @p _TM2U64 function.
+ * @details For information on the encoding, please refer to the @p calendar namespace.
  *
  * @param[out] dst  The TM struct to fill with the decoded values.
  * @param[in]  src  Unsigned 64 bit integer holding the encoded TM value.
@@ -219,21 +325,47 @@ inline void _U642TM(struct tm* dst, const uint64_t src)
 {
   aosDbgCheck(dst != NULL);
 
-  dst->tm_sec  = (src >> 0)  & 0x0000003F;
-  dst->tm_min  = (src >> 6)  & 0x0000003F;
-  dst->tm_hour = (src >> 12) & 0x0000001F;
-  dst->tm_mday = (src >> 17) & 0x0000001F;
-  dst->tm_mon  = (src >> 22) & 0x0000000F;
-  dst->tm_year = (src >> 26) & 0x00FFFFFF;
-  dst->tm_wday = (src >> 50) & 0x00000007;
-  dst->tm_yday = (src >> 53) & 0x000001FF;
-  dst->tm_isdst = (((src >> 62) & 0x03) == 0) ? 0 : (((src >> 62) & 0x03) > 0) ? 1 : -1;
+  dst->tm_sec  = calendar::Sec::decode(src);
+  dst->tm_min  = calendar::Min::decode(src);
+  dst->tm_hour = calendar::Hour::decode(src);
+  dst->tm_mday = calendar::Mday::decode(src);
+  dst->tm_mon  = calendar::Mon::decode(src);
+  dst->tm_year = calendar::Year::decode(src);
+  dst->tm_wday = calendar::Wday::decode(src);
+  dst->tm_yday = calendar::Yday::decode(src);
+  dst->tm_isdst = (calendar::Isdst::decode(src) == 0) ? 0 : (calendar::Isdst::decode(src) == 1) ? 1 : -1;
 
   return;
 }
 
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Derives the claim of the fast enumeration from the unique device ID of the MCU.
+ * @details The 96 bit device ID is hashed (FNV-1a) and folded to the 29 bit of an extended CAN identifier.
+ *          Since lower identifiers win the bus arbitration, the claims of all modules are serialized by the bus itself.
+ *
+ * @return  The 29 bit claim.
+ */
+static uint32_t _ssspClaim(void)
+{
+  uint32_t hash = 2166136261u;
+  for (uint8_t byte = 0; byte < 12; ++byte) {
+    hash ^= ((const uint8_t*)UID_BASE)[byte];
+    hash *= 16777619u;
+  }
+
+  return (hash >> 29) ^ (hash & 0x1FFFFFFF);
+}
+#endif
+
 /**
  * @brief   Implementation of the SSSP module stack initialization sequence (startup phase 3).
+ * @details If the fast enumeration is enabled, the SSSP master offers it before initiating the sequence.
+ *          The offer is passed along the stack via the UP/DN signals by all modules, which support it, and the last
+ *          module reports the completed census via CAN.
+ *          All modules then claim an ID at once, using a CAN identifier derived from their unique device ID, and count
+ *          the claims which won the arbitration before their own.
+ *          If the census does not complete in time, the master initiates the sequential initialization instead.
  *
  * @return Shutdown value.
  * @retval AOS_SHUTDOWN_NONE      No shutdown signal received
@@ -248,6 +380,8 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
   typedef enum {
     STAGE_3_1,                  /**< Initiation of SSSP startup stage 3. */
     STAGE_3_2,                  /**< Starting the sequence and broadcasting the first ID. */
+    STAGE_3_2_CLAIM,            /**< Collecting the claims of the fast enumeration. */
+    STAGE_3_3_WAITFORCOMMIT,    /**< Waiting for the number of claims to be confirmed by the master. */
     STAGE_3_3_WAITFORFIRSTID,   /**< Waiting for first ID after initiation. */
     STAGE_3_3_WAITFORIDORSIG,   /**< Waiting for next ID or activation of neighbor signal. */
     STAGE_3_3_WAITFORID,        /**< Waiting for next ID (after the module has set its own ID). */
@@ -260,6 +394,11 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
     bool loop     : 1;
     bool wfe      : 1;
     bool wfe_next : 1;
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+    bool negotiating  : 1;
+    bool forwarded    : 1;
+    bool fast         : 1;
+#endif
   } flags_t;
 
   // local variables
@@ -280,6 +419,12 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
   aos_ssspmoduleid_t lastid = 0;
 #endif
   flags_t flags;
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+  const uint32_t claim = _ssspClaim();
+  aos_ssspmoduleid_t claims = 0;
+  aos_ssspmoduleid_t lower = 0;
+  aos_ssspmoduleid_t committed = 0;
+#endif
 
   // initialize local varibles
   chEvtObjectInit(&eventSourceTimeout);
@@ -291,10 +436,17 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
   flags.loop = true;
   flags.wfe = false; // do not wait for events in the initial iteration of the FSM loop
   flags.wfe_next = true;
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+  flags.negotiating = false;
+  flags.forwarded = false;
+  flags.fast = false;
+#endif
 
   // initialize system variables
   aos.sssp.stage = AOS_SSSP_STARTUP_3_1;
   aos.sssp.moduleId = 0;
+  aosSysGetUptime(&_ssspTiming.start);
+  aosBootMark(AOS_BOOT_STAGE, aos.sssp.stage);
 
   // listen to events (timout, delay, CAN receive)
   chEvtRegisterMask(&eventSourceTimeout, &eventListenerTimeout, TIMEOUTEVENT_MASK);
@@ -338,6 +490,12 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
       case STAGE_3_2:
         aosDbgPrintf(">>> 3-2\n");
         break;
+      case STAGE_3_2_CLAIM:
+        aosDbgPrintf(">>> 3-2 (claim)\n");
+        break;
+      case STAGE_3_3_WAITFORCOMMIT:
+        aosDbgPrintf(">>> 3-3 (commit)\n");
+        break;
       case STAGE_3_3_WAITFORFIRSTID:
         aosDbgPrintf(">>> 3-3 (1st ID)\n");
         break;
@@ -436,12 +594,22 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
         aosDbgPrintf("CAN <- 0x%03X\n", canRxFrame.SID);
       }
       // identify and handle abort messgaes
-      if (canRxFrame.SID == SSSP_STACKINIT_CANMSGID_ABORT) {
+      if (canRxFrame.IDE == CAN_IDE_STD && canRxFrame.SID == SSSP_STACKINIT_CANMSGID_ABORT) {
         stage = STAGE_3_4_ABORT;
       }
       // warn if a unexpected message was received
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+      else if ((canRxFrame.IDE == CAN_IDE_STD) &&
+               (canRxFrame.SID != SSSP_STACKINIT_CANMSGID_INIT) &&
+               (canRxFrame.SID != SSSP_STACKINIT_CANMSGID_MODULEID) &&
+               (canRxFrame.SID != SSSP_STACKINIT_CANMSGID_OFFER) &&
+               (canRxFrame.SID != SSSP_STACKINIT_CANMSGID_CENSUS) &&
+               (canRxFrame.SID != SSSP_STACKINIT_CANMSGID_GO) &&
+               (canRxFrame.SID != SSSP_STACKINIT_CANMSGID_COMMIT)) {
+#else
       else if ((canRxFrame.SID != SSSP_STACKINIT_CANMSGID_INIT) &&
                (canRxFrame.SID != SSSP_STACKINIT_CANMSGID_MODULEID)) {
+#endif
         aosDbgPrintf("WARN: unknown msg\n");
       }
       // any further pending messages are fetched at the end of the loop
@@ -462,30 +630,32 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
       case STAGE_3_1:
       {
         aos.sssp.stage = AOS_SSSP_STARTUP_3_1;
+#if (AMIROOS_CFG_SSSP_MASTER == true)
+        bool initiate = false;
+#endif
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+        bool go = false;
+#endif
 
         // there was no event at all (skipped wfe)
         if (eventmask == 0 && flags.wfe == false) {
 #if (AMIROOS_CFG_SSSP_MASTER == true)
-          // initialize the stage by transmitting an according CAN message
-          aosDbgPrintf("CAN -> init\n");
-          canTxFrame.DLC = 0;
-          canTxFrame.SID = SSSP_STACKINIT_CANMSGID_INIT;
-          if (canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_IMMEDIATE) != MSG_OK) {
-            chEvtBroadcast(&eventSourceTimeout);
-            break;
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+          // offer the fast enumeration by transmitting an according CAN message
+          aosDbgPrintf("CAN -> offer\n");
+          SsspOfferMessage::prepare(&canTxFrame);
+          SsspOfferMessage::pack<SsspOfferMajorField>(canTxFrame.data8, AOS_SYSTEM_SSSP_VERSION_MAJOR);
+          SsspOfferMessage::pack<SsspOfferMinorField>(canTxFrame.data8, AOS_SYSTEM_SSSP_VERSION_MINOR);
+          SsspOfferMessage::pack<SsspOfferVersionField>(canTxFrame.data8, SSSP_FASTENUM_VERSION);
+          if (canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_IMMEDIATE) == MSG_OK) {
+            flags.negotiating = true;
+            // set the delay timer to fall back to the sequential initialization
+            chVTSet(&timerDelay, TIME_US2I(SSSP_FASTENUM_NEGOTIATIONWINDOW), _ssspTimerCallback, &eventSourceDelay);
+          } else {
+            initiate = true;
           }
-          // activate S
-          aosDbgPrintf("S+\n");
-          apalControlGpioSet(&moduleSsspGpioSync, APAL_GPIO_ON);
-#if (AMIROOS_CFG_SSSP_STACK_START == true)
-          // proceed immediately
-          stage = STAGE_3_2;
-          flags.wfe_next = false;
 #else
-          // set the timeout timer
-          chVTSet(&timerTimeout, TIME_US2I(AOS_SYSTEM_SSSP_TIMEOUT), _ssspTimerCallback, &eventSourceTimeout);
-          // proceed
-          stage = STAGE_3_3_WAITFORFIRSTID;
+          initiate = true;
 #endif
 #else
           // set the timeout timer
@@ -493,15 +663,20 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
 #endif
         }
 
-#if (AMIROOS_CFG_SSSP_MASTER != true)
         // a CAN message was received
         else if (eventmask & eventListenerCan.events) {
+#if (AMIROOS_CFG_SSSP_MASTER != true)
           // if an initiation message was received
-          if (canRxFrame.DLC == 0 &&
-              canRxFrame.RTR == CAN_RTR_DATA &&
-              canRxFrame.IDE == CAN_IDE_STD &&
-              canRxFrame.SID == SSSP_STACKINIT_CANMSGID_INIT) {
+          if (SsspInitMessage::match(&canRxFrame)) {
             aosDbgPrintf("init msg\n");
+            aosSysGetUptime(&_ssspTiming.negotiated);
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+            flags.negotiating = false;
+#if (AMIROOS_CFG_SSSP_STACK_END != true)
+            // withdraw the census (if any)
+            apalControlGpioSet(&moduleSsspGpioUp, APAL_GPIO_OFF);
+#endif
+#endif
             // reset the timeout timer and clear pending flags
             chVTReset(&timerTimeout);
             chEvtWaitAnyTimeout(eventListenerTimeout.events, TIME_IMMEDIATE);
@@ -520,6 +695,155 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
             stage = STAGE_3_3_WAITFORFIRSTID;
 #endif
           }
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+          // if the fast enumeration was offered
+          else if (SsspOfferMessage::match(&canRxFrame)) {
+            // only participate if the versions match, so the census will not complete otherwise
+            if (SsspOfferMessage::unpack<SsspOfferMajorField>(canRxFrame.data8) == AOS_SYSTEM_SSSP_VERSION_MAJOR &&
+                SsspOfferMessage::unpack<SsspOfferVersionField>(canRxFrame.data8) == SSSP_FASTENUM_VERSION) {
+              aosDbgPrintf("offer msg\n");
+              flags.negotiating = true;
+            } else {
+              aosDbgPrintf("WARN: incompatible offer (%u.%u/%u)\n",
+                           SsspOfferMessage::unpack<SsspOfferMajorField>(canRxFrame.data8),
+                           SsspOfferMessage::unpack<SsspOfferMinorField>(canRxFrame.data8),
+                           SsspOfferMessage::unpack<SsspOfferVersionField>(canRxFrame.data8));
+            }
+          }
+          // if the fast enumeration was confirmed
+          else if (flags.negotiating &&
+                   SsspGoMessage::match(&canRxFrame)) {
+            aosDbgPrintf("go msg\n");
+            go = true;
+          }
+#endif
+#elif (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+          // if the census completed
+          if (flags.negotiating &&
+              SsspCensusMessage::match(&canRxFrame)) {
+            aosDbgPrintf("census msg\n");
+            go = true;
+          }
+#endif
+        }
+
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+        // forward the census as soon as all modules below support the offer
+        if (flags.negotiating && !flags.forwarded) {
+          apalControlGpioState_t dnstate = APAL_GPIO_ON;
+#if (AMIROOS_CFG_SSSP_STACK_START != true)
+          apalControlGpioGet(&moduleSsspGpioDn, &dnstate);
+#endif
+          if (dnstate == APAL_GPIO_ON) {
+            flags.forwarded = true;
+#if (AMIROOS_CFG_SSSP_STACK_END == true)
+#if (AMIROOS_CFG_SSSP_MASTER == true)
+            go = true;
+#else
+            aosDbgPrintf("CAN -> census\n");
+            SsspCensusMessage::prepare(&canTxFrame);
+            canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_IMMEDIATE);
+#endif
+#else
+            aosDbgPrintf("UP+\n");
+            apalControlGpioSet(&moduleSsspGpioUp, APAL_GPIO_ON);
+#endif
+          }
+        }
+
+#if (AMIROOS_CFG_SSSP_MASTER == true)
+        // if the census did not complete in time
+        if (flags.negotiating && !go && (eventmask & eventListenerDelay.events)) {
+          aosDbgPrintf("census incomplete\n");
+          initiate = true;
+        }
+#endif
+
+        // if the fast enumeration was confirmed
+        if (go) {
+          // reset the timers and clear pending flags
+          chVTReset(&timerDelay);
+          chVTReset(&timerTimeout);
+          chEvtWaitAnyTimeout(eventListenerDelay.events | eventListenerTimeout.events, TIME_IMMEDIATE);
+          eventmask &= ~(eventListenerDelay.events | eventListenerTimeout.events);
+#if (AMIROOS_CFG_SSSP_MASTER == true)
+          // confirm the fast enumeration to all modules
+          aosDbgPrintf("CAN -> go\n");
+          SsspGoMessage::prepare(&canTxFrame);
+          if (canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_IMMEDIATE) != MSG_OK) {
+            chEvtBroadcast(&eventSourceTimeout);
+            break;
+          }
+#endif
+          aosSysGetUptime(&_ssspTiming.negotiated);
+          _ssspTiming.fast = true;
+          flags.negotiating = false;
+          flags.fast = true;
+#if (AMIROOS_CFG_SSSP_STACK_END != true)
+          // withdraw the census
+          aosDbgPrintf("UP-\n");
+          apalControlGpioSet(&moduleSsspGpioUp, APAL_GPIO_OFF);
+#endif
+          // activate S
+          aosDbgPrintf("S+\n");
+          apalControlGpioSet(&moduleSsspGpioSync, APAL_GPIO_ON);
+          // claim an ID (the payload only serves to tell equal claims apart on the bus)
+          aosDbgPrintf("CAN -> claim (0x%08X)\n", claim);
+          canTxFrame.IDE = CAN_IDE_EXT;
+          canTxFrame.EID = claim;
+          canTxFrame.DLC = 8;
+          for (uint8_t byte = 0; byte < 8; ++byte) {
+            canTxFrame.data8[byte] = ((const uint8_t*)UID_BASE)[byte];
+          }
+          const msg_t status = canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_IMMEDIATE);
+          canTxFrame.IDE = CAN_IDE_STD;
+          if (status != MSG_OK) {
+            chEvtBroadcast(&eventSourceTimeout);
+            break;
+          }
+          // set the delay timer to close the claims and the timeout timer
+          chVTSet(&timerDelay, TIME_US2I(SSSP_FASTENUM_CLAIMWINDOW), _ssspTimerCallback, &eventSourceDelay);
+          chVTSet(&timerTimeout, TIME_US2I(AOS_SYSTEM_SSSP_TIMEOUT), _ssspTimerCallback, &eventSourceTimeout);
+          // proceed
+          stage = STAGE_3_2_CLAIM;
+        }
+#endif
+
+#if (AMIROOS_CFG_SSSP_MASTER == true)
+        // initiate the sequential initialization
+        if (initiate) {
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+          // stop the negotiation and clear pending flags
+          flags.negotiating = false;
+          chVTReset(&timerDelay);
+          chEvtWaitAnyTimeout(eventListenerDelay.events, TIME_IMMEDIATE);
+          eventmask &= ~(eventListenerDelay.events);
+#if (AMIROOS_CFG_SSSP_STACK_END != true)
+          // withdraw the census (if any)
+          apalControlGpioSet(&moduleSsspGpioUp, APAL_GPIO_OFF);
+#endif
+#endif
+          aosSysGetUptime(&_ssspTiming.negotiated);
+          // initialize the stage by transmitting an according CAN message
+          aosDbgPrintf("CAN -> init\n");
+          SsspInitMessage::prepare(&canTxFrame);
+          if (canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_IMMEDIATE) != MSG_OK) {
+            chEvtBroadcast(&eventSourceTimeout);
+            break;
+          }
+          // activate S
+          aosDbgPrintf("S+\n");
+          apalControlGpioSet(&moduleSsspGpioSync, APAL_GPIO_ON);
+#if (AMIROOS_CFG_SSSP_STACK_START == true)
+          // proceed immediately
+          stage = STAGE_3_2;
+          flags.wfe_next = false;
+#else
+          // set the timeout timer
+          chVTSet(&timerTimeout, TIME_US2I(AOS_SYSTEM_SSSP_TIMEOUT), _ssspTimerCallback, &eventSourceTimeout);
+          // proceed
+          stage = STAGE_3_3_WAITFORFIRSTID;
+#endif
         }
 #endif
 
@@ -535,11 +859,11 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
         if (flags.wfe == false) {
           // set the module ID
           aos.sssp.moduleId = 1;
+          aosSysGetUptime(&_ssspTiming.enumerated);
           // broadcast module ID
           aosDbgPrintf("CAN -> ID (%u)\n", aos.sssp.moduleId);
-          canTxFrame.DLC = 4;
-          canTxFrame.SID = SSSP_STACKINIT_CANMSGID_MODULEID;
-          _serialize(canTxFrame.data8, aos.sssp.moduleId, 4);
+          SsspModuleIdMessage::prepare(&canTxFrame);
+          SsspModuleIdMessage::pack<SsspModuleIdField>(canTxFrame.data8, aos.sssp.moduleId);
           if (canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_IMMEDIATE) != MSG_OK) {
             chEvtBroadcast(&eventSourceTimeout);
             break;
@@ -579,6 +903,107 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
         break;
       } /* end of STAGE_3_2 */
 
+      case STAGE_3_2_CLAIM:
+      {
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+        aos.sssp.stage = AOS_SSSP_STARTUP_3_2;
+
+        // a CAN message was received
+        if (eventmask & eventListenerCan.events) {
+          // if a claim was received
+          if (canRxFrame.DLC == 8 &&
+              canRxFrame.RTR == CAN_RTR_DATA &&
+              canRxFrame.IDE == CAN_IDE_EXT) {
+            aosDbgPrintf("claim (0x%08X)\n", canRxFrame.EID);
+            // equal claims can not be told apart
+            if (canRxFrame.EID == claim) {
+              aosDbgPrintf("ERR: claim collision\n");
+              // abort
+              stage = STAGE_3_4_ABORT_ACTIVE;
+              flags.wfe_next = false;
+              break;
+            }
+            // count all claims and those which won the arbitration
+            ++claims;
+            if (canRxFrame.EID < claim) {
+              ++lower;
+            }
+          }
+#if (AMIROOS_CFG_SSSP_MASTER != true)
+          // if the master closed the claims already
+          else if (SsspCommitMessage::match(&canRxFrame)) {
+            committed = SsspCommitMessage::unpack<SsspCommitClaimsField>(canRxFrame.data8);
+          }
+#endif
+        }
+
+        // if the claims are closed
+        if ((eventmask & eventListenerDelay.events) || (committed != 0)) {
+          // reset the delay timer and clear pending flags
+          chVTReset(&timerDelay);
+          chEvtWaitAnyTimeout(eventListenerDelay.events, TIME_IMMEDIATE);
+          eventmask &= ~(eventListenerDelay.events);
+          // the ID is given by the number of claims which won the arbitration
+          aos.sssp.moduleId = lower + 1;
+          aosDbgPrintf("ID (%u/%u)\n", aos.sssp.moduleId, claims + 1);
+#if (AMIROOS_CFG_SSSP_MASTER == true)
+          // broadcast the number of claims
+          aosDbgPrintf("CAN -> commit (%u)\n", claims + 1);
+          SsspCommitMessage::prepare(&canTxFrame);
+          SsspCommitMessage::pack<SsspCommitClaimsField>(canTxFrame.data8, claims + 1);
+          if (canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_IMMEDIATE) != MSG_OK) {
+            chEvtBroadcast(&eventSourceTimeout);
+            break;
+          }
+          committed = claims + 1;
+#endif
+          // proceed (immediately if the commit is known already)
+          stage = STAGE_3_3_WAITFORCOMMIT;
+          flags.wfe_next = (committed == 0);
+        }
+#endif
+
+        break;
+      } /* end of STAGE_3_2_CLAIM */
+
+      case STAGE_3_3_WAITFORCOMMIT:
+      {
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+        aos.sssp.stage = AOS_SSSP_STARTUP_3_3;
+
+#if (AMIROOS_CFG_SSSP_MASTER != true)
+        // if the number of claims was received
+        if ((eventmask & eventListenerCan.events) &&
+            SsspCommitMessage::match(&canRxFrame)) {
+          committed = SsspCommitMessage::unpack<SsspCommitClaimsField>(canRxFrame.data8);
+        }
+#endif
+
+        if (committed != 0) {
+          // all modules must have seen the same claims
+          if (committed == claims + 1) {
+            aosSysGetUptime(&_ssspTiming.enumerated);
+            // deactivate S
+            aosDbgPrintf("S-\n");
+            apalControlGpioSet(&moduleSsspGpioSync, APAL_GPIO_OFF);
+            // restart the timeout timer and clear pending flags
+            chVTSet(&timerTimeout, TIME_US2I(AOS_SYSTEM_SSSP_TIMEOUT), _ssspTimerCallback, &eventSourceTimeout);
+            chEvtWaitAnyTimeout(eventListenerTimeout.events, TIME_IMMEDIATE);
+            eventmask &= ~(eventListenerTimeout.events);
+            // proceed and wait for all modules to deactivate S
+            stage = STAGE_3_3_WAITFORID;
+          } else {
+            aosDbgPrintf("ERR: invalid number of claims (%u/%u)\n", claims + 1, committed);
+            // abort
+            stage = STAGE_3_4_ABORT_ACTIVE;
+            flags.wfe_next = false;
+          }
+        }
+#endif
+
+        break;
+      } /* end of STAGE_3_3_WAITFORCOMMIT */
+
       case STAGE_3_3_WAITFORFIRSTID:
       {
 #if (AMIROOS_CFG_SSSP_STACK_START != true)
@@ -587,15 +1012,12 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
         // a CAN message was received
         if (eventmask & eventListenerCan.events) {
           // if an ID message was received
-          if (canRxFrame.DLC == 4 &&
-              canRxFrame.RTR == CAN_RTR_DATA &&
-              canRxFrame.IDE == CAN_IDE_STD &&
-              canRxFrame.SID == SSSP_STACKINIT_CANMSGID_MODULEID) {
-            aosDbgPrintf("ID (%u)\n", (uint32_t)_deserialize(canRxFrame.data8, 4));
+          if (SsspModuleIdMessage::match(&canRxFrame)) {
+            aosDbgPrintf("ID (%u)\n", SsspModuleIdMessage::unpack<SsspModuleIdField>(canRxFrame.data8));
             // validate received ID
-            if (lastid < _deserialize(canRxFrame.data8, 4)) {
+            if (lastid < SsspModuleIdMessage::unpack<SsspModuleIdField>(canRxFrame.data8)) {
               // store received ID
-              lastid = _deserialize(canRxFrame.data8, 4);
+              lastid = SsspModuleIdMessage::unpack<SsspModuleIdField>(canRxFrame.data8);
               // restart timeout timer
               chVTSet(&timerTimeout, TIME_US2I(AOS_SYSTEM_SSSP_TIMEOUT), _ssspTimerCallback, &eventSourceTimeout);
               // proceed
@@ -623,15 +1045,12 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
         // a CAN message was received
         if (eventmask & eventListenerCan.events) {
           // if an ID message was received
-          if (canRxFrame.DLC == 4 &&
-              canRxFrame.RTR == CAN_RTR_DATA &&
-              canRxFrame.IDE == CAN_IDE_STD &&
-              canRxFrame.SID == SSSP_STACKINIT_CANMSGID_MODULEID) {
-            aosDbgPrintf("ID (%u)\n", (uint32_t)_deserialize(canRxFrame.data8, 4));
+          if (SsspModuleIdMessage::match(&canRxFrame)) {
+            aosDbgPrintf("ID (%u)\n", SsspModuleIdMessage::unpack<SsspModuleIdField>(canRxFrame.data8));
             // validate received ID
-            if (lastid < _deserialize(canRxFrame.data8, 4)) {
+            if (lastid < SsspModuleIdMessage::unpack<SsspModuleIdField>(canRxFrame.data8)) {
               // store received ID
-              lastid = _deserialize(canRxFrame.data8, 4);
+              lastid = SsspModuleIdMessage::unpack<SsspModuleIdField>(canRxFrame.data8);
               // restart timeout timer
               chVTSet(&timerTimeout, TIME_US2I(AOS_SYSTEM_SSSP_TIMEOUT), _ssspTimerCallback, &eventSourceTimeout);
             } else {
@@ -655,10 +1074,10 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
           eventmask &= ~(eventListenerTimeout.events);
           // increment and broadcast ID
           aos.sssp.moduleId = lastid + 1;
+          aosSysGetUptime(&_ssspTiming.enumerated);
           aosDbgPrintf("CAN -> ID (%u)\n", aos.sssp.moduleId);
-          canTxFrame.DLC = 4;
-          canTxFrame.SID = SSSP_STACKINIT_CANMSGID_MODULEID;
-          _serialize(canTxFrame.data8, aos.sssp.moduleId, 4);
+          SsspModuleIdMessage::prepare(&canTxFrame);
+          SsspModuleIdMessage::pack<SsspModuleIdField>(canTxFrame.data8, aos.sssp.moduleId);
           if (canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_IMMEDIATE) != MSG_OK) {
             chEvtBroadcast(&eventSourceTimeout);
             break;
@@ -697,13 +1116,10 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
         // a CAN message was received
         if (eventmask & eventListenerCan.events) {
           // if an ID message was received
-          if (canRxFrame.DLC == 4 &&
-              canRxFrame.RTR == CAN_RTR_DATA &&
-              canRxFrame.IDE == CAN_IDE_STD &&
-              canRxFrame.SID == SSSP_STACKINIT_CANMSGID_MODULEID) {
+          if (SsspModuleIdMessage::match(&canRxFrame)) {
 #if (AMIROOS_CFG_SSSP_STACK_START != true) || (AMIROOS_CFG_DBG == true)
             // Plausibility of the received ID is not checked at this point but is done by other modules still in a previous stage.
-            lastid = _deserialize(canRxFrame.data8, 4);
+            lastid = SsspModuleIdMessage::unpack<SsspModuleIdField>(canRxFrame.data8);
             aosDbgPrintf("ID (%u)\n", lastid);
 #endif
             // restart timeout timer
@@ -728,13 +1144,18 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
           chEvtWaitAnyTimeout(eventListenerTimeout.events, TIME_IMMEDIATE);
           eventmask &= ~(eventListenerTimeout.events);
           //set the delay timer
+#if (AMIROOS_CFG_SSSP_FASTENUMERATION == true)
+          // the fast enumeration was confirmed by all modules already, so a short grace period for aborts suffices
+          chVTSet(&timerDelay, TIME_US2I(flags.fast ? AMIROOS_CFG_SSSP_SIGNALDELAY : AOS_SYSTEM_SSSP_TIMEOUT), _ssspTimerCallback, &eventSourceDelay);
+#else
           chVTSet(&timerDelay, TIME_US2I(AOS_SYSTEM_SSSP_TIMEOUT), _ssspTimerCallback, &eventSourceDelay);
+#endif
         }
 
         // if a CAN event was received
         if (eventmask & eventListenerCan.events) {
           // if an abort message was received
-          if (canRxFrame.SID == SSSP_STACKINIT_CANMSGID_ABORT) {
+          if (canRxFrame.IDE == CAN_IDE_STD && canRxFrame.SID == SSSP_STACKINIT_CANMSGID_ABORT) {
             aosDbgPrintf("abort msg\n");
             // reset the delay timer
             chVTReset(&timerDelay);
@@ -760,8 +1181,7 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
         aos.sssp.stage = AOS_SSSP_STARTUP_3_4;
 
         // emit abort message
-        canTxFrame.DLC = 0;
-        canTxFrame.SID = SSSP_STACKINIT_CANMSGID_ABORT;
+        SsspAbortMessage::prepare(&canTxFrame);
         canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canTxFrame, TIME_INFINITE);
         aosDbgPrintf("CAN -> abort\n");
         // clear timeout flag
@@ -793,6 +1213,9 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
       } /* end of STAGE_3_4_ABORT */
     }
 
+    // record stage transitions
+    aosBootMark(AOS_BOOT_STAGE, aos.sssp.stage);
+
     // fetch pending CAN message (if any)
     if ((eventmask & eventListenerCan.events) && (canReceiveTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &canRxFrame, TIME_IMMEDIATE) == MSG_OK)) {
       aosDbgPrintf("CAN <- 0x%03X\n", canRxFrame.SID);
@@ -811,6 +1234,7 @@ aos_shutdown_t _ssspModuleStackInitialization(void)
     flags.wfe = flags.wfe_next;
   }
   aosDbgPrintf("\n");
+  aosSysGetUptime(&_ssspTiming.finished);
 
   // unregister all events (timeout, delay, CAN receive)
   chEvtUnregister(&eventSourceTimeout, &eventListenerTimeout);
@@ -847,6 +1271,10 @@ int main(void)
    * ##########################################################################
    */
 
+  // boot profiler (must be first)
+  aosBootInit();
+
+  aosBootMark(AOS_BOOT_HOOK, 0);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_0)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_0_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_0(AMIROOS_CFG_MAIN_INIT_HOOK_0_ARGS);
@@ -861,7 +1289,10 @@ int main(void)
 #ifdef MODULE_INIT_HAL_EXTRA
   MODULE_INIT_HAL_EXTRA();
 #endif
+  // persistent boot log (requires the HAL for backup RAM)
+  aosBootLogOpen();
 
+  aosBootMark(AOS_BOOT_HOOK, 1);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_1)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_1_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_1(AMIROOS_CFG_MAIN_INIT_HOOK_1_ARGS);
@@ -876,6 +1307,7 @@ int main(void)
   MODULE_INIT_KERNEL_EXTRA();
 #endif
 
+  aosBootMark(AOS_BOOT_HOOK, 2);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_2)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_2_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_2(AMIROOS_CFG_MAIN_INIT_HOOK_2_ARGS);
@@ -894,6 +1326,7 @@ int main(void)
   MODULE_INIT_OS_EXTRA();
 #endif
 
+  aosBootMark(AOS_BOOT_HOOK, 3);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_3)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_3_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_3(AMIROOS_CFG_MAIN_INIT_HOOK_3_ARGS);
@@ -910,6 +1343,7 @@ int main(void)
 #endif
 #endif
 
+  aosBootMark(AOS_BOOT_HOOK, 4);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_4)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_4_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_4(AMIROOS_CFG_MAIN_INIT_HOOK_4_ARGS);
@@ -922,6 +1356,7 @@ int main(void)
   chEvtRegisterMask(&aos.events.io, &_eventListenerIO, IOEVENT_MASK);
   chEvtRegisterMask(&aos.events.os, &_eventListenerOS, OSEVENT_MASK);
 
+  aosBootMark(AOS_BOOT_HOOK, 5);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_5)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_5_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_5(AMIROOS_CFG_MAIN_INIT_HOOK_5_ARGS);
@@ -933,6 +1368,8 @@ int main(void)
   /* periphery communication initialization */
   // CAN (mandatory)
   canStart(&MODULE_HAL_CAN, &moduleHalCanConfig);
+  // frames would be lost while the CAN clock is halted, so STOP mode is prevented until the SSSP startup has completed
+  aosIdleHold(AOS_IDLE_STOP);
   // module specific initialization (if any)
 #ifdef MODULE_INIT_PERIPHERY_COMM
   MODULE_INIT_PERIPHERY_COMM();
@@ -950,6 +1387,7 @@ int main(void)
 #endif
 #endif
 
+  aosBootMark(AOS_BOOT_HOOK, 6);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_6)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_6_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_6(AMIROOS_CFG_MAIN_INIT_HOOK_6_ARGS);
@@ -975,6 +1413,7 @@ int main(void)
   aosprintf("######################################################################\n");
   aosprintf("\n");
 
+  aosBootMark(AOS_BOOT_HOOK, 7);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_7)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_7_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_7(AMIROOS_CFG_MAIN_INIT_HOOK_7_ARGS);
@@ -1034,10 +1473,7 @@ int main(void)
     struct tm t;
     uint64_t encoded;
 
-    frame.DLC = 8;
-    frame.RTR = CAN_RTR_DATA;
-    frame.IDE = CAN_IDE_STD;
-    frame.SID = CALENDERSYNC_CANMSGID;
+    CalendarSyncMessage::prepare(&frame);
 
     aosDbgPrintf("transmitting current date/time...\t");
     // get current date & time
@@ -1045,7 +1481,7 @@ int main(void)
     // encode
     encoded = _TM2U64(&t);
     // serialize
-    _serialize(frame.data8, encoded, 8);
+    CalendarSyncMessage::pack<CalendarSyncField>(frame.data8, encoded);
     // transmit
     canTransmitTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &frame, TIME_IMMEDIATE);
 
@@ -1059,12 +1495,9 @@ int main(void)
     // receive message
     if (canReceiveTimeout(&MODULE_HAL_CAN, CAN_ANY_MAILBOX, &frame, TIME_US2I(AOS_SYSTEM_SSSP_TIMEOUT)) == MSG_OK) {
       // validate message
-      if (frame.DLC == 8 &&
-          frame.RTR == CAN_RTR_DATA &&
-          frame.IDE == CAN_IDE_STD &&
-          frame.SID == CALENDERSYNC_CANMSGID) {
+      if (CalendarSyncMessage::match(&frame)) {
         // deserialize
-        encoded = _deserialize(frame.data8, 8);
+        encoded = CalendarSyncMessage::unpack<CalendarSyncField>(frame.data8);
         // decode
         _U642TM(&t, encoded);
         // set current date & time
@@ -1080,6 +1513,26 @@ int main(void)
     aosDbgPrintf("\n");
   }
 
+  // afterwards CAN traffic prevents STOP mode only for a while (see AMIROOS_CFG_IDLE_STOP_CANQUIET)
+  aosIdleRelease(AOS_IDLE_STOP);
+
+  /* report the latency of the SSSP startup (not before, since printing may block) */
+  if (shutdown == AOS_SHUTDOWN_NONE) {
+    aosprintf("SSSP startup: stage 3 entered after %uus, ", (uint32_t)_ssspTiming.start);
+    if (aos.sssp.moduleId != 0) {
+      aosprintf("took %uus (%s: %uus negotiation, %uus enumeration, %uus completion) -> ID %u\n",
+                (uint32_t)(_ssspTiming.finished - _ssspTiming.start),
+                _ssspTiming.fast ? "fast" : "sequential",
+                (uint32_t)(_ssspTiming.negotiated - _ssspTiming.start),
+                (uint32_t)(_ssspTiming.enumerated - _ssspTiming.negotiated),
+                (uint32_t)(_ssspTiming.finished - _ssspTiming.enumerated),
+                aos.sssp.moduleId);
+    } else {
+      aosprintf("aborted after %uus\n", (uint32_t)(_ssspTiming.finished - _ssspTiming.start));
+    }
+  }
+
+  aosBootMark(AOS_BOOT_HOOK, 8);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_8)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_8_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_8(AMIROOS_CFG_MAIN_INIT_HOOK_8_ARGS);
@@ -1091,8 +1544,12 @@ int main(void)
   /* completely start AMiRo-OS */
   if (shutdown == AOS_SHUTDOWN_NONE) {
     aosSysStart();
+#ifdef MODULE_INIT_SERVICES
+    MODULE_INIT_SERVICES();
+#endif
   }
 
+  aosBootMark(AOS_BOOT_HOOK, 9);
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_9)
 #if defined(AMIROOS_CFG_MAIN_INIT_HOOK_9_ARGS)
   AMIROOS_CFG_MAIN_INIT_HOOK_9(AMIROOS_CFG_MAIN_INIT_HOOK_9_ARGS);
@@ -1101,6 +1558,8 @@ int main(void)
 #endif
 #endif
 
+  aosBootMark(AOS_BOOT_READY, 0);
+
   /*
    * ##########################################################################
    * # infinite loop                                                          #
@@ -1205,6 +1664,12 @@ int main(void)
 #endif
 #endif
 
+  // stop module services (if any)
+#ifdef MODULE_SHUTDOWN_SERVICES
+  MODULE_SHUTDOWN_SERVICES();
+#endif
+  aosTeardownRun(AOS_TEARDOWN_SERVICES);
+
   // stop system threads
   aosSysStop();
 
@@ -1233,6 +1698,7 @@ int main(void)
 #ifdef MODULE_SHUTDOWN_PERIPHERY_COMM
   MODULE_SHUTDOWN_PERIPHERY_COMM();
 #endif
+  aosTeardownRun(AOS_TEARDOWN_PERIPHERY);
 
 #if defined(AMIROOS_CFG_MAIN_SHUTDOWN_HOOK_4)
 #if defined(AMIROOS_CFG_MAIN_SHUTDOWN_HOOK_4_ARGS)
@@ -0,0 +1,325 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <aos_snapshot.h>
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <aos_thread.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Event mask to wake up the refresher thread.
+ */
+#define SNAPSHOT_REFRESHER_WAKEUP_EVENTMASK   EVENT_MASK(0)
+
+/**
+ * @brief   Refresher thread working area.
+ */
+static THD_WORKING_AREA(_refresher_wa, AMIROOS_CFG_SNAPSHOT_STACKSIZE);
+
+/**
+ * @brief   Pointer to the refresher thread.
+ */
+static thread_t* _refresher = NULL;
+
+/**
+ * @brief   List of registered snapshots.
+ */
+static aos_snapshot_t* _snapshots = NULL;
+
+/**
+ * @brief   Performs the actual bus transaction and updates the snapshot.
+ * @note    The snapshot must be locked by the calling thread.
+ *
+ * @param[in] snapshot  The snapshot to update.
+ * @param[in] uptime    Current system uptime.
+ *
+ * @return  The status of the bus transaction.
+ */
+static apalExitStatus_t _update(aos_snapshot_t* snapshot, aos_timestamp_t uptime)
+{
+  snapshot->status = snapshot->readcb(snapshot->buffer, snapshot->cbparam);
+  snapshot->lastattempt = uptime;
+#if (AMIROOS_CFG_PROFILE == true)
+  ++snapshot->stats.transactions;
+#endif
+  if (snapshot->status == APAL_STATUS_SUCCESS) {
+    snapshot->timestamp = uptime;
+    snapshot->valid = true;
+  } else {
+#if (AMIROOS_CFG_PROFILE == true)
+    ++snapshot->stats.errors;
+#endif
+  }
+
+  return snapshot->status;
+}
+
+/**
+ * @brief   Background thread to keep hot snapshots up to date.
+ *
+ * @param[in] arg   Unused.
+ */
+static THD_FUNCTION(_snapshotRefresherThread, arg)
+{
+  (void)arg;
+
+  aos_timestamp_t uptime;
+  aos_timestamp_t next;
+  aos_timestamp_t due;
+
+  chRegSetThreadName("snapshot");
+
+  while (!chThdShouldTerminateX()) {
+    aosSysGetUptime(&uptime);
+    next = uptime + AOS_THD_MAX_SLEEP_US;
+
+    // refresh all snapshots that are due
+    for (aos_snapshot_t* snapshot = _snapshots; snapshot != NULL; snapshot = snapshot->next) {
+      if (snapshot->refresh == 0) {
+        continue;
+      }
+      chMtxLock(&snapshot->lock);
+      due = snapshot->lastattempt + snapshot->refresh;
+      if (!snapshot->valid || due <= uptime) {
+        _update(snapshot, uptime);
+        due = uptime + snapshot->refresh;
+      }
+      chMtxUnlock(&snapshot->lock);
+      if (due < next) {
+        next = due;
+      }
+    }
+
+    // sleep until the next snapshot is due or the thread is woken up
+    aosSysGetUptime(&uptime);
+    if (next > uptime) {
+      chEvtWaitAnyTimeout(SNAPSHOT_REFRESHER_WAKEUP_EVENTMASK, TIME_US2I(next - uptime));
+    }
+  }
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes a snapshot object.
+ *
+ * @param[in] snapshot      The snapshot to initialize.
+ * @param[in] name          Name of the snapshot.
+ * @param[in] readcb        Callback to read the data from the device.
+ * @param[in] cbparam       Parameter for the read callback.
+ * @param[in] buffer        Buffer to hold the cached data.
+ * @param[in] size          Size of the buffer in bytes.
+ * @param[in] mininterval   Minimum interval between two bus transactions in microseconds.
+ * @param[in] refresh       Background refresh interval in microseconds (0 to disable).
+ */
+void aosSnapshotInit(aos_snapshot_t* snapshot, const char* name, aos_snapshot_readcb_t readcb, void* cbparam, void* buffer, size_t size, aos_interval_t mininterval, aos_interval_t refresh)
+{
+  aosDbgCheck(snapshot != NULL);
+  aosDbgCheck(readcb != NULL);
+  aosDbgCheck(buffer != NULL);
+  aosDbgCheck(size > 0);
+  aosDbgCheck(refresh == 0 || refresh >= mininterval);
+
+  snapshot->name = name;
+  snapshot->readcb = readcb;
+  snapshot->cbparam = cbparam;
+  snapshot->buffer = buffer;
+  snapshot->size = size;
+  snapshot->mininterval = mininterval;
+  snapshot->refresh = refresh;
+  chMtxObjectInit(&snapshot->lock);
+  snapshot->timestamp = 0;
+  snapshot->lastattempt = 0;
+  snapshot->status = APAL_STATUS_SUCCESS;
+  snapshot->valid = false;
+#if (AMIROOS_CFG_PROFILE == true)
+  snapshot->stats.hits = 0;
+  snapshot->stats.transactions = 0;
+  snapshot->stats.errors = 0;
+#endif
+  snapshot->next = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Reads data from a snapshot.
+ * @details If the cached data is not older than @p maxage, it is returned without any bus transaction.
+ *          Otherwise the data is read from the device, unless the last bus transaction was less than @p mininterval ago.
+ *          Since the snapshot is locked during the bus transaction, concurrent readers will wait and receive the fresh data.
+ *
+ * @param[in]  snapshot   The snapshot to read.
+ * @param[out] dst        Buffer to copy the data to (may be NULL).
+ * @param[in]  maxage     Maximum acceptable age of the data in microseconds.
+ * @param[out] timestamp  System uptime when the returned data was read from the device (may be NULL).
+ *
+ * @return  The status of the operation.
+ * @retval APAL_STATUS_SUCCESS  Valid data was copied to @p dst.
+ * @retval others               Error status of the last bus transaction. @p dst was not modified.
+ */
+apalExitStatus_t aosSnapshotRead(aos_snapshot_t* snapshot, void* dst, aos_interval_t maxage, aos_timestamp_t* timestamp)
+{
+  aosDbgCheck(snapshot != NULL);
+
+  // local variables
+  aos_timestamp_t uptime;
+  apalExitStatus_t status;
+
+  chMtxLock(&snapshot->lock);
+
+  aosSysGetUptime(&uptime);
+  // serve from cache if the data is fresh enough or the device must not be accessed yet
+  if (snapshot->valid &&
+      ((uptime - snapshot->timestamp <= maxage) || (uptime - snapshot->lastattempt < snapshot->mininterval))) {
+#if (AMIROOS_CFG_PROFILE == true)
+    ++snapshot->stats.hits;
+#endif
+    status = APAL_STATUS_SUCCESS;
+  }
+  // the last (failed) attempt was too recent
+  else if (snapshot->lastattempt != 0 && uptime - snapshot->lastattempt < snapshot->mininterval) {
+    status = snapshot->status;
+  }
+  // read from device
+  else {
+    status = _update(snapshot, uptime);
+  }
+
+  if (status == APAL_STATUS_SUCCESS) {
+    if (dst != NULL) {
+      memcpy(dst, snapshot->buffer, snapshot->size);
+    }
+    if (timestamp != NULL) {
+      *timestamp = snapshot->timestamp;
+    }
+  }
+
+  chMtxUnlock(&snapshot->lock);
+
+  return status;
+}
+
+/**
+ * @brief   Invalidates the cached data of a snapshot.
+ * @details This should be called whenever the device was written to, so the next read will access the device.
+ *
+ * @param[in] snapshot  The snapshot to invalidate.
+ */
+void aosSnapshotInvalidate(aos_snapshot_t* snapshot)
+{
+  aosDbgCheck(snapshot != NULL);
+
+  chMtxLock(&snapshot->lock);
+  snapshot->valid = false;
+  snapshot->lastattempt = 0;
+  chMtxUnlock(&snapshot->lock);
+
+  return;
+}
+
+/**
+ * @brief   Registers a snapshot to the system.
+ * @details Registered snapshots are listed by the shell and updated by the background refresher (if @p refresh is set).
+ *
+ * @param[in] snapshot  The snapshot to register.
+ */
+void aosSnapshotRegister(aos_snapshot_t* snapshot)
+{
+  aosDbgCheck(snapshot != NULL);
+  aosDbgCheck(snapshot->next == NULL);
+
+  // append to the list
+  aos_snapshot_t** curr = &_snapshots;
+  chSysLock();
+  while (*curr != NULL) {
+    curr = &((*curr)->next);
+  }
+  *curr = snapshot;
+  chSysUnlock();
+
+  // wake up the refresher so it considers the new snapshot
+  if (_refresher != NULL) {
+    chEvtSignal(_refresher, SNAPSHOT_REFRESHER_WAKEUP_EVENTMASK);
+  }
+
+  return;
+}
+
+/**
+ * @brief   Starts the background refresher thread.
+ */
+void aosSnapshotRefresherStart(void)
+{
+  aosDbgAssert(_refresher == NULL);
+
+  _refresher = chThdCreateStatic(_refresher_wa, sizeof(_refresher_wa), AMIROOS_CFG_SNAPSHOT_THREADPRIO, _snapshotRefresherThread, NULL);
+
+  return;
+}
+
+/**
+ * @brief   Stops the background refresher thread.
+ */
+void aosSnapshotRefresherStop(void)
+{
+  if (_refresher != NULL) {
+    chThdTerminate(_refresher);
+    chEvtSignal(_refresher, SNAPSHOT_REFRESHER_WAKEUP_EVENTMASK);
+    chThdWait(_refresher);
+    _refresher = NULL;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Prints information about all registered snapshots.
+ *
+ * @param[in] stream  Stream to print to.
+ */
+void aosSnapshotPrintInfo(BaseSequentialStream* stream)
+{
+  aosDbgCheck(stream != NULL);
+
+  aos_timestamp_t uptime;
+
+  aosSysGetUptime(&uptime);
+#if (AMIROOS_CFG_PROFILE == true)
+  chprintf(stream, "%-16s%12s%12s%12s%10s%10s\n", "name", "age [ms]", "refresh", "hits", "reads", "errors");
+#else
+  chprintf(stream, "%-16s%12s%12s\n", "name", "age [ms]", "refresh");
+#endif
+  for (aos_snapshot_t* snapshot = _snapshots; snapshot != NULL; snapshot = snapshot->next) {
+    chprintf(stream, "%-16s", (snapshot->name != NULL) ? snapshot->name : "");
+    if (snapshot->valid) {
+      chprintf(stream, "%12u", (uint32_t)((uptime - snapshot->timestamp) / MICROSECONDS_PER_MILLISECOND));
+    } else {
+      chprintf(stream, "%12s", "-");
+    }
+    chprintf(stream, "%12u", (uint32_t)(snapshot->refresh / MICROSECONDS_PER_MILLISECOND));
+#if (AMIROOS_CFG_PROFILE == true)
+    chprintf(stream, "%12u%10u%10u", snapshot->stats.hits, snapshot->stats.transactions, snapshot->stats.errors);
+#endif
+    chprintf(stream, "\n");
+  }
+
+  return;
+}
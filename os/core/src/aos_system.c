@@ -49,6 +49,12 @@ static void _printSystemInfo(BaseSequentialStream* stream);
 static int _shellcmd_configcb(BaseSequentialStream* stream, int argc, char* argv[]);
 static int _shellcmd_infocb(BaseSequentialStream* stream, int argc, char* argv[]);
 static int _shellcmd_shutdowncb(BaseSequentialStream* stream, int argc, char* argv[]);
+static int _shellcmd_snapshotcb(BaseSequentialStream* stream, int argc, char* argv[]);
+static int _shellcmd_teardowncb(BaseSequentialStream* stream, int argc, char* argv[]);
+static int _shellcmd_idlecb(BaseSequentialStream* stream, int argc, char* argv[]);
+#if (AMIROOS_CFG_PROFILE == true)
+static int _shellcmd_bootcb(BaseSequentialStream* stream, int argc, char* argv[]);
+#endif
 #endif /* AMIROOS_CFG_SHELL_ENABLE == true */
 #if (AMIROOS_CFG_TESTS_ENABLE == true)
 static int _shellcmd_kerneltestcb(BaseSequentialStream* stream, int argc, char* argv[]);
@@ -81,16 +87,69 @@ static virtual_timer_t _syssynctimer;
 static aos_timestamp_t _syssynctime;
 #endif
 
-#if ((AMIROOS_CFG_SSSP_MASTER != true) && (AMIROOS_CFG_PROFILE == true)) || defined(__DOXYGEN__)
 /**
- * @brief   Offset between local clock and system wide synchronization signal.
+ * @brief   Uptime of the last synchronization edge.
+ */
+static aos_timestamp_t _syssyncedge;
+
+/**
+ * @brief   Number of synchronization edges.
+ */
+static uint32_t _syssyncedges;
+
+#if (AMIROOS_CFG_SSSP_MASTER != true) || defined(__DOXYGEN__)
+/**
+ * @brief   Maximum rate correction of the local clock (1000 ppm as Q32 fraction).
  */
-static float _syssyncskew;
+#define SYSTEM_CLOCK_MAXRATE          ((int32_t)4294967)
 
 /**
- * @brief   Weighting factor for the low-pass filter used for calculating the @p _syssyncskew value.
+ * @brief   Offset in microseconds above which the local clock is stepped instead of slewed.
  */
-#define SYSTEM_SYSSYNCSKEW_LPFACTOR   (0.1f / AOS_SYSTEM_TIME_RESOLUTION)
+#define SYSTEM_CLOCK_STEPTHRESHOLD    1000
+
+/**
+ * @brief   Maximum number of synchronization periods between two references to estimate the frequency.
+ */
+#define SYSTEM_CLOCK_MAXSPAN          16
+
+/**
+ * @brief   Clock discipline of SSSP slaves.
+ * @details The local clock is slewed towards the master clock by scaling the elapsed time with a rate correction,
+ *          which compensates the frequency offset of the oscillator and removes the remaining offset over the next two
+ *          synchronization periods, so the uptime never jumps.
+ *          The frequency offset is estimated from the uncorrected time between successive synchronization edges and the
+ *          uptimes of the master at these edges, which are broadcast via CAN.
+ *          As long as no such references are received, the edges are assumed to lie on the synchronization period grid.
+ */
+static struct {
+  aos_timestamp_t raw;          /**< Accumulated uncorrected uptime.                                */
+  int32_t rate;                 /**< Rate correction of the local clock (Q32 fraction).             */
+  uint32_t fraction;            /**< Accumulated fraction of a microsecond (Q32).                   */
+  int32_t frequency;            /**< Estimated frequency offset of the oscillator (Q32 fraction).   */
+  aos_timestamp_t edgeraw;      /**< Uncorrected uptime of the last synchronization edge.           */
+  bool pending;                 /**< Flag whether the last edge awaits a reference of the master.   */
+  bool referenced;              /**< Flag whether references of the master are being received.      */
+
+  /**
+   * @brief   Last edge with known master time.
+   */
+  struct {
+    aos_timestamp_t raw;        /**< Uncorrected uptime at the edge.                                */
+    aos_timestamp_t master;     /**< Uptime of the master at the edge.                              */
+    bool valid;                 /**< Flag whether the reference is valid.                           */
+  } reference;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    int32_t offset;             /**< Offset at the last disciplined edge in microseconds.           */
+    uint32_t references;        /**< Number of edges disciplined with a reference of the master.    */
+    uint32_t rejected;          /**< Number of references which did not match the last edge.        */
+    uint32_t steps;             /**< Number of offsets which were too large to be slewed.           */
+  } stats;
+} _clock;
 #endif
 
 #if (AMIROOS_CFG_SHELL_ENABLE == true) || defined(__DOXYGEN__)
@@ -135,6 +194,44 @@ static aos_shellcommand_t _shellcmd_shutdown = {
   /* callback */ _shellcmd_shutdowncb,
   /* next     */ NULL,
 };
+
+/**
+ * @brief   Shell command to retrieve information about the snapshot cache.
+ */
+static aos_shellcommand_t _shellcmd_snapshot = {
+  /* name     */ "module:snapshots",
+  /* callback */ _shellcmd_snapshotcb,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Shell command to retrieve information about the shutdown sequence.
+ */
+static aos_shellcommand_t _shellcmd_teardown = {
+  /* name     */ "module:teardown",
+  /* callback */ _shellcmd_teardowncb,
+  /* next     */ NULL,
+};
+
+/**
+ * @brief   Shell command to retrieve information about the idle modes.
+ */
+static aos_shellcommand_t _shellcmd_idle = {
+  /* name     */ "module:idle",
+  /* callback */ _shellcmd_idlecb,
+  /* next     */ NULL,
+};
+
+#if (AMIROOS_CFG_PROFILE == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Shell command to print the boot profile.
+ */
+static aos_shellcommand_t _shellcmd_boot = {
+  /* name     */ "module:boot",
+  /* callback */ _shellcmd_bootcb,
+  /* next     */ NULL,
+};
+#endif
 #endif /* AMIROOS_CFG_SHELL_ENABLE == true */
 
 #if (AMIROOS_CFG_TESTS_ENABLE == true) || defined(__DOXYGEN__)
@@ -148,6 +245,18 @@ static aos_shellcommand_t _shellcmd_kerneltest = {
 };
 #endif /* AMIROOS_CFG_TESTS_ENABLE == true */
 
+#if (AMIROOS_CFG_SHELL_ENABLE == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Teardown task to wait for the shell thread to exit.
+ */
+static aos_teardown_t _teardownShell;
+#endif
+
+/**
+ * @brief   Teardown task to stop the snapshot refresher thread.
+ */
+static aos_teardown_t _teardownSnapshots;
+
 /**
  * @brief   Global system object.
  */
@@ -426,6 +535,13 @@ static int _shellcmd_configcb(BaseSequentialStream* stream, int argc, char* argv
     }
   }
 
+#ifdef MODULE_SYSTEM_CONFIG_HOOK
+  // let the module persist the modified configuration
+  if (retval == AOS_OK && argc > 2) {
+    MODULE_SYSTEM_CONFIG_HOOK();
+  }
+#endif
+
   // print help, if required
   if (retval == AOS_INVALID_ARGUMENTS) {
     chprintf(stream, "Usage: %s OPTION\n", argv[0]);
@@ -486,8 +602,17 @@ static int _shellcmd_infocb(BaseSequentialStream* stream, int argc, char* argv[]
   chprintf(stream, "%10u seconds\n", (uint8_t)(uptime % MICROSECONDS_PER_MINUTE / MICROSECONDS_PER_SECOND));
   chprintf(stream, "%10u milliseconds\n", (uint16_t)(uptime % MICROSECONDS_PER_SECOND / MICROSECONDS_PER_MILLISECOND));
   chprintf(stream, "%10u microseconds\n", (uint16_t)(uptime % MICROSECONDS_PER_MILLISECOND / MICROSECONDS_PER_MICROSECOND));
-#if (AMIROOS_CFG_SSSP_MASTER != true) && (AMIROOS_CFG_PROFILE == true)
-  chprintf(stream, "SSSP synchronization offset: %.3fus per %uus\n", _syssyncskew, AMIROOS_CFG_SSSP_SYSSYNCPERIOD);
+#if (AMIROOS_CFG_SSSP_MASTER != true)
+  chSysLock();
+  const int32_t offset = _clock.stats.offset;
+  const int32_t rate = _clock.rate;
+  const int32_t frequency = _clock.frequency;
+  chSysUnlock();
+  chprintf(stream, "SSSP synchronization offset: %dus per %uus\n", offset, AMIROOS_CFG_SSSP_SYSSYNCPERIOD);
+  chprintf(stream, "clock frequency offset: %dppb, rate correction: %dppb\n",
+           (int32_t)(((int64_t)frequency * 1000000000) >> 32), (int32_t)(((int64_t)rate * 1000000000) >> 32));
+  chprintf(stream, "%u of %u edges referenced by the master, %u references rejected, %u steps\n",
+           _clock.stats.references, _syssyncedges, _clock.stats.rejected, _clock.stats.steps);
 #endif
   _printSystemInfoSeparator(stream, '=', SYSTEM_INFO_WIDTH);
 
@@ -557,6 +682,137 @@ static int _shellcmd_shutdowncb(BaseSequentialStream* stream, int argc, char* ar
     }
   }
 }
+
+/**
+ * @brief   Callback function for the module:snapshots shell command.
+ *
+ * @param[in] stream    The I/O stream to use.
+ * @param[in] argc      Number of arguments.
+ * @param[in] argv      List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+static int _shellcmd_snapshotcb(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(stream != NULL);
+
+  // print help text
+  if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints all registered snapshots, their age and access statistics.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  aosSnapshotPrintInfo(stream);
+
+  return AOS_OK;
+}
+
+/**
+ * @brief   Callback function for the module:teardown shell command.
+ *
+ * @param[in] stream    The I/O stream to use.
+ * @param[in] argc      Number of arguments.
+ * @param[in] argv      List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+static int _shellcmd_teardowncb(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(stream != NULL);
+
+  // print help text
+  if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints all tasks of the shutdown sequence and the durations of the last shutdown.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  aosTeardownPrintInfo(stream);
+
+  return AOS_OK;
+}
+
+/**
+ * @brief   Callback function for the module:idle shell command.
+ *
+ * @param[in] stream    The I/O stream to use.
+ * @param[in] argc      Number of arguments.
+ * @param[in] argv      List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+static int _shellcmd_idlecb(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(stream != NULL);
+
+  // print help text
+  if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the time the system spent in each idle mode since startup.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  aosIdlePrintInfo(stream);
+
+  return AOS_OK;
+}
+
+#if (AMIROOS_CFG_PROFILE == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Callback function for the module:boot shell command.
+ *
+ * @param[in] stream    The I/O stream to use.
+ * @param[in] argc      Number of arguments.
+ * @param[in] argv      List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+static int _shellcmd_bootcb(BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(stream != NULL);
+
+  if (argc == 1) {
+    aosBootPrintInfo(stream, false);
+    return AOS_OK;
+  }
+  else if (argc == 2 && strcmp(argv[1], "--history") == 0) {
+    aosBootPrintInfo(stream, true);
+    return AOS_OK;
+  }
+
+  // print help text
+  chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+  chprintf(stream, "Prints the timestamps of all SSSP stage transitions and initialization hooks of the current boot.\n");
+  chprintf(stream, "Options:\n");
+  chprintf(stream, "  --history\n");
+  chprintf(stream, "    Print the last %u boots from the persistent log.\n", AOS_BOOT_HISTORY);
+  chprintf(stream, "  --help\n");
+  chprintf(stream, "    Print this help text.\n");
+
+  return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+}
+#endif
 #endif /* AMIROOS_CFG_SHELL_ENABLE == true */
 
 #if (AMIROOS_CFG_TESTS_ENABLE == true) || defined(__DOXYGEN__)
@@ -602,6 +858,72 @@ static void _signalPdCallback(void *args)
   return;
 }
 
+/**
+ * @brief   Accumulates the time elapsed since the last accumulation to the uptime.
+ * @details On SSSP slaves, the elapsed time is scaled by the rate correction of the clock discipline.
+ */
+static inline void _accumulateUptimeX(void)
+{
+  // read current time in system ticks
+  const systime_t st = chVTGetSystemTimeX();
+  const aos_interval_t dt = TIME_I2US(st - _synctime);
+
+#if (AMIROOS_CFG_SSSP_MASTER != true)
+  const int64_t scaled = ((int64_t)dt * _clock.rate) + _clock.fraction;
+  _uptime += (aos_timestamp_t)((int64_t)dt + (scaled >> 32));
+  _clock.fraction = (uint32_t)scaled;
+  _clock.raw += dt;
+#else
+  _uptime += dt;
+#endif
+  _synctime = st;
+
+  return;
+}
+
+#if (AMIROOS_CFG_SSSP_MASTER != true) || defined(__DOXYGEN__)
+/**
+ * @brief   Disciplines the local clock with the master time of the last synchronization edge.
+ *
+ * @param[in] master    Uptime of the master at the last synchronization edge.
+ */
+static void _disciplineClockX(aos_timestamp_t master)
+{
+  const int64_t offset = (int64_t)(_syssyncedge - master);
+  int64_t rate;
+
+  // estimate the frequency offset of the oscillator from the uncorrected time between two referenced edges
+  if (_clock.reference.valid && master > _clock.reference.master &&
+      master - _clock.reference.master <= SYSTEM_CLOCK_MAXSPAN * AMIROOS_CFG_SSSP_SYSSYNCPERIOD) {
+    const int64_t span = (int64_t)(master - _clock.reference.master);
+    const int64_t drift = (int64_t)(_clock.edgeraw - _clock.reference.raw) - span;
+    // implausible estimates (e.g. due to a missed edge) are ignored
+    if (drift * 1000 <= span && drift * 1000 >= -span) {
+      _clock.frequency += (int32_t)(((drift << 32) / span - _clock.frequency) / 4);
+    }
+  }
+  _clock.reference.raw = _clock.edgeraw;
+  _clock.reference.master = master;
+  _clock.reference.valid = true;
+
+  // the time since the edge is accounted with the previous rate
+  _accumulateUptimeX();
+  _clock.stats.offset = (int32_t)offset;
+  if (offset > SYSTEM_CLOCK_STEPTHRESHOLD || offset < -SYSTEM_CLOCK_STEPTHRESHOLD) {
+    _uptime -= offset;
+    _syssyncedge -= offset;
+    rate = -(int64_t)_clock.frequency;
+    ++_clock.stats.steps;
+  } else {
+    // compensate the frequency and slew half of the offset per synchronization period
+    rate = -(int64_t)_clock.frequency - ((offset << 32) / (2 * AMIROOS_CFG_SSSP_SYSSYNCPERIOD));
+  }
+  _clock.rate = (int32_t)((rate > SYSTEM_CLOCK_MAXRATE) ? SYSTEM_CLOCK_MAXRATE : (rate < -SYSTEM_CLOCK_MAXRATE) ? -SYSTEM_CLOCK_MAXRATE : rate);
+
+  return;
+}
+#endif
+
 /**
  * @brief   Callback function for the Sync signal interrupt.
  *
@@ -614,11 +936,10 @@ static void _signalSyncCallback(void *args)
 
 #if (AMIROOS_CFG_SSSP_MASTER == true)
   chSysLockFromISR();
-  chEvtBroadcastFlagsI(&aos.events.io, 0);
+  chEvtBroadcastFlagsI(&aos.events.io, MODULE_SSSP_EVENTFLAGS_SYNC);
   chSysUnlockFromISR();
 #else
   apalControlGpioState_t s_state;
-  aos_timestamp_t uptime;
 
   chSysLockFromISR();
   // if the system is in operation phase
@@ -627,24 +948,26 @@ static void _signalSyncCallback(void *args)
     apalControlGpioGet(&moduleSsspGpioSync, &s_state);
     // if S was toggled from on to off
     if (s_state == APAL_GPIO_OFF) {
-      // get current uptime
-      aosSysGetUptimeX(&uptime);
-      // align the uptime with the synchronization period
-      if (uptime % AMIROOS_CFG_SSSP_SYSSYNCPERIOD < AMIROOS_CFG_SSSP_SYSSYNCPERIOD / 2) {
-        _uptime -= uptime % AMIROOS_CFG_SSSP_SYSSYNCPERIOD;
-#if (AMIROOS_CFG_PROFILE == true)
-        _syssyncskew = ((1.0f - SYSTEM_SYSSYNCSKEW_LPFACTOR) * _syssyncskew) + (SYSTEM_SYSSYNCSKEW_LPFACTOR * (uptime % AMIROOS_CFG_SSSP_SYSSYNCPERIOD));
-#endif
+      // the edge becomes the new base of the uptime
+      _accumulateUptimeX();
+      _syssyncedge = _uptime;
+      _clock.edgeraw = _clock.raw;
+      ++_syssyncedges;
+      // the previous edge did not receive a reference of the master
+      if (_clock.pending) {
+        _clock.referenced = false;
+      }
+      if (_clock.referenced) {
+        _clock.pending = true;
       } else {
-        _uptime += AMIROOS_CFG_SSSP_SYSSYNCPERIOD - (uptime % AMIROOS_CFG_SSSP_SYSSYNCPERIOD);
-#if (AMIROOS_CFG_PROFILE == true)
-        _syssyncskew = ((1.0f - SYSTEM_SYSSYNCSKEW_LPFACTOR) * _syssyncskew) - (SYSTEM_SYSSYNCSKEW_LPFACTOR * (AMIROOS_CFG_SSSP_SYSSYNCPERIOD - (uptime % AMIROOS_CFG_SSSP_SYSSYNCPERIOD)));
-#endif
+        // align the uptime with the synchronization period
+        const aos_interval_t phase = _uptime % AMIROOS_CFG_SSSP_SYSSYNCPERIOD;
+        _disciplineClockX((phase < AMIROOS_CFG_SSSP_SYSSYNCPERIOD / 2) ? (_uptime - phase) : (_uptime + (AMIROOS_CFG_SSSP_SYSSYNCPERIOD - phase)));
       }
     }
   }
   // broadcast event
-  chEvtBroadcastFlagsI(&aos.events.io, 0);
+  chEvtBroadcastFlagsI(&aos.events.io, MODULE_SSSP_EVENTFLAGS_SYNC);
   chSysUnlockFromISR();
 #endif
 
@@ -661,11 +984,8 @@ static void _uptimeCallback(void* par)
   (void)par;
 
   chSysLockFromISR();
-  // read current time in system ticks
-  register const systime_t st = chVTGetSystemTimeX();
   // update the uptime variables
-  _uptime += TIME_I2US(st - _synctime);
-  _synctime = st;
+  _accumulateUptimeX();
   // enable the timer again
   chVTSetI(&_systimer, SYSTIMER_PERIOD, &_uptimeCallback, NULL);
   chSysUnlockFromISR();
@@ -700,6 +1020,9 @@ static void _sysSyncTimerCallback(void* par)
   }
   // if S was toggled from on to off
   else /* if (s_state == APAL_GPIO_OFF) */ {
+    // the uptime of this edge is broadcast to the slaves
+    aosSysGetUptimeX(&_syssyncedge);
+    ++_syssyncedges;
     // reconfigure the timer (lazy)
     chVTSetI(&_syssynctimer, TIME_US2I(AMIROOS_CFG_SSSP_SYSSYNCPERIOD / 2), _sysSyncTimerCallback, NULL);
   }
@@ -709,6 +1032,37 @@ static void _sysSyncTimerCallback(void* par)
 }
 #endif
 
+#if (AMIROOS_CFG_SHELL_ENABLE == true) || defined(__DOXYGEN__)
+/**
+ * @brief   Teardown callback to wait for the shell thread to exit.
+ * @details The shell thread terminates itself on the shutdown event.
+ *
+ * @param[in] param   Unused.
+ */
+static void _teardownShellCb(void* param)
+{
+  (void)param;
+
+  chThdWait(aos.shell.thread);
+
+  return;
+}
+#endif
+
+/**
+ * @brief   Teardown callback to stop the snapshot refresher thread.
+ *
+ * @param[in] param   Unused.
+ */
+static void _teardownSnapshotsCb(void* param)
+{
+  (void)param;
+
+  aosSnapshotRefresherStop();
+
+  return;
+}
+
 /**
  * @brief   AMiRo-OS system initialization.
  * @note    Must be called from the system control thread (usually main thread).
@@ -732,13 +1086,16 @@ void aosSysInit(void)
   chVTObjectInit(&_syssynctimer);
   _syssynctime = 0;
 #endif
-#if (AMIROOS_CFG_SSSP_MASTER != true) && (AMIROOS_CFG_PROFILE == true)
-  _syssyncskew = 0.0f;
+  _syssyncedge = 0;
+  _syssyncedges = 0;
+#if (AMIROOS_CFG_SSSP_MASTER != true)
+  memset(&_clock, 0, sizeof(_clock));
 #endif
 
   // set aos configuration
   aos.sssp.stage = AOS_SSSP_STARTUP_2_1;
   aos.sssp.moduleId = 0;
+  aosBootMark(AOS_BOOT_STAGE, aos.sssp.stage);
   aosIOStreamInit(&aos.iostream);
   chEvtObjectInit(&aos.events.io);
   chEvtObjectInit(&aos.events.os);
@@ -747,9 +1104,20 @@ void aosSysInit(void)
   aosIntDriverInit(&moduleIntDriver, moduleIntConfig);
   chSysLock();
   palSetPadCallbackI(moduleGpioSysPd.port, moduleGpioSysPd.pad, _signalPdCallback, NULL);
-  palSetPadCallbackI(moduleGpioSysSync.port, moduleGpioSysSync.pad, _signalSyncCallback, NULL);
   chSysUnlock();
   aosIntDriverStart(&moduleIntDriver);
+  // the synchronization edges must be captured by the system, so the callback of the interrupt driver is replaced
+  chSysLock();
+  palSetPadCallbackI(moduleGpioSysSync.port, moduleGpioSysSync.pad, _signalSyncCallback, NULL);
+  chSysUnlock();
+
+  // register the teardown tasks of the system threads
+#if (AMIROOS_CFG_SHELL_ENABLE == true)
+  aosTeardownInit(&_teardownShell, "shell", _teardownShellCb, NULL, AOS_TEARDOWN_SYSTEM, MICROSECONDS_PER_MILLISECOND);
+  aosTeardownRegister(&_teardownShell);
+#endif
+  aosTeardownInit(&_teardownSnapshots, "snapshots", _teardownSnapshotsCb, NULL, AOS_TEARDOWN_SYSTEM, MICROSECONDS_PER_MILLISECOND);
+  aosTeardownRegister(&_teardownSnapshots);
 
 #if (AMIROOS_CFG_SHELL_ENABLE == true)
   // init shell
@@ -764,6 +1132,12 @@ void aosSysInit(void)
   aosShellAddCommand(&aos.shell, &_shellcmd_config);
   aosShellAddCommand(&aos.shell, &_shellcmd_info);
   aosShellAddCommand(&aos.shell, &_shellcmd_shutdown);
+  aosShellAddCommand(&aos.shell, &_shellcmd_snapshot);
+  aosShellAddCommand(&aos.shell, &_shellcmd_teardown);
+  aosShellAddCommand(&aos.shell, &_shellcmd_idle);
+#if (AMIROOS_CFG_PROFILE == true)
+  aosShellAddCommand(&aos.shell, &_shellcmd_boot);
+#endif
 #if (AMIROOS_CFG_TESTS_ENABLE == true)
   aosShellAddCommand(&aos.shell, &_shellcmd_kerneltest);
 #endif
@@ -779,6 +1153,7 @@ inline void aosSysStart(void)
 {
   // update the system SSSP stage
   aos.sssp.stage = AOS_SSSP_OPERATION;
+  aosBootMark(AOS_BOOT_STAGE, aos.sssp.stage);
 
 #if (AMIROOS_CFG_SSSP_MASTER == true)
   {
@@ -797,6 +1172,9 @@ inline void aosSysStart(void)
   _printSystemInfo((BaseSequentialStream*)&aos.iostream);
   aosprintf("\n");
 
+  // start snapshot refresher thread
+  aosSnapshotRefresherStart();
+
 #if (AMIROOS_CFG_SHELL_ENABLE == true)
   // start system shell thread
   aos.shell.thread = chThdCreateStatic(_shell_wa, sizeof(_shell_wa), AMIROOS_CFG_SHELL_THREADPRIO, aosShellThread, &aos.shell);
@@ -824,6 +1202,7 @@ eventmask_t aosSysSsspStartupOsInitSyncCheck(event_listener_t* syncEvtListener)
 
   // update the system SSSP stage
   aos.sssp.stage = AOS_SSSP_STARTUP_2_2;
+  aosBootMark(AOS_BOOT_STAGE, aos.sssp.stage);
 
   // deactivate the sync signal to indicate that the module is ready (SSSPv1 stage 2.1 of startup phase)
   apalControlGpioSet(&moduleSsspGpioSync, APAL_GPIO_OFF);
@@ -865,11 +1244,82 @@ inline void aosSysGetUptimeX(aos_timestamp_t* ut)
 {
   aosDbgCheck(ut != NULL);
 
-  *ut = _uptime + TIME_I2US(chVTGetSystemTimeX() - _synctime);
+  const aos_interval_t dt = TIME_I2US(chVTGetSystemTimeX() - _synctime);
+
+#if (AMIROOS_CFG_SSSP_MASTER != true)
+  *ut = _uptime + (aos_timestamp_t)((int64_t)dt + ((((int64_t)dt * _clock.rate) + _clock.fraction) >> 32));
+#else
+  *ut = _uptime + dt;
+#endif
+
+  return;
+}
+
+/**
+ * @brief   Retrieves the uptime of the last synchronization edge.
+ * @details On the SSSP master, this is the reference to be broadcast to all slaves.
+ *
+ * @param[out] edge   The uptime of the last synchronization edge.
+ *
+ * @return  The number of synchronization edges so far, which identifies the edge.
+ */
+uint32_t aosSysGetSyncEdge(aos_timestamp_t* edge)
+{
+  aosDbgCheck(edge != NULL);
+
+  uint32_t edges;
+
+  chSysLock();
+  *edge = _syssyncedge;
+  edges = _syssyncedges;
+  chSysUnlock();
+
+  return edges;
+}
+
+/**
+ * @brief   Compensates the uptime for time, which was not measured by the system timer.
+ * @details Low-power modes, which halt the system timer, must account the time spent in them.
+ * @note    Must be called with interrupts disabled.
+ *
+ * @param[in] offset  Time to add to the uptime in microseconds.
+ */
+void aosSysCompensateUptimeX(aos_interval_t offset)
+{
+  _uptime += offset;
 
   return;
 }
 
+#if (AMIROOS_CFG_SSSP_MASTER != true) || defined(__DOXYGEN__)
+/**
+ * @brief   Disciplines the local clock with the uptime of the master at the last synchronization edge.
+ * @details References which differ from the local time of the edge by more than half a synchronization period do not
+ *          belong to the last edge and are rejected.
+ *          If no reference is received for an edge, the following edges are aligned with the synchronization period
+ *          grid until references are received again.
+ *
+ * @param[in] master    Uptime of the master at the last synchronization edge.
+ */
+void aosSysSyncReference(aos_timestamp_t master)
+{
+  chSysLock();
+  if (master + (AMIROOS_CFG_SSSP_SYSSYNCPERIOD / 2) < _syssyncedge || master > _syssyncedge + (AMIROOS_CFG_SSSP_SYSSYNCPERIOD / 2)) {
+    ++_clock.stats.rejected;
+  } else {
+    if (_clock.pending) {
+      _disciplineClockX(master);
+      _clock.pending = false;
+      ++_clock.stats.references;
+    }
+    _clock.referenced = true;
+  }
+  chSysUnlock();
+
+  return;
+}
+#endif
+
 /**
  * @brief   retrieves the date and time from the MCU clock.
  *
@@ -913,6 +1363,9 @@ void aosSysShutdownInit(aos_shutdown_t shutdown)
   // check arguments
   aosDbgCheck(shutdown != AOS_SHUTDOWN_NONE);
 
+  // start the time measurement of the shutdown
+  aosTeardownStart(shutdown);
+
 #if (AMIROOS_CFG_SSSP_MASTER == true)
   // deactivate the system synchronization timer
   chVTReset(&_syssynctimer);
@@ -965,12 +1418,11 @@ void aosSysShutdownInit(aos_shutdown_t shutdown)
 
 /**
  * @brief   Stops the system and all related threads (not the thread this function is called from).
+ * @details The shell and the snapshot refresher are stopped concurrently by the teardown orchestrator.
  */
 void aosSysStop(void)
 {
-#if (AMIROOS_CFG_SHELL_ENABLE == true)
-  chThdWait(aos.shell.thread);
-#endif
+  aosTeardownRun(AOS_TEARDOWN_SYSTEM);
 
   return;
 }
@@ -1002,6 +1454,9 @@ void aosSysShutdownFinal(aos_interrupt_driver_t* intDrv, aos_shutdown_t shutdown
   // update the system SSSP stage
   aos.sssp.stage = AOS_SSSP_SHUTDOWN_1_3;
 
+  // complete the time measurement of the shutdown
+  aosTeardownFinish();
+
   // call bootloader callback depending on arguments
   switch (shutdown) {
     case AOS_SHUTDOWN_PASSIVE:
@@ -0,0 +1,578 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <aos_teardown.h>
+
+#include <aos_crc.h>
+#include <aos_debug.h>
+#include <aos_thread.h>
+#include <chprintf.h>
+#include <module.h>
+#include <stddef.h>
+
+/**
+ * @brief   Magic value of a valid shutdown report.
+ */
+#define TEARDOWN_REPORT_MAGIC         0x4E574F44
+
+/**
+ * @brief   Event mask to wake up waiting workers.
+ * @details The calling thread is a worker as well, so the mask must not collide with any of its event listeners.
+ */
+#define TEARDOWN_WAKEUP_EVENTMASK     EVENT_MASK(31)
+
+/**
+ * @brief   Width of the name column of the teardown table.
+ */
+#define TEARDOWN_INFO_NAMEWIDTH       16
+
+/**
+ * @brief   Section of the persistent shutdown report.
+ * @details Modules with backup RAM should place the report there.
+ *          By default the report is placed in the part of the RAM, which is not initialized at startup, so it survives
+ *          resets, but no power loss.
+ */
+#if !defined(MODULE_OS_TEARDOWN_SECTION)
+#define MODULE_OS_TEARDOWN_SECTION    ".ram0"
+#endif
+
+/**
+ * @brief   Persistent report of the last shutdown.
+ */
+static aos_teardownreport_t _report __attribute__((section(MODULE_OS_TEARDOWN_SECTION)));
+
+#if (AMIROOS_CFG_TEARDOWN_WORKERS > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Worker thread working areas.
+ */
+static THD_WORKING_AREA(_workers_wa[AMIROOS_CFG_TEARDOWN_WORKERS], AMIROOS_CFG_TEARDOWN_STACKSIZE);
+#endif
+
+/**
+ * @brief   Teardown orchestrator state.
+ */
+static struct {
+  /**
+   * @brief   Registered tasks, indexed by their ID.
+   */
+  aos_teardown_t* tasks[AOS_TEARDOWN_MAXTASKS];
+
+  /**
+   * @brief   Number of registered tasks.
+   */
+  uint8_t count;
+
+  /**
+   * @brief   Bitmask of the tasks, which were not started yet.
+   */
+  uint32_t pending;
+
+  /**
+   * @brief   Bitmask of the tasks, which are currently running.
+   */
+  uint32_t running;
+
+  /**
+   * @brief   Bitmask of the completed tasks.
+   */
+  uint32_t done;
+
+  /**
+   * @brief   Threads of all workers (index 0 is the calling thread).
+   */
+  thread_t* workers[AMIROOS_CFG_TEARDOWN_WORKERS + 1];
+
+  /**
+   * @brief   Type of the current shutdown.
+   */
+  aos_shutdown_t shutdown;
+
+  /**
+   * @brief   Uptime when the shutdown was initialized.
+   */
+  aos_timestamp_t start;
+
+  /**
+   * @brief   Measured duration of each phase.
+   */
+  aos_interval_t phases[AOS_TEARDOWN_PHASES];
+} _teardown;
+
+/**
+ * @brief   Names of the phases.
+ */
+static const char* const _phasenames[AOS_TEARDOWN_PHASES] = {
+  "services",
+  "system",
+  "periphery",
+};
+
+/**
+ * @brief   Names of the shutdown types.
+ */
+static const char* const _shutdownnames[] = {
+  "none",
+  "passive",
+  "hibernate",
+  "deepsleep",
+  "transportation",
+  "restart",
+};
+
+/**
+ * @brief   Calculates the rank of all tasks of a phase.
+ * @details The rank of a task is the estimated duration of the longest path from the task to the end of the phase.
+ *
+ * @param[in] phase   The phase.
+ */
+static void _rank(const aos_teardownphase_t phase)
+{
+  aos_teardown_t* task;
+  aos_teardown_t* prerequisite;
+  bool changed = true;
+
+  for (uint8_t id = 0; id < _teardown.count; ++id) {
+    _teardown.tasks[id]->rank = _teardown.tasks[id]->estimate;
+  }
+
+  // relax the ranks along all dependencies until they are stable (each path has less edges than there are tasks)
+  for (uint8_t iteration = 1; iteration < _teardown.count && changed; ++iteration) {
+    changed = false;
+    for (uint8_t id = 0; id < _teardown.count; ++id) {
+      task = _teardown.tasks[id];
+      if (task->phase != phase) {
+        continue;
+      }
+      for (uint8_t p = 0; p < _teardown.count; ++p) {
+        prerequisite = _teardown.tasks[p];
+        if ((task->prerequisites & ((uint32_t)1 << p)) &&
+            prerequisite->phase == phase &&
+            prerequisite->rank < prerequisite->estimate + task->rank) {
+          prerequisite->rank = prerequisite->estimate + task->rank;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  return;
+}
+
+/**
+ * @brief   Selects the next task to execute.
+ * @details Among all pending tasks, whose prerequisites are completed, the one with the highest rank is selected.
+ *
+ * @return  The next task or NULL if no task can be started right now.
+ */
+static aos_teardown_t* _nextI(void)
+{
+  aos_teardown_t* next = NULL;
+
+  for (uint8_t id = 0; id < _teardown.count; ++id) {
+    if ((_teardown.pending & ((uint32_t)1 << id)) &&
+        (_teardown.tasks[id]->prerequisites & ~_teardown.done) == 0 &&
+        (next == NULL || _teardown.tasks[id]->rank > next->rank)) {
+      next = _teardown.tasks[id];
+    }
+  }
+
+  // if no task can be started while none is running, the dependencies are cyclic
+  if (next == NULL && _teardown.running == 0) {
+    // start the pending task with the lowest ID anyway, so the shutdown cannot get stuck
+    for (uint8_t id = 0; id < _teardown.count && next == NULL; ++id) {
+      if (_teardown.pending & ((uint32_t)1 << id)) {
+        next = _teardown.tasks[id];
+      }
+    }
+  }
+
+  return next;
+}
+
+/**
+ * @brief   Executes pending tasks until all tasks of the phase were started.
+ *
+ * @param[in] worker  Index of the worker.
+ */
+static void _work(const uint8_t worker)
+{
+  aos_teardown_t* task;
+  aos_timestamp_t start;
+  aos_timestamp_t end;
+
+  for (;;) {
+    chSysLock();
+    if (_teardown.pending == 0) {
+      chSysUnlock();
+      break;
+    }
+    task = _nextI();
+    if (task != NULL) {
+      _teardown.pending &= ~((uint32_t)1 << task->id);
+      _teardown.running |= (uint32_t)1 << task->id;
+    }
+    chSysUnlock();
+
+    // wait for another task to complete
+    if (task == NULL) {
+      chEvtWaitAny(TEARDOWN_WAKEUP_EVENTMASK);
+      continue;
+    }
+
+    aosSysGetUptime(&start);
+    task->callback(task->cbparam);
+    aosSysGetUptime(&end);
+    task->duration = end - start;
+
+    // mark the task as completed and wake up all other workers
+    chSysLock();
+    _teardown.running &= ~((uint32_t)1 << task->id);
+    _teardown.done |= (uint32_t)1 << task->id;
+    for (uint8_t w = 0; w < AMIROOS_CFG_TEARDOWN_WORKERS + 1; ++w) {
+      if (w != worker && _teardown.workers[w] != NULL) {
+        chEvtSignalI(_teardown.workers[w], TEARDOWN_WAKEUP_EVENTMASK);
+      }
+    }
+    chSchRescheduleS();
+    chSysUnlock();
+  }
+
+  return;
+}
+
+#if (AMIROOS_CFG_TEARDOWN_WORKERS > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Worker thread to execute teardown tasks concurrently.
+ *
+ * @param[in] worker  Index of the worker.
+ */
+static THD_FUNCTION(_teardownWorkerThread, worker)
+{
+  chRegSetThreadName("teardown");
+
+  _work((uint8_t)(uintptr_t)worker);
+
+  chThdExit(MSG_OK);
+}
+#endif
+
+/**
+ * @brief   Initializes a teardown task.
+ *
+ * @param[in] task      The task to initialize.
+ * @param[in] name      Name of the task.
+ * @param[in] callback  Callback to stop the service, thread or driver.
+ * @param[in] cbparam   Parameter for the callback.
+ * @param[in] phase     Phase, in which the task is executed.
+ * @param[in] estimate  Estimated duration of the task in microseconds.
+ */
+void aosTeardownInit(aos_teardown_t* task, const char* name, aos_teardown_cb_t callback, void* cbparam, aos_teardownphase_t phase, aos_interval_t estimate)
+{
+  aosDbgCheck(task != NULL);
+  aosDbgCheck(callback != NULL);
+  aosDbgCheck(phase < AOS_TEARDOWN_PHASES);
+
+  task->name = name;
+  task->callback = callback;
+  task->cbparam = cbparam;
+  task->phase = phase;
+  task->estimate = estimate;
+  task->prerequisites = 0;
+  task->rank = 0;
+  task->duration = 0;
+  task->id = AOS_TEARDOWN_MAXTASKS;
+
+  return;
+}
+
+/**
+ * @brief   Declares that a task must not be started before another task was completed.
+ *
+ * @param[in] task          The dependent task.
+ * @param[in] prerequisite  The (registered) task, which must be completed before.
+ */
+void aosTeardownDepends(aos_teardown_t* task, const aos_teardown_t* prerequisite)
+{
+  aosDbgCheck(task != NULL);
+  aosDbgCheck(prerequisite != NULL && prerequisite->id < _teardown.count);
+  aosDbgCheck(prerequisite->phase <= task->phase);
+
+  task->prerequisites |= (uint32_t)1 << prerequisite->id;
+
+  return;
+}
+
+/**
+ * @brief   Registers a task to be executed on shutdown.
+ *
+ * @param[in] task  The task to register.
+ */
+void aosTeardownRegister(aos_teardown_t* task)
+{
+  aosDbgCheck(task != NULL);
+  aosDbgCheck(task->id == AOS_TEARDOWN_MAXTASKS);
+  aosDbgAssert(_teardown.count < AOS_TEARDOWN_MAXTASKS);
+
+  chSysLock();
+  task->id = _teardown.count;
+  _teardown.tasks[_teardown.count++] = task;
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Starts the time measurement of a shutdown.
+ *
+ * @param[in] shutdown  Type of the shutdown.
+ */
+void aosTeardownStart(aos_shutdown_t shutdown)
+{
+  aosSysGetUptime(&_teardown.start);
+  _teardown.shutdown = shutdown;
+  _teardown.done = 0;
+  for (uint8_t phase = 0; phase < AOS_TEARDOWN_PHASES; ++phase) {
+    _teardown.phases[phase] = 0;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Executes all tasks of a phase.
+ * @details Each task is started as soon as all its prerequisites are completed.
+ *          Independent tasks are executed concurrently by up to AMIROOS_CFG_TEARDOWN_WORKERS worker threads in
+ *          addition to the calling thread.
+ *          All workers run with the priority of the calling thread.
+ *          Tasks of earlier phases are considered completed.
+ *
+ * @param[in] phase   The phase to execute.
+ */
+void aosTeardownRun(aos_teardownphase_t phase)
+{
+  aosDbgCheck(phase < AOS_TEARDOWN_PHASES);
+
+  aos_timestamp_t start;
+  aos_timestamp_t end;
+  uint32_t pending = 0;
+  uint8_t workers = 0;
+
+  aosSysGetUptime(&start);
+
+  for (uint8_t id = 0; id < _teardown.count; ++id) {
+    if (_teardown.tasks[id]->phase == phase) {
+      pending |= (uint32_t)1 << id;
+      if (workers < AMIROOS_CFG_TEARDOWN_WORKERS + 1) {
+        ++workers;
+      }
+    } else if (_teardown.tasks[id]->phase < phase) {
+      _teardown.done |= (uint32_t)1 << id;
+    }
+  }
+  _rank(phase);
+
+  _teardown.pending = pending;
+  _teardown.running = 0;
+  _teardown.workers[0] = chThdGetSelfX();
+  chEvtGetAndClearEvents(TEARDOWN_WAKEUP_EVENTMASK);
+
+#if (AMIROOS_CFG_TEARDOWN_WORKERS > 0)
+  // start as many workers as there are tasks to execute besides the calling thread
+  for (uint8_t w = 1; w < workers; ++w) {
+    _teardown.workers[w] = chThdCreateStatic(_workers_wa[w - 1], sizeof(_workers_wa[w - 1]), chThdGetPriorityX(), _teardownWorkerThread, (void*)(uintptr_t)w);
+  }
+#endif
+
+  _work(0);
+
+#if (AMIROOS_CFG_TEARDOWN_WORKERS > 0)
+  // wait for the workers to complete their last tasks
+  for (uint8_t w = 1; w < workers; ++w) {
+    chThdWait(_teardown.workers[w]);
+    _teardown.workers[w] = NULL;
+  }
+#endif
+  _teardown.workers[0] = NULL;
+  chEvtGetAndClearEvents(TEARDOWN_WAKEUP_EVENTMASK);
+
+  aosSysGetUptime(&end);
+  _teardown.phases[phase] += end - start;
+
+  return;
+}
+
+/**
+ * @brief   Completes the time measurement of a shutdown and stores the report in persistent memory.
+ * @note    This function should be called immediately before the system is handed over to the bootloader.
+ */
+void aosTeardownFinish(void)
+{
+  aos_timestamp_t end;
+
+  aosSysGetUptime(&end);
+
+  _report.magic = TEARDOWN_REPORT_MAGIC;
+  _report.total = (uint32_t)(end - _teardown.start);
+  _report.sequential = 0;
+  _report.tasks = 0;
+  for (uint8_t id = 0; id < _teardown.count; ++id) {
+    if (_teardown.done & ((uint32_t)1 << id)) {
+      _report.sequential += _teardown.tasks[id]->duration;
+      ++_report.tasks;
+    }
+  }
+  for (uint8_t phase = 0; phase < AOS_TEARDOWN_PHASES; ++phase) {
+    _report.phases[phase] = _teardown.phases[phase];
+  }
+  _report.shutdown = (uint8_t)_teardown.shutdown;
+  _report.workers = AMIROOS_CFG_TEARDOWN_WORKERS + 1;
+  _report.crc = aosCrc8((const uint8_t*)&_report, offsetof(aos_teardownreport_t, crc));
+
+  aosDbgPrintf("shutdown took %uus (%u tasks, %uus sequential)\n", _report.total, _report.tasks, _report.sequential);
+
+  return;
+}
+
+/**
+ * @brief   Prints all registered tasks and the report of the last shutdown.
+ *
+ * @param[in] stream  Stream to print to.
+ */
+void aosTeardownPrintInfo(BaseSequentialStream* stream)
+{
+  aosDbgCheck(stream != NULL);
+
+  bool first;
+
+  chprintf(stream, "%-*s%-12s%16s  %s\n", TEARDOWN_INFO_NAMEWIDTH, "task", "phase", "estimate [us]", "after");
+  for (uint8_t id = 0; id < _teardown.count; ++id) {
+    aos_teardown_t* task = _teardown.tasks[id];
+    chprintf(stream, "%-*s%-12s%16u  ", TEARDOWN_INFO_NAMEWIDTH, (task->name != NULL) ? task->name : "", _phasenames[task->phase], task->estimate);
+    first = true;
+    for (uint8_t p = 0; p < _teardown.count; ++p) {
+      if (task->prerequisites & ((uint32_t)1 << p)) {
+        chprintf(stream, "%s%s", first ? "" : ", ", (_teardown.tasks[p]->name != NULL) ? _teardown.tasks[p]->name : "");
+        first = false;
+      }
+    }
+    chprintf(stream, "%s\n", first ? "-" : "");
+  }
+  chprintf(stream, "\n");
+
+  // print the report of the last shutdown
+  if (_report.magic == TEARDOWN_REPORT_MAGIC &&
+      _report.crc == aosCrc8((const uint8_t*)&_report, offsetof(aos_teardownreport_t, crc)) &&
+      _report.shutdown < sizeof(_shutdownnames) / sizeof(_shutdownnames[0])) {
+    chprintf(stream, "last shutdown (%s): %uus until handover to the bootloader\n", _shutdownnames[_report.shutdown], _report.total);
+    for (uint8_t phase = 0; phase < AOS_TEARDOWN_PHASES; ++phase) {
+      chprintf(stream, "  %-*s%10uus\n", TEARDOWN_INFO_NAMEWIDTH - 2, _phasenames[phase], _report.phases[phase]);
+    }
+    chprintf(stream, "  %u tasks took %uus in total, executed by %u workers\n", _report.tasks, _report.sequential, _report.workers);
+  } else {
+    chprintf(stream, "no shutdown recorded\n");
+  }
+
+  return;
+}
+
+#if (HAL_USE_ADC == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Teardown callback, which stops an ADC driver.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] driver  The driver to stop.
+ */
+void aosTeardownAdc(void* driver)
+{
+  aosDbgCheck(driver != NULL);
+
+  adcStop((ADCDriver*)driver);
+
+  return;
+}
+#endif
+
+#if (HAL_USE_I2C == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Teardown callback, which stops an I2C driver.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] driver  The driver to stop.
+ */
+void aosTeardownI2c(void* driver)
+{
+  aosDbgCheck(driver != NULL);
+
+  i2cStop((I2CDriver*)driver);
+
+  return;
+}
+#endif
+
+#if (HAL_USE_PWM == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Teardown callback, which stops a PWM driver.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] driver  The driver to stop.
+ */
+void aosTeardownPwm(void* driver)
+{
+  aosDbgCheck(driver != NULL);
+
+  pwmStop((PWMDriver*)driver);
+
+  return;
+}
+#endif
+
+#if (defined(HAL_USE_QEI) && (HAL_USE_QEI == TRUE)) || defined(__DOXYGEN__)
+/**
+ * @brief   Teardown callback, which stops a QEI driver.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] driver  The driver to stop.
+ */
+void aosTeardownQei(void* driver)
+{
+  aosDbgCheck(driver != NULL);
+
+  qeiDisable((QEIDriver*)driver);
+  qeiStop((QEIDriver*)driver);
+
+  return;
+}
+#endif
+
+#if (HAL_USE_SPI == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Teardown callback, which stops an SPI driver.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] driver  The driver to stop.
+ */
+void aosTeardownSpi(void* driver)
+{
+  aosDbgCheck(driver != NULL);
+
+  spiStop((SPIDriver*)driver);
+
+  return;
+}
+#endif
@@ -37,10 +37,48 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @name    QEI configuration options
+ * @{
+ */
+/**
+ * @brief   Enables the extended position counter.
+ * @details If set to @p TRUE the driver tracks over- and underflows of the
+ *          hardware counter by interrupt and provides a 64 bit signed position.
+ * @note    The default is @p TRUE.
+ */
+#if !defined(QEI_USE_EXTENDED_POSITION) || defined(__DOXYGEN__)
+#define QEI_USE_EXTENDED_POSITION           TRUE
+#endif
+
+/**
+ * @brief   Enables the velocity estimation.
+ * @details If set to @p TRUE the driver estimates the velocity by the M/T
+ *          method: The pulses between two captured encoder edges are divided
+ *          by the time between these edges, which is measured with the
+ *          realtime counter. Sampling is triggered by a virtual timer, so
+ *          no thread is involved.
+ * @note    The default is @p FALSE.
+ * @note    Requires @p QEI_USE_EXTENDED_POSITION.
+ */
+#if !defined(QEI_USE_VELOCITY) || defined(__DOXYGEN__)
+#define QEI_USE_VELOCITY                    FALSE
+#endif
+/** @} */
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if QEI_USE_VELOCITY && !QEI_USE_EXTENDED_POSITION
+#error "QEI_USE_VELOCITY requires QEI_USE_EXTENDED_POSITION"
+#endif
+
+/**
+ * @brief   Number of fractional bits of the velocity type.
+ */
+#define QEI_VELOCITY_FRACBITS               16
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -60,6 +98,18 @@ typedef enum {
  */
 typedef struct QEIDriver QEIDriver;
 
+/**
+ * @brief   Extended (signed 64 bit) position type.
+ */
+typedef int64_t qeiextcnt_t;
+
+/**
+ * @brief   Velocity type in pulses per second.
+ * @details Signed fixed-point value with @p QEI_VELOCITY_FRACBITS fractional
+ *          bits.
+ */
+typedef int32_t qeivelocity_t;
+
 #include "hal_qei_lld.h"
 
 /*===========================================================================*/
@@ -122,6 +172,51 @@ typedef struct QEIDriver QEIDriver;
  * @iclass
  */
 #define qeiGetRangeI(qeip) qei_lld_get_range(qeip)
+
+#if QEI_USE_EXTENDED_POSITION || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the extended position of the encoder.
+ * @details The extended position is the number of pulses since the driver
+ *          was started, including all over- and underflows of the counter.
+ *          Wraps which occurred but have not been served by the interrupt
+ *          handler yet are taken into account.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @return              The extended number of pulses.
+ *
+ * @iclass
+ */
+#define qeiGetPositionExtendedI(qeip) qei_lld_get_position_extended(qeip)
+#endif
+
+#if QEI_USE_VELOCITY || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the estimated velocity of the encoder.
+ * @details The estimate is updated once per sampling period at the first
+ *          encoder edge after the period started. If no edge occurs, the
+ *          estimate is bounded by the elapsed time and drops to zero after
+ *          the configured timeout.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @return              The velocity in pulses per second (fixed-point).
+ *
+ * @iclass
+ */
+#define qeiGetVelocityI(qeip) qei_lld_get_velocity(qeip)
+
+/**
+ * @brief   Sets the frequency of the realtime counter.
+ * @details Must be called whenever the core clock, which drives the
+ *          realtime counter, is changed at runtime. Defaults to
+ *          @p STM32_HCLK after the driver was started.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @param[in] freq      frequency of the realtime counter in Hz
+ *
+ * @iclass
+ */
+#define qeiSetRealtimeFrequencyI(qeip, freq) qei_lld_set_rtc_frequency(qeip, freq)
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -137,6 +232,12 @@ extern "C" {
   void qeiStop(QEIDriver *qeip);
   void qeiEnable(QEIDriver *qeip);
   void qeiDisable(QEIDriver *qeip);
+#if QEI_USE_EXTENDED_POSITION
+  qeiextcnt_t qeiGetPositionExtended(QEIDriver *qeip);
+#endif
+#if QEI_USE_VELOCITY
+  qeivelocity_t qeiGetVelocity(QEIDriver *qeip);
+#endif
 #ifdef __cplusplus
 }
 #endif
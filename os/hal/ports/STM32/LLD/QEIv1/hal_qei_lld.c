@@ -82,6 +82,18 @@ QEIDriver QEID5;
 QEIDriver QEID8;
 #endif
 
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#if QEI_USE_VELOCITY || defined(__DOXYGEN__)
+/**
+ * @brief   Pulses counted between two captures of the same edge of TI1.
+ */
+#define QEI_PULSES_PER_CAPTURE(qeip)                                        \
+  (((qeip)->config->mode == QEI_COUNT_BOTH) ? 4 : 2)
+#endif
+
 /*===========================================================================*/
 /* Driver local variables.                                                   */
 /*===========================================================================*/
@@ -90,10 +102,307 @@ QEIDriver QEID8;
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+#if QEI_USE_EXTENDED_POSITION || defined(__DOXYGEN__)
+/**
+ * @brief   Computes the pulses represented by a counter wrap.
+ * @details Right after an overflow the counter is close to zero, right after
+ *          an underflow it is close to the range. This does not rely on the
+ *          direction bit, which may have changed again meanwhile.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @param[in] cnt       counter value read after the wrap
+ * @return              The pulses to add to the accumulated wraps.
+ *
+ * @notapi
+ */
+static inline qeiextcnt_t qei_lld_wrap_delta(QEIDriver *qeip, qeicnt_t cnt) {
+  const qeicnt_t range = qei_lld_get_range(qeip);
+
+  return (cnt < (range / 2)) ? (qeiextcnt_t)range : -(qeiextcnt_t)range;
+}
+
+#if QEI_USE_VELOCITY || defined(__DOXYGEN__)
+/**
+ * @brief   Computes a velocity from pulses and elapsed realtime counter ticks.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @param[in] pulses    number of pulses
+ * @param[in] ticks     elapsed realtime counter ticks
+ * @return              The velocity in pulses per second (fixed-point).
+ *
+ * @notapi
+ */
+static inline qeivelocity_t qei_lld_compute_velocity(QEIDriver *qeip, qeiextcnt_t pulses, rtcnt_t ticks) {
+
+  return (qeivelocity_t)((pulses * ((int64_t)qeip->velocity.frequency << QEI_VELOCITY_FRACBITS)) / (int64_t)ticks);
+}
+
+/**
+ * @brief   Handles a captured encoder edge.
+ * @details Computes the velocity by the pulses and the exact time between
+ *          this and the previously captured edge (M/T method) and disarms
+ *          the capture interrupt until the next sampling period.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ *
+ * @notapi
+ */
+static void qei_lld_serve_capture(QEIDriver *qeip) {
+  const rtcnt_t now = chSysGetRealtimeCounterX();
+  const int32_t range = (int32_t)qei_lld_get_range(qeip);
+  qeiextcnt_t position;
+  int32_t delta;
+
+  qeip->tim->DIER &= ~TIM_DIER_CC1IE;
+
+  /* Position at the edge is the current position minus the pulses counted
+     since the capture, which may have wrapped.*/
+  position = qei_lld_get_position_extended(qeip);
+  delta = (int32_t)qeip->tim->CNT - (int32_t)qeip->tim->CCR[0];
+  if (delta > range / 2)
+    delta -= range;
+  else if (delta < -range / 2)
+    delta += range;
+  position -= delta;
+
+  if (qeip->velocity.valid) {
+    const rtcnt_t ticks = now - qeip->velocity.time;
+    if (ticks > 0)
+      qeip->velocity.value = qei_lld_compute_velocity(qeip, position - qeip->velocity.position, ticks);
+  }
+  qeip->velocity.position = position;
+  qeip->velocity.time = now;
+  qeip->velocity.valid = true;
+}
+
+/**
+ * @brief   Velocity sampling timer callback.
+ * @details Arms the capture interrupt for the next encoder edge. If the
+ *          previous period did not see any edge, the velocity is bounded by
+ *          the pulses of a single edge divided by the elapsed time and set to
+ *          zero once the timeout expired.
+ *
+ * @param[in] p         pointer to the @p QEIDriver object
+ *
+ * @notapi
+ */
+static void qei_lld_velocity_cb(void *p) {
+  QEIDriver *qeip = (QEIDriver *)p;
+
+  osalSysLockFromISR();
+  if (qeip->tim->DIER & TIM_DIER_CC1IE) {
+    if (qeip->velocity.valid) {
+      const rtcnt_t ticks = chSysGetRealtimeCounterX() - qeip->velocity.time;
+      if (ticks >= (rtcnt_t)(qeip->config->velocity_timeout * (qeip->velocity.frequency / 1000000))) {
+        qeip->velocity.value = 0;
+        qeip->velocity.valid = false;
+      }
+      else {
+        const qeivelocity_t bound = qei_lld_compute_velocity(qeip, QEI_PULSES_PER_CAPTURE(qeip), ticks);
+        if (qeip->velocity.value > bound)
+          qeip->velocity.value = bound;
+        else if (qeip->velocity.value < -bound)
+          qeip->velocity.value = -bound;
+      }
+    }
+  }
+  else {
+    qeip->tim->SR = ~TIM_SR_CC1IF;
+    qeip->tim->DIER |= TIM_DIER_CC1IE;
+  }
+  chVTSetI(&qeip->velocity.vt, qeip->config->velocity_period, qei_lld_velocity_cb, qeip);
+  osalSysUnlockFromISR();
+}
+#endif /* QEI_USE_VELOCITY */
+
+/**
+ * @brief   Shared timer interrupt handler.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ *
+ * @notapi
+ */
+static void qei_lld_serve_interrupt(QEIDriver *qeip) {
+  uint32_t sr;
+
+  sr = qeip->tim->SR & qeip->tim->DIER;
+  if (sr & TIM_SR_UIF) {
+    qeip->tim->SR = ~TIM_SR_UIF;
+    osalSysLockFromISR();
+    qeip->wraps += qei_lld_wrap_delta(qeip, qeip->tim->CNT);
+    osalSysUnlockFromISR();
+  }
+#if QEI_USE_VELOCITY
+  if (sr & TIM_SR_CC1IF) {
+    qeip->tim->SR = ~TIM_SR_CC1IF;
+    osalSysLockFromISR();
+    qei_lld_serve_capture(qeip);
+    osalSysUnlockFromISR();
+  }
+#endif
+}
+#endif /* QEI_USE_EXTENDED_POSITION */
+
 /*===========================================================================*/
 /* Driver interrupt handlers.                                                */
 /*===========================================================================*/
 
+#if QEI_USE_EXTENDED_POSITION || defined(__DOXYGEN__)
+#if STM32_QEI_USE_TIM1 || defined(__DOXYGEN__)
+#if !defined(STM32_TIM1_UP_HANDLER)
+#error "STM32_TIM1_UP_HANDLER not defined"
+#endif
+/**
+ * @brief   TIM1 update interrupt handler.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(STM32_TIM1_UP_HANDLER) {
+
+  OSAL_IRQ_PROLOGUE();
+
+  qei_lld_serve_interrupt(&QEID1);
+
+  OSAL_IRQ_EPILOGUE();
+}
+
+#if QEI_USE_VELOCITY || defined(__DOXYGEN__)
+#if !defined(STM32_TIM1_CC_HANDLER)
+#error "STM32_TIM1_CC_HANDLER not defined"
+#endif
+/**
+ * @brief   TIM1 compare/capture interrupt handler.
+ * @note    The advanced timers raise capture events on a separate vector.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(STM32_TIM1_CC_HANDLER) {
+
+  OSAL_IRQ_PROLOGUE();
+
+  qei_lld_serve_interrupt(&QEID1);
+
+  OSAL_IRQ_EPILOGUE();
+}
+#endif
+#endif
+
+#if STM32_QEI_USE_TIM2 || defined(__DOXYGEN__)
+#if !defined(STM32_TIM2_HANDLER)
+#error "STM32_TIM2_HANDLER not defined"
+#endif
+/**
+ * @brief   TIM2 update interrupt handler.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(STM32_TIM2_HANDLER) {
+
+  OSAL_IRQ_PROLOGUE();
+
+  qei_lld_serve_interrupt(&QEID2);
+
+  OSAL_IRQ_EPILOGUE();
+}
+#endif
+
+#if STM32_QEI_USE_TIM3 || defined(__DOXYGEN__)
+#if !defined(STM32_TIM3_HANDLER)
+#error "STM32_TIM3_HANDLER not defined"
+#endif
+/**
+ * @brief   TIM3 update interrupt handler.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(STM32_TIM3_HANDLER) {
+
+  OSAL_IRQ_PROLOGUE();
+
+  qei_lld_serve_interrupt(&QEID3);
+
+  OSAL_IRQ_EPILOGUE();
+}
+#endif
+
+#if STM32_QEI_USE_TIM4 || defined(__DOXYGEN__)
+#if !defined(STM32_TIM4_HANDLER)
+#error "STM32_TIM4_HANDLER not defined"
+#endif
+/**
+ * @brief   TIM4 update interrupt handler.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(STM32_TIM4_HANDLER) {
+
+  OSAL_IRQ_PROLOGUE();
+
+  qei_lld_serve_interrupt(&QEID4);
+
+  OSAL_IRQ_EPILOGUE();
+}
+#endif
+
+#if STM32_QEI_USE_TIM5 || defined(__DOXYGEN__)
+#if !defined(STM32_TIM5_HANDLER)
+#error "STM32_TIM5_HANDLER not defined"
+#endif
+/**
+ * @brief   TIM5 update interrupt handler.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(STM32_TIM5_HANDLER) {
+
+  OSAL_IRQ_PROLOGUE();
+
+  qei_lld_serve_interrupt(&QEID5);
+
+  OSAL_IRQ_EPILOGUE();
+}
+#endif
+
+#if STM32_QEI_USE_TIM8 || defined(__DOXYGEN__)
+#if !defined(STM32_TIM8_UP_HANDLER)
+#error "STM32_TIM8_UP_HANDLER not defined"
+#endif
+/**
+ * @brief   TIM8 update interrupt handler.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(STM32_TIM8_UP_HANDLER) {
+
+  OSAL_IRQ_PROLOGUE();
+
+  qei_lld_serve_interrupt(&QEID8);
+
+  OSAL_IRQ_EPILOGUE();
+}
+
+#if QEI_USE_VELOCITY || defined(__DOXYGEN__)
+#if !defined(STM32_TIM8_CC_HANDLER)
+#error "STM32_TIM8_CC_HANDLER not defined"
+#endif
+/**
+ * @brief   TIM8 compare/capture interrupt handler.
+ * @note    The advanced timers raise capture events on a separate vector.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(STM32_TIM8_CC_HANDLER) {
+
+  OSAL_IRQ_PROLOGUE();
+
+  qei_lld_serve_interrupt(&QEID8);
+
+  OSAL_IRQ_EPILOGUE();
+}
+#endif
+#endif
+#endif /* QEI_USE_EXTENDED_POSITION */
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -158,24 +467,39 @@ void qei_lld_start(QEIDriver *qeip) {
     if (&QEID1 == qeip) {
       rccEnableTIM1();
       rccResetTIM1();
+#if QEI_USE_EXTENDED_POSITION
+      nvicEnableVector(STM32_TIM1_UP_NUMBER, STM32_QEI_TIM1_IRQ_PRIORITY);
+#endif
+#if QEI_USE_VELOCITY
+      nvicEnableVector(STM32_TIM1_CC_NUMBER, STM32_QEI_TIM1_IRQ_PRIORITY);
+#endif
     }
 #endif
 #if STM32_QEI_USE_TIM2
     if (&QEID2 == qeip) {
       rccEnableTIM2();
       rccResetTIM2();
+#if QEI_USE_EXTENDED_POSITION
+      nvicEnableVector(STM32_TIM2_NUMBER, STM32_QEI_TIM2_IRQ_PRIORITY);
+#endif
     }
 #endif
 #if STM32_QEI_USE_TIM3
     if (&QEID3 == qeip) {
       rccEnableTIM3();
       rccResetTIM3();
+#if QEI_USE_EXTENDED_POSITION
+      nvicEnableVector(STM32_TIM3_NUMBER, STM32_QEI_TIM3_IRQ_PRIORITY);
+#endif
     }
 #endif
 #if STM32_QEI_USE_TIM4
     if (&QEID4 == qeip) {
       rccEnableTIM4();
       rccResetTIM4();
+#if QEI_USE_EXTENDED_POSITION
+      nvicEnableVector(STM32_TIM4_NUMBER, STM32_QEI_TIM4_IRQ_PRIORITY);
+#endif
     }
 #endif
 
@@ -183,12 +507,21 @@ void qei_lld_start(QEIDriver *qeip) {
     if (&QEID5 == qeip) {
       rccEnableTIM5();
       rccResetTIM5();
+#if QEI_USE_EXTENDED_POSITION
+      nvicEnableVector(STM32_TIM5_NUMBER, STM32_QEI_TIM5_IRQ_PRIORITY);
+#endif
     }
 #endif
 #if STM32_QEI_USE_TIM8
     if (&QEID8 == qeip) {
       rccEnableTIM8();
       rccResetTIM8();
+#if QEI_USE_EXTENDED_POSITION
+      nvicEnableVector(STM32_TIM8_UP_NUMBER, STM32_QEI_TIM8_IRQ_PRIORITY);
+#endif
+#if QEI_USE_VELOCITY
+      nvicEnableVector(STM32_TIM8_CC_NUMBER, STM32_QEI_TIM8_IRQ_PRIORITY);
+#endif
     }
 #endif
   }
@@ -201,6 +534,17 @@ void qei_lld_start(QEIDriver *qeip) {
     qeip->tim->CCR[1] = 0;                  /* Comparator 2 disabled.       */
     qeip->tim->CNT    = 0;                  /* Counter reset to zero.       */
   }
+#if QEI_USE_EXTENDED_POSITION
+  qeip->wraps = 0;
+#endif
+#if QEI_USE_VELOCITY
+  osalDbgAssert(qeip->config->velocity_period > 0, "invalid velocity period");
+  osalDbgAssert(qeip->config->velocity_timeout <= (uint32_t)(((uint64_t)1 << 31) / (STM32_HCLK / 1000000)), "velocity timeout too long");
+  chVTObjectInit(&qeip->velocity.vt);
+  qeip->velocity.frequency = STM32_HCLK;
+  qeip->velocity.valid = false;
+  qeip->velocity.value = 0;
+#endif
 
   /* Timer configuration.*/
   qeip->tim->PSC  = 0;
@@ -217,6 +561,10 @@ void qei_lld_start(QEIDriver *qeip) {
     ccer |= TIM_CCER_CC1P;
   if (qeip->config->channels[1].mode == QEI_INPUT_INVERTED)
     ccer |= TIM_CCER_CC2P;
+#if QEI_USE_VELOCITY
+  /* Capture the counter on TI1 edges for the period measurement.*/
+  ccer |= TIM_CCER_CC1E;
+#endif
   qeip->tim->CCER = ccer;
 
   if (qeip->config->mode == QEI_COUNT_CH1)
@@ -225,6 +573,12 @@ void qei_lld_start(QEIDriver *qeip) {
     qeip->tim->SMCR  = TIM_SMCR_SMS_0;
   else
     qeip->tim->SMCR  = TIM_SMCR_SMS_0 | TIM_SMCR_SMS_1;
+
+#if QEI_USE_EXTENDED_POSITION
+  /* Update interrupt on counter over- and underflow.*/
+  qeip->tim->SR   = 0;
+  qeip->tim->DIER = TIM_DIER_UIE;
+#endif
 }
 
 /**
@@ -239,38 +593,63 @@ void qei_lld_stop(QEIDriver *qeip) {
   if (qeip->state == QEI_READY) {
     /* Clock deactivation.*/
     qeip->tim->CR1  = 0;                    /* Timer disabled.              */
+    qeip->tim->DIER = 0;                    /* All IRQs disabled.           */
 
 #if STM32_QEI_USE_TIM1
     if (&QEID1 == qeip) {
+#if QEI_USE_EXTENDED_POSITION
+      nvicDisableVector(STM32_TIM1_UP_NUMBER);
+#endif
+#if QEI_USE_VELOCITY
+      nvicDisableVector(STM32_TIM1_CC_NUMBER);
+#endif
       rccDisableTIM1();
     }
 #endif
 #if STM32_QEI_USE_TIM2
     if (&QEID2 == qeip) {
+#if QEI_USE_EXTENDED_POSITION
+      nvicDisableVector(STM32_TIM2_NUMBER);
+#endif
       rccDisableTIM2();
     }
 #endif
 #if STM32_QEI_USE_TIM3
     if (&QEID3 == qeip) {
+#if QEI_USE_EXTENDED_POSITION
+      nvicDisableVector(STM32_TIM3_NUMBER);
+#endif
       rccDisableTIM3();
     }
 #endif
 #if STM32_QEI_USE_TIM4
     if (&QEID4 == qeip) {
+#if QEI_USE_EXTENDED_POSITION
+      nvicDisableVector(STM32_TIM4_NUMBER);
+#endif
       rccDisableTIM4();
     }
 #endif
 #if STM32_QEI_USE_TIM5
     if (&QEID5 == qeip) {
+#if QEI_USE_EXTENDED_POSITION
+      nvicDisableVector(STM32_TIM5_NUMBER);
+#endif
       rccDisableTIM5();
     }
 #endif
-  }
 #if STM32_QEI_USE_TIM8
     if (&QEID8 == qeip) {
+#if QEI_USE_EXTENDED_POSITION
+      nvicDisableVector(STM32_TIM8_UP_NUMBER);
+#endif
+#if QEI_USE_VELOCITY
+      nvicDisableVector(STM32_TIM8_CC_NUMBER);
+#endif
       rccDisableTIM8();
     }
 #endif
+  }
 }
 
 /**
@@ -282,7 +661,14 @@ void qei_lld_stop(QEIDriver *qeip) {
  */
 void qei_lld_enable(QEIDriver *qeip) {
 
-  qeip->tim->CR1  = TIM_CR1_CEN;
+  /* Only over- and underflows generate update events.*/
+  qeip->tim->CR1  = TIM_CR1_URS | TIM_CR1_CEN;
+
+#if QEI_USE_VELOCITY
+  qeip->velocity.valid = false;
+  qeip->velocity.value = 0;
+  chVTSetI(&qeip->velocity.vt, qeip->config->velocity_period, qei_lld_velocity_cb, qeip);
+#endif
 }
 
 /**
@@ -295,7 +681,40 @@ void qei_lld_enable(QEIDriver *qeip) {
 void qei_lld_disable(QEIDriver *qeip) {
 
   qeip->tim->CR1  = 0;
+
+#if QEI_USE_VELOCITY
+  chVTResetI(&qeip->velocity.vt);
+  qeip->tim->DIER &= ~TIM_DIER_CC1IE;
+  qeip->velocity.value = 0;
+#endif
+}
+
+#if QEI_USE_EXTENDED_POSITION || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the extended position of the encoder.
+ * @details A wrap which occurred but was not served by the interrupt handler
+ *          yet is detected by the pending update flag. In this case the
+ *          counter is read again, so the value is consistent with the flag.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @return              The extended number of pulses.
+ *
+ * @iclass
+ */
+qeiextcnt_t qei_lld_get_position_extended(QEIDriver *qeip) {
+  qeicnt_t cnt;
+  qeiextcnt_t wraps;
+
+  cnt = qeip->tim->CNT;
+  wraps = qeip->wraps;
+  if (qeip->tim->SR & TIM_SR_UIF) {
+    cnt = qeip->tim->CNT;
+    wraps += qei_lld_wrap_delta(qeip, cnt);
+  }
+
+  return wraps + (qeiextcnt_t)cnt;
 }
+#endif /* QEI_USE_EXTENDED_POSITION */
 
 #endif /* HAL_USE_QEI */
 
@@ -101,6 +101,54 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #if !defined(STM32_QEI_USE_TIM8) || defined(__DOXYGEN__)
 #define STM32_QEI_USE_TIM8                  TRUE
 #endif
+
+/**
+ * @brief   QEID1 interrupt priority level setting.
+ * @note    Only used if @p QEI_USE_EXTENDED_POSITION is enabled.
+ */
+#if !defined(STM32_QEI_TIM1_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_QEI_TIM1_IRQ_PRIORITY         7
+#endif
+
+/**
+ * @brief   QEID2 interrupt priority level setting.
+ * @note    Only used if @p QEI_USE_EXTENDED_POSITION is enabled.
+ */
+#if !defined(STM32_QEI_TIM2_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_QEI_TIM2_IRQ_PRIORITY         7
+#endif
+
+/**
+ * @brief   QEID3 interrupt priority level setting.
+ * @note    Only used if @p QEI_USE_EXTENDED_POSITION is enabled.
+ */
+#if !defined(STM32_QEI_TIM3_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_QEI_TIM3_IRQ_PRIORITY         7
+#endif
+
+/**
+ * @brief   QEID4 interrupt priority level setting.
+ * @note    Only used if @p QEI_USE_EXTENDED_POSITION is enabled.
+ */
+#if !defined(STM32_QEI_TIM4_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_QEI_TIM4_IRQ_PRIORITY         7
+#endif
+
+/**
+ * @brief   QEID5 interrupt priority level setting.
+ * @note    Only used if @p QEI_USE_EXTENDED_POSITION is enabled.
+ */
+#if !defined(STM32_QEI_TIM5_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_QEI_TIM5_IRQ_PRIORITY         7
+#endif
+
+/**
+ * @brief   QEID8 interrupt priority level setting.
+ * @note    Only used if @p QEI_USE_EXTENDED_POSITION is enabled.
+ */
+#if !defined(STM32_QEI_TIM8_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define STM32_QEI_TIM8_IRQ_PRIORITY         7
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -137,6 +185,38 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #error "QEI driver activated but no TIM peripheral assigned"
 #endif
 
+#if QEI_USE_EXTENDED_POSITION
+#if STM32_QEI_USE_TIM1 &&                                                   \
+    !OSAL_IRQ_IS_VALID_PRIORITY(STM32_QEI_TIM1_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to TIM1"
+#endif
+
+#if STM32_QEI_USE_TIM2 &&                                                   \
+    !OSAL_IRQ_IS_VALID_PRIORITY(STM32_QEI_TIM2_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to TIM2"
+#endif
+
+#if STM32_QEI_USE_TIM3 &&                                                   \
+    !OSAL_IRQ_IS_VALID_PRIORITY(STM32_QEI_TIM3_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to TIM3"
+#endif
+
+#if STM32_QEI_USE_TIM4 &&                                                   \
+    !OSAL_IRQ_IS_VALID_PRIORITY(STM32_QEI_TIM4_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to TIM4"
+#endif
+
+#if STM32_QEI_USE_TIM5 &&                                                   \
+    !OSAL_IRQ_IS_VALID_PRIORITY(STM32_QEI_TIM5_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to TIM5"
+#endif
+
+#if STM32_QEI_USE_TIM8 &&                                                   \
+    !OSAL_IRQ_IS_VALID_PRIORITY(STM32_QEI_TIM8_IRQ_PRIORITY)
+#error "Invalid IRQ priority assigned to TIM8"
+#endif
+#endif /* QEI_USE_EXTENDED_POSITION */
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -191,6 +271,17 @@ typedef struct {
    */
   qeicnt_t                  range;
   /* End of the mandatory fields.*/
+#if QEI_USE_VELOCITY || defined(__DOXYGEN__)
+  /**
+   * @brief   Velocity sampling period in system ticks.
+   */
+  sysinterval_t             velocity_period;
+  /**
+   * @brief   Time in microseconds without any encoder edge, after which the
+   *          velocity is considered zero.
+   */
+  uint32_t                  velocity_timeout;
+#endif
 } QEIConfig;
 
 /**
@@ -213,6 +304,43 @@ struct QEIDriver {
    * @brief Pointer to the TIMx registers block.
    */
   stm32_tim_t               *tim;
+#if QEI_USE_EXTENDED_POSITION || defined(__DOXYGEN__)
+  /**
+   * @brief Accumulated pulses of all counter over- and underflows.
+   */
+  volatile qeiextcnt_t      wraps;
+#endif
+#if QEI_USE_VELOCITY || defined(__DOXYGEN__)
+  /**
+   * @brief Velocity estimation data.
+   */
+  struct {
+    /**
+     * @brief Sampling timer.
+     */
+    virtual_timer_t         vt;
+    /**
+     * @brief Extended position at the last captured edge.
+     */
+    qeiextcnt_t             position;
+    /**
+     * @brief Realtime counter value at the last captured edge.
+     */
+    rtcnt_t                 time;
+    /**
+     * @brief Frequency of the realtime counter in Hz.
+     */
+    uint32_t                frequency;
+    /**
+     * @brief Flag whether @p position and @p time are valid.
+     */
+    bool                    valid;
+    /**
+     * @brief Current velocity estimate.
+     */
+    volatile qeivelocity_t  value;
+  } velocity;
+#endif
 };
 
 /*===========================================================================*/
@@ -255,6 +383,29 @@ struct QEIDriver {
  */
 #define qei_lld_get_range(qeip) ((qeip)->tim->ARR + 1)
 
+#if QEI_USE_VELOCITY || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the estimated velocity of the encoder.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @return              The velocity in pulses per second (fixed-point).
+ *
+ * @iclass
+ */
+#define qei_lld_get_velocity(qeip) ((qeip)->velocity.value)
+
+/**
+ * @brief   Sets the frequency of the realtime counter.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @param[in] freq      frequency of the realtime counter in Hz
+ *
+ * @iclass
+ */
+#define qei_lld_set_rtc_frequency(qeip, freq)                               \
+  ((qeip)->velocity.frequency = (freq))
+#endif /* QEI_USE_VELOCITY */
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -291,6 +442,9 @@ extern "C" {
   void qei_lld_stop(QEIDriver *qeip);
   void qei_lld_enable(QEIDriver *qeip);
   void qei_lld_disable(QEIDriver *qeip);
+#if QEI_USE_EXTENDED_POSITION
+  qeiextcnt_t qei_lld_get_position_extended(QEIDriver *qeip);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -151,6 +151,50 @@ void qeiDisable(QEIDriver *qeip) {
   chSysUnlock();
 }
 
+#if QEI_USE_EXTENDED_POSITION || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the extended position of the encoder.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @return              The extended number of pulses.
+ *
+ * @api
+ */
+qeiextcnt_t qeiGetPositionExtended(QEIDriver *qeip) {
+  qeiextcnt_t position;
+
+  chDbgCheck(qeip != NULL /*, "qeiGetPositionExtended"*/);
+
+  chSysLock();
+  position = qeiGetPositionExtendedI(qeip);
+  chSysUnlock();
+
+  return position;
+}
+#endif
+
+#if QEI_USE_VELOCITY || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the estimated velocity of the encoder.
+ *
+ * @param[in] qeip      pointer to the @p QEIDriver object
+ * @return              The velocity in pulses per second (fixed-point).
+ *
+ * @api
+ */
+qeivelocity_t qeiGetVelocity(QEIDriver *qeip) {
+  qeivelocity_t velocity;
+
+  chDbgCheck(qeip != NULL /*, "qeiGetVelocity"*/);
+
+  chSysLock();
+  velocity = qeiGetVelocityI(qeip);
+  chSysUnlock();
+
+  return velocity;
+}
+#endif
+
 #endif /* HAL_USE_QEI */
 
 /** @} */
@@ -0,0 +1,255 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_SVC_BATTERY_H_
+#define _AMIROOS_SVC_BATTERY_H_
+
+#include <amiro-lld.h>
+
+#if defined(AMIROLLD_CFG_USE_BQ27500) || defined(__DOXYGEN__)
+
+#include <alld_bq27500.h>
+#include <aos_snapshot.h>
+#include <aos_time.h>
+
+/**
+ * @brief   Number of consecutive standard command bytes read in a single transaction.
+ * @details Temperature (0x06) to StateOfCharge (0x2C).
+ */
+#define SVC_BATTERY_REGISTERS_SIZE              40
+
+/**
+ * @brief   Runtime value to indicate that the system is not discharging.
+ */
+#define SVC_BATTERY_RUNTIME_INFINITE            ((uint16_t)0xFFFF)
+
+/**
+ * @brief   Standard command values of a BQ27500 fuel gauge as stored in a snapshot.
+ */
+typedef struct svc_battery_registers {
+  uint16_t temperature;         /**< Temperature in 0.1K.                         */
+  uint16_t voltage;             /**< Voltage in mV.                               */
+  uint16_t flags;               /**< Flags register.                              */
+  uint16_t remaining;           /**< Remaining capacity in mAh.                   */
+  uint16_t fullcharge;          /**< Full charge capacity in mAh.                 */
+  int16_t current;              /**< Average current in mA (negative discharging). */
+  uint16_t timetoempty;         /**< Time to empty in minutes (0xFFFF if charging). */
+  uint16_t timetofull;          /**< Time to full in minutes (0xFFFF if discharging). */
+  int16_t power;                /**< Average power in mW.                         */
+  uint16_t cycles;              /**< Number of charge cycles.                     */
+  uint16_t soc;                 /**< State of charge in percent.                  */
+} svc_battery_registers_t;
+
+/**
+ * @brief   Battery level the system view was classified into.
+ */
+typedef enum {
+  SVC_BATTERY_LEVEL_NORMAL = 0,     /**< Above the low threshold.                 */
+  SVC_BATTERY_LEVEL_LOW = 1,        /**< Below the low threshold.                 */
+  SVC_BATTERY_LEVEL_CRITICAL = 2,   /**< Below the critical threshold.            */
+} svc_battery_level_t;
+
+/**
+ * @brief   Single battery pack monitored by a BQ27500 fuel gauge.
+ */
+typedef struct svc_battery_pack {
+  /**
+   * @brief   Name of the pack.
+   */
+  const char* name;
+
+  /**
+   * @brief   Snapshot of the standard commands (see svc_battery_registers_t).
+   * @details The snapshot must read the fuel gauge via svcBatteryReadRegisters().
+   */
+  aos_snapshot_t* snapshot;
+
+  /**
+   * @brief   Most recent register values.
+   */
+  svc_battery_registers_t registers;
+
+  /**
+   * @brief   Uptime of the most recent successful read.
+   */
+  aos_timestamp_t timestamp;
+
+  /**
+   * @brief   Number of failed reads.
+   */
+  uint32_t errors;
+} svc_battery_pack_t;
+
+/**
+ * @brief   Battery service configuration.
+ */
+typedef struct svc_battery_config {
+  /**
+   * @brief   Array of battery packs.
+   */
+  svc_battery_pack_t* packs;
+
+  /**
+   * @brief   Number of battery packs.
+   */
+  size_t numpacks;
+
+  /**
+   * @brief   Refresh interval in microseconds.
+   * @note    The fuel gauges update their standard commands once per second.
+   */
+  aos_interval_t period;
+
+  /**
+   * @brief   Time constant of the current filter for the runtime prediction in microseconds.
+   */
+  aos_interval_t tau;
+
+  /**
+   * @brief   Event source to broadcast level changes to (e.g. aos.events.io).
+   */
+  event_source_t* source;
+
+  /**
+   * @brief   Event flags to broadcast.
+   */
+  struct {
+    eventflags_t low;           /**< Flags when the low threshold was crossed.      */
+    eventflags_t critical;      /**< Flags when the critical threshold was crossed. */
+    eventflags_t normal;        /**< Flags when the level recovered.                */
+  } flags;
+
+  /**
+   * @brief   Thresholds of the combined state of charge in percent.
+   */
+  struct {
+    uint8_t low;                /**< Low threshold.                       */
+    uint8_t critical;           /**< Critical threshold.                  */
+    uint8_t hysteresis;         /**< Hysteresis to leave a level.         */
+  } threshold;
+} svc_battery_config_t;
+
+/**
+ * @brief   Combined view of all battery packs.
+ */
+typedef struct svc_battery_state {
+  /**
+   * @brief   Combined state of charge in percent (capacity weighted).
+   */
+  uint8_t soc;
+
+  /**
+   * @brief   Combined remaining capacity in mAh.
+   */
+  uint32_t remaining;
+
+  /**
+   * @brief   Combined full charge capacity in mAh.
+   */
+  uint32_t fullcharge;
+
+  /**
+   * @brief   Combined average current in mA (negative when discharging).
+   */
+  int32_t current;
+
+  /**
+   * @brief   Low-pass filtered combined current in mA.
+   */
+  float filteredcurrent;
+
+  /**
+   * @brief   Predicted runtime in minutes based on the filtered current.
+   */
+  uint16_t runtime;
+
+  /**
+   * @brief   Lowest pack voltage in mV.
+   */
+  uint16_t voltage;
+
+  /**
+   * @brief   Current battery level.
+   */
+  svc_battery_level_t level;
+
+  /**
+   * @brief   Number of packs with valid data.
+   */
+  uint8_t validpacks;
+
+  /**
+   * @brief   Uptime of the most recent update.
+   */
+  aos_timestamp_t timestamp;
+} svc_battery_state_t;
+
+/**
+ * @brief   Battery service.
+ * @details A thread refreshes the snapshots of all fuel gauges, merges them into a combined view and predicts the remaining
+ *          runtime from the low-pass filtered discharge current.
+ *          Level changes are broadcasted, so no consumer has to poll the fuel gauges.
+ */
+typedef struct svc_battery {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_battery_config_t* config;
+
+  /**
+   * @brief   Combined state.
+   */
+  svc_battery_state_t state;
+
+  /**
+   * @brief   Mutex to protect the state and the pack data.
+   */
+  mutex_t lock;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t updates;     /**< Number of combined updates.          */
+    uint32_t events;      /**< Number of broadcasted level changes. */
+  } stats;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_battery_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  apalExitStatus_t svcBatteryReadRegisters(BQ27500Driver* bq27500, svc_battery_registers_t* registers, apalTime_t timeout);
+  void svcBatteryInit(svc_battery_t* battery, const svc_battery_config_t* config);
+  void svcBatteryStart(svc_battery_t* battery, void* wa, size_t wasize, tprio_t prio);
+  void svcBatteryStop(svc_battery_t* battery);
+  void svcBatteryTeardown(void* battery);
+  void svcBatteryGetState(svc_battery_t* battery, svc_battery_state_t* state);
+  int svcBatteryShellCmd(svc_battery_t* battery, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(AMIROLLD_CFG_USE_BQ27500) */
+
+#endif /* _AMIROOS_SVC_BATTERY_H_ */
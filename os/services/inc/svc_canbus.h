@@ -0,0 +1,243 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_SVC_CANBUS_H_
+#define _AMIROOS_SVC_CANBUS_H_
+
+#include <hal.h>
+
+#if (HAL_USE_CAN == TRUE) || defined(__DOXYGEN__)
+
+#include <aos_time.h>
+#include <svc_canfilter.h>
+#include <svc_canproto.h>
+#include <svc_cantx.h>
+
+#if (CH_CFG_USE_MAILBOXES != TRUE) || (CH_CFG_USE_MEMPOOLS != TRUE)
+#error "the CAN bus service requires CH_CFG_USE_MAILBOXES and CH_CFG_USE_MEMPOOLS enabled"
+#endif
+
+/**
+ * @brief   Maximum payload of a message in bytes.
+ */
+#define SVC_CANBUS_MAXPAYLOAD                   64
+
+/**
+ * @brief   Number of messages which can be reassembled concurrently.
+ */
+#define SVC_CANBUS_REASSEMBLYSLOTS              4
+
+/**
+ * @brief   Topic for the time references of the SSSP master.
+ * @details Lower topics win the bus arbitration, so topics are ordered by their latency requirements.
+ */
+#define SVC_CANBUS_TOPIC_TIMESYNC               0x010
+
+/**
+ * @brief   Topic for odometry data.
+ */
+#define SVC_CANBUS_TOPIC_ODOMETRY               0x100
+
+/**
+ * @brief   Topic for proximity data.
+ */
+#define SVC_CANBUS_TOPIC_PROXIMITY              0x200
+
+/**
+ * @brief   Topic for power and battery data.
+ */
+#define SVC_CANBUS_TOPIC_POWER                  0x300
+
+/**
+ * @brief   Received message.
+ * @details Messages are taken from the pool of the service and must be returned via svcCanBusRelease().
+ */
+typedef struct svc_canbus_message {
+  uint16_t topic;                         /**< Topic of the message.                */
+  uint8_t source;                         /**< Module ID of the publisher.          */
+  uint16_t length;                        /**< Length of the payload.               */
+  aos_timestamp_t timestamp;              /**< Uptime when the message completed.   */
+  uint8_t data[SVC_CANBUS_MAXPAYLOAD];    /**< Payload.                             */
+} svc_canbus_message_t;
+
+/**
+ * @brief   Subscription of a topic.
+ */
+typedef struct svc_canbus_subscription {
+  /**
+   * @brief   Pointer to the next subscription.
+   */
+  struct svc_canbus_subscription* next;
+
+  /**
+   * @brief   Subscribed topic.
+   */
+  uint16_t topic;
+
+  /**
+   * @brief   Queue of received messages.
+   */
+  mailbox_t mailbox;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t received;    /**< Number of messages queued.                       */
+    uint32_t overflows;   /**< Number of messages dropped due to a full queue.  */
+  } stats;
+} svc_canbus_subscription_t;
+
+/**
+ * @brief   CAN bus service configuration.
+ */
+typedef struct svc_canbus_config {
+  /**
+   * @brief   CAN driver (must be started before the service).
+   */
+  CANDriver* driver;
+
+  /**
+   * @brief   Transmit scheduler for the fragments of published messages.
+   */
+  svc_cantx_t* scheduler;
+
+  /**
+   * @brief   Storage for the message pool.
+   */
+  svc_canbus_message_t* messages;
+
+  /**
+   * @brief   Number of messages in the pool.
+   */
+  size_t nummessages;
+} svc_canbus_config_t;
+
+/**
+ * @brief   Topic based publish/subscribe service on the CAN bus.
+ * @details Messages are transmitted as a sequence of extended data frames, which carry the topic, the publisher and the
+ *          position of the fragment in their identifier (see svc_canproto.h), so the payload of each frame is used
+ *          completely.
+ *          Received fragments are written directly to a message taken from a pool, which is handed to the subscriber
+ *          without a further copy once it is complete.
+ *          The hardware acceptance filters are compiled from the subscribed topics and reprogrammed whenever a topic is
+ *          subscribed or unsubscribed, so frames of other topics do not cause any interrupts at all.
+ *          If the filter banks do not suffice, neighboring topics share a bank and the surplus frames are dropped in
+ *          software, which is reported in the statistics.
+ */
+typedef struct svc_canbus {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_canbus_config_t* config;
+
+  /**
+   * @brief   Pool of free messages.
+   */
+  memory_pool_t pool;
+
+  /**
+   * @brief   List of subscriptions.
+   */
+  svc_canbus_subscription_t* subscriptions;
+
+  /**
+   * @brief   Messages in reassembly.
+   */
+  struct {
+    svc_canproto_reassembly_t context;    /**< Reassembly context.                    */
+    svc_canbus_message_t* message;        /**< Message in progress or NULL if unused. */
+  } reassembly[SVC_CANBUS_REASSEMBLYSLOTS];
+
+  /**
+   * @brief   Next reassembly slot to reuse if all are occupied.
+   */
+  uint8_t victim;
+
+  /**
+   * @brief   Compiled filter banks.
+   */
+  svc_canfilter_bank_t banks[STM32_CAN_MAX_FILTERS];
+
+  /**
+   * @brief   Number of filter banks in use.
+   */
+  uint8_t filters;
+
+  /**
+   * @brief   Flag whether the filters accept all frames.
+   */
+  bool acceptall;
+
+  /**
+   * @brief   Mutex to protect the subscriptions, reassembly slots and filters.
+   */
+  mutex_t rxlock;
+
+  /**
+   * @brief   Mutex to keep the fragments of a message together.
+   */
+  mutex_t txlock;
+
+  /**
+   * @brief   Sequence number of the next published message.
+   */
+  uint8_t sequence;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t rxframes;     /**< Number of received frames.                            */
+    uint32_t txframes;     /**< Number of frames queued for transmission.             */
+    uint32_t published;    /**< Number of published messages.                         */
+    uint32_t delivered;    /**< Number of messages handed to subscribers.             */
+    uint32_t filtered;     /**< Number of frames passing the filters, but dropped.    */
+    uint32_t lost;         /**< Number of messages dropped due to missing fragments.  */
+    uint32_t nobuffer;     /**< Number of messages dropped due to an empty pool.      */
+    uint32_t txerrors;     /**< Number of frames which could not be queued.           */
+    uint32_t reprogrammed; /**< Number of filter updates.                             */
+  } stats;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_canbus_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcCanBusInit(svc_canbus_t* bus, const svc_canbus_config_t* config);
+  void svcCanBusSubscribe(svc_canbus_t* bus, svc_canbus_subscription_t* sub, uint16_t topic, msg_t* queue, size_t depth);
+  void svcCanBusUnsubscribe(svc_canbus_t* bus, svc_canbus_subscription_t* sub);
+  void svcCanBusStart(svc_canbus_t* bus, void* wa, size_t wasize, tprio_t prio);
+  void svcCanBusStop(svc_canbus_t* bus);
+  void svcCanBusTeardown(void* bus);
+  msg_t svcCanBusPublish(svc_canbus_t* bus, uint16_t topic, svc_cantx_class_t txclass, const void* data, size_t length, sysinterval_t timeout);
+  svc_canbus_message_t* svcCanBusReceive(svc_canbus_subscription_t* sub, sysinterval_t timeout);
+  void svcCanBusRelease(svc_canbus_t* bus, svc_canbus_message_t* message);
+  int svcCanBusShellCmd(svc_canbus_t* bus, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* (HAL_USE_CAN == TRUE) */
+
+#endif /* _AMIROOS_SVC_CANBUS_H_ */
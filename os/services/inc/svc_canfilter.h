@@ -0,0 +1,71 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_SVC_CANFILTER_H_
+#define _AMIROOS_SVC_CANFILTER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief   Maximum number of rules which can be compiled at once.
+ */
+#define SVC_CANFILTER_MAXRULES                  16
+
+/**
+ * @brief   Acceptance rule for CAN data frames.
+ * @details A frame is accepted if its identifier matches the rule in all bits set in the mask.
+ */
+typedef struct svc_canfilter_rule {
+  uint32_t id;                  /**< Identifier to match (11 or 29 bit).            */
+  uint32_t mask;                /**< Identifier bits which must match.              */
+  bool extended;                /**< Flag whether the rule applies to extended IDs. */
+} svc_canfilter_rule_t;
+
+/**
+ * @brief   Configuration of a bxCAN filter bank.
+ */
+typedef enum svc_canfilter_mode {
+  SVC_CANFILTER_MASK32,         /**< One 32 bit identifier/mask pair.               */
+  SVC_CANFILTER_LIST32,         /**< Two 32 bit identifiers.                        */
+  SVC_CANFILTER_MASK16,         /**< Two 16 bit identifier/mask pairs.              */
+  SVC_CANFILTER_LIST16,         /**< Four 16 bit identifiers.                       */
+} svc_canfilter_mode_t;
+
+/**
+ * @brief   Compiled filter bank.
+ * @details The register values are in the format of the bxCAN filter bank registers.
+ */
+typedef struct svc_canfilter_bank {
+  svc_canfilter_mode_t mode;    /**< Mode and scale of the bank.                    */
+  uint32_t fr1;                 /**< Value of the first filter bank register.       */
+  uint32_t fr2;                 /**< Value of the second filter bank register.      */
+} svc_canfilter_bank_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  int svcCanFilterCompile(svc_canfilter_rule_t* rules, size_t numrules, svc_canfilter_bank_t* banks, size_t maxbanks);
+  bool svcCanFilterMatch(const svc_canfilter_bank_t* banks, size_t numbanks, bool extended, uint32_t id);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_SVC_CANFILTER_H_ */
@@ -0,0 +1,105 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_SVC_CANPROTO_H_
+#define _AMIROOS_SVC_CANPROTO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief   Maximum number of payload bytes per CAN frame.
+ */
+#define SVC_CANPROTO_FRAMESIZE                  8
+
+/**
+ * @brief   Maximum number of fragments of a message.
+ */
+#define SVC_CANPROTO_MAXFRAGMENTS               64
+
+/**
+ * @brief   Maximum topic identifier.
+ */
+#define SVC_CANPROTO_MAXTOPIC                   0x0FFFu
+
+/**
+ * @brief   Position of the topic in the extended CAN identifier.
+ * @details Layout of the 29 bit identifier (lower topics win the arbitration):
+ *          [topic:12] [source module:8] [fragment index:6] [last fragment:1] [sequence number:2]
+ */
+#define SVC_CANPROTO_TOPICSHIFT                 17
+
+/**
+ * @brief   Bits of the extended CAN identifier that hold the topic.
+ */
+#define SVC_CANPROTO_TOPICMASK                  ((uint32_t)SVC_CANPROTO_MAXTOPIC << SVC_CANPROTO_TOPICSHIFT)
+
+/**
+ * @brief   Decoded extended CAN identifier of a message fragment.
+ */
+typedef struct svc_canproto_header {
+  uint16_t topic;               /**< Topic of the message.                          */
+  uint8_t source;               /**< Module ID of the publisher.                    */
+  uint8_t index;                /**< Index of the fragment.                         */
+  bool last;                    /**< Flag whether this is the last fragment.        */
+  uint8_t sequence;             /**< Sequence number of the message (2 bit).        */
+} svc_canproto_header_t;
+
+/**
+ * @brief   Result of feeding a fragment to a reassembly context.
+ */
+typedef enum svc_canproto_result {
+  SVC_CANPROTO_PENDING,         /**< The fragment was accepted, more are expected.  */
+  SVC_CANPROTO_COMPLETE,        /**< The fragment completed the message.            */
+  SVC_CANPROTO_LOST,            /**< A fragment was missed, the message is dropped. */
+  SVC_CANPROTO_OVERFLOW,        /**< The message exceeds the buffer and is dropped. */
+} svc_canproto_result_t;
+
+/**
+ * @brief   Reassembly context of a fragmented message.
+ * @details Fragments are copied to their final position in the buffer, so a completed message can be handed to the
+ *          receiver without any further copy.
+ *          Since the publisher transmits the fragments of a message back-to-back and in order, any gap is treated as loss.
+ */
+typedef struct svc_canproto_reassembly {
+  uint8_t* buffer;              /**< Buffer for the payload.                        */
+  size_t size;                  /**< Size of the buffer.                            */
+  size_t length;                /**< Number of payload bytes received so far.       */
+  uint16_t topic;               /**< Topic of the message in progress.              */
+  uint8_t source;               /**< Publisher of the message in progress.          */
+  uint8_t sequence;             /**< Sequence number of the message in progress.    */
+  uint8_t next;                 /**< Index of the next expected fragment.           */
+  bool active;                  /**< Flag whether a message is in progress.         */
+} svc_canproto_reassembly_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  uint32_t svcCanProtoEncodeId(const svc_canproto_header_t* header);
+  void svcCanProtoDecodeId(uint32_t id, svc_canproto_header_t* header);
+  uint8_t svcCanProtoNumFragments(size_t length);
+  uint8_t svcCanProtoFragment(uint16_t topic, uint8_t source, uint8_t sequence, size_t length, uint8_t index, uint32_t* id);
+  void svcCanProtoReassemblyInit(svc_canproto_reassembly_t* reassembly, uint8_t* buffer, size_t size);
+  svc_canproto_result_t svcCanProtoReassemble(svc_canproto_reassembly_t* reassembly, const svc_canproto_header_t* header, const uint8_t* data, uint8_t dlc);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_SVC_CANPROTO_H_ */
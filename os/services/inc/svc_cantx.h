@@ -0,0 +1,162 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_CANTX_H_
+#define _AMIROOS_SVC_CANTX_H_
+
+#include <hal.h>
+
+#if (HAL_USE_CAN == TRUE) || defined(__DOXYGEN__)
+
+#include <aos_time.h>
+
+/**
+ * @brief   Transmission classes in descending priority.
+ */
+typedef enum svc_cantx_class {
+  SVC_CANTX_CONTROL = 0,    /**< Time-critical control traffic, which may use all transmit mailboxes.         */
+  SVC_CANTX_DATA = 1,       /**< Regular sensor data.                                                         */
+  SVC_CANTX_BULK = 2,       /**< Telemetry and log traffic, which is dropped if it could not be sent in time.  */
+} svc_cantx_class_t;
+
+/**
+ * @brief   Number of transmission classes.
+ */
+#define SVC_CANTX_NUMCLASSES                    3
+
+/**
+ * @brief   Queued frame.
+ */
+typedef struct svc_cantx_entry {
+  CANTxFrame frame;           /**< The frame to transmit.                             */
+  aos_timestamp_t enqueued;   /**< Uptime when the frame was queued.                  */
+  aos_timestamp_t deadline;   /**< Uptime after which the frame is dropped or 0.      */
+} svc_cantx_entry_t;
+
+/**
+ * @brief   Configuration of a transmission class.
+ */
+typedef struct svc_cantx_classconfig {
+  /**
+   * @brief   Storage for the queue.
+   */
+  svc_cantx_entry_t* entries;
+
+  /**
+   * @brief   Number of frames the queue can hold.
+   */
+  size_t size;
+
+  /**
+   * @brief   Maximum time a frame may wait before it is dropped (0 for no deadline).
+   */
+  aos_interval_t lifetime;
+} svc_cantx_classconfig_t;
+
+/**
+ * @brief   CAN transmit scheduler configuration.
+ */
+typedef struct svc_cantx_config {
+  /**
+   * @brief   CAN driver (must be started before the service).
+   */
+  CANDriver* driver;
+
+  /**
+   * @brief   Configuration of the transmission classes.
+   */
+  svc_cantx_classconfig_t classes[SVC_CANTX_NUMCLASSES];
+} svc_cantx_config_t;
+
+/**
+ * @brief   Prioritized transmit scheduler for the CAN bus.
+ * @details Each transmission class has its own queue and frames are handed to the transmit mailboxes in the order of
+ *          their class, so control frames never wait behind queued telemetry.
+ *          The last free mailbox is reserved for control traffic, which thus waits for the frame on the wire at most.
+ *          Since the controller arbitrates the pending mailboxes by identifier (CAN_MCR_TXFP cleared), a frame is only
+ *          handed to a mailbox if it has a higher identifier than all pending frames of its class, which preserves the
+ *          order within each class (e.g. of the fragments of a message).
+ *          Mailboxes are refilled back-to-back by a thread that is woken by the transmit interrupt, while frames that
+ *          find a free mailbox are handed to it directly by the caller.
+ *          Frames of classes with a lifetime are dropped once their deadline has passed.
+ *          All transmissions must go through the scheduler while it is running.
+ */
+typedef struct svc_cantx {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_cantx_config_t* config;
+
+  /**
+   * @brief   State of the transmission classes.
+   */
+  struct {
+    size_t head;                /**< Index of the oldest queued frame.            */
+    size_t count;               /**< Number of queued frames.                     */
+    threads_queue_t waiting;    /**< Threads waiting for space in the queue.      */
+
+    /**
+     * @brief   Statistics.
+     */
+    struct {
+      uint32_t frames;          /**< Number of transmitted frames.                */
+      uint32_t expired;         /**< Number of frames dropped after the deadline. */
+      size_t peak;              /**< Maximum number of queued frames.             */
+      aos_interval_t min;       /**< Minimum latency in microseconds.             */
+      aos_interval_t max;       /**< Maximum latency in microseconds.             */
+      uint64_t total;           /**< Sum of all latencies in microseconds.        */
+    } stats;
+  } classes[SVC_CANTX_NUMCLASSES];
+
+  /**
+   * @brief   Frames in the transmit mailboxes.
+   */
+  struct {
+    bool pending;               /**< Flag whether the mailbox is in use.          */
+    uint8_t txclass;            /**< Class of the frame.                          */
+    uint32_t priority;          /**< Arbitration priority of the frame.           */
+    aos_timestamp_t enqueued;   /**< Uptime when the frame was queued.            */
+  } mailboxes[CAN_TX_MAILBOXES];
+
+  /**
+   * @brief   Number of frames which were aborted or failed.
+   */
+  uint32_t failed;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_cantx_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcCanTxInit(svc_cantx_t* tx, const svc_cantx_config_t* config);
+  void svcCanTxStart(svc_cantx_t* tx, void* wa, size_t wasize, tprio_t prio);
+  void svcCanTxStop(svc_cantx_t* tx);
+  void svcCanTxTeardown(void* tx);
+  msg_t svcCanTxEnqueue(svc_cantx_t* tx, svc_cantx_class_t txclass, const CANTxFrame* frame, sysinterval_t timeout);
+  int svcCanTxShellCmd(svc_cantx_t* tx, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* (HAL_USE_CAN == TRUE) */
+
+#endif /* _AMIROOS_SVC_CANTX_H_ */
@@ -0,0 +1,92 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_SVC_CPUFREQ_H_
+#define _AMIROOS_SVC_CPUFREQ_H_
+
+#include <aosconf.h>
+#include <hal.h>
+#include <aos_clock.h>
+#include <aos_time.h>
+
+/**
+ * @brief   CPU frequency governor configuration.
+ */
+typedef struct svc_cpufreq_config {
+  /**
+   * @brief   Period of the load measurement in microseconds.
+   */
+  aos_interval_t period;
+
+  /**
+   * @brief   Load in permille, above which the fastest clock level is selected.
+   */
+  uint16_t up;
+
+  /**
+   * @brief   Load in permille, which must not be reached at the next slower clock level to step down.
+   */
+  uint16_t down;
+} svc_cpufreq_config_t;
+
+/**
+ * @brief   CPU frequency governor.
+ * @details The load of the core is derived from the time spent in the idle modes.
+ *          Bursts immediately raise the clock to the fastest level, so they are served at full speed, while the clock
+ *          is lowered step by step as long as the load projected to the next slower level stays below a threshold.
+ */
+typedef struct svc_cpufreq {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_cpufreq_config_t* config;
+
+  /**
+   * @brief   Load of the last period in permille.
+   */
+  uint16_t load;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t samples;   /**< Number of load measurements.           */
+    uint32_t boosts;    /**< Number of switches to the fastest level. */
+    uint32_t steps;     /**< Number of steps to a slower level.       */
+  } stats;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_cpufreq_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcCpuFreqInit(svc_cpufreq_t* cpufreq, const svc_cpufreq_config_t* config);
+  void svcCpuFreqStart(svc_cpufreq_t* cpufreq, void* wa, size_t wasize, tprio_t prio);
+  void svcCpuFreqStop(svc_cpufreq_t* cpufreq);
+  void svcCpuFreqTeardown(void* cpufreq);
+  int svcCpuFreqShellCmd(svc_cpufreq_t* cpufreq, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_SVC_CPUFREQ_H_ */
@@ -0,0 +1,297 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_DIFFDRIVE_H_
+#define _AMIROOS_SVC_DIFFDRIVE_H_
+
+#include <hal.h>
+#include <amiro-lld.h>
+#if (HAL_USE_QEI == TRUE)
+#include <hal_qei.h>
+#endif
+
+#if (defined(AMIROLLD_CFG_USE_A3906) && (HAL_USE_GPT == TRUE) && (HAL_USE_PWM == TRUE) && (HAL_USE_QEI == TRUE) && (QEI_USE_VELOCITY == TRUE)) || defined(__DOXYGEN__)
+
+#include <alld_a3906.h>
+
+#if (CH_CFG_USE_TM != TRUE)
+#error "the differential drive service requires CH_CFG_USE_TM enabled"
+#endif
+
+/**
+ * @brief   Number of fractional bits of the fixed-point controller gains.
+ */
+#define SVC_DIFFDRIVE_GAIN_FRACBITS             24
+
+/**
+ * @brief   Number of fractional bits of the controller output.
+ * @details An output of (1 << SVC_DIFFDRIVE_OUTPUT_FRACBITS) corresponds to full PWM duty.
+ */
+#define SVC_DIFFDRIVE_OUTPUT_FRACBITS           16
+
+/**
+ * @brief   Identifiers of the wheels.
+ */
+typedef enum {
+  SVC_DIFFDRIVE_WHEEL_LEFT = 0,   /**< Left wheel.  */
+  SVC_DIFFDRIVE_WHEEL_RIGHT = 1,  /**< Right wheel. */
+  SVC_DIFFDRIVE_NUMWHEELS = 2,    /**< Number of wheels. */
+} svc_diffdrive_wheelid_t;
+
+/**
+ * @brief   Controller gains.
+ * @details The controller output is given as fraction of full PWM duty [-1, 1], the input in encoder increments per second.
+ */
+typedef struct svc_diffdrive_gains {
+  float kp;   /**< Proportional gain [1/(inc/s)].                */
+  float ki;   /**< Integral gain [1/inc].                        */
+  float kd;   /**< Derivative gain [s/(inc/s)].                  */
+  float kff;  /**< Velocity feed-forward gain [1/(inc/s)].       */
+  float kfs;  /**< Static friction feed-forward (duty fraction). */
+} svc_diffdrive_gains_t;
+
+/**
+ * @brief   Hardware configuration of a single wheel.
+ */
+typedef struct svc_diffdrive_wheelconfig {
+  QEIDriver* qei;         /**< Encoder of the wheel.           */
+  pwmchannel_t forward;   /**< PWM channel to drive forward.   */
+  pwmchannel_t backward;  /**< PWM channel to drive backward.  */
+} svc_diffdrive_wheelconfig_t;
+
+/**
+ * @brief   Differential drive configuration.
+ */
+typedef struct svc_diffdrive_config {
+  /**
+   * @brief   Timer to trigger the control loop.
+   */
+  GPTDriver* gpt;
+
+  /**
+   * @brief   Frequency of the timer in Hz.
+   */
+  gptfreq_t gptfrequency;
+
+  /**
+   * @brief   Control loop rate in Hz.
+   */
+  uint32_t rate;
+
+  /**
+   * @brief   PWM driver of the motors.
+   */
+  PWMDriver* pwm;
+
+  /**
+   * @brief   Motor driver (used for power control only).
+   */
+  A3906Driver* motors;
+
+  /**
+   * @brief   Wheel configurations (see @p svc_diffdrive_wheelid_t).
+   */
+  svc_diffdrive_wheelconfig_t wheels[SVC_DIFFDRIVE_NUMWHEELS];
+
+  /**
+   * @brief   Encoder increments per wheel revolution.
+   */
+  uint32_t increments;
+
+  /**
+   * @brief   Wheel diameter in meters.
+   */
+  float wheeldiameter;
+
+  /**
+   * @brief   Distance between the wheels in meters.
+   */
+  float wheelbase;
+
+  /**
+   * @brief   Initial controller gains.
+   */
+  svc_diffdrive_gains_t gains;
+} svc_diffdrive_config_t;
+
+/**
+ * @brief   Controller state of a single wheel.
+ */
+typedef struct svc_diffdrive_wheel {
+  /**
+   * @brief   Target velocity in increments per second (Q16.16).
+   */
+  qeivelocity_t setpoint;
+
+  /**
+   * @brief   Measured velocity in increments per second (Q16.16).
+   */
+  qeivelocity_t velocity;
+
+  /**
+   * @brief   Most recent control error (Q16.16).
+   */
+  int32_t error;
+
+  /**
+   * @brief   Integrator state (@p SVC_DIFFDRIVE_GAIN_FRACBITS + @p SVC_DIFFDRIVE_OUTPUT_FRACBITS fractional bits).
+   */
+  int64_t integral;
+
+  /**
+   * @brief   Applied output (@p SVC_DIFFDRIVE_OUTPUT_FRACBITS fractional bits).
+   */
+  int32_t output;
+
+  /**
+   * @brief   Number of saturated control cycles.
+   */
+  uint32_t saturations;
+} svc_diffdrive_wheel_t;
+
+/**
+ * @brief   Differential drive controller service.
+ * @details Both wheels are controlled by a fixed-point PID loop with feed-forward and anti-windup (conditional integration).
+ *          The loop is executed directly in the callback of a hardware timer, so it is not affected by thread scheduling.
+ */
+typedef struct svc_diffdrive {
+  /**
+   * @brief   Timer configuration.
+   * @details Must be the first member, since the timer callback retrieves the service object from the active configuration.
+   */
+  GPTConfig gptconfig;
+
+  /**
+   * @brief   Hardware configuration.
+   */
+  const svc_diffdrive_config_t* config;
+
+  /**
+   * @brief   Active gains in fixed-point representation.
+   */
+  struct {
+    int32_t kp;   /**< Proportional gain (@p SVC_DIFFDRIVE_GAIN_FRACBITS).     */
+    int32_t ki;   /**< Integral gain per cycle (@p SVC_DIFFDRIVE_GAIN_FRACBITS). */
+    int32_t kd;   /**< Derivative gain per cycle (@p SVC_DIFFDRIVE_GAIN_FRACBITS). */
+    int32_t kff;  /**< Feed-forward gain (@p SVC_DIFFDRIVE_GAIN_FRACBITS).     */
+    int32_t kfs;  /**< Static friction offset (@p SVC_DIFFDRIVE_OUTPUT_FRACBITS). */
+  } gains;
+
+  /**
+   * @brief   Increments per micrometer (32 fractional bits).
+   */
+  uint32_t incperum;
+
+  /**
+   * @brief   Half the wheel base in micrometers.
+   */
+  uint32_t halfbase;
+
+  /**
+   * @brief   Most recent velocity command.
+   */
+  struct {
+    int32_t linear;   /**< Linear velocity in micrometers per second.   */
+    int32_t angular;  /**< Angular velocity in microradians per second. */
+  } command;
+
+  /**
+   * @brief   Controller states of both wheels.
+   */
+  svc_diffdrive_wheel_t wheels[SVC_DIFFDRIVE_NUMWHEELS];
+
+  /**
+   * @brief   Loop timing statistics.
+   */
+  struct {
+    /**
+     * @brief   Execution time of the control loop.
+     */
+    time_measurement_t execution;
+
+    /**
+     * @brief   Realtime counter value at the beginning of the previous cycle.
+     */
+    rtcnt_t last;
+
+    /**
+     * @brief   Nominal cycle period in microseconds.
+     */
+    uint32_t period;
+
+    /**
+     * @brief   Shortest interval between two cycles in microseconds.
+     */
+    uint32_t intervalmin;
+
+    /**
+     * @brief   Longest interval between two cycles in microseconds.
+     */
+    uint32_t intervalmax;
+
+    /**
+     * @brief   Number of executed cycles.
+     */
+    uint32_t cycles;
+
+    /**
+     * @brief   Number of cycles which took longer than the period.
+     */
+    uint32_t overruns;
+
+    /**
+     * @brief   Number of cycles which started more than half a period late.
+     */
+    uint32_t late;
+  } timing;
+
+  /**
+   * @brief   Mutex to serialize enabling and disabling the motors.
+   */
+  mutex_t lock;
+
+  /**
+   * @brief   Flag whether the motors are driven by the controller.
+   */
+  bool enabled;
+
+  /**
+   * @brief   Flag whether the control loop is running.
+   */
+  bool running;
+} svc_diffdrive_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcDiffDriveInit(svc_diffdrive_t* dd, const svc_diffdrive_config_t* config);
+  void svcDiffDriveSetGains(svc_diffdrive_t* dd, const svc_diffdrive_gains_t* gains);
+  void svcDiffDriveStart(svc_diffdrive_t* dd);
+  void svcDiffDriveStop(svc_diffdrive_t* dd);
+  void svcDiffDriveTeardown(void* dd);
+  void svcDiffDriveSetVelocity(svc_diffdrive_t* dd, int32_t linear, int32_t angular);
+  void svcDiffDriveDisable(svc_diffdrive_t* dd);
+  void svcDiffDriveResetTiming(svc_diffdrive_t* dd);
+  int svcDiffDriveShellCmd(svc_diffdrive_t* dd, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(AMIROLLD_CFG_USE_A3906) && (HAL_USE_GPT == TRUE) && (HAL_USE_PWM == TRUE) && (HAL_USE_QEI == TRUE) && (QEI_USE_VELOCITY == TRUE) */
+
+#endif /* _AMIROOS_SVC_DIFFDRIVE_H_ */
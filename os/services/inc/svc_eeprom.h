@@ -0,0 +1,142 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_EEPROM_H_
+#define _AMIROOS_SVC_EEPROM_H_
+
+#include <hal.h>
+#include <amiro-lld.h>
+
+#if defined(AMIROLLD_CFG_USE_AT24C01BN) || defined(__DOXYGEN__)
+
+#include <alld_at24c01bn-sh-b.h>
+#include <aos_time.h>
+
+/**
+ * @brief   Size of the cached EEPROM in bytes.
+ */
+#define SVC_EEPROM_SIZE                         AT24C01BN_LLD_SIZE_BYTES
+
+/**
+ * @brief   Page size of the EEPROM in bytes.
+ */
+#define SVC_EEPROM_PAGESIZE                     AT24C01BN_LLD_PAGE_SIZE_BYTES
+
+/**
+ * @brief   Number of pages of the EEPROM.
+ */
+#define SVC_EEPROM_NUMPAGES                     (SVC_EEPROM_SIZE / SVC_EEPROM_PAGESIZE)
+
+#if (SVC_EEPROM_PAGESIZE > 8)
+#error "the dirty mask of a page must fit into a single byte"
+#endif
+
+/**
+ * @brief   EEPROM cache configuration.
+ */
+typedef struct svc_eeprom_config {
+  /**
+   * @brief   EEPROM driver.
+   */
+  AT24C01BNDriver* driver;
+
+  /**
+   * @brief   I2C timeout in microseconds.
+   */
+  apalTime_t timeout;
+
+  /**
+   * @brief   Delay between the first write and the asynchronous flush in microseconds.
+   * @details Writes within this interval are merged, so each page is written only once.
+   */
+  aos_interval_t delay;
+} svc_eeprom_config_t;
+
+/**
+ * @brief   Write-through EEPROM cache.
+ * @details The whole device is held in RAM, so reads never access the bus.
+ *          Written bytes which differ from the cached content are marked dirty and a thread writes them back
+ *          asynchronously, using a single page write per dirty page.
+ */
+typedef struct svc_eeprom {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_eeprom_config_t* config;
+
+  /**
+   * @brief   Cached content of the EEPROM.
+   */
+  uint8_t cache[SVC_EEPROM_SIZE];
+
+  /**
+   * @brief   Dirty masks of all pages (one bit per byte).
+   */
+  uint8_t dirty[SVC_EEPROM_NUMPAGES];
+
+  /**
+   * @brief   Flag whether the cache was loaded successfully.
+   */
+  bool valid;
+
+  /**
+   * @brief   Mutex to protect the cache and the dirty masks.
+   */
+  mutex_t lock;
+
+  /**
+   * @brief   Mutex to serialize flushes.
+   */
+  mutex_t flushlock;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t writes;      /**< Number of write requests which modified the cache.   */
+    uint32_t merged;      /**< Number of writes merged into an already dirty page.  */
+    uint32_t pagewrites;  /**< Number of page writes to the device.                 */
+    uint32_t bytes;       /**< Number of bytes written to the device.               */
+    uint32_t errors;      /**< Number of failed transactions.                       */
+  } stats;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_eeprom_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcEepromInit(svc_eeprom_t* eeprom, const svc_eeprom_config_t* config);
+  void svcEepromStart(svc_eeprom_t* eeprom, void* wa, size_t wasize, tprio_t prio);
+  void svcEepromStop(svc_eeprom_t* eeprom);
+  void svcEepromTeardown(void* eeprom);
+  apalExitStatus_t svcEepromLoad(svc_eeprom_t* eeprom);
+  apalExitStatus_t svcEepromRead(svc_eeprom_t* eeprom, size_t address, uint8_t* buffer, size_t length);
+  apalExitStatus_t svcEepromWrite(svc_eeprom_t* eeprom, size_t address, const uint8_t* data, size_t length);
+  apalExitStatus_t svcEepromFlush(svc_eeprom_t* eeprom);
+  int svcEepromShellCmd(svc_eeprom_t* eeprom, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(AMIROLLD_CFG_USE_AT24C01BN) */
+
+#endif /* _AMIROOS_SVC_EEPROM_H_ */
@@ -0,0 +1,146 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_FRAMEBUFFER_H_
+#define _AMIROOS_SVC_FRAMEBUFFER_H_
+
+#include <hal.h>
+#include <amiro-lld.h>
+
+#if (defined(AMIROLLD_CFG_USE_TLC5947) && (HAL_USE_SPI == TRUE)) || defined(__DOXYGEN__)
+
+#include <alld_tlc5947.h>
+#include <aos_time.h>
+
+#if (CH_CFG_USE_TM != TRUE)
+#error "the frame buffer service requires CH_CFG_USE_TM enabled"
+#endif
+
+/**
+ * @brief   Event flag which is broadcasted after each refresh period (whether a new frame was latched or not).
+ */
+#define SVC_FRAMEBUFFER_EVENTFLAG_VSYNC         (eventflags_t)(1 << 0)
+
+/**
+ * @brief   Frame buffer configuration.
+ */
+typedef struct svc_framebuffer_config {
+  /**
+   * @brief   LED PWM driver.
+   */
+  TLC5947Driver* driver;
+
+  /**
+   * @brief   SPI driver the LED PWM driver is connected to.
+   * @details The SPI driver must already be started with the XLAT signal configured as chip select line.
+   */
+  SPIDriver* spid;
+
+  /**
+   * @brief   Refresh period in microseconds.
+   */
+  aos_interval_t period;
+} svc_framebuffer_config_t;
+
+/**
+ * @brief   Double buffered LED frame buffer.
+ * @details Drawing is done in the back buffer, which is published by svcFrameBufferSwap().
+ *          A published frame is latched at the next refresh period, while the front buffer is only accessed by the
+ *          refresh thread.
+ *          Since published frames wait in a separate slot, drawing never has to wait for an ongoing SPI transfer and a
+ *          frame is always latched as a whole.
+ */
+typedef struct svc_framebuffer {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_framebuffer_config_t* config;
+
+  /**
+   * @brief   Memory of all buffers.
+   */
+  tlc5947_lld_buffer_t buffers[3];
+
+  /**
+   * @brief   Buffer which is transmitted by the refresh thread.
+   */
+  tlc5947_lld_buffer_t* front;
+
+  /**
+   * @brief   Most recently published buffer.
+   */
+  tlc5947_lld_buffer_t* pending;
+
+  /**
+   * @brief   Buffer to draw to.
+   */
+  tlc5947_lld_buffer_t* back;
+
+  /**
+   * @brief   Flag whether the pending buffer holds a frame which was not latched yet.
+   */
+  bool ready;
+
+  /**
+   * @brief   Flag whether the LEDs are enabled (otherwise BLANK is held active).
+   */
+  bool enabled;
+
+  /**
+   * @brief   Event source for vsync events.
+   */
+  event_source_t source;
+
+  /**
+   * @brief   Duration of the SPI transfers (in realtime counter ticks).
+   */
+  time_measurement_t transfertime;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t latched;   /**< Number of latched frames.                          */
+    uint32_t dropped;   /**< Number of published frames which were never latched. */
+    uint32_t overruns;  /**< Number of missed refresh periods.                  */
+  } stats;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_framebuffer_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcFrameBufferInit(svc_framebuffer_t* fb, const svc_framebuffer_config_t* config);
+  void svcFrameBufferStart(svc_framebuffer_t* fb, void* wa, size_t wasize, tprio_t prio);
+  void svcFrameBufferStop(svc_framebuffer_t* fb);
+  void svcFrameBufferTeardown(void* fb);
+  tlc5947_lld_buffer_t* svcFrameBufferGetBack(svc_framebuffer_t* fb);
+  void svcFrameBufferSwap(svc_framebuffer_t* fb);
+  void svcFrameBufferSetEnabled(svc_framebuffer_t* fb, bool enable);
+  int svcFrameBufferShellCmd(svc_framebuffer_t* fb, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(AMIROLLD_CFG_USE_TLC5947) && (HAL_USE_SPI == TRUE) */
+
+#endif /* _AMIROOS_SVC_FRAMEBUFFER_H_ */
@@ -0,0 +1,304 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_IMU_H_
+#define _AMIROOS_SVC_IMU_H_
+
+#include <hal.h>
+#include <amiro-lld.h>
+
+#if (defined(AMIROLLD_CFG_USE_L3G4200D) && defined(AMIROLLD_CFG_USE_LIS331DLH) && defined(AMIROLLD_CFG_USE_HMC5883L) && defined(AMIROLLD_CFG_USE_AT24C01BN) && (HAL_USE_SPI == TRUE)) || defined(__DOXYGEN__)
+
+#include <alld_hmc5883l.h>
+#include <alld_l3g4200d.h>
+#include <alld_lis331dlh.h>
+#include <aos_time.h>
+#include <svc_eeprom.h>
+#include <svc_imucalib.h>
+#include <svc_imufilter.h>
+
+#if (CH_CFG_USE_TM != TRUE)
+#error "the IMU service requires CH_CFG_USE_TM enabled"
+#endif
+
+/**
+ * @brief   Event flag which is broadcasted after each filter update.
+ */
+#define SVC_IMU_EVENTFLAG_UPDATE                (eventflags_t)(1 << 0)
+
+/**
+ * @brief   Callback function type to forward gyroscope data.
+ * @details The callback is executed in the context of the IMU thread after each filter update.
+ *
+ * @param[in] arg         Argument as specified in the configuration.
+ * @param[in] rate        Bias compensated angular rates in radians per second.
+ * @param[in] timestamp   Uptime of the gyroscope measurement.
+ */
+typedef void (*svc_imu_gyrocb_t)(void* arg, const float rate[3], aos_timestamp_t timestamp);
+
+/**
+ * @brief   IMU configuration.
+ */
+typedef struct svc_imu_config {
+  /**
+   * @brief   Gyroscope driver.
+   */
+  L3G4200DDriver* gyro;
+
+  /**
+   * @brief   SPI configuration of the gyroscope.
+   */
+  SPIConfig* gyrospi;
+
+  /**
+   * @brief   Accelerometer driver (must share the SPI driver with the gyroscope).
+   */
+  LIS331DLHDriver* accel;
+
+  /**
+   * @brief   SPI configuration of the accelerometer.
+   */
+  SPIConfig* accelspi;
+
+  /**
+   * @brief   Compass driver (may be NULL).
+   */
+  HMC5883LDriver* compass;
+
+  /**
+   * @brief   I2C timeout of the compass in microseconds.
+   */
+  apalTime_t compasstimeout;
+
+  /**
+   * @brief   Filter period in microseconds (should match the gyroscope data rate).
+   */
+  aos_interval_t period;
+
+  /**
+   * @brief   Accelerometer is read every n-th filter period.
+   */
+  uint8_t acceldivider;
+
+  /**
+   * @brief   Compass is read every n-th filter period.
+   */
+  uint8_t compassdivider;
+
+  /**
+   * @brief   Gyroscope resolution in radians per second per LSB.
+   */
+  float gyroscale;
+
+  /**
+   * @brief   Number of gyroscope samples to average for bias estimation at startup (0 to keep the calibration).
+   * @details The robot must not move during this phase.
+   */
+  uint16_t biassamples;
+
+  /**
+   * @brief   Standstill detection and online bias estimation.
+   */
+  struct {
+    uint16_t window;        /**< Window length in filter periods (0 to disable).            */
+    float maxstddev;        /**< Maximum standard deviation of the rates in rad/s.          */
+    float maxdeviation;     /**< Maximum deviation of the mean rate from the bias in rad/s. */
+    float weight;           /**< Weight of a standstill window for the bias [0, 1].         */
+  } standstill;
+
+  /**
+   * @brief   Minimum range of compass values of an axis to be included in the ellipsoid fit.
+   */
+  float magspan;
+
+  /**
+   * @brief   EEPROM cache to persist the calibration (may be NULL).
+   * @details The cache must be started before the IMU service.
+   */
+  svc_eeprom_t* eeprom;
+
+  /**
+   * @brief   Address of the calibration in the EEPROM (should be page aligned).
+   */
+  uint8_t eepromaddress;
+
+  /**
+   * @brief   Proportional gain of the filter.
+   */
+  float kp;
+
+  /**
+   * @brief   Integral gain of the filter.
+   */
+  float ki;
+
+  /**
+   * @brief   Optional callback to forward the gyroscope data (may be NULL).
+   */
+  svc_imu_gyrocb_t gyrocb;
+
+  /**
+   * @brief   Argument for the gyroscope callback.
+   */
+  void* gyrocbarg;
+} svc_imu_config_t;
+
+/**
+ * @brief   Orientation estimate.
+ */
+typedef struct svc_imu_orientation {
+  /**
+   * @brief   Orientation quaternion (w, x, y, z).
+   */
+  float q[4];
+
+  /**
+   * @brief   Bias compensated angular rates in radians per second.
+   */
+  float rate[3];
+
+  /**
+   * @brief   Most recent accelerometer data in raw units.
+   */
+  float accel[3];
+
+  /**
+   * @brief   Most recent hard and soft iron compensated compass data.
+   */
+  float mag[3];
+
+  /**
+   * @brief   Uptime of the gyroscope measurement the estimate is based on.
+   */
+  aos_timestamp_t timestamp;
+} svc_imu_orientation_t;
+
+/**
+ * @brief   IMU fusion service.
+ * @details A thread samples the gyroscope with a fixed rate and feeds the orientation filter.
+ *          Accelerometer and compass are sampled at integer fractions of that rate and are only passed to the filter when new
+ *          measurements are available.
+ */
+typedef struct svc_imu {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_imu_config_t* config;
+
+  /**
+   * @brief   Orientation filter.
+   */
+  svc_imufilter_t filter;
+
+  /**
+   * @brief   Active sensor calibration.
+   */
+  svc_imu_calibration_t calibration;
+
+  /**
+   * @brief   Standstill detector for online gyroscope bias estimation.
+   */
+  svc_imucalib_standstill_t standstill;
+
+  /**
+   * @brief   Compass ellipsoid fit.
+   */
+  svc_imucalib_magfit_t magfit;
+
+  /**
+   * @brief   Flag whether compass data is added to the ellipsoid fit.
+   */
+  bool magcalibrating;
+
+  /**
+   * @brief   Mutex to protect the ellipsoid fit.
+   */
+  mutex_t lock;
+
+  /**
+   * @brief   Active sensor configurations.
+   */
+  struct {
+    l3g4200d_lld_cfg_t gyro;          /**< Gyroscope configuration.     */
+    lis331dlh_lld_cfg_t accel;        /**< Accelerometer configuration. */
+  } sensorcfg;
+
+  /**
+   * @brief   Most recent raw samples.
+   */
+  struct {
+    int16_t gyro[3];                  /**< Gyroscope data.                       */
+    int16_t accel[3];                 /**< Accelerometer data.                   */
+    int16_t compass[3];               /**< Compass data.                         */
+    aos_timestamp_t gyrotime;         /**< Uptime of the gyroscope measurement.  */
+    aos_timestamp_t acceltime;        /**< Uptime of the accelerometer measurement. */
+    aos_timestamp_t compasstime;      /**< Uptime of the compass measurement.    */
+  } raw;
+
+  /**
+   * @brief   Published orientation estimate.
+   */
+  svc_imu_orientation_t orientation;
+
+  /**
+   * @brief   Event source for update events.
+   */
+  event_source_t source;
+
+  /**
+   * @brief   Execution time of the filter update (in realtime counter ticks).
+   */
+  time_measurement_t filtertime;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t updates;   /**< Number of filter updates.                  */
+    uint32_t overruns;  /**< Number of periods missed by the thread.    */
+    uint32_t errors;    /**< Number of failed sensor transactions.      */
+  } stats;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_imu_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcImuInit(svc_imu_t* imu, const svc_imu_config_t* config);
+  void svcImuStart(svc_imu_t* imu, void* wa, size_t wasize, tprio_t prio);
+  void svcImuStop(svc_imu_t* imu);
+  void svcImuTeardown(void* imu);
+  void svcImuSetCalibration(svc_imu_t* imu, const svc_imu_calibration_t* calibration);
+  void svcImuGetCalibration(svc_imu_t* imu, svc_imu_calibration_t* calibration);
+  apalExitStatus_t svcImuLoadCalibration(svc_imu_t* imu);
+  apalExitStatus_t svcImuSaveCalibration(svc_imu_t* imu);
+  void svcImuStartMagCalibration(svc_imu_t* imu);
+  uint8_t svcImuFinishMagCalibration(svc_imu_t* imu);
+  void svcImuGetOrientation(svc_imu_t* imu, svc_imu_orientation_t* orientation);
+  int svcImuShellCmd(svc_imu_t* imu, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(AMIROLLD_CFG_USE_L3G4200D) && defined(AMIROLLD_CFG_USE_LIS331DLH) && defined(AMIROLLD_CFG_USE_HMC5883L) && defined(AMIROLLD_CFG_USE_AT24C01BN) && (HAL_USE_SPI == TRUE) */
+
+#endif /* _AMIROOS_SVC_IMU_H_ */
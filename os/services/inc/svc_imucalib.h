@@ -0,0 +1,148 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_IMUCALIB_H_
+#define _AMIROOS_SVC_IMUCALIB_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief   Size of a serialized calibration in bytes.
+ */
+#define SVC_IMUCALIB_SERIALIZED_SIZE            32
+
+/**
+ * @brief   Sensor calibration.
+ * @details Gyroscope rates are corrected by subtracting the bias.
+ *          Compass data is corrected by subtracting the hard iron offset and multiplying the result with the soft iron matrix.
+ */
+typedef struct svc_imu_calibration {
+  /**
+   * @brief   Gyroscope bias in radians per second.
+   */
+  float gyrobias[3];
+
+  /**
+   * @brief   Hard iron offset of the compass in raw units.
+   */
+  float magoffset[3];
+
+  /**
+   * @brief   Soft iron compensation matrix of the compass (row major).
+   */
+  float magmatrix[9];
+} svc_imu_calibration_t;
+
+/**
+ * @brief   Standstill detector and gyroscope bias estimator.
+ * @details Gyroscope rates are collected in windows of fixed length.
+ *          If the variance of all axes is low and the mean does not deviate much from the current bias, the robot is
+ *          considered standing still and the bias is moved towards the mean of the window.
+ */
+typedef struct svc_imucalib_standstill {
+  /**
+   * @brief   Sum of the rates of the current window.
+   */
+  float sum[3];
+
+  /**
+   * @brief   Sum of the squared rates of the current window.
+   */
+  float sumsq[3];
+
+  /**
+   * @brief   Number of samples in the current window.
+   */
+  uint16_t n;
+
+  /**
+   * @brief   Window length in samples.
+   */
+  uint16_t window;
+
+  /**
+   * @brief   Maximum variance of the rates during standstill in (rad/s)^2.
+   */
+  float maxvariance;
+
+  /**
+   * @brief   Maximum deviation of the mean rate from the current bias during standstill in rad/s.
+   */
+  float maxdeviation;
+
+  /**
+   * @brief   Weight of a new window mean for the bias [0, 1].
+   */
+  float weight;
+
+  /**
+   * @brief   Number of windows detected as standstill.
+   */
+  uint32_t detections;
+} svc_imucalib_standstill_t;
+
+/**
+ * @brief   Incremental magnetometer ellipsoid fit.
+ * @details Fits an axis aligned ellipsoid (A*x^2 + B*y^2 + C*z^2 + D*x + E*y + F*z = 1) by accumulating the normal
+ *          equations of the least squares problem, so no samples need to be stored.
+ *          Axes which were not sufficiently excited (e.g. the vertical axis of a ground robot) are excluded from the fit.
+ */
+typedef struct svc_imucalib_magfit {
+  /**
+   * @brief   Upper triangle of the normal matrix (row major).
+   */
+  double ata[21];
+
+  /**
+   * @brief   Right hand side of the normal equations.
+   */
+  double atb[6];
+
+  /**
+   * @brief   Minimum values of all axes.
+   */
+  float min[3];
+
+  /**
+   * @brief   Maximum values of all axes.
+   */
+  float max[3];
+
+  /**
+   * @brief   Number of accumulated samples.
+   */
+  uint32_t n;
+} svc_imucalib_magfit_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcImuCalibDefault(svc_imu_calibration_t* calibration);
+  void svcImuCalibStandstillInit(svc_imucalib_standstill_t* standstill, uint16_t window, float maxstddev, float maxdeviation, float weight);
+  bool svcImuCalibStandstillUpdate(svc_imucalib_standstill_t* standstill, const float rate[3], float bias[3]);
+  void svcImuCalibMagFitReset(svc_imucalib_magfit_t* fit);
+  void svcImuCalibMagFitAdd(svc_imucalib_magfit_t* fit, const float mag[3]);
+  uint8_t svcImuCalibMagFitSolve(const svc_imucalib_magfit_t* fit, float minspan, float offset[3], float matrix[9]);
+  void svcImuCalibSerialize(const svc_imu_calibration_t* calibration, uint8_t buffer[SVC_IMUCALIB_SERIALIZED_SIZE]);
+  bool svcImuCalibDeserialize(svc_imu_calibration_t* calibration, const uint8_t buffer[SVC_IMUCALIB_SERIALIZED_SIZE]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_SVC_IMUCALIB_H_ */
@@ -0,0 +1,62 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_IMUFILTER_H_
+#define _AMIROOS_SVC_IMUFILTER_H_
+
+/**
+ * @brief   Orientation filter core.
+ * @details Nonlinear complementary filter on the rotation group (Mahony et al.).
+ *          The gyroscope rates are integrated into a quaternion, while the errors between the measured and the estimated
+ *          direction of gravity and the magnetic field are fed back through a PI controller.
+ * @note    The filter core is plain C without any OS dependencies, so it can be compiled and tested on any platform.
+ */
+typedef struct svc_imufilter {
+  /**
+   * @brief   Orientation quaternion (w, x, y, z) which rotates from the body to the earth frame.
+   */
+  float q[4];
+
+  /**
+   * @brief   Integral feedback in radians per second.
+   * @details Converges to the negative gyroscope bias.
+   */
+  float integral[3];
+
+  /**
+   * @brief   Proportional gain.
+   */
+  float kp;
+
+  /**
+   * @brief   Integral gain.
+   */
+  float ki;
+} svc_imufilter_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcImuFilterInit(svc_imufilter_t* filter, float kp, float ki);
+  void svcImuFilterUpdate(svc_imufilter_t* filter, const float gyro[3], const float accel[3], const float mag[3], float dt);
+  void svcImuFilterGetEuler(const svc_imufilter_t* filter, float euler[3]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_SVC_IMUFILTER_H_ */
@@ -0,0 +1,158 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_SVC_KVSTORE_H_
+#define _AMIROOS_SVC_KVSTORE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief   Size of a record slot in bytes.
+ * @details Each record occupies exactly one EEPROM page, so that a record is always written in a single write cycle:
+ *          [key:5 | length:3] [sequence number (16 bit, little endian)] [value (padded with 0xFF)] [CRC-8 of bytes 0..6]
+ */
+#define SVC_KVSTORE_SLOTSIZE                    8
+
+/**
+ * @brief   Maximum length of a value in bytes.
+ */
+#define SVC_KVSTORE_MAXVALUE                    4
+
+/**
+ * @brief   Number of keys (key 0 is reserved).
+ */
+#define SVC_KVSTORE_NUMKEYS                     16
+
+/**
+ * @brief   Maximum number of slots of a store.
+ */
+#define SVC_KVSTORE_MAXSLOTS                    32
+
+/**
+ * @brief   Slot index of keys without a valid record.
+ */
+#define SVC_KVSTORE_NOSLOT                      ((int8_t)-1)
+
+/**
+ * @brief   Callback function type to read from the storage backend.
+ *
+ * @param[in]  arg      Argument as specified for the backend.
+ * @param[in]  address  Address to read from.
+ * @param[out] buffer   Buffer to store the data to.
+ * @param[in]  length   Number of bytes to read.
+ *
+ * @return    True on success, false otherwise.
+ */
+typedef bool (*svc_kvstore_read_t)(void* arg, size_t address, uint8_t* buffer, size_t length);
+
+/**
+ * @brief   Callback function type to write to the storage backend.
+ *
+ * @param[in] arg       Argument as specified for the backend.
+ * @param[in] address   Address to write to (always slot aligned).
+ * @param[in] data      Data to write.
+ * @param[in] length    Number of bytes to write (always a single slot).
+ *
+ * @return    True on success, false otherwise.
+ */
+typedef bool (*svc_kvstore_write_t)(void* arg, size_t address, const uint8_t* data, size_t length);
+
+/**
+ * @brief   Storage backend of a key-value store.
+ */
+typedef struct svc_kvstore_backend {
+  svc_kvstore_read_t read;      /**< Read callback.                   */
+  svc_kvstore_write_t write;    /**< Write callback.                  */
+  void* arg;                    /**< Argument for both callbacks.     */
+} svc_kvstore_backend_t;
+
+/**
+ * @brief   Log-structured key-value store.
+ * @details Every modification appends a new record to a circular log of page sized slots.
+ *          Records are written round-robin to slots that do not hold the current value of any key, which spreads the write
+ *          cycles evenly over the region while values which never change are not rewritten at all.
+ *          At mount time only the record headers are scanned to build the index; the CRC is verified for the winning record of
+ *          each key only and the key is rescanned with full verification if that check fails (e.g. after a torn write).
+ */
+typedef struct svc_kvstore {
+  /**
+   * @brief   Storage backend.
+   */
+  const svc_kvstore_backend_t* backend;
+
+  /**
+   * @brief   Start address of the region (should be page aligned).
+   */
+  size_t address;
+
+  /**
+   * @brief   Number of slots in the region.
+   */
+  uint8_t numslots;
+
+  /**
+   * @brief   Index of the most recent record of each key.
+   */
+  struct {
+    int8_t slot;                /**< Slot of the current value or SVC_KVSTORE_NOSLOT. */
+    bool known;                 /**< Flag whether a record (or tombstone) was found.  */
+    uint16_t sequence;          /**< Sequence number of the most recent record.       */
+  } index[SVC_KVSTORE_NUMKEYS];
+
+  /**
+   * @brief   Bitmask of slots holding the current value of a key.
+   */
+  uint32_t live;
+
+  /**
+   * @brief   Most recent sequence number.
+   */
+  uint16_t sequence;
+
+  /**
+   * @brief   Next slot to write to.
+   */
+  uint8_t head;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t writes;            /**< Number of records written.                       */
+    uint32_t skipped;           /**< Number of writes skipped for unchanged values.   */
+    uint32_t rescans;           /**< Number of keys rescanned due to CRC errors.      */
+  } stats;
+} svc_kvstore_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcKvStoreInit(svc_kvstore_t* store, const svc_kvstore_backend_t* backend, size_t address, size_t size);
+  bool svcKvStoreMount(svc_kvstore_t* store);
+  bool svcKvStoreFormat(svc_kvstore_t* store);
+  int svcKvStoreGet(svc_kvstore_t* store, uint8_t key, uint8_t* buffer, size_t size);
+  bool svcKvStoreSet(svc_kvstore_t* store, uint8_t key, const uint8_t* data, size_t length);
+  bool svcKvStoreDelete(svc_kvstore_t* store, uint8_t key);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_SVC_KVSTORE_H_ */
@@ -0,0 +1,152 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_LIGHTANIM_H_
+#define _AMIROOS_SVC_LIGHTANIM_H_
+
+#include <svc_framebuffer.h>
+
+#if (defined(AMIROLLD_CFG_USE_TLC5947) && (HAL_USE_SPI == TRUE)) || defined(__DOXYGEN__)
+
+#include <svc_lightscript.h>
+
+#if (TLC5947_LLD_NUM_CHANNELS != SVC_LIGHTSCRIPT_NUMCHANNELS) || (TLC5947_LLD_PWM_RESOLUTION_BITS != SVC_LIGHTSCRIPT_PWM_BITS)
+#error "the light scripts do not match the LED driver"
+#endif
+
+/**
+ * @brief   Maximum size of an animation script in bytes.
+ */
+#define SVC_LIGHTANIM_MAXSCRIPTSIZE             256
+
+/**
+ * @brief   Animation configuration.
+ */
+typedef struct svc_lightanim_config {
+  /**
+   * @brief   Frame buffer to draw to (frames are rendered at its refresh rate).
+   */
+  svc_framebuffer_t* framebuffer;
+
+  /**
+   * @brief   Initial global brightness (255 for full intensity).
+   */
+  uint8_t brightness;
+
+  /**
+   * @brief   CPU time budget per frame in microseconds.
+   */
+  aos_interval_t budget;
+} svc_lightanim_config_t;
+
+/**
+ * @brief   LED animation engine.
+ * @details A thread renders the active script at each vsync event of the frame buffer.
+ *          Scripts are loaded in chunks (e.g. from CAN frames) to a staging buffer and activated atomically when
+ *          committed, so a partially loaded script is never played.
+ */
+typedef struct svc_lightanim {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_lightanim_config_t* config;
+
+  /**
+   * @brief   Script player.
+   */
+  svc_lightscript_player_t player;
+
+  /**
+   * @brief   Active and staging script memory.
+   */
+  uint8_t scripts[2][SVC_LIGHTANIM_MAXSCRIPTSIZE];
+
+  /**
+   * @brief   Index of the active script.
+   */
+  uint8_t active;
+
+  /**
+   * @brief   Flag whether a script is played (otherwise the frame buffer is not modified).
+   */
+  bool playing;
+
+  /**
+   * @brief   Flag whether the last frame needs to be rendered again (e.g. after a brightness change).
+   */
+  bool dirty;
+
+  /**
+   * @brief   Most recently rendered intensities in Q8.8 format.
+   */
+  uint16_t values[SVC_LIGHTSCRIPT_NUMCHANNELS];
+
+  /**
+   * @brief   Combined brightness and gamma lookup table.
+   */
+  uint16_t lut[SVC_LIGHTSCRIPT_LUT_SIZE];
+
+  /**
+   * @brief   Current global brightness.
+   */
+  uint8_t brightness;
+
+  /**
+   * @brief   Mutex to protect the player, the scripts and the lookup table.
+   */
+  mutex_t lock;
+
+  /**
+   * @brief   Execution time of rendering a frame (in realtime counter ticks).
+   */
+  time_measurement_t frametime;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t frames;      /**< Number of rendered frames.                   */
+    uint32_t overbudget;  /**< Number of frames which exceeded the budget.  */
+    uint32_t loads;       /**< Number of committed scripts.                 */
+  } stats;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_lightanim_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcLightAnimInit(svc_lightanim_t* anim, const svc_lightanim_config_t* config);
+  void svcLightAnimStart(svc_lightanim_t* anim, void* wa, size_t wasize, tprio_t prio);
+  void svcLightAnimStop(svc_lightanim_t* anim);
+  void svcLightAnimTeardown(void* anim);
+  bool svcLightAnimLoad(svc_lightanim_t* anim, size_t offset, const uint8_t* data, size_t length);
+  bool svcLightAnimCommit(svc_lightanim_t* anim, size_t size);
+  void svcLightAnimHalt(svc_lightanim_t* anim);
+  void svcLightAnimSetBrightness(svc_lightanim_t* anim, uint8_t brightness);
+  int svcLightAnimShellCmd(svc_lightanim_t* anim, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(AMIROLLD_CFG_USE_TLC5947) && (HAL_USE_SPI == TRUE) */
+
+#endif /* _AMIROOS_SVC_LIGHTANIM_H_ */
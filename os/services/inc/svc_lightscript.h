@@ -0,0 +1,142 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_LIGHTSCRIPT_H_
+#define _AMIROOS_SVC_LIGHTSCRIPT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief   Number of RGB LEDs.
+ */
+#define SVC_LIGHTSCRIPT_NUMLEDS                 8
+
+/**
+ * @brief   Number of PWM channels (three per LED).
+ */
+#define SVC_LIGHTSCRIPT_NUMCHANNELS             (3 * SVC_LIGHTSCRIPT_NUMLEDS)
+
+/**
+ * @brief   Resolution of the PWM values in bits.
+ */
+#define SVC_LIGHTSCRIPT_PWM_BITS                12
+
+/**
+ * @brief   Number of entries of a gamma lookup table.
+ * @details The additional entry allows interpolation up to the maximum intensity without a range check.
+ */
+#define SVC_LIGHTSCRIPT_LUT_SIZE                257
+
+/**
+ * @brief   Maximum intensity of an interpolated channel value in Q8.8 format.
+ */
+#define SVC_LIGHTSCRIPT_VALUE_MAX               (uint16_t)(255 << 8)
+
+/**
+ * @brief   Keyframe opcodes.
+ * @details Each keyframe starts with the opcode and (except for SVC_LIGHTSCRIPT_OP_LOOP) the transition time in
+ *          milliseconds as little endian 16 bit value, followed by the operands.
+ *          Each keyframe is encoded relative to the previous one, which makes scripts very compact:
+ *          - SVC_LIGHTSCRIPT_OP_SET:    count, count times (channel, intensity)
+ *          - SVC_LIGHTSCRIPT_OP_FILL:   three intensities, applied to the channels of each LED
+ *          - SVC_LIGHTSCRIPT_OP_ROTATE: signed number of LEDs to rotate the pattern by
+ *          - SVC_LIGHTSCRIPT_OP_SCALE:  factor in 1/255 to scale all intensities with
+ *          - SVC_LIGHTSCRIPT_OP_LOOP:   offset of the keyframe to continue with (must be the last keyframe)
+ *          The transition towards a keyframe is linear, unless SVC_LIGHTSCRIPT_FLAG_EASE is set in the opcode.
+ */
+typedef enum {
+  SVC_LIGHTSCRIPT_OP_SET    = 0x00,
+  SVC_LIGHTSCRIPT_OP_FILL   = 0x01,
+  SVC_LIGHTSCRIPT_OP_ROTATE = 0x02,
+  SVC_LIGHTSCRIPT_OP_SCALE  = 0x03,
+  SVC_LIGHTSCRIPT_OP_LOOP   = 0x04,
+} svc_lightscript_op_t;
+
+/**
+ * @brief   Opcode flag to smooth the transition at start and end (smoothstep).
+ */
+#define SVC_LIGHTSCRIPT_FLAG_EASE               0x80
+
+/**
+ * @brief   Script player.
+ * @details Keeps the previous and the next keyframe and interpolates between them in fixed point arithmetics.
+ *          Keyframes are decoded on demand, so the script is never expanded in memory.
+ */
+typedef struct svc_lightscript_player {
+  /**
+   * @brief   The script (must remain valid while playing).
+   */
+  const uint8_t* script;
+
+  /**
+   * @brief   Size of the script in bytes.
+   */
+  size_t size;
+
+  /**
+   * @brief   Offset of the next keyframe to decode.
+   */
+  size_t pc;
+
+  /**
+   * @brief   Intensities of the previous keyframe.
+   */
+  uint8_t from[SVC_LIGHTSCRIPT_NUMCHANNELS];
+
+  /**
+   * @brief   Intensities of the next keyframe.
+   */
+  uint8_t to[SVC_LIGHTSCRIPT_NUMCHANNELS];
+
+  /**
+   * @brief   Time when the transition towards the next keyframe started in microseconds.
+   */
+  uint64_t start;
+
+  /**
+   * @brief   Transition time towards the next keyframe in microseconds.
+   */
+  uint32_t duration;
+
+  /**
+   * @brief   Flag whether the transition towards the next keyframe is eased.
+   */
+  bool ease;
+
+  /**
+   * @brief   Flag whether the script is still running (otherwise the last keyframe is held).
+   */
+  bool running;
+} svc_lightscript_player_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  extern const uint16_t svcLightScriptGamma[SVC_LIGHTSCRIPT_LUT_SIZE];
+  bool svcLightScriptValidate(const uint8_t* script, size_t size);
+  void svcLightScriptStart(svc_lightscript_player_t* player, const uint8_t* script, size_t size, const uint8_t initial[SVC_LIGHTSCRIPT_NUMCHANNELS], uint64_t now);
+  bool svcLightScriptRender(svc_lightscript_player_t* player, uint64_t now, uint16_t values[SVC_LIGHTSCRIPT_NUMCHANNELS]);
+  void svcLightScriptBuildLut(uint16_t lut[SVC_LIGHTSCRIPT_LUT_SIZE], uint8_t brightness);
+  uint16_t svcLightScriptMap(const uint16_t lut[SVC_LIGHTSCRIPT_LUT_SIZE], uint16_t value);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AMIROOS_SVC_LIGHTSCRIPT_H_ */
@@ -0,0 +1,225 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_ODOMETRY_H_
+#define _AMIROOS_SVC_ODOMETRY_H_
+
+#include <hal.h>
+#if (HAL_USE_QEI == TRUE)
+#include <hal_qei.h>
+#endif
+
+#if ((HAL_USE_QEI == TRUE) && (QEI_USE_EXTENDED_POSITION == TRUE) && (QEI_USE_VELOCITY == TRUE)) || defined(__DOXYGEN__)
+
+#include <aos_qei.h>
+#include <aos_time.h>
+
+/**
+ * @brief   Number of fractional bits of the internal position accumulators (in micrometers).
+ */
+#define SVC_ODOMETRY_POSITION_FRACBITS          16
+
+/**
+ * @brief   Number of fractional bits of the gyroscope weight.
+ */
+#define SVC_ODOMETRY_WEIGHT_FRACBITS            16
+
+/**
+ * @brief   Converts a binary angle to radians.
+ * @details Binary angles cover a full circle with 32 bits, so they wrap around naturally.
+ */
+#define SVC_ODOMETRY_BAM2RAD(bam)               ((float)(int32_t)(bam) * (3.14159265f / 2147483648.0f))
+
+/**
+ * @brief   Converts an angle in radians to a binary angle.
+ */
+#define SVC_ODOMETRY_RAD2BAM(rad)               ((uint32_t)(int32_t)((rad) * (2147483648.0f / 3.14159265f)))
+
+/**
+ * @brief   Pose estimate.
+ */
+typedef struct svc_odometry_pose {
+  /**
+   * @brief   X position in micrometers.
+   */
+  int32_t x;
+
+  /**
+   * @brief   Y position in micrometers.
+   */
+  int32_t y;
+
+  /**
+   * @brief   Heading as binary angle (2^32 equals a full turn, counterclockwise).
+   */
+  uint32_t theta;
+
+  /**
+   * @brief   Linear velocity in micrometers per second.
+   */
+  int32_t linear;
+
+  /**
+   * @brief   Angular velocity in microradians per second.
+   */
+  int32_t angular;
+
+  /**
+   * @brief   Uptime of the encoder capture the estimate is based on.
+   */
+  aos_timestamp_t timestamp;
+} svc_odometry_pose_t;
+
+/**
+ * @brief   Odometry configuration.
+ */
+typedef struct svc_odometry_config {
+  /**
+   * @brief   Encoders of the left and right wheel (in this order).
+   */
+  QEIDriver* qei[2];
+
+  /**
+   * @brief   Integration period.
+   * @details Should match the velocity period of the encoders.
+   */
+  sysinterval_t period;
+
+  /**
+   * @brief   Encoder increments per wheel revolution.
+   */
+  uint32_t increments;
+
+  /**
+   * @brief   Wheel diameter in meters.
+   */
+  float wheeldiameter;
+
+  /**
+   * @brief   Distance between the wheels in meters.
+   */
+  float wheelbase;
+
+  /**
+   * @brief   Weight of the gyroscope yaw rate for the heading [0, 1].
+   */
+  float gyroweight;
+
+  /**
+   * @brief   Maximum age of a yaw rate measurement in microseconds to be considered.
+   */
+  aos_interval_t gyrotimeout;
+} svc_odometry_config_t;
+
+/**
+ * @brief   Odometry service.
+ * @details Wheel increments are integrated from a virtual timer at the encoder update rate using fixed-point arithmetic only.
+ *          The heading increment of the encoders is optionally fused with the yaw rate of a gyroscope.
+ *          The resulting pose is published via a sequence lock, so consumers never block the integrator.
+ */
+typedef struct svc_odometry {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_odometry_config_t* config;
+
+  /**
+   * @brief   Micrometers per increment (@p SVC_ODOMETRY_POSITION_FRACBITS fractional bits).
+   */
+  uint32_t umperinc;
+
+  /**
+   * @brief   Binary angle per micrometer of wheel distance difference (@p SVC_ODOMETRY_POSITION_FRACBITS fractional bits).
+   */
+  uint32_t bamperum;
+
+  /**
+   * @brief   Wheel base in micrometers.
+   */
+  uint32_t wheelbase;
+
+  /**
+   * @brief   Weight of the gyroscope (@p SVC_ODOMETRY_WEIGHT_FRACBITS fractional bits).
+   */
+  uint32_t gyroweight;
+
+  /**
+   * @brief   Integrator state.
+   */
+  struct {
+    int64_t x;                  /**< X position (@p SVC_ODOMETRY_POSITION_FRACBITS). */
+    int64_t y;                  /**< Y position (@p SVC_ODOMETRY_POSITION_FRACBITS). */
+    uint32_t theta;             /**< Heading as binary angle.                       */
+    aos_qeicapture_t last[2];   /**< Previous encoder captures.                     */
+  } state;
+
+  /**
+   * @brief   Most recent yaw rate measurement.
+   */
+  struct {
+    int32_t rate;               /**< Yaw rate in microradians per second. */
+    aos_timestamp_t timestamp;  /**< Uptime of the measurement.           */
+  } gyro;
+
+  /**
+   * @brief   Published pose.
+   */
+  svc_odometry_pose_t pose;
+
+  /**
+   * @brief   Sequence counter of the published pose (odd while an update is in progress).
+   */
+  volatile uint32_t sequence;
+
+  /**
+   * @brief   Virtual timer driving the integration.
+   */
+  virtual_timer_t timer;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t updates;   /**< Number of integration steps.          */
+    uint32_t fused;     /**< Number of steps fused with gyro data. */
+  } stats;
+
+  /**
+   * @brief   Flag whether the integration is running.
+   */
+  bool running;
+} svc_odometry_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcOdometryInit(svc_odometry_t* odo, const svc_odometry_config_t* config);
+  void svcOdometryStart(svc_odometry_t* odo);
+  void svcOdometryStop(svc_odometry_t* odo);
+  void svcOdometryTeardown(void* odo);
+  void svcOdometrySetPose(svc_odometry_t* odo, int32_t x, int32_t y, uint32_t theta);
+  void svcOdometrySetYawRateI(svc_odometry_t* odo, int32_t rate, aos_timestamp_t timestamp);
+  void svcOdometryGetPose(svc_odometry_t* odo, svc_odometry_pose_t* pose);
+  int svcOdometryShellCmd(svc_odometry_t* odo, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* (HAL_USE_QEI == TRUE) && (QEI_USE_EXTENDED_POSITION == TRUE) && (QEI_USE_VELOCITY == TRUE) */
+
+#endif /* _AMIROOS_SVC_ODOMETRY_H_ */
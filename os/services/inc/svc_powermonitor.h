@@ -0,0 +1,237 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_POWERMONITOR_H_
+#define _AMIROOS_SVC_POWERMONITOR_H_
+
+#include <amiro-lld.h>
+
+#if defined(AMIROLLD_CFG_USE_INA219) || defined(__DOXYGEN__)
+
+#include <alld_ina219.h>
+#include <aos_snapshot.h>
+#include <aos_time.h>
+
+/**
+ * @brief   INA219 configuration used by the power monitor.
+ * @details 32V bus range, PGA /8 (320mV), 12 bit bus and shunt ADC with 16 samples averaging (8.51ms each), continuous shunt and bus conversion.
+ */
+#define SVC_POWERMONITOR_INA219_CONFIG          ((uint16_t)((1 << 13) | (0x3 << 11) | (0xC << 7) | (0xC << 3) | 0x7))
+
+/**
+ * @brief   Current LSB in microampere used for calibration.
+ * @details Allows to measure currents up to 3.2A.
+ */
+#define SVC_POWERMONITOR_CURRENT_LSB_UA         100
+
+/**
+ * @brief   Number of microwatt-microseconds per microwatt-hour.
+ */
+#define SVC_POWERMONITOR_UWUS_PER_UWH           ((uint64_t)MICROSECONDS_PER_HOUR)
+
+/**
+ * @brief   Power statistics of a time window.
+ */
+typedef struct svc_powermonitor_window {
+  /**
+   * @brief   Minimum power in microwatts.
+   */
+  uint32_t min;
+
+  /**
+   * @brief   Maximum power in microwatts.
+   */
+  uint32_t max;
+
+  /**
+   * @brief   Mean power in microwatts.
+   */
+  uint32_t mean;
+
+  /**
+   * @brief   Number of samples in the window.
+   */
+  uint32_t samples;
+} svc_powermonitor_window_t;
+
+/**
+ * @brief   Single power rail monitored by an INA219.
+ */
+typedef struct svc_powermonitor_rail {
+  /**
+   * @brief   Name of the rail.
+   */
+  const char* name;
+
+  /**
+   * @brief   INA219 driver.
+   */
+  INA219Driver* driver;
+
+  /**
+   * @brief   Snapshot of the INA219 register set (see module_ina219snapshot_t).
+   */
+  aos_snapshot_t* snapshot;
+
+  /**
+   * @brief   Shunt resistance in ohms.
+   */
+  float shunt;
+
+  /**
+   * @brief   Maximum expected current in amperes.
+   */
+  float maxcurrent;
+
+  /**
+   * @brief   Most recent measurements.
+   */
+  struct {
+    /**
+     * @brief   Bus voltage in microvolts.
+     */
+    uint32_t voltage;
+
+    /**
+     * @brief   Current in microamperes.
+     */
+    int32_t current;
+
+    /**
+     * @brief   Power in microwatts.
+     */
+    uint32_t power;
+
+    /**
+     * @brief   Uptime of the measurement.
+     */
+    aos_timestamp_t timestamp;
+  } last;
+
+  /**
+   * @brief   Accumulated energy.
+   */
+  struct {
+    /**
+     * @brief   Accumulated energy in microwatt-hours.
+     */
+    uint64_t uwh;
+
+    /**
+     * @brief   Remainder in microwatt-microseconds (always less than 1uWh).
+     */
+    uint64_t remainder;
+  } energy;
+
+  /**
+   * @brief   Statistics of the current (incomplete) window.
+   */
+  struct {
+    uint32_t min;   /**< Minimum power in microwatts. */
+    uint32_t max;   /**< Maximum power in microwatts. */
+    uint64_t sum;   /**< Sum of all samples in microwatts. */
+    uint32_t n;     /**< Number of samples. */
+  } accu;
+
+  /**
+   * @brief   Statistics of the last completed window.
+   */
+  svc_powermonitor_window_t window;
+
+  /**
+   * @brief   Number of failed samples.
+   */
+  uint32_t errors;
+} svc_powermonitor_rail_t;
+
+/**
+ * @brief   Power monitor service.
+ */
+typedef struct svc_powermonitor {
+  /**
+   * @brief   Array of monitored rails.
+   */
+  svc_powermonitor_rail_t* rails;
+
+  /**
+   * @brief   Number of monitored rails.
+   */
+  size_t numrails;
+
+  /**
+   * @brief   Interval between two samples (of any rail) in microseconds.
+   * @details Each rail is sampled every @p numrails * @p interval microseconds.
+   */
+  aos_interval_t interval;
+
+  /**
+   * @brief   Length of a statistics window in microseconds.
+   */
+  aos_interval_t windowlength;
+
+  /**
+   * @brief   Uptime when the current window started.
+   */
+  aos_timestamp_t windowstart;
+
+  /**
+   * @brief   I2C timeout in microseconds.
+   */
+  apalTime_t timeout;
+
+  /**
+   * @brief   Mutex to protect the measurement data.
+   */
+  mutex_t lock;
+
+  /**
+   * @brief   Sampling thread.
+   */
+  thread_t* thread;
+} svc_powermonitor_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcPowerMonitorInit(svc_powermonitor_t* pm, svc_powermonitor_rail_t* rails, size_t numrails, aos_interval_t interval, aos_interval_t windowlength, apalTime_t timeout);
+  apalExitStatus_t svcPowerMonitorConfigure(svc_powermonitor_t* pm);
+  void svcPowerMonitorStart(svc_powermonitor_t* pm, void* wa, size_t wasize, tprio_t prio);
+  void svcPowerMonitorStop(svc_powermonitor_t* pm);
+  void svcPowerMonitorTeardown(void* pm);
+  void svcPowerMonitorGetRail(svc_powermonitor_t* pm, size_t rail, svc_powermonitor_rail_t* dst);
+  void svcPowerMonitorResetEnergy(svc_powermonitor_t* pm);
+  int svcPowerMonitorShellCmd(svc_powermonitor_t* pm, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief   Retrieves the accumulated energy of a rail in milliwatt-hours.
+ *
+ * @param[in] rail  The rail to read.
+ *
+ * @return  The accumulated energy in milliwatt-hours.
+ */
+static inline float svcPowerMonitorEnergyMWh(const svc_powermonitor_rail_t* rail)
+{
+  return ((float)rail->energy.uwh + ((float)rail->energy.remainder / (float)SVC_POWERMONITOR_UWUS_PER_UWH)) / 1000.0f;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_INA219) */
+
+#endif /* _AMIROOS_SVC_POWERMONITOR_H_ */
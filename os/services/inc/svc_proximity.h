@@ -0,0 +1,225 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_PROXIMITY_H_
+#define _AMIROOS_SVC_PROXIMITY_H_
+
+#include <hal.h>
+#include <amiro-lld.h>
+
+#if (defined(AMIROLLD_CFG_USE_VCNL4020) && defined(AMIROLLD_CFG_USE_PCA9544A)) || defined(__DOXYGEN__)
+
+#include <alld_pca9544a.h>
+#include <alld_vcnl4020.h>
+#include <aos_interrupts.h>
+#include <aos_time.h>
+
+/**
+ * @brief   Maximum number of sensors behind a single multiplexer.
+ */
+#define SVC_PROXIMITY_MAXSENSORS                4
+
+/**
+ * @brief   Event flag which is broadcasted when new data of a sensor is available.
+ *
+ * @param[in] sensor  Index of the sensor.
+ */
+#define SVC_PROXIMITY_EVENTFLAG_SENSOR(sensor)  ((eventflags_t)1 << (sensor))
+
+/**
+ * @brief   Single proximity sensor behind the multiplexer.
+ */
+typedef struct svc_proximity_sensor {
+  /**
+   * @brief   Name of the sensor.
+   */
+  const char* name;
+
+  /**
+   * @brief   Multiplexer channel of the sensor.
+   */
+  pca9544a_lld_chid_t channel;
+} svc_proximity_sensor_t;
+
+/**
+ * @brief   Proximity service configuration.
+ */
+typedef struct svc_proximity_config {
+  /**
+   * @brief   I2C multiplexer.
+   */
+  PCA9544ADriver* mux;
+
+  /**
+   * @brief   Sensor driver (shared by all channels of the multiplexer).
+   */
+  VCNL4020Driver* driver;
+
+  /**
+   * @brief   Array of sensors.
+   */
+  const svc_proximity_sensor_t* sensors;
+
+  /**
+   * @brief   Number of sensors (at most SVC_PROXIMITY_MAXSENSORS).
+   */
+  uint8_t numsensors;
+
+  /**
+   * @brief   Interrupt driver.
+   */
+  aos_interrupt_driver_t* intdriver;
+
+  /**
+   * @brief   Interrupt channel of the (combined) sensor interrupt signal.
+   */
+  uint8_t intchannel;
+
+  /**
+   * @brief   Event source the interrupt is broadcasted on.
+   */
+  event_source_t* intsource;
+
+  /**
+   * @brief   Event flags of the interrupt.
+   */
+  eventflags_t intflags;
+
+  /**
+   * @brief   Proximity measurement rate (value of the VCNL4020 proximity rate register).
+   */
+  uint8_t proxrate;
+
+  /**
+   * @brief   Ambient light compensation factor as unsigned Q8.8 fixed point value (0 to disable).
+   * @details The scaled ambient light value is subtracted from the proximity value.
+   */
+  uint16_t ambientfactor;
+
+  /**
+   * @brief   Maximum time to wait for an interrupt before all sensors are checked anyway (in microseconds).
+   */
+  aos_interval_t watchdog;
+
+  /**
+   * @brief   I2C timeout in microseconds.
+   */
+  apalTime_t timeout;
+} svc_proximity_config_t;
+
+/**
+ * @brief   Single proximity reading.
+ */
+typedef struct svc_proximity_reading {
+  /**
+   * @brief   Raw proximity value.
+   */
+  uint16_t proximity;
+
+  /**
+   * @brief   Most recent ambient light value.
+   */
+  uint16_t ambient;
+
+  /**
+   * @brief   Ambient light compensated proximity value (equals @p proximity if compensation is disabled).
+   */
+  uint16_t compensated;
+
+  /**
+   * @brief   Uptime when the data was read.
+   */
+  aos_timestamp_t timestamp;
+} svc_proximity_reading_t;
+
+/**
+ * @brief   Interrupt driven proximity service.
+ * @details All sensors behind a multiplexer run self-timed measurements and signal new proximity data via the combined
+ *          interrupt line.
+ *          On each interrupt, all sensors are serviced in round-robin order until none has pending data, so the line is
+ *          released and the next edge is detected.
+ *          A service object handles a single I2C bus, so several buses can be read concurrently by separate threads.
+ */
+typedef struct svc_proximity {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_proximity_config_t* config;
+
+  /**
+   * @brief   Most recent readings of all sensors.
+   */
+  svc_proximity_reading_t readings[SVC_PROXIMITY_MAXSENSORS];
+
+  /**
+   * @brief   Sensor to start the next round with.
+   */
+  uint8_t next;
+
+  /**
+   * @brief   Currently selected multiplexer channel.
+   */
+  pca9544a_lld_chid_t channel;
+
+  /**
+   * @brief   Mutex to protect the readings.
+   */
+  mutex_t lock;
+
+  /**
+   * @brief   Event source for update events.
+   */
+  event_source_t source;
+
+  /**
+   * @brief   Uptime when the thread was started.
+   */
+  aos_timestamp_t started;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t readings;  /**< Number of sensor readings.                         */
+    uint32_t rounds;    /**< Number of rounds over all sensors.                 */
+    uint32_t timeouts;  /**< Number of rounds triggered by the watchdog.        */
+    uint32_t errors;    /**< Number of failed I2C transactions.                 */
+  } stats;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_proximity_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcProximityInit(svc_proximity_t* prox, const svc_proximity_config_t* config);
+  void svcProximityStart(svc_proximity_t* prox, void* wa, size_t wasize, tprio_t prio);
+  void svcProximityStop(svc_proximity_t* prox);
+  void svcProximityTeardown(void* prox);
+  void svcProximityGetReadings(svc_proximity_t* prox, svc_proximity_reading_t* readings);
+  int svcProximityShellCmd(svc_proximity_t* prox, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(AMIROLLD_CFG_USE_VCNL4020) && defined(AMIROLLD_CFG_USE_PCA9544A) */
+
+#endif /* _AMIROOS_SVC_PROXIMITY_H_ */
@@ -0,0 +1,109 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _AMIROOS_SVC_SETTINGS_H_
+#define _AMIROOS_SVC_SETTINGS_H_
+
+#include <hal.h>
+#include <amiro-lld.h>
+
+#if defined(AMIROLLD_CFG_USE_AT24C01BN) || defined(__DOXYGEN__)
+
+#include <svc_eeprom.h>
+#include <svc_kvstore.h>
+
+/**
+ * @brief   Key of the persistent shell configuration.
+ */
+#define SVC_SETTINGS_KEY_SHELL                  1
+
+/**
+ * @brief   Key of the persistent date and time.
+ */
+#define SVC_SETTINGS_KEY_DATETIME               2
+
+/**
+ * @brief   Persistent settings configuration.
+ */
+typedef struct svc_settings_config {
+  /**
+   * @brief   EEPROM cache to store the settings in.
+   * @details The cache must be started before the settings service.
+   */
+  svc_eeprom_t* eeprom;
+
+  /**
+   * @brief   Start address of the region reserved for the settings (should be page aligned).
+   */
+  size_t address;
+
+  /**
+   * @brief   Size of the region in bytes.
+   */
+  size_t size;
+} svc_settings_config_t;
+
+/**
+ * @brief   Persistent settings service.
+ * @details The shell configuration and the date and time are kept in a wear-leveled key-value store on the EEPROM.
+ *          They are restored at startup and stored whenever they are modified and at shutdown.
+ */
+typedef struct svc_settings {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_settings_config_t* config;
+
+  /**
+   * @brief   Storage backend on the EEPROM cache.
+   */
+  svc_kvstore_backend_t backend;
+
+  /**
+   * @brief   Key-value store.
+   */
+  svc_kvstore_t store;
+
+  /**
+   * @brief   Flag whether the store was mounted successfully.
+   */
+  bool mounted;
+
+  /**
+   * @brief   Mutex to protect the store.
+   */
+  mutex_t lock;
+} svc_settings_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcSettingsInit(svc_settings_t* settings, const svc_settings_config_t* config);
+  void svcSettingsStart(svc_settings_t* settings);
+  void svcSettingsStop(svc_settings_t* settings);
+  void svcSettingsTeardown(void* settings);
+  bool svcSettingsSave(svc_settings_t* settings);
+  int svcSettingsShellCmd(svc_settings_t* settings, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* defined(AMIROLLD_CFG_USE_AT24C01BN) */
+
+#endif /* _AMIROOS_SVC_SETTINGS_H_ */
@@ -0,0 +1,99 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_TIMESYNC_H_
+#define _AMIROOS_SVC_TIMESYNC_H_
+
+#include <aosconf.h>
+#include <svc_canbus.h>
+
+#if (HAL_USE_CAN == TRUE) || defined(__DOXYGEN__)
+
+/**
+ * @brief   Size of a serialized time reference in bytes.
+ */
+#define SVC_TIMESYNC_REFERENCESIZE              8
+
+/**
+ * @brief   Time synchronization service configuration.
+ */
+typedef struct svc_timesync_config {
+  /**
+   * @brief   CAN bus service to transmit or receive the references.
+   */
+  svc_canbus_t* bus;
+
+  /**
+   * @brief   I/O event flags of the SYS_SYNC signal.
+   */
+  eventflags_t syncflags;
+} svc_timesync_config_t;
+
+/**
+ * @brief   Time synchronization service.
+ * @details The SSSP master publishes its uptime at each synchronization edge of the SYS_SYNC signal.
+ *          The slaves pass these references to the clock discipline of the system, which compensates the frequency
+ *          offset of the local oscillator and slews the uptime towards the time of the master.
+ */
+typedef struct svc_timesync {
+  /**
+   * @brief   Configuration.
+   */
+  const svc_timesync_config_t* config;
+
+#if (AMIROOS_CFG_SSSP_MASTER != true) || defined(__DOXYGEN__)
+  /**
+   * @brief   Subscription of the references.
+   */
+  svc_canbus_subscription_t subscription;
+
+  /**
+   * @brief   Queue of received references.
+   */
+  msg_t queue[2];
+#endif
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t references;    /**< Number of published or received references.  */
+    uint32_t invalid;       /**< Number of malformed or unpublished references. */
+  } stats;
+
+  /**
+   * @brief   Pointer to the thread.
+   */
+  thread_t* thread;
+} svc_timesync_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcTimeSyncInit(svc_timesync_t* sync, const svc_timesync_config_t* config);
+  void svcTimeSyncStart(svc_timesync_t* sync, void* wa, size_t wasize, tprio_t prio);
+  void svcTimeSyncStop(svc_timesync_t* sync);
+  void svcTimeSyncTeardown(void* sync);
+  int svcTimeSyncShellCmd(svc_timesync_t* sync, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* (HAL_USE_CAN == TRUE) */
+
+#endif /* _AMIROOS_SVC_TIMESYNC_H_ */
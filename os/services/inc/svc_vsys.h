@@ -0,0 +1,229 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _AMIROOS_SVC_VSYS_H_
+#define _AMIROOS_SVC_VSYS_H_
+
+#include <hal.h>
+
+#if (HAL_USE_ADC == TRUE) || defined(__DOXYGEN__)
+
+#include <aos_time.h>
+
+/**
+ * @brief   Number of decimated blocks averaged by the second filter stage.
+ * @note    Must be a power of two.
+ */
+#define SVC_VSYS_AVERAGE_DEPTH                  8
+
+/**
+ * @brief   Number of fractional bits of the fixed-point scale factor.
+ */
+#define SVC_VSYS_SCALE_FRACBITS                 16
+
+/**
+ * @brief   Event flag emitted when the voltage dropped below the low threshold.
+ */
+#define SVC_VSYS_EVENTFLAG_LOW                  (eventflags_t)(1 << 0)
+
+/**
+ * @brief   Event flag emitted when the voltage exceeded the high threshold.
+ */
+#define SVC_VSYS_EVENTFLAG_HIGH                 (eventflags_t)(1 << 1)
+
+/**
+ * @brief   Event flag emitted when the voltage returned to the normal range.
+ */
+#define SVC_VSYS_EVENTFLAG_NORMAL               (eventflags_t)(1 << 2)
+
+/**
+ * @brief   Voltage range the last sample was classified into.
+ */
+typedef enum {
+  SVC_VSYS_ZONE_NORMAL = 0,   /**< Between the low and high threshold. */
+  SVC_VSYS_ZONE_LOW = 1,      /**< Below the low threshold.            */
+  SVC_VSYS_ZONE_HIGH = 2,     /**< Above the high threshold.           */
+} svc_vsys_zone_t;
+
+/**
+ * @brief   Filtered voltage reading.
+ */
+typedef struct svc_vsys_reading {
+  /**
+   * @brief   Filtered voltage in microvolts.
+   */
+  uint32_t voltage;
+
+  /**
+   * @brief   Minimum block average in microvolts since the last reset.
+   */
+  uint32_t min;
+
+  /**
+   * @brief   Maximum block average in microvolts since the last reset.
+   */
+  uint32_t max;
+
+  /**
+   * @brief   Current voltage range.
+   */
+  svc_vsys_zone_t zone;
+
+  /**
+   * @brief   Uptime of the most recent filter update.
+   */
+  aos_timestamp_t timestamp;
+} svc_vsys_reading_t;
+
+/**
+ * @brief   Continuous system voltage acquisition service.
+ * @details The ADC converts continuously into a circular DMA buffer.
+ *          Each half of the buffer is summed up in the DMA callback (first CIC/boxcar stage),
+ *          a moving average over the last @p SVC_VSYS_AVERAGE_DEPTH block sums forms the second stage.
+ *          Threshold violations are detected per sample by the analog watchdog, so no thread is involved at all.
+ * @note    The analog watchdog requires the ADCv2 patch shipped in kernel/patches.
+ */
+typedef struct svc_vsys {
+  /**
+   * @brief   Conversion group used for continuous sampling.
+   * @details Copied from the template at initialization and modified by the service.
+   *          Must be the first member, since the ADC callbacks retrieve the service object from the active group.
+   */
+  ADCConversionGroup group;
+
+  /**
+   * @brief   ADC driver.
+   */
+  ADCDriver* driver;
+
+  /**
+   * @brief   Circular DMA buffer.
+   */
+  adcsample_t* buffer;
+
+  /**
+   * @brief   Number of samples in the DMA buffer (must be even).
+   */
+  size_t depth;
+
+  /**
+   * @brief   Scale factor in microvolts per LSB (fixed-point, @p SVC_VSYS_SCALE_FRACBITS fractional bits).
+   */
+  uint32_t scale;
+
+  /**
+   * @brief   Threshold configuration in ADC counts.
+   */
+  struct {
+    adcsample_t low;          /**< Low threshold.              */
+    adcsample_t high;         /**< High threshold.             */
+    adcsample_t hysteresis;   /**< Hysteresis to leave a zone. */
+  } threshold;
+
+  /**
+   * @brief   Second filter stage.
+   */
+  struct {
+    /**
+     * @brief   Ring buffer of the most recent block sums.
+     */
+    uint32_t blocks[SVC_VSYS_AVERAGE_DEPTH];
+
+    /**
+     * @brief   Running sum of all elements in @p blocks.
+     */
+    uint32_t sum;
+
+    /**
+     * @brief   Index of the oldest block.
+     */
+    uint8_t idx;
+
+    /**
+     * @brief   Number of valid blocks (saturates at @p SVC_VSYS_AVERAGE_DEPTH).
+     */
+    uint8_t fill;
+  } filter;
+
+  /**
+   * @brief   Minimum and maximum block sums since the last reset.
+   */
+  struct {
+    uint32_t min;   /**< Minimum block sum. */
+    uint32_t max;   /**< Maximum block sum. */
+  } extrema;
+
+  /**
+   * @brief   Current voltage range.
+   */
+  svc_vsys_zone_t zone;
+
+  /**
+   * @brief   Uptime of the most recent filter update.
+   */
+  aos_timestamp_t timestamp;
+
+  /**
+   * @brief   Uptime of the most recent zone transition.
+   */
+  aos_timestamp_t transition;
+
+  /**
+   * @brief   Virtual timer to restart the conversion after a watchdog event.
+   */
+  virtual_timer_t restarttimer;
+
+  /**
+   * @brief   Event source for threshold events.
+   */
+  event_source_t source;
+
+  /**
+   * @brief   Statistics.
+   */
+  struct {
+    uint32_t blocks;    /**< Number of processed blocks.    */
+    uint32_t low;       /**< Number of low events.          */
+    uint32_t high;      /**< Number of high events.         */
+    uint32_t errors;    /**< Number of DMA/overflow errors. */
+  } stats;
+
+  /**
+   * @brief   Flag whether the service is running.
+   */
+  bool running;
+} svc_vsys_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void svcVsysInit(svc_vsys_t* vsys, ADCDriver* driver, const ADCConversionGroup* group, adcsample_t* buffer, size_t depth, float scale);
+  void svcVsysSetThresholds(svc_vsys_t* vsys, uint32_t low, uint32_t high, uint32_t hysteresis);
+  void svcVsysStart(svc_vsys_t* vsys);
+  void svcVsysStop(svc_vsys_t* vsys);
+  void svcVsysTeardown(void* vsys);
+  void svcVsysGet(svc_vsys_t* vsys, svc_vsys_reading_t* reading);
+  void svcVsysResetExtrema(svc_vsys_t* vsys);
+  int svcVsysShellCmd(svc_vsys_t* vsys, BaseSequentialStream* stream, int argc, char* argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* (HAL_USE_ADC == TRUE) */
+
+#endif /* _AMIROOS_SVC_VSYS_H_ */
@@ -0,0 +1,53 @@
+################################################################################
+# AMiRo-OS is an operating system designed for the Autonomous Mini Robot       #
+# (AMiRo) platform.                                                            #
+# Copyright (C) 2016..2018  Thomas Schöpping et al.                            #
+#                                                                              #
+# This program is free software: you can redistribute it and/or modify         #
+# it under the terms of the GNU General Public License as published by         #
+# the Free Software Foundation, either version 3 of the License, or            #
+# (at your option) any later version.                                          #
+#                                                                              #
+# This program is distributed in the hope that it will be useful,              #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of               #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                #
+# GNU General Public License for more details.                                 #
+#                                                                              #
+# You should have received a copy of the GNU General Public License            #
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.        #
+#                                                                              #
+# This research/work was supported by the Cluster of Excellence Cognitive      #
+# Interaction Technology 'CITEC' (EXC 277) at Bielefeld University, which is   #
+# funded by the German Research Foundation (DFG).                              #
+################################################################################
+
+
+
+# absolute path to this directory
+SERVICES_DIR := $(dir $(lastword $(MAKEFILE_LIST)))
+
+# include path
+SERVICESINC = $(SERVICES_DIR)inc
+
+# C sources
+SERVICESCSRC = $(SERVICES_DIR)src/svc_battery.c \
+               $(SERVICES_DIR)src/svc_canbus.c \
+               $(SERVICES_DIR)src/svc_canfilter.c \
+               $(SERVICES_DIR)src/svc_canproto.c \
+               $(SERVICES_DIR)src/svc_cantx.c \
+               $(SERVICES_DIR)src/svc_cpufreq.c \
+               $(SERVICES_DIR)src/svc_diffdrive.c \
+               $(SERVICES_DIR)src/svc_eeprom.c \
+               $(SERVICES_DIR)src/svc_framebuffer.c \
+               $(SERVICES_DIR)src/svc_imu.c \
+               $(SERVICES_DIR)src/svc_imucalib.c \
+               $(SERVICES_DIR)src/svc_imufilter.c \
+               $(SERVICES_DIR)src/svc_kvstore.c \
+               $(SERVICES_DIR)src/svc_lightanim.c \
+               $(SERVICES_DIR)src/svc_lightscript.c \
+               $(SERVICES_DIR)src/svc_odometry.c \
+               $(SERVICES_DIR)src/svc_powermonitor.c \
+               $(SERVICES_DIR)src/svc_proximity.c \
+               $(SERVICES_DIR)src/svc_settings.c \
+               $(SERVICES_DIR)src/svc_timesync.c \
+               $(SERVICES_DIR)src/svc_vsys.c
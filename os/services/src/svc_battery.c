@@ -0,0 +1,395 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <svc_battery.h>
+
+#if defined(AMIROLLD_CFG_USE_BQ27500) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <aos_thread.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Offsets of the standard commands within a register block read from Temperature (0x06) onwards.
+ */
+#define OFFSET_TEMPERATURE            0x00
+#define OFFSET_VOLTAGE                0x02
+#define OFFSET_FLAGS                  0x04
+#define OFFSET_REMAINING              0x0A
+#define OFFSET_FULLCHARGE             0x0C
+#define OFFSET_CURRENT                0x0E
+#define OFFSET_TIMETOEMPTY            0x10
+#define OFFSET_TIMETOFULL             0x12
+#define OFFSET_POWER                  0x1E
+#define OFFSET_CYCLES                 0x24
+#define OFFSET_SOC                    0x26
+
+/**
+ * @brief   Number of periods after which the data of a pack is considered stale (e.g. the pack was removed).
+ */
+#define STALE_PERIODS                 3
+
+/**
+ * @brief   Reads a little endian 16 bit value from a register block.
+ */
+#define _le16(buffer, offset)         ((uint16_t)((buffer)[(offset)] | ((uint16_t)(buffer)[(offset) + 1] << 8)))
+
+/**
+ * @brief   Classifies a state of charge into a battery level.
+ * @details A level is only left towards a higher state of charge if the according threshold is exceeded by the hysteresis.
+ *
+ * @param[in] config  The battery configuration.
+ * @param[in] level   The current level.
+ * @param[in] soc     The state of charge in percent.
+ *
+ * @return  The new level.
+ */
+static svc_battery_level_t _classify(const svc_battery_config_t* config, svc_battery_level_t level, uint8_t soc)
+{
+  if (soc <= config->threshold.critical ||
+      (level == SVC_BATTERY_LEVEL_CRITICAL && soc <= config->threshold.critical + config->threshold.hysteresis)) {
+    return SVC_BATTERY_LEVEL_CRITICAL;
+  }
+  if (soc <= config->threshold.low ||
+      (level != SVC_BATTERY_LEVEL_NORMAL && soc <= config->threshold.low + config->threshold.hysteresis)) {
+    return SVC_BATTERY_LEVEL_LOW;
+  }
+  return SVC_BATTERY_LEVEL_NORMAL;
+}
+
+/**
+ * @brief   Refreshes all packs and updates the combined state.
+ *
+ * @param[in] battery   The battery service.
+ */
+static void _update(svc_battery_t* battery)
+{
+  const svc_battery_config_t* const config = battery->config;
+  svc_battery_registers_t registers;
+  aos_timestamp_t t, uptime;
+  uint32_t remaining = 0;
+  uint32_t fullcharge = 0;
+  int32_t current = 0;
+  uint16_t voltage = 0xFFFF;
+  uint8_t validpacks = 0;
+
+  aosSysGetUptime(&uptime);
+
+  for (size_t p = 0; p < config->numpacks; ++p) {
+    svc_battery_pack_t* const pack = &config->packs[p];
+    // one batched transaction per fuel gauge (shared with any other reader of the snapshot)
+    const apalExitStatus_t status = aosSnapshotRead(pack->snapshot, &registers, config->period / 2, &t);
+    chMtxLock(&battery->lock);
+    if (status == APAL_STATUS_SUCCESS) {
+      pack->registers = registers;
+      pack->timestamp = t;
+    } else {
+      ++pack->errors;
+    }
+    if (pack->timestamp != 0 && uptime - pack->timestamp <= (aos_timestamp_t)STALE_PERIODS * config->period) {
+      remaining += pack->registers.remaining;
+      fullcharge += pack->registers.fullcharge;
+      current += pack->registers.current;
+      voltage = (pack->registers.voltage < voltage) ? pack->registers.voltage : voltage;
+      ++validpacks;
+    }
+    chMtxUnlock(&battery->lock);
+  }
+
+  chMtxLock(&battery->lock);
+  svc_battery_state_t* const state = &battery->state;
+  const svc_battery_level_t level = state->level;
+  if (validpacks > 0) {
+    // low-pass filter the current, so load peaks do not make the prediction jump
+    if (state->validpacks == 0) {
+      state->filteredcurrent = (float)current;
+    } else {
+      const float dt = (float)(uptime - state->timestamp);
+      state->filteredcurrent += (dt / ((float)config->tau + dt)) * ((float)current - state->filteredcurrent);
+    }
+    state->soc = (fullcharge > 0) ? (uint8_t)(((remaining > fullcharge ? fullcharge : remaining) * 100 + fullcharge / 2) / fullcharge) : 0;
+    state->remaining = remaining;
+    state->fullcharge = fullcharge;
+    state->current = current;
+    state->voltage = voltage;
+    if (state->filteredcurrent < -1.0f) {
+      const float runtime = (float)remaining * 60.0f / -state->filteredcurrent;
+      state->runtime = (runtime < (float)SVC_BATTERY_RUNTIME_INFINITE) ? (uint16_t)runtime : (SVC_BATTERY_RUNTIME_INFINITE - 1);
+    } else {
+      state->runtime = SVC_BATTERY_RUNTIME_INFINITE;
+    }
+    state->level = _classify(config, level, state->soc);
+  }
+  state->validpacks = validpacks;
+  state->timestamp = uptime;
+  ++battery->stats.updates;
+  const svc_battery_level_t newlevel = state->level;
+  if (newlevel != level) {
+    ++battery->stats.events;
+  }
+  chMtxUnlock(&battery->lock);
+
+  // notify listeners about level changes
+  if (newlevel != level && config->source != NULL) {
+    switch (newlevel) {
+      case SVC_BATTERY_LEVEL_NORMAL:
+        chEvtBroadcastFlags(config->source, config->flags.normal);
+        break;
+      case SVC_BATTERY_LEVEL_LOW:
+        chEvtBroadcastFlags(config->source, config->flags.low);
+        break;
+      case SVC_BATTERY_LEVEL_CRITICAL:
+        chEvtBroadcastFlags(config->source, config->flags.critical);
+        break;
+    }
+  }
+
+  return;
+}
+
+/**
+ * @brief   Battery thread.
+ *
+ * @param[in] battery   The battery service.
+ */
+static THD_FUNCTION(_svcBatteryThread, battery)
+{
+  svc_battery_t* const b = (svc_battery_t*)battery;
+  aos_timestamp_t next;
+  aos_timestamp_t uptime;
+
+  chRegSetThreadName("battery");
+
+  aosSysGetUptime(&next);
+
+  while (!chThdShouldTerminateX()) {
+    _update(b);
+
+    // resynchronize if the update fell behind for more than one period
+    aosSysGetUptime(&uptime);
+    next += b->config->period;
+    if (uptime > next + b->config->period) {
+      next = uptime;
+    }
+    chSysLock();
+    aosThdSleepUntilS(&next);
+    chSysUnlock();
+  }
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Reads the standard commands of a BQ27500 fuel gauge in a single transaction.
+ * @details The standard commands are consecutive 16 bit registers and the fuel gauge supports incremental reads,
+ *          so a single transaction replaces one transaction per command.
+ *          This function is intended to be called by the read callback of a snapshot.
+ *
+ * @param[in]  bq27500    The fuel gauge driver.
+ * @param[out] registers  The decoded register values.
+ * @param[in]  timeout    I2C timeout in microseconds.
+ *
+ * @return  The status of the bus transaction.
+ */
+apalExitStatus_t svcBatteryReadRegisters(BQ27500Driver* bq27500, svc_battery_registers_t* registers, apalTime_t timeout)
+{
+  aosDbgCheck(bq27500 != NULL);
+  aosDbgCheck(registers != NULL);
+
+  uint8_t buffer[SVC_BATTERY_REGISTERS_SIZE];
+
+  // the extended command access is a plain incremental read starting at the given command code
+  const apalExitStatus_t status = bq27500_lld_ext_command(bq27500, (bq27500_lld_ext_command_t)BQ27500_LLD_STD_CMD_Temperatur, BQ27500_LLD_EXT_CMD_READ, buffer, SVC_BATTERY_REGISTERS_SIZE, 0, timeout);
+  if (status == APAL_STATUS_SUCCESS) {
+    registers->temperature = _le16(buffer, OFFSET_TEMPERATURE);
+    registers->voltage = _le16(buffer, OFFSET_VOLTAGE);
+    registers->flags = _le16(buffer, OFFSET_FLAGS);
+    registers->remaining = _le16(buffer, OFFSET_REMAINING);
+    registers->fullcharge = _le16(buffer, OFFSET_FULLCHARGE);
+    registers->current = (int16_t)_le16(buffer, OFFSET_CURRENT);
+    registers->timetoempty = _le16(buffer, OFFSET_TIMETOEMPTY);
+    registers->timetofull = _le16(buffer, OFFSET_TIMETOFULL);
+    registers->power = (int16_t)_le16(buffer, OFFSET_POWER);
+    registers->cycles = _le16(buffer, OFFSET_CYCLES);
+    registers->soc = _le16(buffer, OFFSET_SOC);
+  }
+
+  return status;
+}
+
+/**
+ * @brief   Initializes a battery service.
+ *
+ * @param[out] battery  The battery service to initialize.
+ * @param[in]  config   The configuration to use.
+ */
+void svcBatteryInit(svc_battery_t* battery, const svc_battery_config_t* config)
+{
+  aosDbgCheck(battery != NULL);
+  aosDbgCheck(config != NULL && config->packs != NULL && config->numpacks > 0);
+  aosDbgCheck(config->period > 0);
+  aosDbgCheck(config->threshold.critical < config->threshold.low);
+
+  battery->config = config;
+  memset(&battery->state, 0, sizeof(battery->state));
+  battery->state.runtime = SVC_BATTERY_RUNTIME_INFINITE;
+  battery->state.level = SVC_BATTERY_LEVEL_NORMAL;
+  chMtxObjectInit(&battery->lock);
+  memset(&battery->stats, 0, sizeof(battery->stats));
+  battery->thread = NULL;
+  for (size_t p = 0; p < config->numpacks; ++p) {
+    aosDbgCheck(config->packs[p].snapshot != NULL);
+    memset(&config->packs[p].registers, 0, sizeof(svc_battery_registers_t));
+    config->packs[p].timestamp = 0;
+    config->packs[p].errors = 0;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Starts the battery thread.
+ *
+ * @param[in] battery   The battery service.
+ * @param[in] wa        Working area for the thread.
+ * @param[in] wasize    Size of the working area.
+ * @param[in] prio      Priority of the thread.
+ */
+void svcBatteryStart(svc_battery_t* battery, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(battery != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(battery->thread == NULL);
+
+  battery->thread = chThdCreateStatic(wa, wasize, prio, _svcBatteryThread, battery);
+
+  return;
+}
+
+/**
+ * @brief   Stops the battery thread.
+ *
+ * @param[in] battery   The battery service.
+ */
+void svcBatteryStop(svc_battery_t* battery)
+{
+  aosDbgCheck(battery != NULL);
+
+  if (battery->thread != NULL) {
+    chThdTerminate(battery->thread);
+    chThdWait(battery->thread);
+    battery->thread = NULL;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] battery   The battery service.
+ */
+void svcBatteryTeardown(void* battery)
+{
+  svcBatteryStop((svc_battery_t*)battery);
+
+  return;
+}
+
+/**
+ * @brief   Retrieves a consistent copy of the combined state.
+ *
+ * @param[in]  battery  The battery service.
+ * @param[out] state    Object to copy the state to.
+ */
+void svcBatteryGetState(svc_battery_t* battery, svc_battery_state_t* state)
+{
+  aosDbgCheck(battery != NULL);
+  aosDbgCheck(state != NULL);
+
+  chMtxLock(&battery->lock);
+  memcpy(state, &battery->state, sizeof(svc_battery_state_t));
+  chMtxUnlock(&battery->lock);
+
+  return;
+}
+
+/**
+ * @brief   Shell command implementation to print the battery state.
+ *
+ * @param[in] battery   The battery service.
+ * @param[in] stream    The I/O stream to use.
+ * @param[in] argc      Number of arguments.
+ * @param[in] argv      List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+int svcBatteryShellCmd(svc_battery_t* battery, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(battery != NULL);
+  aosDbgCheck(stream != NULL);
+
+  static const char* const levels[] = {"normal", "low", "critical"};
+  svc_battery_state_t state;
+  svc_battery_pack_t pack;
+
+  if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the state of all battery packs and the combined runtime prediction.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  chprintf(stream, "%-8s%6s%8s%10s%14s%8s%10s%8s%8s\n", "pack", "SoC", "U [V]", "I [mA]", "C [mAh]", "T [C]", "TTE [min]", "cycles", "errors");
+  for (size_t p = 0; p < battery->config->numpacks; ++p) {
+    chMtxLock(&battery->lock);
+    memcpy(&pack, &battery->config->packs[p], sizeof(svc_battery_pack_t));
+    chMtxUnlock(&battery->lock);
+    chprintf(stream, "%-8s%5u%%%8.3f%10d%7u/%-6u%8.1f%10u%8u%8u\n",
+             pack.name,
+             pack.registers.soc,
+             (float)pack.registers.voltage / 1000.0f,
+             pack.registers.current,
+             pack.registers.remaining, pack.registers.fullcharge,
+             (float)pack.registers.temperature / 10.0f - 273.15f,
+             pack.registers.timetoempty,
+             pack.registers.cycles,
+             pack.errors);
+  }
+
+  svcBatteryGetState(battery, &state);
+  chprintf(stream, "system:  %u%% (%u/%umAh) of %u packs, %s\n", state.soc, state.remaining, state.fullcharge, state.validpacks, levels[state.level]);
+  chprintf(stream, "current: %dmA (filtered %.1fmA)\n", state.current, state.filteredcurrent);
+  if (state.runtime == SVC_BATTERY_RUNTIME_INFINITE) {
+    chprintf(stream, "runtime: n/a (not discharging)\n");
+  } else {
+    chprintf(stream, "runtime: %uh %02umin\n", state.runtime / 60, state.runtime % 60);
+  }
+
+  return AOS_OK;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_BQ27500) */
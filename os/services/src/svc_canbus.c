@@ -0,0 +1,630 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <svc_canbus.h>
+
+#if (HAL_USE_CAN == TRUE) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_idle.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief   Event ID of the receive listener.
+ */
+#define RXEVENT_ID                    0
+
+/**
+ * @brief   Returns the number of filter banks assigned to CAN1.
+ *
+ * @return  The number of filter banks.
+ */
+static inline uint8_t _numFilterBanks(void)
+{
+#if defined(CAN_FMR_CAN2SB)
+  // filter banks starting at CAN2SB are assigned to CAN2
+  return (uint8_t)((CAN1->FMR & CAN_FMR_CAN2SB) >> 8);
+#else
+  return STM32_CAN_MAX_FILTERS;
+#endif
+}
+
+/**
+ * @brief   Programs the filter banks of CAN1.
+ * @details All banks are replaced within a single filter initialization phase with the kernel locked, so there is no
+ *          intermediate state in which only some of the new filters are active.
+ *          The banks are distributed alternately to both receive FIFOs to double the hardware buffer.
+ *
+ * @param[in] bus   The CAN bus service holding the compiled banks.
+ */
+static void _programBanks(svc_canbus_t* bus)
+{
+  const uint32_t bankmask = ((uint32_t)1 << _numFilterBanks()) - 1;
+  uint32_t list = 0, scale = 0, fifo = 0, active = 0;
+
+  for (uint8_t b = 0; b < bus->filters; ++b) {
+    const svc_canfilter_mode_t mode = bus->banks[b].mode;
+    list |= (uint32_t)((mode == SVC_CANFILTER_LIST32 || mode == SVC_CANFILTER_LIST16) ? 1 : 0) << b;
+    scale |= (uint32_t)((mode == SVC_CANFILTER_MASK32 || mode == SVC_CANFILTER_LIST32) ? 1 : 0) << b;
+    fifo |= (uint32_t)(b & 1) << b;
+    active |= (uint32_t)1 << b;
+  }
+
+  chSysLock();
+  // reception is paused while the filters are initialized (a few microseconds, less than a single frame)
+  CAN1->FMR |= CAN_FMR_FINIT;
+  CAN1->FA1R &= ~bankmask;
+  for (uint8_t b = 0; b < bus->filters; ++b) {
+    CAN1->sFilterRegister[b].FR1 = bus->banks[b].fr1;
+    CAN1->sFilterRegister[b].FR2 = bus->banks[b].fr2;
+  }
+  CAN1->FM1R = (CAN1->FM1R & ~bankmask) | list;
+  CAN1->FS1R = (CAN1->FS1R & ~bankmask) | scale;
+  CAN1->FFA1R = (CAN1->FFA1R & ~bankmask) | fifo;
+  CAN1->FA1R |= active;
+  CAN1->FMR &= ~CAN_FMR_FINIT;
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Configures a single filter bank that accepts all frames.
+ *
+ * @param[in] bus   The CAN bus service.
+ */
+static void _acceptAll(svc_canbus_t* bus)
+{
+  bus->banks[0].mode = SVC_CANFILTER_MASK32;
+  bus->banks[0].fr1 = 0;
+  bus->banks[0].fr2 = 0;
+  bus->filters = 1;
+  bus->acceptall = true;
+
+  return;
+}
+
+/**
+ * @brief   Compiles the acceptance filters for all subscribed topics and programs them.
+ * @details Must be called with the receive lock held.
+ *
+ * @param[in] bus   The CAN bus service.
+ */
+static void _applyFilters(svc_canbus_t* bus)
+{
+  svc_canfilter_rule_t rules[SVC_CANFILTER_MAXRULES];
+  size_t numrules = 0;
+  int numbanks;
+
+  for (svc_canbus_subscription_t* sub = bus->subscriptions; sub != NULL && numrules <= SVC_CANFILTER_MAXRULES; sub = sub->next) {
+    if (numrules < SVC_CANFILTER_MAXRULES) {
+      rules[numrules].id = (uint32_t)sub->topic << SVC_CANPROTO_TOPICSHIFT;
+      rules[numrules].mask = SVC_CANPROTO_TOPICMASK;
+      rules[numrules].extended = true;
+    }
+    ++numrules;
+  }
+
+  numbanks = (numrules <= SVC_CANFILTER_MAXRULES) ? svcCanFilterCompile(rules, numrules, bus->banks, _numFilterBanks()) : -1;
+  if (numbanks < 0) {
+    _acceptAll(bus);
+  } else {
+    bus->filters = (uint8_t)numbanks;
+    bus->acceptall = false;
+  }
+  _programBanks(bus);
+  ++bus->stats.reprogrammed;
+
+  return;
+}
+
+/**
+ * @brief   Searches the subscription of a topic.
+ *
+ * @param[in] bus     The CAN bus service.
+ * @param[in] topic   The topic.
+ *
+ * @return  The subscription or NULL if the topic is not subscribed.
+ */
+static svc_canbus_subscription_t* _findSubscription(svc_canbus_t* bus, uint16_t topic)
+{
+  svc_canbus_subscription_t* sub = bus->subscriptions;
+  while (sub != NULL && sub->topic != topic) {
+    sub = sub->next;
+  }
+  return sub;
+}
+
+/**
+ * @brief   Aborts a message in reassembly and returns its buffer to the pool.
+ *
+ * @param[in] bus   The CAN bus service.
+ * @param[in] slot  The reassembly slot.
+ */
+static void _abortSlot(svc_canbus_t* bus, uint8_t slot)
+{
+  chPoolFree(&bus->pool, bus->reassembly[slot].message);
+  bus->reassembly[slot].message = NULL;
+  ++bus->stats.lost;
+
+  return;
+}
+
+/**
+ * @brief   Selects the reassembly slot for a fragment.
+ * @details The first fragment of a message takes a free slot or the oldest one if all are occupied.
+ *
+ * @param[in] bus     The CAN bus service.
+ * @param[in] header  Header of the fragment.
+ *
+ * @return  The slot index or -1 if the fragment cannot be processed.
+ */
+static int _selectSlot(svc_canbus_t* bus, const svc_canproto_header_t* header)
+{
+  int slot = -1;
+
+  for (uint8_t s = 0; s < SVC_CANBUS_REASSEMBLYSLOTS; ++s) {
+    if (bus->reassembly[s].message == NULL) {
+      slot = (slot < 0) ? s : slot;
+    } else if (bus->reassembly[s].context.topic == header->topic && bus->reassembly[s].context.source == header->source) {
+      if (header->index == 0) {
+        // the previous message of this publisher is incomplete, but its buffer can be reused
+        ++bus->stats.lost;
+      }
+      return s;
+    }
+  }
+
+  if (header->index != 0) {
+    ++bus->stats.lost;
+    return -1;
+  }
+  if (slot < 0) {
+    slot = bus->victim;
+    bus->victim = (bus->victim + 1) % SVC_CANBUS_REASSEMBLYSLOTS;
+    _abortSlot(bus, (uint8_t)slot);
+  }
+  bus->reassembly[slot].message = (svc_canbus_message_t*)chPoolAlloc(&bus->pool);
+  if (bus->reassembly[slot].message == NULL) {
+    ++bus->stats.nobuffer;
+    return -1;
+  }
+  svcCanProtoReassemblyInit(&bus->reassembly[slot].context, bus->reassembly[slot].message->data, SVC_CANBUS_MAXPAYLOAD);
+
+  return slot;
+}
+
+/**
+ * @brief   Processes a received frame.
+ *
+ * @param[in] bus     The CAN bus service.
+ * @param[in] frame   The received frame.
+ */
+static void _receive(svc_canbus_t* bus, const CANRxFrame* frame)
+{
+  svc_canproto_header_t header;
+  svc_canbus_subscription_t* sub;
+  svc_canbus_message_t* message;
+  int slot;
+
+  // frames of other protocols and topics pass the filters if they had to be merged or all frames are accepted
+  if (frame->IDE != CAN_IDE_EXT || frame->RTR != CAN_RTR_DATA) {
+    ++bus->stats.filtered;
+    return;
+  }
+  svcCanProtoDecodeId(frame->EID, &header);
+  sub = _findSubscription(bus, header.topic);
+  if (sub == NULL) {
+    ++bus->stats.filtered;
+    return;
+  }
+
+  slot = _selectSlot(bus, &header);
+  if (slot < 0) {
+    return;
+  }
+  switch (svcCanProtoReassemble(&bus->reassembly[slot].context, &header, frame->data8, frame->DLC)) {
+    case SVC_CANPROTO_PENDING:
+      break;
+    case SVC_CANPROTO_COMPLETE:
+      message = bus->reassembly[slot].message;
+      bus->reassembly[slot].message = NULL;
+      message->topic = header.topic;
+      message->source = header.source;
+      message->length = (uint16_t)bus->reassembly[slot].context.length;
+      aosSysGetUptime(&message->timestamp);
+      if (chMBPostTimeout(&sub->mailbox, (msg_t)message, TIME_IMMEDIATE) == MSG_OK) {
+        ++sub->stats.received;
+        ++bus->stats.delivered;
+      } else {
+        chPoolFree(&bus->pool, message);
+        ++sub->stats.overflows;
+      }
+      break;
+    case SVC_CANPROTO_LOST:
+    case SVC_CANPROTO_OVERFLOW:
+      _abortSlot(bus, (uint8_t)slot);
+      break;
+  }
+
+  return;
+}
+
+/**
+ * @brief   CAN bus receive thread.
+ * @details Sleeps until the driver signals received frames and drains both receive FIFOs.
+ *
+ * @param[in] bus   The CAN bus service.
+ */
+static THD_FUNCTION(_svcCanBusThread, bus)
+{
+  svc_canbus_t* const b = (svc_canbus_t*)bus;
+  event_listener_t listener;
+  CANRxFrame frame;
+
+  chRegSetThreadName("canbus");
+
+  chEvtRegisterMask(&b->config->driver->rxfull_event, &listener, EVENT_MASK(RXEVENT_ID));
+
+  while (!chThdShouldTerminateX()) {
+    chEvtWaitAny(EVENT_MASK(RXEVENT_ID));
+    chEvtGetAndClearFlags(&listener);
+    while (canReceiveTimeout(b->config->driver, CAN_ANY_MAILBOX, &frame, TIME_IMMEDIATE) == MSG_OK) {
+      ++b->stats.rxframes;
+#if (AMIROOS_CFG_IDLE_STOP == true)
+      // further frames of a burst would be lost in STOP mode
+      chSysLock();
+      aosIdleDeferI(AOS_IDLE_STOP, AMIROOS_CFG_IDLE_STOP_CANQUIET);
+      chSysUnlock();
+#endif
+      chMtxLock(&b->rxlock);
+      _receive(b, &frame);
+      chMtxUnlock(&b->rxlock);
+    }
+  }
+
+  chEvtUnregister(&b->config->driver->rxfull_event, &listener);
+  for (uint8_t s = 0; s < SVC_CANBUS_REASSEMBLYSLOTS; ++s) {
+    if (b->reassembly[s].message != NULL) {
+      chPoolFree(&b->pool, b->reassembly[s].message);
+      b->reassembly[s].message = NULL;
+    }
+  }
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes a CAN bus service object.
+ *
+ * @param[in] bus     The CAN bus service to initialize.
+ * @param[in] config  The configuration to use.
+ */
+void svcCanBusInit(svc_canbus_t* bus, const svc_canbus_config_t* config)
+{
+  aosDbgCheck(bus != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->driver != NULL);
+  aosDbgCheck(config->scheduler != NULL);
+  aosDbgCheck(config->messages != NULL && config->nummessages > 0);
+
+  bus->config = config;
+  chPoolObjectInit(&bus->pool, sizeof(svc_canbus_message_t), NULL);
+  chPoolLoadArray(&bus->pool, config->messages, config->nummessages);
+  bus->subscriptions = NULL;
+  for (uint8_t s = 0; s < SVC_CANBUS_REASSEMBLYSLOTS; ++s) {
+    bus->reassembly[s].message = NULL;
+  }
+  bus->victim = 0;
+  bus->filters = 0;
+  bus->acceptall = true;
+  chMtxObjectInit(&bus->rxlock);
+  chMtxObjectInit(&bus->txlock);
+  bus->sequence = 0;
+  memset(&bus->stats, 0, sizeof(bus->stats));
+  bus->thread = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Subscribes a topic.
+ * @details If the service is running, the acceptance filters are updated right away.
+ *
+ * @param[in] bus     The CAN bus service.
+ * @param[in] sub     The subscription object to initialize.
+ * @param[in] topic   The topic to subscribe (each topic can be subscribed once only).
+ * @param[in] queue   Buffer for the queue of received messages.
+ * @param[in] depth   Number of messages the queue can hold.
+ */
+void svcCanBusSubscribe(svc_canbus_t* bus, svc_canbus_subscription_t* sub, uint16_t topic, msg_t* queue, size_t depth)
+{
+  aosDbgCheck(bus != NULL);
+  aosDbgCheck(sub != NULL);
+  aosDbgCheck(topic <= SVC_CANPROTO_MAXTOPIC);
+  aosDbgCheck(queue != NULL && depth > 0);
+
+  sub->topic = topic;
+  chMBObjectInit(&sub->mailbox, queue, depth);
+  memset(&sub->stats, 0, sizeof(sub->stats));
+
+  chMtxLock(&bus->rxlock);
+  aosDbgAssert(_findSubscription(bus, topic) == NULL);
+  sub->next = bus->subscriptions;
+  bus->subscriptions = sub;
+  if (bus->thread != NULL) {
+    _applyFilters(bus);
+  }
+  chMtxUnlock(&bus->rxlock);
+
+  return;
+}
+
+/**
+ * @brief   Cancels a subscription.
+ * @details Messages in reassembly are dropped and all queued messages are returned to the pool.
+ *          If the service is running, the acceptance filters are updated right away.
+ *
+ * @param[in] bus   The CAN bus service.
+ * @param[in] sub   The subscription to cancel.
+ */
+void svcCanBusUnsubscribe(svc_canbus_t* bus, svc_canbus_subscription_t* sub)
+{
+  aosDbgCheck(bus != NULL);
+  aosDbgCheck(sub != NULL);
+
+  msg_t message;
+
+  chMtxLock(&bus->rxlock);
+  for (svc_canbus_subscription_t** link = &bus->subscriptions; *link != NULL; link = &(*link)->next) {
+    if (*link == sub) {
+      *link = sub->next;
+      break;
+    }
+  }
+  for (uint8_t s = 0; s < SVC_CANBUS_REASSEMBLYSLOTS; ++s) {
+    if (bus->reassembly[s].message != NULL && bus->reassembly[s].context.topic == sub->topic) {
+      chPoolFree(&bus->pool, bus->reassembly[s].message);
+      bus->reassembly[s].message = NULL;
+    }
+  }
+  while (chMBFetchTimeout(&sub->mailbox, &message, TIME_IMMEDIATE) == MSG_OK) {
+    chPoolFree(&bus->pool, (void*)message);
+  }
+  sub->next = NULL;
+  if (bus->thread != NULL) {
+    _applyFilters(bus);
+  }
+  chMtxUnlock(&bus->rxlock);
+
+  return;
+}
+
+/**
+ * @brief   Sets up the acceptance filters and starts the receive thread.
+ * @details Must be called after the SSSP module stack initialization, which relies on standard frames.
+ *          From then on, the acceptance filters follow the subscriptions.
+ *
+ * @param[in] bus     The CAN bus service.
+ * @param[in] wa      Working area for the thread.
+ * @param[in] wasize  Size of the working area.
+ * @param[in] prio    Priority of the thread.
+ */
+void svcCanBusStart(svc_canbus_t* bus, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(bus != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(bus->thread == NULL);
+
+  chMtxLock(&bus->rxlock);
+  _applyFilters(bus);
+  bus->thread = chThdCreateStatic(wa, wasize, prio, _svcCanBusThread, bus);
+  chMtxUnlock(&bus->rxlock);
+
+  return;
+}
+
+/**
+ * @brief   Stops the receive thread and restores the acceptance of all frames.
+ *
+ * @param[in] bus   The CAN bus service.
+ */
+void svcCanBusStop(svc_canbus_t* bus)
+{
+  aosDbgCheck(bus != NULL);
+
+  if (bus->thread != NULL) {
+    chThdTerminate(bus->thread);
+    chEvtSignal(bus->thread, EVENT_MASK(RXEVENT_ID));
+    chThdWait(bus->thread);
+    chMtxLock(&bus->rxlock);
+    bus->thread = NULL;
+    _acceptAll(bus);
+    _programBanks(bus);
+    chMtxUnlock(&bus->rxlock);
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] bus   The CAN bus service.
+ */
+void svcCanBusTeardown(void* bus)
+{
+  svcCanBusStop((svc_canbus_t*)bus);
+
+  return;
+}
+
+/**
+ * @brief   Publishes a message.
+ * @details The fragments of a message are queued back-to-back in the given class of the transmit scheduler, which
+ *          keeps them in order.
+ *          If the class has a lifetime, stale fragments are dropped and the receivers discard the incomplete message.
+ *
+ * @param[in] bus       The CAN bus service.
+ * @param[in] topic     Topic of the message.
+ * @param[in] txclass   Transmission class of the message.
+ * @param[in] data      The payload.
+ * @param[in] length    Length of the payload (at most SVC_CANBUS_MAXPAYLOAD bytes).
+ * @param[in] timeout   Timeout for each frame to get space in the transmit queue.
+ *
+ * @return  The result of the transmission.
+ * @retval  MSG_OK        All fragments were queued for transmission.
+ * @retval  MSG_TIMEOUT   A fragment could not be queued in time, so the message is incomplete.
+ * @retval  MSG_RESET     The transmit scheduler was stopped.
+ */
+msg_t svcCanBusPublish(svc_canbus_t* bus, uint16_t topic, svc_cantx_class_t txclass, const void* data, size_t length, sysinterval_t timeout)
+{
+  aosDbgCheck(bus != NULL);
+  aosDbgCheck(topic <= SVC_CANPROTO_MAXTOPIC);
+  aosDbgCheck(data != NULL || length == 0);
+  aosDbgCheck(length <= SVC_CANBUS_MAXPAYLOAD);
+
+  const uint8_t source = (uint8_t)aos.sssp.moduleId;
+  const uint8_t fragments = svcCanProtoNumFragments(length);
+  CANTxFrame frame;
+  msg_t status = MSG_OK;
+
+  frame.IDE = CAN_IDE_EXT;
+  frame.RTR = CAN_RTR_DATA;
+
+  chMtxLock(&bus->txlock);
+  for (uint8_t f = 0; f < fragments && status == MSG_OK; ++f) {
+    uint32_t id;
+    frame.DLC = svcCanProtoFragment(topic, source, bus->sequence, length, f, &id);
+    frame.EID = id;
+    memcpy(frame.data8, &((const uint8_t*)data)[f * SVC_CANPROTO_FRAMESIZE], frame.DLC);
+    status = svcCanTxEnqueue(bus->config->scheduler, txclass, &frame, timeout);
+    if (status == MSG_OK) {
+      ++bus->stats.txframes;
+    } else {
+      ++bus->stats.txerrors;
+    }
+  }
+  ++bus->sequence;
+  ++bus->stats.published;
+  chMtxUnlock(&bus->txlock);
+
+  return status;
+}
+
+/**
+ * @brief   Waits for a message of a subscribed topic.
+ *
+ * @param[in] sub       The subscription.
+ * @param[in] timeout   Maximum time to wait.
+ *
+ * @return  The received message or NULL on timeout.
+ *          The message must be returned via svcCanBusRelease() after processing.
+ */
+svc_canbus_message_t* svcCanBusReceive(svc_canbus_subscription_t* sub, sysinterval_t timeout)
+{
+  aosDbgCheck(sub != NULL);
+
+  msg_t message;
+
+  return (chMBFetchTimeout(&sub->mailbox, &message, timeout) == MSG_OK) ? (svc_canbus_message_t*)message : NULL;
+}
+
+/**
+ * @brief   Returns a received message to the pool.
+ *
+ * @param[in] bus       The CAN bus service.
+ * @param[in] message   The message to release.
+ */
+void svcCanBusRelease(svc_canbus_t* bus, svc_canbus_message_t* message)
+{
+  aosDbgCheck(bus != NULL);
+  aosDbgCheck(message != NULL);
+
+  chPoolFree(&bus->pool, message);
+
+  return;
+}
+
+/**
+ * @brief   Shell command to publish messages and print the state of the CAN bus service.
+ *
+ * @param[in] bus     The CAN bus service.
+ * @param[in] stream  The I/O stream to use.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ * @retval  AOS_ERROR               The message could not be queued for transmission.
+ */
+int svcCanBusShellCmd(svc_canbus_t* bus, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(bus != NULL);
+  aosDbgCheck(stream != NULL);
+
+  if (argc >= 3 && argc - 3 <= SVC_CANBUS_MAXPAYLOAD && (strcmp(argv[1], "--publish") == 0 || strcmp(argv[1], "-p") == 0)) {
+    uint8_t payload[SVC_CANBUS_MAXPAYLOAD];
+    for (int i = 3; i < argc; ++i) {
+      payload[i - 3] = (uint8_t)strtoul(argv[i], NULL, 0);
+    }
+    return (svcCanBusPublish(bus, (uint16_t)strtoul(argv[2], NULL, 0), SVC_CANTX_DATA, payload, (size_t)(argc - 3), TIME_MS2I(10)) == MSG_OK) ? AOS_OK : AOS_ERROR;
+  } else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the subscriptions, acceptance filters and statistics of the CAN publish/subscribe service.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --publish, -p <TOPIC> [<BYTE> ...]\n");
+    chprintf(stream, "    Publish a message with up to %u bytes.\n", SVC_CANBUS_MAXPAYLOAD);
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  chprintf(stream, "module ID %u\n", aos.sssp.moduleId);
+  chprintf(stream, "%-8s%12s%12s%12s\n", "topic", "received", "overflows", "queued");
+  // the receive thread is not blocked while printing, so the output is a snapshot that may be slightly inconsistent
+  for (svc_canbus_subscription_t* sub = bus->subscriptions; sub != NULL; sub = sub->next) {
+    uint32_t queued;
+    chSysLock();
+    queued = (uint32_t)chMBGetUsedCountI(&sub->mailbox);
+    chSysUnlock();
+    chprintf(stream, "0x%03X   %12u%12u%12u\n", sub->topic, sub->stats.received, sub->stats.overflows, queued);
+  }
+  chprintf(stream, "%u of %u filter banks%s, reprogrammed %u times\n", bus->filters, _numFilterBanks(), bus->acceptall ? " (accepting all frames)" : "", bus->stats.reprogrammed);
+  for (uint8_t b = 0; b < bus->filters; ++b) {
+    static const char* const modes[] = {"mask32", "list32", "mask16", "list16"};
+    chprintf(stream, "  %2u  %-8s0x%08X  0x%08X  FIFO%u\n", b, modes[bus->banks[b].mode], bus->banks[b].fr1, bus->banks[b].fr2, b & 1);
+  }
+  chprintf(stream, "frames: %u received, %u dropped in software (%u.%u%%), %u queued for transmission, %u not queued\n",
+           bus->stats.rxframes, bus->stats.filtered,
+           (bus->stats.rxframes > 0) ? (uint32_t)(((uint64_t)bus->stats.filtered * 100) / bus->stats.rxframes) : 0,
+           (bus->stats.rxframes > 0) ? (uint32_t)((((uint64_t)bus->stats.filtered * 1000) / bus->stats.rxframes) % 10) : 0,
+           bus->stats.txframes, bus->stats.txerrors);
+  chprintf(stream, "messages: %u published, %u delivered, %u lost, %u dropped for lack of buffers\n",
+           bus->stats.published, bus->stats.delivered, bus->stats.lost, bus->stats.nobuffer);
+
+  return AOS_OK;
+}
+
+#endif /* (HAL_USE_CAN == TRUE) */
@@ -0,0 +1,359 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <svc_canfilter.h>
+
+/**
+ * @brief   Identifier bits of standard frames.
+ */
+#define STD_BITS                      0x000007FFu
+
+/**
+ * @brief   Identifier bits of extended frames.
+ */
+#define EXT_BITS                      0x1FFFFFFFu
+
+/**
+ * @brief   IDE bit of a 32 bit filter.
+ */
+#define REG32_IDE                     (1u << 2)
+
+/**
+ * @brief   RTR bit of a 32 bit filter.
+ */
+#define REG32_RTR                     (1u << 1)
+
+/**
+ * @brief   IDE bit of a 16 bit filter.
+ */
+#define REG16_IDE                     (1u << 3)
+
+/**
+ * @brief   RTR bit of a 16 bit filter.
+ */
+#define REG16_RTR                     (1u << 4)
+
+/**
+ * @brief   Number of rules per class, which determines the number of filter banks.
+ */
+typedef struct {
+  size_t stdexact;              /**< Standard identifiers (four per 16 bit list).   */
+  size_t stdmask;               /**< Standard patterns (two per 16 bit mask bank).  */
+  size_t extexact;              /**< Extended identifiers (two per 32 bit list).    */
+  size_t extmask;               /**< Extended patterns (one per 32 bit mask bank).  */
+} classes_t;
+
+/**
+ * @brief   Returns the identifier bits of a frame format.
+ */
+static inline uint32_t _bits(bool extended)
+{
+  return extended ? EXT_BITS : STD_BITS;
+}
+
+/**
+ * @brief   Counts the set bits of a word.
+ */
+static uint8_t _popcount(uint32_t value)
+{
+  uint8_t count = 0;
+  while (value != 0) {
+    value &= value - 1;
+    ++count;
+  }
+  return count;
+}
+
+/**
+ * @brief   Checks whether a rule accepts all identifiers of another rule.
+ */
+static inline bool _covers(const svc_canfilter_rule_t* outer, const svc_canfilter_rule_t* inner)
+{
+  return (outer->extended == inner->extended) && ((outer->mask & ~inner->mask) == 0) && (((outer->id ^ inner->id) & outer->mask) == 0);
+}
+
+/**
+ * @brief   Merges two rules of the same frame format to the most specific rule that accepts both.
+ */
+static inline void _merge(const svc_canfilter_rule_t* a, const svc_canfilter_rule_t* b, svc_canfilter_rule_t* merged)
+{
+  merged->extended = a->extended;
+  merged->mask = a->mask & b->mask & ~(a->id ^ b->id);
+  merged->id = a->id & merged->mask;
+  return;
+}
+
+/**
+ * @brief   Adds a rule to the class counters.
+ */
+static inline void _classify(classes_t* classes, const svc_canfilter_rule_t* rule, int delta)
+{
+  const bool exact = (rule->mask == _bits(rule->extended));
+  size_t* const counter = rule->extended ? (exact ? &classes->extexact : &classes->extmask) : (exact ? &classes->stdexact : &classes->stdmask);
+  *counter = (size_t)((int)*counter + delta);
+  return;
+}
+
+/**
+ * @brief   Calculates the number of filter banks for the given classes.
+ * @details An odd number of standard patterns leaves a free 16 bit mask filter, which takes a standard identifier.
+ */
+static size_t _numBanks(const classes_t* classes)
+{
+  const size_t spare = classes->stdmask % 2;
+  const size_t stdexact = (classes->stdexact > spare) ? (classes->stdexact - spare) : 0;
+
+  return ((classes->stdmask + 1) / 2) + ((stdexact + 3) / 4) + ((classes->extexact + 1) / 2) + classes->extmask;
+}
+
+/**
+ * @brief   Removes all rules which are covered by other rules.
+ *
+ * @param[in] rules     The rules.
+ * @param[in] numrules  Number of rules.
+ *
+ * @return  The remaining number of rules.
+ */
+static size_t _removeCovered(svc_canfilter_rule_t* rules, size_t numrules)
+{
+  for (size_t i = 0; i < numrules; ++i) {
+    for (size_t j = 0; j < numrules; ++j) {
+      if (i != j && _covers(&rules[j], &rules[i])) {
+        rules[i] = rules[--numrules];
+        --i;
+        break;
+      }
+    }
+  }
+  return numrules;
+}
+
+/**
+ * @brief   Encodes a standard identifier for a 16 bit filter.
+ */
+static inline uint32_t _reg16(uint32_t id)
+{
+  return (id & STD_BITS) << 5;
+}
+
+/**
+ * @brief   Encodes a standard mask for a 16 bit filter.
+ */
+static inline uint32_t _mask16(uint32_t mask)
+{
+  return ((mask & STD_BITS) << 5) | REG16_IDE | REG16_RTR;
+}
+
+/**
+ * @brief   Encodes an identifier for a 32 bit filter.
+ */
+static inline uint32_t _reg32(bool extended, uint32_t id)
+{
+  return extended ? (((id & EXT_BITS) << 3) | REG32_IDE) : ((id & STD_BITS) << 21);
+}
+
+/**
+ * @brief   Encodes a mask for a 32 bit filter.
+ */
+static inline uint32_t _mask32(bool extended, uint32_t mask)
+{
+  return (extended ? ((mask & EXT_BITS) << 3) : ((mask & STD_BITS) << 21)) | REG32_IDE | REG32_RTR;
+}
+
+/**
+ * @brief   Compiles acceptance rules to a minimal set of bxCAN filter banks.
+ * @details Rules covered by others are removed first.
+ *          Exact identifiers are packed into list mode banks (four standard or two extended identifiers per bank),
+ *          patterns into mask mode banks (two standard or one extended pattern per bank).
+ *          If more banks would be required than available, the two rules whose merged pattern is the most specific one are
+ *          merged repeatedly, preferring merges that actually free a bank.
+ *          Merged rules accept a superset of the frames, so the receiver must still check the identifiers in software.
+ *          Only data frames are accepted.
+ *
+ * @param[in,out] rules     The rules (merged in place).
+ * @param[in]     numrules  Number of rules (at most SVC_CANFILTER_MAXRULES).
+ * @param[out]    banks     Array for the compiled filter banks.
+ * @param[in]     maxbanks  Number of available filter banks.
+ *
+ * @return  The number of filter banks used or -1 if the arguments are invalid.
+ */
+int svcCanFilterCompile(svc_canfilter_rule_t* rules, size_t numrules, svc_canfilter_bank_t* banks, size_t maxbanks)
+{
+  classes_t classes = {0, 0, 0, 0};
+  int used = 0;
+
+  if ((rules == NULL && numrules > 0) || numrules > SVC_CANFILTER_MAXRULES || banks == NULL || maxbanks == 0) {
+    return -1;
+  }
+
+  // normalize and remove redundant rules
+  for (size_t r = 0; r < numrules; ++r) {
+    rules[r].mask &= _bits(rules[r].extended);
+    rules[r].id &= rules[r].mask;
+  }
+  numrules = _removeCovered(rules, numrules);
+  for (size_t r = 0; r < numrules; ++r) {
+    _classify(&classes, &rules[r], 1);
+  }
+
+  // merge rules until they fit
+  while (_numBanks(&classes) > maxbanks) {
+    const size_t current = _numBanks(&classes);
+    size_t besti = 0, bestj = 0;
+    int bestscore = -1;
+    svc_canfilter_rule_t merged, best;
+
+    for (size_t i = 0; i < numrules; ++i) {
+      for (size_t j = i + 1; j < numrules; ++j) {
+        if (rules[i].extended != rules[j].extended) {
+          continue;
+        }
+        _merge(&rules[i], &rules[j], &merged);
+        classes_t next = classes;
+        _classify(&next, &rules[i], -1);
+        _classify(&next, &rules[j], -1);
+        _classify(&next, &merged, 1);
+        // freeing a bank dominates, then the number of identifier bits that are still checked
+        const int score = ((_numBanks(&next) < current) ? 64 : 0) + _popcount(merged.mask);
+        if (score > bestscore) {
+          bestscore = score;
+          besti = i;
+          bestj = j;
+          best = merged;
+        }
+      }
+    }
+    if (bestscore < 0) {
+      // standard and extended rules left only, but a single bank: accept everything
+      banks[0].mode = SVC_CANFILTER_MASK32;
+      banks[0].fr1 = 0;
+      banks[0].fr2 = 0;
+      return 1;
+    }
+    _classify(&classes, &rules[besti], -1);
+    _classify(&classes, &rules[bestj], -1);
+    rules[besti] = best;
+    rules[bestj] = rules[--numrules];
+    numrules = _removeCovered(rules, numrules);
+    classes = (classes_t){0, 0, 0, 0};
+    for (size_t r = 0; r < numrules; ++r) {
+      _classify(&classes, &rules[r], 1);
+    }
+  }
+
+  // sort by class, so rules sharing a bank are adjacent: standard patterns, standard IDs, extended patterns, extended IDs
+  for (size_t i = 1; i < numrules; ++i) {
+    const svc_canfilter_rule_t rule = rules[i];
+    const uint8_t key = (uint8_t)((rule.extended ? 2 : 0) + ((rule.mask == _bits(rule.extended)) ? 1 : 0));
+    size_t j = i;
+    while (j > 0 && (uint8_t)((rules[j - 1].extended ? 2 : 0) + ((rules[j - 1].mask == _bits(rules[j - 1].extended)) ? 1 : 0)) > key) {
+      rules[j] = rules[j - 1];
+      --j;
+    }
+    rules[j] = rule;
+  }
+
+  // emit the banks
+  {
+    size_t r = 0;
+    // standard patterns in pairs; an odd pattern shares its bank with a standard identifier if there is any
+    for (size_t p = 0; p < classes.stdmask; p += 2, ++used) {
+      const svc_canfilter_rule_t* const first = &rules[r++];
+      const svc_canfilter_rule_t* second = first;
+      if (p + 1 < classes.stdmask || classes.stdexact > 0) {
+        second = &rules[r++];
+      }
+      banks[used].mode = SVC_CANFILTER_MASK16;
+      banks[used].fr1 = _reg16(first->id) | (_mask16(first->mask) << 16);
+      banks[used].fr2 = _reg16(second->id) | (_mask16(second->mask) << 16);
+    }
+    // standard identifiers in quads
+    while (r < numrules && !rules[r].extended) {
+      uint32_t ids[4];
+      for (uint8_t i = 0; i < 4; ++i) {
+        ids[i] = (r < numrules && !rules[r].extended) ? _reg16(rules[r++].id) : ids[0];
+      }
+      banks[used].mode = SVC_CANFILTER_LIST16;
+      banks[used].fr1 = ids[0] | (ids[1] << 16);
+      banks[used].fr2 = ids[2] | (ids[3] << 16);
+      ++used;
+    }
+    // extended patterns
+    for (size_t p = 0; p < classes.extmask; ++p, ++used) {
+      banks[used].mode = SVC_CANFILTER_MASK32;
+      banks[used].fr1 = _reg32(true, rules[r].id);
+      banks[used].fr2 = _mask32(true, rules[r].mask);
+      ++r;
+    }
+    // extended identifiers in pairs
+    while (r < numrules) {
+      banks[used].mode = SVC_CANFILTER_LIST32;
+      banks[used].fr1 = _reg32(true, rules[r++].id);
+      banks[used].fr2 = (r < numrules) ? _reg32(true, rules[r++].id) : banks[used].fr1;
+      ++used;
+    }
+  }
+
+  return used;
+}
+
+/**
+ * @brief   Checks whether a data frame passes compiled filter banks.
+ *
+ * @param[in] banks     The filter banks.
+ * @param[in] numbanks  Number of filter banks.
+ * @param[in] extended  Flag whether the identifier is an extended one.
+ * @param[in] id        The identifier.
+ *
+ * @return  True if any bank accepts the frame.
+ */
+bool svcCanFilterMatch(const svc_canfilter_bank_t* banks, size_t numbanks, bool extended, uint32_t id)
+{
+  const uint32_t rx32 = _reg32(extended, id);
+  const uint32_t rx16 = extended ? ((((id >> 18) & STD_BITS) << 5) | REG16_IDE | ((id >> 15) & 0x7u)) : _reg16(id);
+
+  for (size_t b = 0; b < numbanks; ++b) {
+    switch (banks[b].mode) {
+      case SVC_CANFILTER_MASK32:
+        if (((rx32 ^ banks[b].fr1) & banks[b].fr2) == 0) {
+          return true;
+        }
+        break;
+      case SVC_CANFILTER_LIST32:
+        if (rx32 == banks[b].fr1 || rx32 == banks[b].fr2) {
+          return true;
+        }
+        break;
+      case SVC_CANFILTER_MASK16:
+        if (((rx16 ^ banks[b].fr1) & (banks[b].fr1 >> 16) & 0xFFFFu) == 0 ||
+            ((rx16 ^ banks[b].fr2) & (banks[b].fr2 >> 16) & 0xFFFFu) == 0) {
+          return true;
+        }
+        break;
+      case SVC_CANFILTER_LIST16:
+        if (rx16 == (banks[b].fr1 & 0xFFFFu) || rx16 == (banks[b].fr1 >> 16) ||
+            rx16 == (banks[b].fr2 & 0xFFFFu) || rx16 == (banks[b].fr2 >> 16)) {
+          return true;
+        }
+        break;
+    }
+  }
+
+  return false;
+}
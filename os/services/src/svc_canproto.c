@@ -0,0 +1,192 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <svc_canproto.h>
+
+#include <string.h>
+
+/**
+ * @brief   Position of the source module in the extended CAN identifier.
+ */
+#define SOURCE_SHIFT                  9
+
+/**
+ * @brief   Position of the fragment index in the extended CAN identifier.
+ */
+#define INDEX_SHIFT                   3
+
+/**
+ * @brief   Position of the last fragment flag in the extended CAN identifier.
+ */
+#define LAST_SHIFT                    2
+
+/**
+ * @brief   Mask of the sequence number.
+ */
+#define SEQUENCE_MASK                 0x03u
+
+/**
+ * @brief   Encodes a fragment header to an extended CAN identifier.
+ *
+ * @param[in] header  The header to encode.
+ *
+ * @return  The 29 bit identifier.
+ */
+uint32_t svcCanProtoEncodeId(const svc_canproto_header_t* header)
+{
+  return (((uint32_t)header->topic & SVC_CANPROTO_MAXTOPIC) << SVC_CANPROTO_TOPICSHIFT) |
+         ((uint32_t)header->source << SOURCE_SHIFT) |
+         (((uint32_t)header->index & (SVC_CANPROTO_MAXFRAGMENTS - 1)) << INDEX_SHIFT) |
+         ((header->last ? 1u : 0u) << LAST_SHIFT) |
+         ((uint32_t)header->sequence & SEQUENCE_MASK);
+}
+
+/**
+ * @brief   Decodes an extended CAN identifier to a fragment header.
+ *
+ * @param[in]  id       The 29 bit identifier.
+ * @param[out] header   The decoded header.
+ */
+void svcCanProtoDecodeId(uint32_t id, svc_canproto_header_t* header)
+{
+  header->topic = (uint16_t)((id & SVC_CANPROTO_TOPICMASK) >> SVC_CANPROTO_TOPICSHIFT);
+  header->source = (uint8_t)(id >> SOURCE_SHIFT);
+  header->index = (uint8_t)((id >> INDEX_SHIFT) & (SVC_CANPROTO_MAXFRAGMENTS - 1));
+  header->last = ((id >> LAST_SHIFT) & 1u) != 0;
+  header->sequence = (uint8_t)(id & SEQUENCE_MASK);
+
+  return;
+}
+
+/**
+ * @brief   Calculates the number of fragments required to transmit a message.
+ *
+ * @param[in] length  Length of the payload in bytes.
+ *
+ * @return  The number of fragments (at least one, even for empty messages) or 0 if the payload is too long.
+ */
+uint8_t svcCanProtoNumFragments(size_t length)
+{
+  if (length > SVC_CANPROTO_MAXFRAGMENTS * SVC_CANPROTO_FRAMESIZE) {
+    return 0;
+  }
+  return (length == 0) ? 1 : (uint8_t)((length + SVC_CANPROTO_FRAMESIZE - 1) / SVC_CANPROTO_FRAMESIZE);
+}
+
+/**
+ * @brief   Calculates identifier and size of a fragment.
+ * @details The payload of the fragment starts at index * SVC_CANPROTO_FRAMESIZE.
+ *
+ * @param[in]  topic      Topic of the message.
+ * @param[in]  source     Module ID of the publisher.
+ * @param[in]  sequence   Sequence number of the message.
+ * @param[in]  length     Length of the complete payload.
+ * @param[in]  index      Index of the fragment.
+ * @param[out] id         The extended CAN identifier of the fragment.
+ *
+ * @return  The number of payload bytes of the fragment (DLC).
+ */
+uint8_t svcCanProtoFragment(uint16_t topic, uint8_t source, uint8_t sequence, size_t length, uint8_t index, uint32_t* id)
+{
+  const uint8_t fragments = svcCanProtoNumFragments(length);
+  const size_t offset = (size_t)index * SVC_CANPROTO_FRAMESIZE;
+  const svc_canproto_header_t header = {
+    /* topic    */ topic,
+    /* source   */ source,
+    /* index    */ index,
+    /* last     */ (index + 1 >= fragments),
+    /* sequence */ sequence,
+  };
+
+  *id = svcCanProtoEncodeId(&header);
+
+  return (offset >= length) ? 0 : (uint8_t)(((length - offset) < SVC_CANPROTO_FRAMESIZE) ? (length - offset) : SVC_CANPROTO_FRAMESIZE);
+}
+
+/**
+ * @brief   Initializes a reassembly context.
+ *
+ * @param[in] reassembly  The reassembly context.
+ * @param[in] buffer      Buffer for the payload.
+ * @param[in] size        Size of the buffer.
+ */
+void svcCanProtoReassemblyInit(svc_canproto_reassembly_t* reassembly, uint8_t* buffer, size_t size)
+{
+  reassembly->buffer = buffer;
+  reassembly->size = size;
+  reassembly->length = 0;
+  reassembly->topic = 0;
+  reassembly->source = 0;
+  reassembly->sequence = 0;
+  reassembly->next = 0;
+  reassembly->active = false;
+
+  return;
+}
+
+/**
+ * @brief   Feeds a received fragment to a reassembly context.
+ * @details A first fragment always (re)starts the context, discarding any message in progress.
+ *          All further fragments must belong to the message in progress and arrive in order.
+ *
+ * @param[in] reassembly  The reassembly context.
+ * @param[in] header      Decoded header of the fragment.
+ * @param[in] data        Payload of the fragment.
+ * @param[in] dlc         Number of payload bytes.
+ *
+ * @return  The state of the context after the fragment was processed.
+ */
+svc_canproto_result_t svcCanProtoReassemble(svc_canproto_reassembly_t* reassembly, const svc_canproto_header_t* header, const uint8_t* data, uint8_t dlc)
+{
+  if (header->index == 0) {
+    reassembly->topic = header->topic;
+    reassembly->source = header->source;
+    reassembly->sequence = header->sequence;
+    reassembly->length = 0;
+    reassembly->next = 0;
+    reassembly->active = true;
+  } else if (!reassembly->active ||
+             header->topic != reassembly->topic ||
+             header->source != reassembly->source ||
+             header->sequence != reassembly->sequence ||
+             header->index != reassembly->next) {
+    reassembly->active = false;
+    return SVC_CANPROTO_LOST;
+  }
+
+  // all fragments but the last one are completely filled
+  if (dlc > SVC_CANPROTO_FRAMESIZE || (!header->last && dlc != SVC_CANPROTO_FRAMESIZE)) {
+    reassembly->active = false;
+    return SVC_CANPROTO_LOST;
+  }
+  if (reassembly->length + dlc > reassembly->size) {
+    reassembly->active = false;
+    return SVC_CANPROTO_OVERFLOW;
+  }
+
+  memcpy(&reassembly->buffer[reassembly->length], data, dlc);
+  reassembly->length += dlc;
+  ++reassembly->next;
+  if (header->last) {
+    reassembly->active = false;
+    return SVC_CANPROTO_COMPLETE;
+  }
+
+  return SVC_CANPROTO_PENDING;
+}
@@ -0,0 +1,418 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_cantx.h>
+
+#if (HAL_USE_CAN == TRUE) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_idle.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Event ID of the transmit listener.
+ */
+#define TXEVENT_ID                    0
+
+/**
+ * @brief   Computes the arbitration priority of a frame.
+ * @details The fields are arranged in the order they are sent on the bus, so lower values win the arbitration.
+ *
+ * @param[in] frame   The frame.
+ *
+ * @return  The arbitration priority.
+ */
+static inline uint32_t _priority(const CANTxFrame* frame)
+{
+  if (frame->IDE == CAN_IDE_EXT) {
+    // base identifier, SRR, IDE, identifier extension, RTR
+    return ((uint32_t)(frame->EID >> 18) << 21) | ((uint32_t)3 << 19) | ((uint32_t)(frame->EID & 0x3FFFF) << 1) | frame->RTR;
+  } else {
+    // base identifier, RTR, IDE
+    return ((uint32_t)frame->SID << 21) | ((uint32_t)frame->RTR << 20);
+  }
+}
+
+/**
+ * @brief   Removes the oldest frame of a class and wakes a thread waiting for space.
+ *
+ * @param[in] tx        The CAN transmit scheduler.
+ * @param[in] txclass   The transmission class.
+ */
+static void _popS(svc_cantx_t* tx, uint8_t txclass)
+{
+  tx->classes[txclass].head = (tx->classes[txclass].head + 1) % tx->config->classes[txclass].size;
+  --tx->classes[txclass].count;
+  chThdDequeueNextI(&tx->classes[txclass].waiting, MSG_OK);
+
+  return;
+}
+
+/**
+ * @brief   Retrieves the oldest frame of a class, dropping all frames which missed their deadline.
+ *
+ * @param[in] tx        The CAN transmit scheduler.
+ * @param[in] txclass   The transmission class.
+ * @param[in] now       The current uptime.
+ *
+ * @return  The oldest valid frame or NULL if the queue is empty.
+ */
+static svc_cantx_entry_t* _headS(svc_cantx_t* tx, uint8_t txclass, aos_timestamp_t now)
+{
+  while (tx->classes[txclass].count > 0) {
+    svc_cantx_entry_t* const entry = &tx->config->classes[txclass].entries[tx->classes[txclass].head];
+    if (entry->deadline == 0 || entry->deadline > now) {
+      return entry;
+    }
+    _popS(tx, txclass);
+    ++tx->classes[txclass].stats.expired;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Checks whether a frame may be handed to a free mailbox.
+ * @details A frame must not overtake the pending frames of its class and the last free mailbox is reserved for control
+ *          frames.
+ *
+ * @param[in] tx        The CAN transmit scheduler.
+ * @param[in] txclass   Transmission class of the frame.
+ * @param[in] priority  Arbitration priority of the frame.
+ *
+ * @return  True if the frame may be transmitted now.
+ */
+static bool _admissible(svc_cantx_t* tx, uint8_t txclass, uint32_t priority)
+{
+  uint8_t others = 0;
+
+  for (uint8_t m = 0; m < CAN_TX_MAILBOXES; ++m) {
+    if (tx->mailboxes[m].pending) {
+      if (tx->mailboxes[m].txclass == txclass && tx->mailboxes[m].priority >= priority) {
+        return false;
+      }
+      others += (tx->mailboxes[m].txclass != SVC_CANTX_CONTROL) ? 1 : 0;
+    }
+  }
+
+  return (txclass == SVC_CANTX_CONTROL) || (others < CAN_TX_MAILBOXES - 1);
+}
+
+/**
+ * @brief   Accounts all completed transmissions and refills the free mailboxes.
+ *
+ * @param[in] tx    The CAN transmit scheduler.
+ */
+static void _refillS(svc_cantx_t* tx)
+{
+  CANDriver* const driver = tx->config->driver;
+  const uint32_t tsr = driver->can->TSR;
+  aos_timestamp_t now;
+
+  aosSysGetUptimeX(&now);
+
+  // a mailbox is empty again once the transmission has completed or was aborted
+  for (uint8_t m = 0; m < CAN_TX_MAILBOXES; ++m) {
+    if (tx->mailboxes[m].pending && (tsr & (CAN_TSR_TME0 << m))) {
+      const aos_interval_t latency = (aos_interval_t)(now - tx->mailboxes[m].enqueued);
+      const uint8_t c = tx->mailboxes[m].txclass;
+      ++tx->classes[c].stats.frames;
+      tx->classes[c].stats.min = (latency < tx->classes[c].stats.min) ? latency : tx->classes[c].stats.min;
+      tx->classes[c].stats.max = (latency > tx->classes[c].stats.max) ? latency : tx->classes[c].stats.max;
+      tx->classes[c].stats.total += latency;
+      tx->mailboxes[m].pending = false;
+    }
+  }
+
+  if (driver->state != CAN_READY) {
+    return;
+  }
+
+  for (uint8_t m = 0; m < CAN_TX_MAILBOXES; ++m) {
+    bool loaded = false;
+    if (tx->mailboxes[m].pending) {
+      continue;
+    }
+    for (uint8_t c = 0; c < SVC_CANTX_NUMCLASSES && !loaded; ++c) {
+      svc_cantx_entry_t* const entry = _headS(tx, c, now);
+      if (entry != NULL) {
+        const uint32_t priority = _priority(&entry->frame);
+        if (_admissible(tx, c, priority) && !canTryTransmitI(driver, (canmbx_t)(m + 1), &entry->frame)) {
+          tx->mailboxes[m].pending = true;
+          tx->mailboxes[m].txclass = c;
+          tx->mailboxes[m].priority = priority;
+          tx->mailboxes[m].enqueued = entry->enqueued;
+          _popS(tx, c);
+          loaded = true;
+#if (AMIROOS_CFG_IDLE_STOP == true)
+          // the transmission and any reply would be lost in STOP mode
+          aosIdleDeferI(AOS_IDLE_STOP, AMIROOS_CFG_IDLE_STOP_CANQUIET);
+#endif
+        }
+      }
+    }
+    if (!loaded) {
+      // none of the remaining frames may be transmitted before a pending one has completed
+      break;
+    }
+  }
+
+  return;
+}
+
+/**
+ * @brief   CAN transmit scheduler thread.
+ * @details Sleeps until the driver signals empty mailboxes and refills them.
+ *
+ * @param[in] tx    The CAN transmit scheduler.
+ */
+static THD_FUNCTION(_svcCanTxThread, tx)
+{
+  svc_cantx_t* const t = (svc_cantx_t*)tx;
+  event_listener_t listener;
+  eventflags_t flags;
+
+  chRegSetThreadName("cantx");
+
+  chEvtRegisterMask(&t->config->driver->txempty_event, &listener, EVENT_MASK(TXEVENT_ID));
+
+  while (!chThdShouldTerminateX()) {
+    chEvtWaitAny(EVENT_MASK(TXEVENT_ID));
+    flags = chEvtGetAndClearFlags(&listener);
+    chSysLock();
+    // the upper half of the flags marks mailboxes whose transmission failed
+    for (uint8_t m = 1; m <= CAN_TX_MAILBOXES; ++m) {
+      t->failed += (flags & (CAN_MAILBOX_TO_MASK(m) << 16)) ? 1 : 0;
+    }
+    _refillS(t);
+    chSchRescheduleS();
+    chSysUnlock();
+  }
+
+  chEvtUnregister(&t->config->driver->txempty_event, &listener);
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes a CAN transmit scheduler object.
+ *
+ * @param[in] tx      The CAN transmit scheduler to initialize.
+ * @param[in] config  The configuration to use.
+ */
+void svcCanTxInit(svc_cantx_t* tx, const svc_cantx_config_t* config)
+{
+  aosDbgCheck(tx != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->driver != NULL);
+
+  tx->config = config;
+  for (uint8_t c = 0; c < SVC_CANTX_NUMCLASSES; ++c) {
+    aosDbgCheck(config->classes[c].entries != NULL && config->classes[c].size > 0);
+    tx->classes[c].head = 0;
+    tx->classes[c].count = 0;
+    chThdQueueObjectInit(&tx->classes[c].waiting);
+    memset(&tx->classes[c].stats, 0, sizeof(tx->classes[c].stats));
+    tx->classes[c].stats.min = ~(aos_interval_t)0;
+  }
+  for (uint8_t m = 0; m < CAN_TX_MAILBOXES; ++m) {
+    tx->mailboxes[m].pending = false;
+  }
+  tx->failed = 0;
+  tx->thread = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Starts the thread that refills the transmit mailboxes.
+ * @details The priority should be above all threads that transmit frames, so the mailboxes are refilled right away.
+ *
+ * @param[in] tx      The CAN transmit scheduler.
+ * @param[in] wa      Working area for the thread.
+ * @param[in] wasize  Size of the working area.
+ * @param[in] prio    Priority of the thread.
+ */
+void svcCanTxStart(svc_cantx_t* tx, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(tx != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(tx->thread == NULL);
+
+  tx->thread = chThdCreateStatic(wa, wasize, prio, _svcCanTxThread, tx);
+
+  return;
+}
+
+/**
+ * @brief   Stops the thread and drops all queued frames.
+ * @details Threads waiting for space in a queue are released with MSG_RESET.
+ *
+ * @param[in] tx    The CAN transmit scheduler.
+ */
+void svcCanTxStop(svc_cantx_t* tx)
+{
+  aosDbgCheck(tx != NULL);
+
+  if (tx->thread != NULL) {
+    chThdTerminate(tx->thread);
+    chEvtSignal(tx->thread, EVENT_MASK(TXEVENT_ID));
+    chThdWait(tx->thread);
+    tx->thread = NULL;
+
+    chSysLock();
+    for (uint8_t c = 0; c < SVC_CANTX_NUMCLASSES; ++c) {
+      tx->classes[c].count = 0;
+      chThdDequeueAllI(&tx->classes[c].waiting, MSG_RESET);
+    }
+    chSchRescheduleS();
+    chSysUnlock();
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] tx    The CAN transmit scheduler.
+ */
+void svcCanTxTeardown(void* tx)
+{
+  svcCanTxStop((svc_cantx_t*)tx);
+
+  return;
+}
+
+/**
+ * @brief   Queues a frame for transmission.
+ * @details If a suitable mailbox is free, the frame is handed to it right away.
+ *
+ * @param[in] tx        The CAN transmit scheduler.
+ * @param[in] txclass   Transmission class of the frame.
+ * @param[in] frame     The frame to transmit.
+ * @param[in] timeout   Maximum time to wait for space in the queue.
+ *
+ * @return  The result of the operation.
+ * @retval  MSG_OK        The frame was queued.
+ * @retval  MSG_TIMEOUT   The queue of the class remained full.
+ * @retval  MSG_RESET     The scheduler was stopped while waiting.
+ */
+msg_t svcCanTxEnqueue(svc_cantx_t* tx, svc_cantx_class_t txclass, const CANTxFrame* frame, sysinterval_t timeout)
+{
+  aosDbgCheck(tx != NULL);
+  aosDbgCheck((unsigned int)txclass < SVC_CANTX_NUMCLASSES);
+  aosDbgCheck(frame != NULL);
+
+  const svc_cantx_classconfig_t* const config = &tx->config->classes[txclass];
+  svc_cantx_entry_t* entry;
+  aos_timestamp_t now;
+  msg_t status = MSG_OK;
+
+  chSysLock();
+  aosSysGetUptimeX(&now);
+  // stale frames give way to new ones
+  _headS(tx, txclass, now);
+  while (status == MSG_OK && tx->classes[txclass].count >= config->size) {
+    status = chThdEnqueueTimeoutS(&tx->classes[txclass].waiting, timeout);
+  }
+  if (status == MSG_OK) {
+    entry = &config->entries[(tx->classes[txclass].head + tx->classes[txclass].count) % config->size];
+    entry->frame = *frame;
+    aosSysGetUptimeX(&entry->enqueued);
+    entry->deadline = (config->lifetime > 0) ? entry->enqueued + config->lifetime : 0;
+    ++tx->classes[txclass].count;
+    if (tx->classes[txclass].count > tx->classes[txclass].stats.peak) {
+      tx->classes[txclass].stats.peak = tx->classes[txclass].count;
+    }
+    _refillS(tx);
+    chSchRescheduleS();
+  }
+  chSysUnlock();
+
+  return status;
+}
+
+/**
+ * @brief   Shell command to print the queues and latency statistics of the CAN transmit scheduler.
+ *
+ * @param[in] tx      The CAN transmit scheduler.
+ * @param[in] stream  The I/O stream to use.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+int svcCanTxShellCmd(svc_cantx_t* tx, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(tx != NULL);
+  aosDbgCheck(stream != NULL);
+
+  static const char* const names[SVC_CANTX_NUMCLASSES] = {"control", "data", "bulk"};
+
+  if (argc > 1 && (strcmp(argv[1], "--reset") == 0 || strcmp(argv[1], "-r") == 0)) {
+    chSysLock();
+    for (uint8_t c = 0; c < SVC_CANTX_NUMCLASSES; ++c) {
+      memset(&tx->classes[c].stats, 0, sizeof(tx->classes[c].stats));
+      tx->classes[c].stats.min = ~(aos_interval_t)0;
+    }
+    tx->failed = 0;
+    chSysUnlock();
+    return AOS_OK;
+  } else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the queues and the latencies (from queueing to completion) of the CAN transmit scheduler.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --reset, -r\n");
+    chprintf(stream, "    Reset the statistics.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  chprintf(stream, "%-8s%8s%6s%10s%9s%10s%10s%10s\n", "class", "queued", "peak", "frames", "expired", "min [us]", "avg [us]", "max [us]");
+  for (uint8_t c = 0; c < SVC_CANTX_NUMCLASSES; ++c) {
+    size_t queued, peak;
+    uint32_t frames, expired;
+    aos_interval_t min, max;
+    uint64_t total;
+    // take a consistent snapshot, since the statistics are updated from the thread and all transmitting threads
+    chSysLock();
+    queued = tx->classes[c].count;
+    peak = tx->classes[c].stats.peak;
+    frames = tx->classes[c].stats.frames;
+    expired = tx->classes[c].stats.expired;
+    min = tx->classes[c].stats.min;
+    max = tx->classes[c].stats.max;
+    total = tx->classes[c].stats.total;
+    chSysUnlock();
+    chprintf(stream, "%-8s%4u/%-3u%6u%10u%9u%10u%10u%10u\n", names[c],
+             (uint32_t)queued, (uint32_t)tx->config->classes[c].size, (uint32_t)peak, frames, expired,
+             (frames > 0) ? min : 0, (frames > 0) ? (uint32_t)(total / frames) : 0, max);
+  }
+  chprintf(stream, "%u frames failed or were aborted\n", tx->failed);
+
+  return AOS_OK;
+}
+
+#endif /* (HAL_USE_CAN == TRUE) */
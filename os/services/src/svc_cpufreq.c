@@ -0,0 +1,190 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <svc_cpufreq.h>
+
+#include <aos_debug.h>
+#include <aos_idle.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   CPU frequency governor thread.
+ * @details Measures the load of the core once per period and selects the clock level accordingly.
+ *
+ * @param[in] cpufreq   The CPU frequency governor.
+ */
+static THD_FUNCTION(_svcCpuFreqThread, cpufreq)
+{
+  svc_cpufreq_t* const c = (svc_cpufreq_t*)cpufreq;
+  aos_timestamp_t uptime, idle;
+  aos_timestamp_t lastuptime, lastidle;
+
+  chRegSetThreadName("cpufreq");
+
+  chSysLock();
+  aosSysGetUptimeX(&lastuptime);
+  aosIdleGetTimeX(&lastidle);
+  chSysUnlock();
+
+  while (!chThdShouldTerminateX()) {
+    chThdSleep(TIME_US2I(c->config->period));
+
+    chSysLock();
+    aosSysGetUptimeX(&uptime);
+    aosIdleGetTimeX(&idle);
+    chSysUnlock();
+
+    const aos_timestamp_t elapsed = uptime - lastuptime;
+    const aos_timestamp_t idled = idle - lastidle;
+    c->load = (idled < elapsed) ? (uint16_t)(1000 - (idled * 1000 / elapsed)) : 0;
+    lastuptime = uptime;
+    lastidle = idle;
+    ++c->stats.samples;
+
+    const uint8_t level = aosClockGetLevelX();
+    if (c->load >= c->config->up) {
+      if (level > 0 && aosClockSwitch(0) == AOS_OK) {
+        ++c->stats.boosts;
+      }
+    } else if (level + 1 < aosClockGetNumLevelsX()) {
+      // the load scales inversely with the core clock
+      const uint64_t projected = (uint64_t)c->load * aosClockGetLevelInfoX(level)->hclk;
+      if (projected < (uint64_t)c->config->down * aosClockGetLevelInfoX(level + 1)->hclk &&
+          aosClockSwitch(level + 1) == AOS_OK) {
+        ++c->stats.steps;
+      }
+    }
+  }
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes a CPU frequency governor object.
+ * @note    The clock levels must have been initialized via aosClockInit() before the governor is started.
+ *
+ * @param[in] cpufreq   The CPU frequency governor to initialize.
+ * @param[in] config    The configuration to use.
+ */
+void svcCpuFreqInit(svc_cpufreq_t* cpufreq, const svc_cpufreq_config_t* config)
+{
+  aosDbgCheck(cpufreq != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->period > 0);
+  aosDbgCheck(config->down < config->up && config->up <= 1000);
+
+  cpufreq->config = config;
+  cpufreq->load = 0;
+  memset(&cpufreq->stats, 0, sizeof(cpufreq->stats));
+  cpufreq->thread = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Starts the governor thread.
+ * @details The thread should run with high priority, so a burst of normal threads raises the clock right away.
+ *
+ * @param[in] cpufreq   The CPU frequency governor.
+ * @param[in] wa        Working area for the thread.
+ * @param[in] wasize    Size of the working area.
+ * @param[in] prio      Priority of the thread.
+ */
+void svcCpuFreqStart(svc_cpufreq_t* cpufreq, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(cpufreq != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(cpufreq->thread == NULL);
+  aosDbgAssert(aosClockGetNumLevelsX() > 0);
+
+  cpufreq->thread = chThdCreateStatic(wa, wasize, prio, _svcCpuFreqThread, cpufreq);
+
+  return;
+}
+
+/**
+ * @brief   Stops the governor thread and restores the fastest clock level.
+ * @details The static clock configuration is restored, so it is active during the shutdown and for the bootloader.
+ *
+ * @param[in] cpufreq   The CPU frequency governor.
+ */
+void svcCpuFreqStop(svc_cpufreq_t* cpufreq)
+{
+  aosDbgCheck(cpufreq != NULL);
+
+  if (cpufreq->thread != NULL) {
+    chThdTerminate(cpufreq->thread);
+    chThdWait(cpufreq->thread);
+    cpufreq->thread = NULL;
+    aosClockSwitch(0);
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] cpufreq   The CPU frequency governor.
+ */
+void svcCpuFreqTeardown(void* cpufreq)
+{
+  svcCpuFreqStop((svc_cpufreq_t*)cpufreq);
+
+  return;
+}
+
+/**
+ * @brief   Shell command to print the state of the CPU frequency governor.
+ *
+ * @param[in] cpufreq   The CPU frequency governor.
+ * @param[in] stream    The I/O stream to use.
+ * @param[in] argc      Number of arguments.
+ * @param[in] argv      List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+int svcCpuFreqShellCmd(svc_cpufreq_t* cpufreq, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(cpufreq != NULL);
+  aosDbgCheck(stream != NULL);
+
+  if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the load of the core and the residency of all clock levels.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  chprintf(stream, "governor:   %s, sampled every %uus\n", (cpufreq->thread != NULL) ? "running" : "stopped", cpufreq->config->period);
+  chprintf(stream, "load:       %u.%u %%\n", cpufreq->load / 10, cpufreq->load % 10);
+  chprintf(stream, "thresholds: %u.%u %% up, %u.%u %% down\n",
+           cpufreq->config->up / 10, cpufreq->config->up % 10, cpufreq->config->down / 10, cpufreq->config->down % 10);
+  chprintf(stream, "changes:    %u boosts, %u steps down (%u samples)\n", cpufreq->stats.boosts, cpufreq->stats.steps, cpufreq->stats.samples);
+  aosClockPrintInfo(stream);
+
+  return AOS_OK;
+}
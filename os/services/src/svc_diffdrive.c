@@ -0,0 +1,553 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_diffdrive.h>
+
+#if (defined(AMIROLLD_CFG_USE_A3906) && (HAL_USE_GPT == TRUE) && (HAL_USE_PWM == TRUE) && (HAL_USE_QEI == TRUE) && (QEI_USE_VELOCITY == TRUE)) || defined(__DOXYGEN__)
+
+#include <aos_clock.h>
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief   Saturation limit of the controller in internal representation.
+ */
+#define SVC_DIFFDRIVE_LIMIT           ((int64_t)1 << (SVC_DIFFDRIVE_GAIN_FRACBITS + SVC_DIFFDRIVE_OUTPUT_FRACBITS))
+
+/**
+ * @brief   Retrieves the service object from a GPT driver.
+ * @details The timer configuration is the first member of the service object.
+ */
+#define _ddFromDriver(gptp)           ((svc_diffdrive_t*)(void*)(gptp)->config)
+
+/**
+ * @brief   Converts a floating point value to fixed-point representation.
+ *
+ * @param[in] value     Value to convert.
+ * @param[in] fracbits  Number of fractional bits.
+ *
+ * @return  The rounded fixed-point value.
+ */
+static inline int32_t _float2fixed(float value, unsigned int fracbits)
+{
+  return (int32_t)lroundf(value * (float)((uint32_t)1 << fracbits));
+}
+
+/**
+ * @brief   Converts a wheel velocity to increments per second.
+ *
+ * @param[in] dd        The service object.
+ * @param[in] velocity  Wheel velocity in micrometers per second.
+ *
+ * @return  Wheel velocity in increments per second (Q16.16).
+ */
+static inline qeivelocity_t _um2inc(svc_diffdrive_t* dd, int64_t velocity)
+{
+  return (qeivelocity_t)((velocity * dd->incperum) >> (32 - QEI_VELOCITY_FRACBITS));
+}
+
+/**
+ * @brief   Converts a wheel velocity to micrometers per second.
+ *
+ * @param[in] dd        The service object.
+ * @param[in] velocity  Wheel velocity in increments per second (Q16.16).
+ *
+ * @return  Wheel velocity in micrometers per second.
+ */
+static inline int32_t _inc2um(svc_diffdrive_t* dd, qeivelocity_t velocity)
+{
+  return (int32_t)(((int64_t)velocity << (32 - QEI_VELOCITY_FRACBITS)) / dd->incperum);
+}
+
+/**
+ * @brief   Applies a controller output to the PWM channels of a wheel.
+ *
+ * @param[in] dd      The service object.
+ * @param[in] wheel   The wheel to drive.
+ * @param[in] output  Output value (@p SVC_DIFFDRIVE_OUTPUT_FRACBITS fractional bits, negative values drive backwards).
+ */
+static void _setOutputI(svc_diffdrive_t* dd, svc_diffdrive_wheelid_t wheel, int32_t output)
+{
+  PWMDriver* const pwm = dd->config->pwm;
+  const svc_diffdrive_wheelconfig_t* const cfg = &dd->config->wheels[wheel];
+  const pwmcnt_t width = (pwmcnt_t)(((uint64_t)((output >= 0) ? output : -output) * pwm->period) >> SVC_DIFFDRIVE_OUTPUT_FRACBITS);
+
+  pwmEnableChannelI(pwm, (output >= 0) ? cfg->backward : cfg->forward, 0);
+  pwmEnableChannelI(pwm, (output >= 0) ? cfg->forward : cfg->backward, width);
+
+  return;
+}
+
+/**
+ * @brief   Executes a single controller step for a wheel.
+ * @details The output is composed of the feed-forward terms (velocity and static friction) and a PID controller.
+ *          Windup is prevented by conditional integration: the integrator is frozen whenever it would push an already saturated output any further.
+ *
+ * @param[in] dd      The service object.
+ * @param[in] wheel   Controller state of the wheel.
+ *
+ * @return  The saturated output (@p SVC_DIFFDRIVE_OUTPUT_FRACBITS fractional bits).
+ */
+static int32_t _controlI(svc_diffdrive_t* dd, svc_diffdrive_wheel_t* wheel)
+{
+  const int32_t error = wheel->setpoint - wheel->velocity;
+  int64_t output;
+  int64_t integral;
+
+  // feed-forward
+  output = (int64_t)dd->gains.kff * wheel->setpoint;
+  if (wheel->setpoint > 0) {
+    output += (int64_t)dd->gains.kfs << SVC_DIFFDRIVE_GAIN_FRACBITS;
+  } else if (wheel->setpoint < 0) {
+    output -= (int64_t)dd->gains.kfs << SVC_DIFFDRIVE_GAIN_FRACBITS;
+  }
+
+  // proportional and derivative part
+  output += (int64_t)dd->gains.kp * error;
+  output += (int64_t)dd->gains.kd * (error - wheel->error);
+  wheel->error = error;
+
+  // integral part with anti-windup
+  integral = wheel->integral + (int64_t)dd->gains.ki * error;
+  if (!((output + integral > SVC_DIFFDRIVE_LIMIT && error > 0) ||
+        (output + integral < -SVC_DIFFDRIVE_LIMIT && error < 0))) {
+    wheel->integral = (integral > SVC_DIFFDRIVE_LIMIT) ? SVC_DIFFDRIVE_LIMIT : (integral < -SVC_DIFFDRIVE_LIMIT) ? -SVC_DIFFDRIVE_LIMIT : integral;
+  }
+  output += wheel->integral;
+
+  // saturation
+  if (output > SVC_DIFFDRIVE_LIMIT) {
+    output = SVC_DIFFDRIVE_LIMIT;
+    ++wheel->saturations;
+  } else if (output < -SVC_DIFFDRIVE_LIMIT) {
+    output = -SVC_DIFFDRIVE_LIMIT;
+    ++wheel->saturations;
+  }
+
+  return (int32_t)(output >> SVC_DIFFDRIVE_GAIN_FRACBITS);
+}
+
+/**
+ * @brief   Resets the controller states of both wheels.
+ *
+ * @param[in] dd  The service object.
+ */
+static void _resetControllerI(svc_diffdrive_t* dd)
+{
+  for (size_t w = 0; w < SVC_DIFFDRIVE_NUMWHEELS; ++w) {
+    dd->wheels[w].setpoint = 0;
+    dd->wheels[w].error = 0;
+    dd->wheels[w].integral = 0;
+    dd->wheels[w].output = 0;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Timer callback executing the control loop.
+ *
+ * @param[in] gptp  GPT driver.
+ */
+static void _gptCb(GPTDriver* gptp)
+{
+  svc_diffdrive_t* dd = _ddFromDriver(gptp);
+  const rtcnt_t now = chSysGetRealtimeCounterX();
+  const uint32_t hclk = aosClockGetHclkX();
+
+  chSysLockFromISR();
+
+  chTMStartMeasurementX(&dd->timing.execution);
+
+  // period jitter
+  if (dd->timing.cycles > 0) {
+    const uint32_t interval = RTC2US(hclk, now - dd->timing.last);
+    if (interval < dd->timing.intervalmin) {
+      dd->timing.intervalmin = interval;
+    }
+    if (interval > dd->timing.intervalmax) {
+      dd->timing.intervalmax = interval;
+    }
+    if (interval > dd->timing.period + (dd->timing.period / 2)) {
+      ++dd->timing.late;
+    }
+  }
+  dd->timing.last = now;
+  ++dd->timing.cycles;
+
+  // control
+  for (size_t w = 0; w < SVC_DIFFDRIVE_NUMWHEELS; ++w) {
+    dd->wheels[w].velocity = qeiGetVelocityI(dd->config->wheels[w].qei);
+    if (dd->enabled) {
+      dd->wheels[w].output = _controlI(dd, &dd->wheels[w]);
+      _setOutputI(dd, w, dd->wheels[w].output);
+    }
+  }
+
+  chTMStopMeasurementX(&dd->timing.execution);
+  if (RTC2US(hclk, dd->timing.execution.last) > dd->timing.period) {
+    ++dd->timing.overruns;
+  }
+
+  chSysUnlockFromISR();
+
+  return;
+}
+
+/**
+ * @brief   Initializes a differential drive service object.
+ *
+ * @param[in] dd      The service object to initialize.
+ * @param[in] config  Hardware configuration.
+ */
+void svcDiffDriveInit(svc_diffdrive_t* dd, const svc_diffdrive_config_t* config)
+{
+  aosDbgCheck(dd != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->gpt != NULL && config->pwm != NULL && config->motors != NULL);
+  aosDbgCheck(config->wheels[SVC_DIFFDRIVE_WHEEL_LEFT].qei != NULL && config->wheels[SVC_DIFFDRIVE_WHEEL_RIGHT].qei != NULL);
+  aosDbgCheck(config->rate > 0 && config->gptfrequency >= config->rate);
+  aosDbgCheck(config->increments > 0 && config->wheeldiameter > 0.0f && config->wheelbase > 0.0f);
+
+  memset(dd, 0, sizeof(svc_diffdrive_t));
+  dd->gptconfig.frequency = config->gptfrequency;
+  dd->gptconfig.callback = _gptCb;
+  dd->config = config;
+  dd->incperum = (uint32_t)((float)config->increments / (config->wheeldiameter * 1e6f * acosf(-1.0f)) * 4294967296.0f + 0.5f);
+  dd->halfbase = (uint32_t)(config->wheelbase * 1e6f / 2.0f + 0.5f);
+  svcDiffDriveSetGains(dd, &config->gains);
+  chTMObjectInit(&dd->timing.execution);
+  chMtxObjectInit(&dd->lock);
+  dd->timing.period = MICROSECONDS_PER_SECOND / config->rate;
+  dd->timing.intervalmin = ~(uint32_t)0;
+  dd->timing.intervalmax = 0;
+  dd->enabled = false;
+  dd->running = false;
+
+  return;
+}
+
+/**
+ * @brief   Sets new controller gains.
+ * @details May be called while the control loop is running.
+ *
+ * @param[in] dd     The service object.
+ * @param[in] gains  The new gains.
+ */
+void svcDiffDriveSetGains(svc_diffdrive_t* dd, const svc_diffdrive_gains_t* gains)
+{
+  aosDbgCheck(dd != NULL);
+  aosDbgCheck(gains != NULL);
+
+  // integral and derivative gains are scaled to the cycle time here, so the loop does not need to
+  const int32_t kp = _float2fixed(gains->kp, SVC_DIFFDRIVE_GAIN_FRACBITS);
+  const int32_t ki = _float2fixed(gains->ki / (float)dd->config->rate, SVC_DIFFDRIVE_GAIN_FRACBITS);
+  const int32_t kd = _float2fixed(gains->kd * (float)dd->config->rate, SVC_DIFFDRIVE_GAIN_FRACBITS);
+  const int32_t kff = _float2fixed(gains->kff, SVC_DIFFDRIVE_GAIN_FRACBITS);
+  const int32_t kfs = _float2fixed(gains->kfs, SVC_DIFFDRIVE_OUTPUT_FRACBITS);
+
+  chSysLock();
+  dd->gains.kp = kp;
+  dd->gains.ki = ki;
+  dd->gains.kd = kd;
+  dd->gains.kff = kff;
+  dd->gains.kfs = kfs;
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Starts the control loop.
+ * @details The motors are not driven until a velocity is commanded.
+ * @note    The PWM and QEI drivers must have been started and the encoders enabled before.
+ *
+ * @param[in] dd  The service object.
+ */
+void svcDiffDriveStart(svc_diffdrive_t* dd)
+{
+  aosDbgCheck(dd != NULL);
+  aosDbgAssert(!dd->running);
+
+  gptStart(dd->config->gpt, &dd->gptconfig);
+  chSysLock();
+  _resetControllerI(dd);
+  dd->enabled = false;
+  dd->running = true;
+  gptStartContinuousI(dd->config->gpt, dd->config->gptfrequency / dd->config->rate);
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Stops the control loop and releases the motors.
+ *
+ * @param[in] dd  The service object.
+ */
+void svcDiffDriveStop(svc_diffdrive_t* dd)
+{
+  aosDbgCheck(dd != NULL);
+
+  if (dd->running) {
+    svcDiffDriveDisable(dd);
+    chSysLock();
+    gptStopTimerI(dd->config->gpt);
+    dd->running = false;
+    chSysUnlock();
+    gptStop(dd->config->gpt);
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] dd  The service object.
+ */
+void svcDiffDriveTeardown(void* dd)
+{
+  svcDiffDriveStop((svc_diffdrive_t*)dd);
+
+  return;
+}
+
+/**
+ * @brief   Commands a new velocity.
+ * @details The motors are powered and driven by the controller from the next cycle on.
+ *          The fastest clock level is held until the controller is disabled.
+ *
+ * @param[in] dd       The service object.
+ * @param[in] linear   Linear velocity in micrometers per second.
+ * @param[in] angular  Angular velocity in microradians per second (counterclockwise).
+ */
+void svcDiffDriveSetVelocity(svc_diffdrive_t* dd, int32_t linear, int32_t angular)
+{
+  aosDbgCheck(dd != NULL);
+  aosDbgAssert(dd->running);
+
+  // wheel velocities in um/s (v -/+ w * b/2)
+  const int64_t rotation = ((int64_t)angular * dd->halfbase) / 1000000;
+  const qeivelocity_t left = _um2inc(dd, (int64_t)linear - rotation);
+  const qeivelocity_t right = _um2inc(dd, (int64_t)linear + rotation);
+
+  chMtxLock(&dd->lock);
+
+  // the flag is only modified by mutex owners, so it can be tested without the kernel lock
+  if (!dd->enabled) {
+    // the control loop must meet its period while the motors are driven
+    aosClockHold();
+    a3906_lld_set_power(dd->config->motors, A3906_LLD_POWER_ON);
+  }
+
+  chSysLock();
+  dd->command.linear = linear;
+  dd->command.angular = angular;
+  dd->wheels[SVC_DIFFDRIVE_WHEEL_LEFT].setpoint = left;
+  dd->wheels[SVC_DIFFDRIVE_WHEEL_RIGHT].setpoint = right;
+  dd->enabled = true;
+  chSysUnlock();
+
+  chMtxUnlock(&dd->lock);
+
+  return;
+}
+
+/**
+ * @brief   Disables the controller and releases the motors.
+ * @details The control loop keeps running to measure the wheel velocities.
+ *
+ * @param[in] dd  The service object.
+ */
+void svcDiffDriveDisable(svc_diffdrive_t* dd)
+{
+  aosDbgCheck(dd != NULL);
+
+  chMtxLock(&dd->lock);
+
+  chSysLock();
+  const bool enabled = dd->enabled;
+  dd->enabled = false;
+  dd->command.linear = 0;
+  dd->command.angular = 0;
+  _resetControllerI(dd);
+  if (enabled) {
+    for (size_t w = 0; w < SVC_DIFFDRIVE_NUMWHEELS; ++w) {
+      _setOutputI(dd, w, 0);
+    }
+  }
+  chSysUnlock();
+
+  if (enabled) {
+    a3906_lld_set_power(dd->config->motors, A3906_LLD_POWER_OFF);
+    aosClockRelease();
+  }
+
+  chMtxUnlock(&dd->lock);
+
+  return;
+}
+
+/**
+ * @brief   Resets the loop timing statistics.
+ *
+ * @param[in] dd  The service object.
+ */
+void svcDiffDriveResetTiming(svc_diffdrive_t* dd)
+{
+  aosDbgCheck(dd != NULL);
+
+  chSysLock();
+  chTMObjectInit(&dd->timing.execution);
+  dd->timing.intervalmin = ~(uint32_t)0;
+  dd->timing.intervalmax = 0;
+  dd->timing.cycles = 0;
+  dd->timing.overruns = 0;
+  dd->timing.late = 0;
+  for (size_t w = 0; w < SVC_DIFFDRIVE_NUMWHEELS; ++w) {
+    dd->wheels[w].saturations = 0;
+  }
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Shell command to control the differential drive and print its state.
+ *
+ * @param[in] dd      The service object.
+ * @param[in] stream  Stream for input/output.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return  An exit status.
+ */
+int svcDiffDriveShellCmd(svc_diffdrive_t* dd, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(dd != NULL);
+  aosDbgCheck(stream != NULL);
+
+  // copy of the printed state, which is small enough to be taken within the kernel lock
+  struct {
+    bool running;
+    bool enabled;
+    int32_t linear;
+    int32_t angular;
+    struct {
+      qeivelocity_t setpoint;
+      qeivelocity_t velocity;
+      int32_t output;
+      uint32_t saturations;
+    } wheels[SVC_DIFFDRIVE_NUMWHEELS];
+    time_measurement_t execution;
+    uint32_t intervalmin;
+    uint32_t intervalmax;
+    uint32_t cycles;
+    uint32_t overruns;
+    uint32_t late;
+  } state;
+  static const char* const names[SVC_DIFFDRIVE_NUMWHEELS] = {"left", "right"};
+
+  if (argc == 4 && (strcmp(argv[1], "--set") == 0 || strcmp(argv[1], "-s") == 0)) {
+    svcDiffDriveSetVelocity(dd, atoi(argv[2]) * 1000, atoi(argv[3]) * 1000);
+    return AOS_OK;
+  } else if (argc == 2 && strcmp(argv[1], "--stop") == 0) {
+    svcDiffDriveDisable(dd);
+    return AOS_OK;
+  } else if (argc == 7 && (strcmp(argv[1], "--gains") == 0 || strcmp(argv[1], "-g") == 0)) {
+    const svc_diffdrive_gains_t gains = {
+      /* kp   */ strtof(argv[2], NULL),
+      /* ki   */ strtof(argv[3], NULL),
+      /* kd   */ strtof(argv[4], NULL),
+      /* kff  */ strtof(argv[5], NULL),
+      /* kfs  */ strtof(argv[6], NULL),
+    };
+    svcDiffDriveSetGains(dd, &gains);
+    return AOS_OK;
+  } else if (argc == 2 && (strcmp(argv[1], "--reset") == 0 || strcmp(argv[1], "-r") == 0)) {
+    svcDiffDriveResetTiming(dd);
+    return AOS_OK;
+  } else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the state of the differential drive controller and its loop timing statistics.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --set, -s <LINEAR> <ANGULAR>\n");
+    chprintf(stream, "    Command a linear (mm/s) and angular (mrad/s) velocity.\n");
+    chprintf(stream, "  --stop\n");
+    chprintf(stream, "    Disable the controller and release the motors.\n");
+    chprintf(stream, "  --gains, -g <KP> <KI> <KD> <KFF> <KFS>\n");
+    chprintf(stream, "    Set the controller gains.\n");
+    chprintf(stream, "  --reset, -r\n");
+    chprintf(stream, "    Reset the timing statistics.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  // take a consistent copy of the state
+  chSysLock();
+  state.running = dd->running;
+  state.enabled = dd->enabled;
+  state.linear = dd->command.linear;
+  state.angular = dd->command.angular;
+  for (size_t w = 0; w < SVC_DIFFDRIVE_NUMWHEELS; ++w) {
+    state.wheels[w].setpoint = dd->wheels[w].setpoint;
+    state.wheels[w].velocity = dd->wheels[w].velocity;
+    state.wheels[w].output = dd->wheels[w].output;
+    state.wheels[w].saturations = dd->wheels[w].saturations;
+  }
+  state.execution = dd->timing.execution;
+  state.intervalmin = dd->timing.intervalmin;
+  state.intervalmax = dd->timing.intervalmax;
+  state.cycles = dd->timing.cycles;
+  state.overruns = dd->timing.overruns;
+  state.late = dd->timing.late;
+  chSysUnlock();
+
+  chprintf(stream, "state:     %s\n", !state.running ? "stopped" : state.enabled ? "enabled" : "idle");
+  chprintf(stream, "command:   %d mm/s, %d mrad/s\n", state.linear / 1000, state.angular / 1000);
+  for (size_t w = 0; w < SVC_DIFFDRIVE_NUMWHEELS; ++w) {
+    chprintf(stream, "%-5s      %d / %d mm/s (setpoint / measured), output %d%%, %u saturations\n",
+             names[w],
+             _inc2um(dd, state.wheels[w].setpoint) / 1000,
+             _inc2um(dd, state.wheels[w].velocity) / 1000,
+             (state.wheels[w].output * 100) >> SVC_DIFFDRIVE_OUTPUT_FRACBITS,
+             state.wheels[w].saturations);
+  }
+  chprintf(stream, "rate:      %uHz\n", dd->config->rate);
+  chprintf(stream, "cycles:    %u\n", state.cycles);
+  chprintf(stream, "interval:  %uus - %uus\n",
+           (state.cycles > 1) ? state.intervalmin : 0,
+           state.intervalmax);
+  chprintf(stream, "execution: %u / %u / %u cycles (best / avg / worst)\n",
+           (state.execution.n > 0) ? state.execution.best : 0,
+           (state.execution.n > 0) ? (uint32_t)(state.execution.cumulative / state.execution.n) : 0,
+           state.execution.worst);
+  chprintf(stream, "overruns:  %u\n", state.overruns);
+  chprintf(stream, "late:      %u\n", state.late);
+
+  return AOS_OK;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_A3906) && (HAL_USE_GPT == TRUE) && (HAL_USE_PWM == TRUE) && (HAL_USE_QEI == TRUE) && (QEI_USE_VELOCITY == TRUE) */
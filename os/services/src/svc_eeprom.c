@@ -0,0 +1,401 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_eeprom.h>
+
+#if defined(AMIROLLD_CFG_USE_AT24C01BN) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_thread.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Event ID to wake the flush thread.
+ */
+#define FLUSH_EVENTID                 0
+
+/**
+ * @brief   Maximum number of acknowledge polls (one per millisecond) to wait for a write cycle.
+ * @details The write cycle of the AT24C01BN takes at most 5ms.
+ */
+#define WRITECYCLE_POLLS              10
+
+/**
+ * @brief   Writes the dirty bytes of a page back to the device.
+ * @details The span from the first to the last dirty byte is written with a single page write.
+ *          On failure the bytes are marked dirty again, so they are retried with the next flush.
+ *
+ * @param[in] eeprom  The EEPROM cache.
+ * @param[in] page    Index of the page.
+ *
+ * @return  The status of the I2C transactions.
+ */
+static apalExitStatus_t _flushPage(svc_eeprom_t* eeprom, uint8_t page)
+{
+  uint8_t buffer[SVC_EEPROM_PAGESIZE];
+  uint8_t mask;
+  uint8_t first = 0;
+  uint8_t last = SVC_EEPROM_PAGESIZE - 1;
+  apalExitStatus_t status;
+
+  // take a snapshot, so writes may continue during the transaction
+  chMtxLock(&eeprom->lock);
+  mask = eeprom->dirty[page];
+  eeprom->dirty[page] = 0;
+  memcpy(buffer, &eeprom->cache[page * SVC_EEPROM_PAGESIZE], SVC_EEPROM_PAGESIZE);
+  chMtxUnlock(&eeprom->lock);
+
+  if (mask == 0) {
+    return APAL_STATUS_SUCCESS;
+  }
+  while (!(mask & (1 << first))) {
+    ++first;
+  }
+  while (!(mask & (1 << last))) {
+    --last;
+  }
+
+  status = at24c01bn_lld_write_page(eeprom->config->driver, (uint8_t)(page * SVC_EEPROM_PAGESIZE + first), &buffer[first], (uint8_t)(last - first + 1), eeprom->config->timeout);
+  if (status == APAL_STATUS_SUCCESS) {
+    // the device does not acknowledge until the write cycle completed
+    status = APAL_STATUS_FAILURE;
+    for (uint8_t poll = 0; poll < WRITECYCLE_POLLS && status == APAL_STATUS_FAILURE; ++poll) {
+      aosThdMSleep(1);
+      status = at24c01bn_lld_poll_ack(eeprom->config->driver, eeprom->config->timeout);
+    }
+  }
+
+  if (status == APAL_STATUS_SUCCESS) {
+    ++eeprom->stats.pagewrites;
+    eeprom->stats.bytes += (uint32_t)(last - first + 1);
+  } else {
+    chMtxLock(&eeprom->lock);
+    eeprom->dirty[page] |= mask;
+    chMtxUnlock(&eeprom->lock);
+    ++eeprom->stats.errors;
+  }
+
+  return status;
+}
+
+/**
+ * @brief   EEPROM flush thread.
+ * @details Waits for writes and flushes all dirty pages after the configured delay.
+ *
+ * @param[in] eeprom  The EEPROM cache.
+ */
+static THD_FUNCTION(_svcEepromThread, eeprom)
+{
+  svc_eeprom_t* const e = (svc_eeprom_t*)eeprom;
+
+  chRegSetThreadName("eeprom");
+
+  while (!chThdShouldTerminateX()) {
+    chEvtWaitAny(EVENT_MASK(FLUSH_EVENTID));
+    if (chThdShouldTerminateX()) {
+      break;
+    }
+    // give subsequent writes the chance to be merged
+    if (e->config->delay > 0) {
+      aosThdUSleep(e->config->delay);
+    }
+    svcEepromFlush(e);
+  }
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes an EEPROM cache object.
+ * @details The cache is invalid until it was loaded.
+ *
+ * @param[in] eeprom  The EEPROM cache to initialize.
+ * @param[in] config  The configuration to use.
+ */
+void svcEepromInit(svc_eeprom_t* eeprom, const svc_eeprom_config_t* config)
+{
+  aosDbgCheck(eeprom != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->driver != NULL);
+
+  eeprom->config = config;
+  memset(eeprom->cache, 0, sizeof(eeprom->cache));
+  memset(eeprom->dirty, 0, sizeof(eeprom->dirty));
+  eeprom->valid = false;
+  chMtxObjectInit(&eeprom->lock);
+  chMtxObjectInit(&eeprom->flushlock);
+  memset(&eeprom->stats, 0, sizeof(eeprom->stats));
+  eeprom->thread = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Loads the cache and starts the flush thread.
+ * @details The cache is loaded synchronously, so it can be read right after this function returns.
+ *
+ * @param[in] eeprom  The EEPROM cache.
+ * @param[in] wa      Working area for the thread.
+ * @param[in] wasize  Size of the working area.
+ * @param[in] prio    Priority of the thread.
+ */
+void svcEepromStart(svc_eeprom_t* eeprom, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(eeprom != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(eeprom->thread == NULL);
+
+  svcEepromLoad(eeprom);
+  eeprom->thread = chThdCreateStatic(wa, wasize, prio, _svcEepromThread, eeprom);
+
+  return;
+}
+
+/**
+ * @brief   Stops the flush thread and writes all pending data back.
+ *
+ * @param[in] eeprom  The EEPROM cache.
+ */
+void svcEepromStop(svc_eeprom_t* eeprom)
+{
+  aosDbgCheck(eeprom != NULL);
+
+  if (eeprom->thread != NULL) {
+    chThdTerminate(eeprom->thread);
+    chEvtSignal(eeprom->thread, EVENT_MASK(FLUSH_EVENTID));
+    chThdWait(eeprom->thread);
+    eeprom->thread = NULL;
+  }
+  svcEepromFlush(eeprom);
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] eeprom  The EEPROM cache.
+ */
+void svcEepromTeardown(void* eeprom)
+{
+  svcEepromStop((svc_eeprom_t*)eeprom);
+
+  return;
+}
+
+/**
+ * @brief   Reads the whole device into the cache with a single sequential read.
+ * @details Pending writes are discarded.
+ *
+ * @param[in] eeprom  The EEPROM cache.
+ *
+ * @return  The status of the I2C transaction.
+ */
+apalExitStatus_t svcEepromLoad(svc_eeprom_t* eeprom)
+{
+  aosDbgCheck(eeprom != NULL);
+
+  apalExitStatus_t status;
+
+  chMtxLock(&eeprom->flushlock);
+  chMtxLock(&eeprom->lock);
+  status = at24c01bn_lld_read(eeprom->config->driver, 0, eeprom->cache, SVC_EEPROM_SIZE, eeprom->config->timeout);
+  // a warning only indicates that the address counter of the device was not updated as expected
+  eeprom->valid = (status == APAL_STATUS_SUCCESS || status == APAL_STATUS_WARNING);
+  memset(eeprom->dirty, 0, sizeof(eeprom->dirty));
+  chMtxUnlock(&eeprom->lock);
+  chMtxUnlock(&eeprom->flushlock);
+
+  if (!eeprom->valid) {
+    ++eeprom->stats.errors;
+  }
+
+  return eeprom->valid ? APAL_STATUS_SUCCESS : status;
+}
+
+/**
+ * @brief   Reads data from the cache.
+ *
+ * @param[in]  eeprom   The EEPROM cache.
+ * @param[in]  address  Address to read from.
+ * @param[out] buffer   Buffer to read to.
+ * @param[in]  length   Number of bytes to read.
+ *
+ * @return  An exit status.
+ * @retval  APAL_STATUS_SUCCESS           The data was read.
+ * @retval  APAL_STATUS_INVALIDARGUMENTS  The range exceeds the device.
+ * @retval  APAL_STATUS_FAILURE           The cache could not be loaded.
+ */
+apalExitStatus_t svcEepromRead(svc_eeprom_t* eeprom, size_t address, uint8_t* buffer, size_t length)
+{
+  aosDbgCheck(eeprom != NULL);
+  aosDbgCheck(buffer != NULL || length == 0);
+
+  if (address + length > SVC_EEPROM_SIZE) {
+    return APAL_STATUS_INVALIDARGUMENTS;
+  }
+  if (!eeprom->valid) {
+    return APAL_STATUS_FAILURE;
+  }
+
+  chMtxLock(&eeprom->lock);
+  memcpy(buffer, &eeprom->cache[address], length);
+  chMtxUnlock(&eeprom->lock);
+
+  return APAL_STATUS_SUCCESS;
+}
+
+/**
+ * @brief   Writes data to the cache and schedules an asynchronous flush.
+ * @details Never blocks on the bus.
+ *          Only bytes which differ from the cached content are written back.
+ *
+ * @param[in] eeprom  The EEPROM cache.
+ * @param[in] address Address to write to.
+ * @param[in] data    Data to write.
+ * @param[in] length  Number of bytes to write.
+ *
+ * @return  An exit status.
+ * @retval  APAL_STATUS_SUCCESS           The data was written to the cache.
+ * @retval  APAL_STATUS_INVALIDARGUMENTS  The range exceeds the device.
+ */
+apalExitStatus_t svcEepromWrite(svc_eeprom_t* eeprom, size_t address, const uint8_t* data, size_t length)
+{
+  aosDbgCheck(eeprom != NULL);
+  aosDbgCheck(data != NULL || length == 0);
+
+  bool modified = false;
+
+  if (address + length > SVC_EEPROM_SIZE) {
+    return APAL_STATUS_INVALIDARGUMENTS;
+  }
+
+  chMtxLock(&eeprom->lock);
+  for (size_t i = 0; i < length; ++i) {
+    const size_t a = address + i;
+    if (eeprom->cache[a] != data[i]) {
+      const uint8_t page = (uint8_t)(a / SVC_EEPROM_PAGESIZE);
+      if (!modified && eeprom->dirty[page] != 0) {
+        ++eeprom->stats.merged;
+      }
+      eeprom->cache[a] = data[i];
+      eeprom->dirty[page] |= (uint8_t)(1 << (a % SVC_EEPROM_PAGESIZE));
+      modified = true;
+    }
+  }
+  if (modified) {
+    ++eeprom->stats.writes;
+  }
+  chMtxUnlock(&eeprom->lock);
+
+  if (modified && eeprom->thread != NULL) {
+    chEvtSignal(eeprom->thread, EVENT_MASK(FLUSH_EVENTID));
+  }
+
+  return APAL_STATUS_SUCCESS;
+}
+
+/**
+ * @brief   Writes all dirty pages back to the device and waits for completion.
+ *
+ * @param[in] eeprom  The EEPROM cache.
+ *
+ * @return  The accumulated status of all I2C transactions.
+ */
+apalExitStatus_t svcEepromFlush(svc_eeprom_t* eeprom)
+{
+  aosDbgCheck(eeprom != NULL);
+
+  apalExitStatus_t status = APAL_STATUS_SUCCESS;
+
+  chMtxLock(&eeprom->flushlock);
+  for (uint8_t page = 0; page < SVC_EEPROM_NUMPAGES; ++page) {
+    status |= _flushPage(eeprom, page);
+  }
+  chMtxUnlock(&eeprom->flushlock);
+
+  return status;
+}
+
+/**
+ * @brief   Shell command implementation to print the cache statistics and content.
+ *
+ * @param[in] eeprom  The EEPROM cache.
+ * @param[in] stream  The I/O stream to use.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ * @retval  AOS_ERROR               The device could not be accessed.
+ */
+int svcEepromShellCmd(svc_eeprom_t* eeprom, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(eeprom != NULL);
+  aosDbgCheck(stream != NULL);
+
+  uint8_t dirty = 0;
+
+  if (argc == 2 && (strcmp(argv[1], "--dump") == 0 || strcmp(argv[1], "-d") == 0)) {
+    chMtxLock(&eeprom->lock);
+    for (size_t address = 0; address < SVC_EEPROM_SIZE; address += SVC_EEPROM_PAGESIZE) {
+      chprintf(stream, "0x%02X:", address);
+      for (size_t i = 0; i < SVC_EEPROM_PAGESIZE; ++i) {
+        chprintf(stream, " %02X", eeprom->cache[address + i]);
+      }
+      chprintf(stream, "%s\n", (eeprom->dirty[address / SVC_EEPROM_PAGESIZE] != 0) ? " *" : "");
+    }
+    chMtxUnlock(&eeprom->lock);
+    return AOS_OK;
+  } else if (argc == 2 && (strcmp(argv[1], "--flush") == 0 || strcmp(argv[1], "-f") == 0)) {
+    return (svcEepromFlush(eeprom) == APAL_STATUS_SUCCESS) ? AOS_OK : AOS_ERROR;
+  } else if (argc == 2 && strcmp(argv[1], "--reload") == 0) {
+    svcEepromFlush(eeprom);
+    return (svcEepromLoad(eeprom) == APAL_STATUS_SUCCESS) ? AOS_OK : AOS_ERROR;
+  } else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the EEPROM cache statistics.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --dump, -d\n");
+    chprintf(stream, "    Print the cached content (dirty pages are marked).\n");
+    chprintf(stream, "  --flush, -f\n");
+    chprintf(stream, "    Write all dirty pages back now.\n");
+    chprintf(stream, "  --reload\n");
+    chprintf(stream, "    Flush and read the whole device again.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  chMtxLock(&eeprom->lock);
+  for (uint8_t page = 0; page < SVC_EEPROM_NUMPAGES; ++page) {
+    dirty += (eeprom->dirty[page] != 0) ? 1 : 0;
+  }
+  chMtxUnlock(&eeprom->lock);
+
+  chprintf(stream, "cache:  %u bytes %s, %u dirty pages\n", SVC_EEPROM_SIZE, eeprom->valid ? "valid" : "invalid", dirty);
+  chprintf(stream, "writes: %u (%u merged)\n", eeprom->stats.writes, eeprom->stats.merged);
+  chprintf(stream, "device: %u page writes, %u bytes, %u errors\n", eeprom->stats.pagewrites, eeprom->stats.bytes, eeprom->stats.errors);
+
+  return AOS_OK;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_AT24C01BN) */
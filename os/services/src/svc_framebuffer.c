@@ -0,0 +1,323 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_framebuffer.h>
+
+#if (defined(AMIROLLD_CFG_USE_TLC5947) && (HAL_USE_SPI == TRUE)) || defined(__DOXYGEN__)
+
+#include <aos_clock.h>
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <aos_thread.h>
+#include <chprintf.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief   Transmits the front buffer and latches it synchronously to the PWM cycle.
+ * @details The SPI transfer is executed via DMA while the thread sleeps.
+ *          XLAT is the chip select line of the SPI driver, so the data is latched by its rising edge on deselection.
+ *          BLANK is held active meanwhile, which restarts the PWM cycle of all channels with the new data.
+ *
+ * @param[in] fb  The frame buffer.
+ */
+static void _latch(svc_framebuffer_t* fb)
+{
+  const svc_framebuffer_config_t* const cfg = fb->config;
+
+  spiAcquireBus(cfg->spid);
+  spiSelect(cfg->spid);
+  chTMStartMeasurementX(&fb->transfertime);
+  spiSend(cfg->spid, TLC5947_LLD_BUFFER_SIZE, fb->front->data);
+  chTMStopMeasurementX(&fb->transfertime);
+  tlc5947_lld_setBlank(cfg->driver, TLC5947_LLD_BLANK_ENABLE);
+  spiUnselect(cfg->spid);
+  if (fb->enabled) {
+    tlc5947_lld_setBlank(cfg->driver, TLC5947_LLD_BLANK_DISABLE);
+  }
+  spiReleaseBus(cfg->spid);
+
+  return;
+}
+
+/**
+ * @brief   Frame buffer refresh thread.
+ * @details Latches the most recently published frame once per refresh period.
+ *          Unchanged frames are not transmitted again, since the LED driver keeps the latched data.
+ *
+ * @param[in] fb  The frame buffer.
+ */
+static THD_FUNCTION(_svcFrameBufferThread, fb)
+{
+  svc_framebuffer_t* const f = (svc_framebuffer_t*)fb;
+  tlc5947_lld_buffer_t* buffer;
+  bool fresh;
+  // the state of the LED driver is unknown at startup
+  bool resend = true;
+  aos_timestamp_t next;
+  aos_timestamp_t uptime;
+
+  chRegSetThreadName("framebuffer");
+
+  aosSysGetUptime(&next);
+
+  while (!chThdShouldTerminateX()) {
+    // take the pending frame (if any)
+    chSysLock();
+    fresh = f->ready;
+    if (fresh) {
+      buffer = f->front;
+      f->front = f->pending;
+      f->pending = buffer;
+      f->ready = false;
+    }
+    chSysUnlock();
+
+    if (fresh || resend) {
+      _latch(f);
+      ++f->stats.latched;
+      resend = false;
+    }
+    chEvtBroadcastFlags(&f->source, SVC_FRAMEBUFFER_EVENTFLAG_VSYNC);
+
+    // resynchronize if the refresh fell behind for more than one period
+    aosSysGetUptime(&uptime);
+    next += f->config->period;
+    if (uptime > next + f->config->period) {
+      ++f->stats.overruns;
+      next = uptime;
+    }
+    chSysLock();
+    aosThdSleepUntilS(&next);
+    chSysUnlock();
+  }
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes a frame buffer object.
+ * @details All buffers are cleared.
+ *
+ * @param[in] fb      The frame buffer to initialize.
+ * @param[in] config  The configuration to use.
+ */
+void svcFrameBufferInit(svc_framebuffer_t* fb, const svc_framebuffer_config_t* config)
+{
+  aosDbgCheck(fb != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->driver != NULL && config->spid != NULL);
+  aosDbgCheck(config->period > 0);
+
+  fb->config = config;
+  memset(fb->buffers, 0, sizeof(fb->buffers));
+  fb->front = &fb->buffers[0];
+  fb->pending = &fb->buffers[1];
+  fb->back = &fb->buffers[2];
+  fb->ready = false;
+  fb->enabled = false;
+  chEvtObjectInit(&fb->source);
+  chTMObjectInit(&fb->transfertime);
+  memset(&fb->stats, 0, sizeof(fb->stats));
+  fb->thread = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Starts the refresh thread and enables the LEDs.
+ * @details The most recent frame is latched immediately.
+ *
+ * @param[in] fb      The frame buffer.
+ * @param[in] wa      Working area for the thread.
+ * @param[in] wasize  Size of the working area.
+ * @param[in] prio    Priority of the thread.
+ */
+void svcFrameBufferStart(svc_framebuffer_t* fb, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(fb != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(fb->thread == NULL);
+
+  fb->enabled = true;
+  fb->thread = chThdCreateStatic(wa, wasize, prio, _svcFrameBufferThread, fb);
+
+  return;
+}
+
+/**
+ * @brief   Stops the refresh thread and blanks the LEDs.
+ *
+ * @param[in] fb  The frame buffer.
+ */
+void svcFrameBufferStop(svc_framebuffer_t* fb)
+{
+  aosDbgCheck(fb != NULL);
+
+  if (fb->thread != NULL) {
+    chThdTerminate(fb->thread);
+    chThdWait(fb->thread);
+    fb->thread = NULL;
+  }
+  svcFrameBufferSetEnabled(fb, false);
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] fb  The frame buffer.
+ */
+void svcFrameBufferTeardown(void* fb)
+{
+  svcFrameBufferStop((svc_framebuffer_t*)fb);
+
+  return;
+}
+
+/**
+ * @brief   Retrieves the buffer to draw to.
+ * @details Only a single thread must draw to the frame buffer.
+ *
+ * @param[in] fb  The frame buffer.
+ *
+ * @return  The back buffer, which is valid until the next call of svcFrameBufferSwap().
+ */
+tlc5947_lld_buffer_t* svcFrameBufferGetBack(svc_framebuffer_t* fb)
+{
+  aosDbgCheck(fb != NULL);
+
+  return fb->back;
+}
+
+/**
+ * @brief   Publishes the back buffer to be latched at the next refresh period.
+ * @details Never blocks.
+ *          If the previously published frame was not latched yet, it is replaced.
+ *          The new back buffer is initialized with the published frame, so drawing can continue incrementally.
+ *
+ * @param[in] fb  The frame buffer.
+ */
+void svcFrameBufferSwap(svc_framebuffer_t* fb)
+{
+  aosDbgCheck(fb != NULL);
+
+  tlc5947_lld_buffer_t* const published = fb->back;
+
+  chSysLock();
+  if (fb->ready) {
+    ++fb->stats.dropped;
+  }
+  fb->back = fb->pending;
+  fb->pending = published;
+  fb->ready = true;
+  chSysUnlock();
+
+  // the published buffer is only read from now on, even if the refresh thread moves it to the front
+  memcpy(fb->back->data, published->data, TLC5947_LLD_BUFFER_SIZE);
+
+  return;
+}
+
+/**
+ * @brief   Enables or blanks the LEDs without modifying the frame buffer.
+ *
+ * @param[in] fb      The frame buffer.
+ * @param[in] enable  Flag whether to enable the LEDs.
+ */
+void svcFrameBufferSetEnabled(svc_framebuffer_t* fb, bool enable)
+{
+  aosDbgCheck(fb != NULL);
+
+  // serialize with the latch sequence
+  spiAcquireBus(fb->config->spid);
+  fb->enabled = enable;
+  tlc5947_lld_setBlank(fb->config->driver, enable ? TLC5947_LLD_BLANK_DISABLE : TLC5947_LLD_BLANK_ENABLE);
+  spiReleaseBus(fb->config->spid);
+
+  return;
+}
+
+/**
+ * @brief   Shell command implementation to print frame buffer statistics and set all LEDs.
+ *
+ * @param[in] fb      The frame buffer.
+ * @param[in] stream  The I/O stream to use.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+int svcFrameBufferShellCmd(svc_framebuffer_t* fb, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(fb != NULL);
+  aosDbgCheck(stream != NULL);
+
+  time_measurement_t tm;
+
+  if (argc == 3 && (strcmp(argv[1], "--fill") == 0 || strcmp(argv[1], "-f") == 0)) {
+    const int value = atoi(argv[2]);
+    if (value < 0 || value >= (1 << TLC5947_LLD_PWM_RESOLUTION_BITS)) {
+      chprintf(stream, "value must be in [0, %u]\n", (1 << TLC5947_LLD_PWM_RESOLUTION_BITS) - 1);
+      return AOS_INVALID_ARGUMENTS;
+    }
+    tlc5947_lld_buffer_t* const buffer = svcFrameBufferGetBack(fb);
+    for (uint8_t channel = 0; channel < TLC5947_LLD_NUM_CHANNELS; ++channel) {
+      tlc5947_lld_setBuffer(buffer, channel, (uint16_t)value);
+    }
+    svcFrameBufferSwap(fb);
+    return AOS_OK;
+  } else if (argc == 2 && strcmp(argv[1], "--on") == 0) {
+    svcFrameBufferSetEnabled(fb, true);
+    return AOS_OK;
+  } else if (argc == 2 && strcmp(argv[1], "--off") == 0) {
+    svcFrameBufferSetEnabled(fb, false);
+    return AOS_OK;
+  } else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the frame buffer statistics.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --fill, -f <VALUE>\n");
+    chprintf(stream, "    Set all channels to the given value (0 to %u).\n", (1 << TLC5947_LLD_PWM_RESOLUTION_BITS) - 1);
+    chprintf(stream, "  --on\n");
+    chprintf(stream, "    Enable the LEDs.\n");
+    chprintf(stream, "  --off\n");
+    chprintf(stream, "    Blank the LEDs.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  chSysLock();
+  memcpy(&tm, &fb->transfertime, sizeof(time_measurement_t));
+  chSysUnlock();
+
+  chprintf(stream, "refresh:  %uHz, LEDs %s\n", MICROSECONDS_PER_SECOND / fb->config->period, fb->enabled ? "enabled" : "blanked");
+  chprintf(stream, "frames:   %u latched, %u dropped, %u overruns\n", fb->stats.latched, fb->stats.dropped, fb->stats.overruns);
+  chprintf(stream, "transfer: %uus / %uus (avg / worst)\n",
+           (tm.n > 0) ? (uint32_t)RTC2US(aosClockGetHclkX(), tm.cumulative / tm.n) : 0,
+           (uint32_t)RTC2US(aosClockGetHclkX(), tm.worst));
+
+  return AOS_OK;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_TLC5947) && (HAL_USE_SPI == TRUE) */
@@ -0,0 +1,647 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_imu.h>
+
+#if (defined(AMIROLLD_CFG_USE_L3G4200D) && defined(AMIROLLD_CFG_USE_LIS331DLH) && defined(AMIROLLD_CFG_USE_HMC5883L) && defined(AMIROLLD_CFG_USE_AT24C01BN) && (HAL_USE_SPI == TRUE)) || defined(__DOXYGEN__)
+
+#include <aos_clock.h>
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <aos_thread.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Conversion factor from radians to degrees.
+ */
+#define RAD2DEG                       57.2957795f
+
+/**
+ * @brief   Reads all axes of the gyroscope.
+ *
+ * @param[in] imu   The IMU service.
+ *
+ * @return  The status of the SPI transaction.
+ */
+static apalExitStatus_t _readGyro(svc_imu_t* imu)
+{
+  const svc_imu_config_t* const cfg = imu->config;
+  apalExitStatus_t status;
+
+  // the bus is shared with the accelerometer, which uses a different SPI configuration
+  spiAcquireBus(cfg->gyro->spid);
+  spiStart(cfg->gyro->spid, cfg->gyrospi);
+  status = l3g4200d_lld_read_all_data(cfg->gyro, imu->raw.gyro, &imu->sensorcfg.gyro);
+  spiReleaseBus(cfg->gyro->spid);
+  aosSysGetUptime(&imu->raw.gyrotime);
+
+  return status;
+}
+
+/**
+ * @brief   Reads all axes of the accelerometer.
+ *
+ * @param[in] imu   The IMU service.
+ *
+ * @return  The status of the SPI transaction.
+ */
+static apalExitStatus_t _readAccel(svc_imu_t* imu)
+{
+  const svc_imu_config_t* const cfg = imu->config;
+  apalExitStatus_t status;
+
+  spiAcquireBus(cfg->accel->spid);
+  spiStart(cfg->accel->spid, cfg->accelspi);
+  status = lis331dlh_lld_read_all_data(cfg->accel, imu->raw.accel, &imu->sensorcfg.accel);
+  spiReleaseBus(cfg->accel->spid);
+  aosSysGetUptime(&imu->raw.acceltime);
+
+  return status;
+}
+
+/**
+ * @brief   Reads all axes of the compass.
+ *
+ * @param[in] imu   The IMU service.
+ *
+ * @return  The status of the I2C transaction.
+ */
+static apalExitStatus_t _readCompass(svc_imu_t* imu)
+{
+  const svc_imu_config_t* const cfg = imu->config;
+  apalExitStatus_t status;
+
+  status = hmc5883l_lld_read_data(cfg->compass, (uint16_t*)imu->raw.compass, cfg->compasstimeout);
+  aosSysGetUptime(&imu->raw.compasstime);
+
+  // warnings are not treated as failures
+  return (status == APAL_STATUS_WARNING) ? APAL_STATUS_SUCCESS : status;
+}
+
+/**
+ * @brief   Configures all sensors for continuous measurement.
+ *
+ * @param[in] imu   The IMU service.
+ *
+ * @return  The accumulated status of all transactions.
+ */
+static apalExitStatus_t _configure(svc_imu_t* imu)
+{
+  const svc_imu_config_t* const cfg = imu->config;
+  apalExitStatus_t status;
+
+  // gyroscope: 100 Hz, 250 dps full scale
+  spiAcquireBus(cfg->gyro->spid);
+  spiStart(cfg->gyro->spid, cfg->gyrospi);
+  status = l3g4200d_lld_read_config(cfg->gyro, &imu->sensorcfg.gyro);
+  imu->sensorcfg.gyro.registers.ctrl_reg1 = L3G4200D_LLD_PD | L3G4200D_LLD_DR_100_HZ | L3G4200D_LLD_BW_12_5 | L3G4200D_LLD_ZEN | L3G4200D_LLD_YEN | L3G4200D_LLD_XEN;
+  status |= l3g4200d_lld_write_config(cfg->gyro, imu->sensorcfg.gyro);
+  spiReleaseBus(cfg->gyro->spid);
+
+  // accelerometer: 1 kHz (the most recent sample is taken)
+  spiAcquireBus(cfg->accel->spid);
+  spiStart(cfg->accel->spid, cfg->accelspi);
+  status |= lis331dlh_lld_read_config(cfg->accel, &imu->sensorcfg.accel);
+  imu->sensorcfg.accel.registers.ctrl_reg1 = LIS331DLH_LLD_PM_ODR | LIS331DLH_LLD_DR_1000HZ_780LP | LIS331DLH_LLD_X_AXIS_ENABLE | LIS331DLH_LLD_Y_AXIS_ENABLE | LIS331DLH_LLD_Z_AXIS_ENABLE;
+  status |= lis331dlh_lld_write_config(cfg->accel, &imu->sensorcfg.accel);
+  spiReleaseBus(cfg->accel->spid);
+
+  // compass: 75 Hz continuous
+  if (cfg->compass != NULL) {
+    hmc5883l_lld_config_t compasscfg;
+    compasscfg.avg = HMC5883L_LLD_AVG1;
+    compasscfg.outrate = HMC5883L_LLD_75_HZ;
+    compasscfg.mbias = HMC5883L_LLD_MB_NORMAL;
+    compasscfg.gain = HMC5883L_LLD_GN_0_GA;
+    compasscfg.highspeed = HMC5883L_LLD_HS_DISABLE;
+    compasscfg.mode = HMC5883L_LLD_MM_CONTINUOUS;
+    status |= hmc5883l_lld_write_config(cfg->compass, compasscfg, cfg->compasstimeout);
+  }
+
+  return status;
+}
+
+/**
+ * @brief   Estimates the gyroscope bias by averaging a number of samples.
+ *
+ * @param[in] imu   The IMU service.
+ */
+static void _estimateBias(svc_imu_t* imu)
+{
+  const svc_imu_config_t* const cfg = imu->config;
+  int32_t sum[3] = {0, 0, 0};
+  uint16_t n = 0;
+  aos_timestamp_t next;
+
+  aosSysGetUptime(&next);
+  while (n < cfg->biassamples && !chThdShouldTerminateX()) {
+    if (_readGyro(imu) == APAL_STATUS_SUCCESS) {
+      sum[0] += imu->raw.gyro[0];
+      sum[1] += imu->raw.gyro[1];
+      sum[2] += imu->raw.gyro[2];
+      ++n;
+    } else {
+      ++imu->stats.errors;
+    }
+    next += cfg->period;
+    chSysLock();
+    aosThdSleepUntilS(&next);
+    chSysUnlock();
+  }
+
+  if (n > 0) {
+    chSysLock();
+    for (uint8_t axis = 0; axis < 3; ++axis) {
+      imu->calibration.gyrobias[axis] = ((float)sum[axis] / (float)n) * cfg->gyroscale;
+    }
+    chSysUnlock();
+  }
+
+  return;
+}
+
+/**
+ * @brief   IMU fusion thread.
+ * @details Runs the filter at a fixed rate, which is given by the gyroscope.
+ *          The other sensors are only read every n-th period to match their native data rates.
+ *
+ * @param[in] imu   The IMU service.
+ */
+static THD_FUNCTION(_svcImuThread, imu)
+{
+  svc_imu_t* const i = (svc_imu_t*)imu;
+  const svc_imu_config_t* const cfg = i->config;
+  svc_imu_calibration_t calib;
+  float gyro[3], accel[3], mag[3], raw[3];
+  bool accelfresh, compassfresh;
+  aos_timestamp_t next;
+  aos_timestamp_t uptime;
+  aos_timestamp_t last = 0;
+  uint32_t cycle = 0;
+
+  chRegSetThreadName("imu");
+
+  if (cfg->eeprom != NULL && svcImuLoadCalibration(i) != APAL_STATUS_SUCCESS) {
+    ++i->stats.errors;
+  }
+  if (_configure(i) != APAL_STATUS_SUCCESS) {
+    ++i->stats.errors;
+  }
+  if (cfg->biassamples > 0) {
+    _estimateBias(i);
+  }
+
+  aosSysGetUptime(&next);
+
+  while (!chThdShouldTerminateX()) {
+    if (_readGyro(i) == APAL_STATUS_SUCCESS) {
+      accelfresh = (cycle % cfg->acceldivider == 0) && (_readAccel(i) == APAL_STATUS_SUCCESS);
+      compassfresh = (cfg->compass != NULL) && (cycle % cfg->compassdivider == 0) && (_readCompass(i) == APAL_STATUS_SUCCESS);
+
+      chSysLock();
+      memcpy(&calib, &i->calibration, sizeof(svc_imu_calibration_t));
+      chSysUnlock();
+
+      // online bias estimation during standstill
+      for (uint8_t axis = 0; axis < 3; ++axis) {
+        gyro[axis] = (float)i->raw.gyro[axis] * cfg->gyroscale;
+      }
+      if (cfg->standstill.window > 0 && svcImuCalibStandstillUpdate(&i->standstill, gyro, calib.gyrobias)) {
+        chSysLock();
+        memcpy(i->calibration.gyrobias, calib.gyrobias, sizeof(calib.gyrobias));
+        chSysUnlock();
+      }
+
+      // compass ellipsoid fit
+      for (uint8_t axis = 0; axis < 3; ++axis) {
+        raw[axis] = (float)i->raw.compass[axis];
+      }
+      if (compassfresh && i->magcalibrating) {
+        chMtxLock(&i->lock);
+        svcImuCalibMagFitAdd(&i->magfit, raw);
+        chMtxUnlock(&i->lock);
+      }
+
+      // apply calibration
+      for (uint8_t axis = 0; axis < 3; ++axis) {
+        gyro[axis] -= calib.gyrobias[axis];
+        accel[axis] = (float)i->raw.accel[axis];
+        raw[axis] -= calib.magoffset[axis];
+      }
+      for (uint8_t row = 0; row < 3; ++row) {
+        mag[row] = calib.magmatrix[row*3+0] * raw[0] + calib.magmatrix[row*3+1] * raw[1] + calib.magmatrix[row*3+2] * raw[2];
+      }
+
+      // filter update with the actual time since the last gyroscope measurement
+      const float dt = (last != 0) ? (float)(i->raw.gyrotime - last) / (float)MICROSECONDS_PER_SECOND : (float)cfg->period / (float)MICROSECONDS_PER_SECOND;
+      last = i->raw.gyrotime;
+      chTMStartMeasurementX(&i->filtertime);
+      svcImuFilterUpdate(&i->filter, gyro, accelfresh ? accel : NULL, compassfresh ? mag : NULL, dt);
+      chTMStopMeasurementX(&i->filtertime);
+
+      // publish
+      chSysLock();
+      memcpy(i->orientation.q, i->filter.q, sizeof(i->orientation.q));
+      memcpy(i->orientation.rate, gyro, sizeof(i->orientation.rate));
+      memcpy(i->orientation.accel, accel, sizeof(i->orientation.accel));
+      memcpy(i->orientation.mag, mag, sizeof(i->orientation.mag));
+      i->orientation.timestamp = i->raw.gyrotime;
+      ++i->stats.updates;
+      chEvtBroadcastFlagsI(&i->source, SVC_IMU_EVENTFLAG_UPDATE);
+      chSchRescheduleS();
+      chSysUnlock();
+      if (cfg->gyrocb != NULL) {
+        cfg->gyrocb(cfg->gyrocbarg, gyro, i->raw.gyrotime);
+      }
+    } else {
+      ++i->stats.errors;
+    }
+    ++cycle;
+
+    // resynchronize if the filter fell behind for more than one period
+    aosSysGetUptime(&uptime);
+    next += cfg->period;
+    if (uptime > next + cfg->period) {
+      ++i->stats.overruns;
+      next = uptime;
+    }
+    chSysLock();
+    aosThdSleepUntilS(&next);
+    chSysUnlock();
+  }
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes an IMU service object.
+ *
+ * @param[in] imu     The IMU service to initialize.
+ * @param[in] config  The configuration to use.
+ */
+void svcImuInit(svc_imu_t* imu, const svc_imu_config_t* config)
+{
+  aosDbgCheck(imu != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->gyro != NULL && config->gyrospi != NULL);
+  aosDbgCheck(config->accel != NULL && config->accelspi != NULL);
+  aosDbgCheck(config->gyro->spid == config->accel->spid);
+  aosDbgCheck(config->period > 0);
+  aosDbgCheck(config->acceldivider > 0 && config->compassdivider > 0);
+  aosDbgCheck(config->eeprom == NULL || (uint32_t)config->eepromaddress + SVC_IMUCALIB_SERIALIZED_SIZE <= SVC_EEPROM_SIZE);
+  aosDbgCheck(config->eepromaddress % SVC_EEPROM_PAGESIZE == 0);
+
+  imu->config = config;
+  svcImuFilterInit(&imu->filter, config->kp, config->ki);
+  svcImuCalibDefault(&imu->calibration);
+  svcImuCalibStandstillInit(&imu->standstill, config->standstill.window, config->standstill.maxstddev, config->standstill.maxdeviation, config->standstill.weight);
+  svcImuCalibMagFitReset(&imu->magfit);
+  imu->magcalibrating = false;
+  chMtxObjectInit(&imu->lock);
+  memset(&imu->raw, 0, sizeof(imu->raw));
+  memset(&imu->orientation, 0, sizeof(imu->orientation));
+  imu->orientation.q[0] = 1.0f;
+  chEvtObjectInit(&imu->source);
+  chTMObjectInit(&imu->filtertime);
+  memset(&imu->stats, 0, sizeof(imu->stats));
+  imu->thread = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Configures the sensors and starts the fusion thread.
+ * @details If configured, the gyroscope bias is estimated first.
+ *
+ * @param[in] imu     The IMU service.
+ * @param[in] wa      Working area for the thread.
+ * @param[in] wasize  Size of the working area.
+ * @param[in] prio    Priority of the thread.
+ */
+void svcImuStart(svc_imu_t* imu, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(imu != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(imu->thread == NULL);
+
+  svcImuFilterInit(&imu->filter, imu->config->kp, imu->config->ki);
+  imu->thread = chThdCreateStatic(wa, wasize, prio, _svcImuThread, imu);
+
+  return;
+}
+
+/**
+ * @brief   Stops the fusion thread.
+ *
+ * @param[in] imu   The IMU service.
+ */
+void svcImuStop(svc_imu_t* imu)
+{
+  aosDbgCheck(imu != NULL);
+
+  if (imu->thread != NULL) {
+    chThdTerminate(imu->thread);
+    chThdWait(imu->thread);
+    imu->thread = NULL;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] imu   The IMU service.
+ */
+void svcImuTeardown(void* imu)
+{
+  svcImuStop((svc_imu_t*)imu);
+
+  return;
+}
+
+/**
+ * @brief   Sets the sensor calibration.
+ * @details May be called while the service is running.
+ *
+ * @param[in] imu           The IMU service.
+ * @param[in] calibration   The calibration to apply.
+ */
+void svcImuSetCalibration(svc_imu_t* imu, const svc_imu_calibration_t* calibration)
+{
+  aosDbgCheck(imu != NULL);
+  aosDbgCheck(calibration != NULL);
+
+  chSysLock();
+  memcpy(&imu->calibration, calibration, sizeof(svc_imu_calibration_t));
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Retrieves a copy of the active sensor calibration.
+ *
+ * @param[in]  imu          The IMU service.
+ * @param[out] calibration  Object to copy the calibration to.
+ */
+void svcImuGetCalibration(svc_imu_t* imu, svc_imu_calibration_t* calibration)
+{
+  aosDbgCheck(imu != NULL);
+  aosDbgCheck(calibration != NULL);
+
+  chSysLock();
+  memcpy(calibration, &imu->calibration, sizeof(svc_imu_calibration_t));
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Loads the calibration from the EEPROM and applies it.
+ *
+ * @param[in] imu   The IMU service.
+ *
+ * @return  An exit status.
+ * @retval  APAL_STATUS_SUCCESS           The calibration was applied.
+ * @retval  APAL_STATUS_FAILURE           The EEPROM could not be read.
+ * @retval  APAL_STATUS_INVALIDARGUMENTS  No valid calibration is stored.
+ */
+apalExitStatus_t svcImuLoadCalibration(svc_imu_t* imu)
+{
+  aosDbgCheck(imu != NULL);
+  aosDbgCheck(imu->config->eeprom != NULL);
+
+  uint8_t buffer[SVC_IMUCALIB_SERIALIZED_SIZE];
+  svc_imu_calibration_t calibration;
+
+  const apalExitStatus_t status = svcEepromRead(imu->config->eeprom, imu->config->eepromaddress, buffer, SVC_IMUCALIB_SERIALIZED_SIZE);
+  if (status != APAL_STATUS_SUCCESS) {
+    return status;
+  }
+  if (!svcImuCalibDeserialize(&calibration, buffer)) {
+    return APAL_STATUS_INVALIDARGUMENTS;
+  }
+  svcImuSetCalibration(imu, &calibration);
+
+  return APAL_STATUS_SUCCESS;
+}
+
+/**
+ * @brief   Stores the active calibration in the EEPROM.
+ * @details The EEPROM cache is flushed, so the calibration is persistent when this function returns.
+ *
+ * @param[in] imu   The IMU service.
+ *
+ * @return  The accumulated status of all I2C transactions.
+ */
+apalExitStatus_t svcImuSaveCalibration(svc_imu_t* imu)
+{
+  aosDbgCheck(imu != NULL);
+  aosDbgCheck(imu->config->eeprom != NULL);
+
+  uint8_t buffer[SVC_IMUCALIB_SERIALIZED_SIZE];
+  svc_imu_calibration_t calibration;
+
+  svcImuGetCalibration(imu, &calibration);
+  svcImuCalibSerialize(&calibration, buffer);
+
+  const apalExitStatus_t status = svcEepromWrite(imu->config->eeprom, imu->config->eepromaddress, buffer, SVC_IMUCALIB_SERIALIZED_SIZE);
+  if (status != APAL_STATUS_SUCCESS) {
+    return status;
+  }
+
+  return svcEepromFlush(imu->config->eeprom);
+}
+
+/**
+ * @brief   Starts collecting compass data for a new ellipsoid fit.
+ * @details The robot should be rotated until all headings were covered.
+ *
+ * @param[in] imu   The IMU service.
+ */
+void svcImuStartMagCalibration(svc_imu_t* imu)
+{
+  aosDbgCheck(imu != NULL);
+
+  chMtxLock(&imu->lock);
+  svcImuCalibMagFitReset(&imu->magfit);
+  imu->magcalibrating = true;
+  chMtxUnlock(&imu->lock);
+
+  return;
+}
+
+/**
+ * @brief   Stops collecting compass data, solves the ellipsoid fit and applies the result.
+ *
+ * @param[in] imu   The IMU service.
+ *
+ * @return  Bit mask of the calibrated axes or 0 if the fit failed (the calibration is kept in that case).
+ */
+uint8_t svcImuFinishMagCalibration(svc_imu_t* imu)
+{
+  aosDbgCheck(imu != NULL);
+
+  svc_imu_calibration_t calibration;
+  uint8_t axes;
+
+  svcImuGetCalibration(imu, &calibration);
+  chMtxLock(&imu->lock);
+  imu->magcalibrating = false;
+  axes = svcImuCalibMagFitSolve(&imu->magfit, imu->config->magspan, calibration.magoffset, calibration.magmatrix);
+  chMtxUnlock(&imu->lock);
+  if (axes != 0) {
+    // only the compass calibration is applied, the gyroscope bias may have been updated in the meantime
+    chSysLock();
+    memcpy(imu->calibration.magoffset, calibration.magoffset, sizeof(calibration.magoffset));
+    memcpy(imu->calibration.magmatrix, calibration.magmatrix, sizeof(calibration.magmatrix));
+    chSysUnlock();
+  }
+
+  return axes;
+}
+
+/**
+ * @brief   Retrieves a consistent copy of the most recent orientation estimate.
+ *
+ * @param[in]  imu          The IMU service.
+ * @param[out] orientation  Object to copy the estimate to.
+ */
+void svcImuGetOrientation(svc_imu_t* imu, svc_imu_orientation_t* orientation)
+{
+  aosDbgCheck(imu != NULL);
+  aosDbgCheck(orientation != NULL);
+
+  chSysLock();
+  memcpy(orientation, &imu->orientation, sizeof(svc_imu_orientation_t));
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Shell command implementation to print the orientation estimate.
+ *
+ * @param[in] imu     The IMU service.
+ * @param[in] stream  The I/O stream to use.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+int svcImuShellCmd(svc_imu_t* imu, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(imu != NULL);
+  aosDbgCheck(stream != NULL);
+
+  svc_imu_orientation_t o;
+  svc_imu_calibration_t c;
+  svc_imufilter_t f;
+  time_measurement_t tm;
+  float euler[3];
+
+  if (argc == 2 && (strcmp(argv[1], "--calibrate") == 0 || strcmp(argv[1], "-c") == 0)) {
+    svcImuStartMagCalibration(imu);
+    chprintf(stream, "compass calibration started, rotate the robot and run '%s --apply' afterwards\n", argv[0]);
+    return AOS_OK;
+  }
+  else if (argc == 2 && (strcmp(argv[1], "--apply") == 0 || strcmp(argv[1], "-a") == 0)) {
+    const uint8_t axes = svcImuFinishMagCalibration(imu);
+    if (axes == 0) {
+      chprintf(stream, "compass calibration failed (%u samples)\n", imu->magfit.n);
+      return AOS_ERROR;
+    }
+    chprintf(stream, "compass calibration applied (%u samples, axes:%s%s%s)\n", imu->magfit.n,
+             (axes & 0x01) ? " x" : "", (axes & 0x02) ? " y" : "", (axes & 0x04) ? " z" : "");
+    return AOS_OK;
+  }
+  else if (argc == 2 && imu->config->eeprom != NULL && (strcmp(argv[1], "--save") == 0 || strcmp(argv[1], "-s") == 0)) {
+    if (svcImuSaveCalibration(imu) != APAL_STATUS_SUCCESS) {
+      chprintf(stream, "failed to write calibration to EEPROM\n");
+      return AOS_ERROR;
+    }
+    chprintf(stream, "calibration written to EEPROM\n");
+    return AOS_OK;
+  }
+  else if (argc == 2 && imu->config->eeprom != NULL && (strcmp(argv[1], "--load") == 0 || strcmp(argv[1], "-l") == 0)) {
+    if (svcImuLoadCalibration(imu) != APAL_STATUS_SUCCESS) {
+      chprintf(stream, "no valid calibration in EEPROM\n");
+      return AOS_ERROR;
+    }
+    chprintf(stream, "calibration loaded from EEPROM\n");
+    return AOS_OK;
+  }
+  else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the orientation estimate, the calibration, the statistics and the execution time of the filter.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --calibrate, -c\n");
+    chprintf(stream, "    Start collecting compass data for hard and soft iron calibration.\n");
+    chprintf(stream, "  --apply, -a\n");
+    chprintf(stream, "    Finish the compass calibration and apply the result.\n");
+    if (imu->config->eeprom != NULL) {
+      chprintf(stream, "  --save, -s\n");
+      chprintf(stream, "    Write the calibration to the EEPROM.\n");
+      chprintf(stream, "  --load, -l\n");
+      chprintf(stream, "    Read the calibration from the EEPROM.\n");
+    }
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  svcImuGetOrientation(imu, &o);
+  svcImuGetCalibration(imu, &c);
+  chSysLock();
+  memcpy(&tm, &imu->filtertime, sizeof(time_measurement_t));
+  chSysUnlock();
+  memcpy(f.q, o.q, sizeof(f.q));
+  svcImuFilterGetEuler(&f, euler);
+
+  chprintf(stream, "quaternion: %.4f %.4f %.4f %.4f\n", o.q[0], o.q[1], o.q[2], o.q[3]);
+  chprintf(stream, "euler:      roll %.2f, pitch %.2f, yaw %.2f [deg]\n", euler[0] * RAD2DEG, euler[1] * RAD2DEG, euler[2] * RAD2DEG);
+  chprintf(stream, "rate:       %.2f %.2f %.2f [deg/s]\n", o.rate[0] * RAD2DEG, o.rate[1] * RAD2DEG, o.rate[2] * RAD2DEG);
+  chprintf(stream, "compass:    %.3f %.3f %.3f (calibrated)\n", o.mag[0], o.mag[1], o.mag[2]);
+  chprintf(stream, "timestamp:  %uus\n", (uint32_t)o.timestamp);
+  chprintf(stream, "gyro bias:  %.4f %.4f %.4f [deg/s], %u standstill windows\n",
+           c.gyrobias[0] * RAD2DEG, c.gyrobias[1] * RAD2DEG, c.gyrobias[2] * RAD2DEG, imu->standstill.detections);
+  chprintf(stream, "mag offset: %.1f %.1f %.1f\n", c.magoffset[0], c.magoffset[1], c.magoffset[2]);
+  chprintf(stream, "mag matrix: %.3f %.3f %.3f / %.3f %.3f %.3f / %.3f %.3f %.3f\n",
+           c.magmatrix[0], c.magmatrix[1], c.magmatrix[2], c.magmatrix[3], c.magmatrix[4], c.magmatrix[5], c.magmatrix[6], c.magmatrix[7], c.magmatrix[8]);
+  if (imu->magcalibrating) {
+    chprintf(stream, "mag fit:    %u samples, range %.0f %.0f %.0f\n", imu->magfit.n,
+             (imu->magfit.n > 0) ? imu->magfit.max[0] - imu->magfit.min[0] : 0.0f,
+             (imu->magfit.n > 0) ? imu->magfit.max[1] - imu->magfit.min[1] : 0.0f,
+             (imu->magfit.n > 0) ? imu->magfit.max[2] - imu->magfit.min[2] : 0.0f);
+  }
+  chprintf(stream, "updates:    %u (%u overruns, %u errors)\n", imu->stats.updates, imu->stats.overruns, imu->stats.errors);
+  chprintf(stream, "filter:     %u / %u / %u cycles (best / avg / worst), %uus worst\n",
+           (tm.n > 0) ? tm.best : 0,
+           (tm.n > 0) ? (uint32_t)(tm.cumulative / tm.n) : 0,
+           tm.worst,
+           (uint32_t)RTC2US(aosClockGetHclkX(), tm.worst));
+
+  return AOS_OK;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_L3G4200D) && defined(AMIROLLD_CFG_USE_LIS331DLH) && defined(AMIROLLD_CFG_USE_HMC5883L) && defined(AMIROLLD_CFG_USE_AT24C01BN) && (HAL_USE_SPI == TRUE) */
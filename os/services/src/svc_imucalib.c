@@ -0,0 +1,373 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_imucalib.h>
+
+#include <aos_crc.h>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief   Identifier of a serialized calibration.
+ */
+#define SERIALIZED_MAGIC              0xCA
+
+/**
+ * @brief   Resolution of the serialized gyroscope bias in radians per second.
+ */
+#define SERIALIZED_GYROBIAS_LSB       1.0e-5f
+
+/**
+ * @brief   Resolution of the serialized soft iron matrix.
+ */
+#define SERIALIZED_MAGMATRIX_LSB      (1.0f / 4096.0f)
+
+/**
+ * @brief   Index of an element of the packed upper triangle of a symmetric 6x6 matrix.
+ */
+#define ATA_INDEX(row, col)           ((row) * 6 - ((row) * ((row) - 1)) / 2 + ((col) - (row)))
+
+/**
+ * @brief   Converts a value to a saturated 16 bit integer and stores it little endian.
+ *
+ * @param[in]  value  The value to store.
+ * @param[out] dst    Destination of the two bytes.
+ */
+static void _putInt16(float value, uint8_t* dst)
+{
+  const float rounded = roundf(value);
+  const int16_t i = (rounded > 32767.0f) ? 32767 : (rounded < -32768.0f) ? -32768 : (int16_t)rounded;
+
+  dst[0] = (uint8_t)((uint16_t)i & 0xFFu);
+  dst[1] = (uint8_t)((uint16_t)i >> 8);
+
+  return;
+}
+
+/**
+ * @brief   Reads a little endian 16 bit integer.
+ *
+ * @param[in] src   Source of the two bytes.
+ *
+ * @return  The value.
+ */
+static inline float _getInt16(const uint8_t* src)
+{
+  return (float)(int16_t)((uint16_t)src[0] | ((uint16_t)src[1] << 8));
+}
+
+/**
+ * @brief   Sets a calibration to neutral values (no bias, no offset, identity matrix).
+ *
+ * @param[out] calibration  The calibration to set.
+ */
+void svcImuCalibDefault(svc_imu_calibration_t* calibration)
+{
+  memset(calibration, 0, sizeof(svc_imu_calibration_t));
+  calibration->magmatrix[0] = 1.0f;
+  calibration->magmatrix[4] = 1.0f;
+  calibration->magmatrix[8] = 1.0f;
+
+  return;
+}
+
+/**
+ * @brief   Initializes a standstill detector.
+ *
+ * @param[in] standstill    The detector to initialize.
+ * @param[in] window        Window length in samples.
+ * @param[in] maxstddev     Maximum standard deviation of the rates during standstill in rad/s.
+ * @param[in] maxdeviation  Maximum deviation of the mean rate from the current bias during standstill in rad/s.
+ * @param[in] weight        Weight of a new window mean for the bias [0, 1].
+ */
+void svcImuCalibStandstillInit(svc_imucalib_standstill_t* standstill, uint16_t window, float maxstddev, float maxdeviation, float weight)
+{
+  memset(standstill, 0, sizeof(svc_imucalib_standstill_t));
+  standstill->window = window;
+  standstill->maxvariance = maxstddev * maxstddev;
+  standstill->maxdeviation = maxdeviation;
+  standstill->weight = weight;
+
+  return;
+}
+
+/**
+ * @brief   Feeds a sample to the standstill detector and updates the bias after each window.
+ * @details A window is only considered standstill if the mean is close to the current bias, so constant rotations
+ *          (which also show a low variance) are not mistaken as bias.
+ *
+ * @param[in]     standstill  The detector.
+ * @param[in]     rate        Uncorrected angular rates in radians per second.
+ * @param[in,out] bias        The bias to update.
+ *
+ * @return  True if the window was completed during standstill and the bias was updated.
+ */
+bool svcImuCalibStandstillUpdate(svc_imucalib_standstill_t* standstill, const float rate[3], float bias[3])
+{
+  bool still = true;
+  float mean[3];
+
+  for (uint8_t axis = 0; axis < 3; ++axis) {
+    standstill->sum[axis] += rate[axis];
+    standstill->sumsq[axis] += rate[axis] * rate[axis];
+  }
+  if (++standstill->n < standstill->window) {
+    return false;
+  }
+
+  // evaluate the completed window
+  for (uint8_t axis = 0; axis < 3; ++axis) {
+    mean[axis] = standstill->sum[axis] / (float)standstill->n;
+    const float variance = standstill->sumsq[axis] / (float)standstill->n - mean[axis] * mean[axis];
+    if (variance > standstill->maxvariance || fabsf(mean[axis] - bias[axis]) > standstill->maxdeviation) {
+      still = false;
+    }
+    standstill->sum[axis] = 0.0f;
+    standstill->sumsq[axis] = 0.0f;
+  }
+  standstill->n = 0;
+
+  if (still) {
+    for (uint8_t axis = 0; axis < 3; ++axis) {
+      bias[axis] += standstill->weight * (mean[axis] - bias[axis]);
+    }
+    ++standstill->detections;
+  }
+
+  return still;
+}
+
+/**
+ * @brief   Resets an ellipsoid fit.
+ *
+ * @param[in] fit   The fit to reset.
+ */
+void svcImuCalibMagFitReset(svc_imucalib_magfit_t* fit)
+{
+  memset(fit, 0, sizeof(svc_imucalib_magfit_t));
+  for (uint8_t axis = 0; axis < 3; ++axis) {
+    fit->min[axis] = INFINITY;
+    fit->max[axis] = -INFINITY;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Adds a compass sample to an ellipsoid fit.
+ *
+ * @param[in] fit   The fit.
+ * @param[in] mag   Uncorrected compass data.
+ */
+void svcImuCalibMagFitAdd(svc_imucalib_magfit_t* fit, const float mag[3])
+{
+  const double v[6] = {
+    (double)mag[0] * mag[0], (double)mag[1] * mag[1], (double)mag[2] * mag[2],
+    (double)mag[0], (double)mag[1], (double)mag[2],
+  };
+
+  for (uint8_t row = 0; row < 6; ++row) {
+    for (uint8_t col = row; col < 6; ++col) {
+      fit->ata[ATA_INDEX(row, col)] += v[row] * v[col];
+    }
+    fit->atb[row] += v[row];
+  }
+  for (uint8_t axis = 0; axis < 3; ++axis) {
+    if (mag[axis] < fit->min[axis]) {
+      fit->min[axis] = mag[axis];
+    }
+    if (mag[axis] > fit->max[axis]) {
+      fit->max[axis] = mag[axis];
+    }
+  }
+  ++fit->n;
+
+  return;
+}
+
+/**
+ * @brief   Solves an ellipsoid fit and calculates hard and soft iron compensation.
+ * @details Only axes whose range of values exceeds @p minspan are fitted.
+ *          For these axes the offset is set, all other offsets are kept.
+ *          The matrix is set to a diagonal matrix, which scales the fitted axes to their mean radius.
+ *
+ * @param[in]     fit       The fit.
+ * @param[in]     minspan   Minimum range of values of an axis to be fitted.
+ * @param[in,out] offset    Hard iron offset.
+ * @param[out]    matrix    Soft iron matrix.
+ *
+ * @return  Bit mask of the fitted axes or 0 if the fit failed (offset and matrix are not modified in that case).
+ */
+uint8_t svcImuCalibMagFitSolve(const svc_imucalib_magfit_t* fit, float minspan, float offset[3], float matrix[9])
+{
+  double m[6][7];
+  uint8_t param[6];
+  uint8_t axes = 0;
+  uint8_t n = 0;
+
+  // select the parameters of all sufficiently excited axes
+  for (uint8_t axis = 0; axis < 3; ++axis) {
+    if (fit->n > 0 && fit->max[axis] - fit->min[axis] >= minspan) {
+      axes |= (uint8_t)(1 << axis);
+    }
+  }
+  // a 2D fit requires at least two axes
+  if (axes == 0 || (axes & (axes - 1)) == 0 || fit->n < 10) {
+    return 0;
+  }
+  for (uint8_t i = 0; i < 6; ++i) {
+    if (axes & (1 << (i % 3))) {
+      param[n++] = i;
+    }
+  }
+
+  // build the reduced augmented system
+  for (uint8_t row = 0; row < n; ++row) {
+    for (uint8_t col = 0; col < n; ++col) {
+      const uint8_t r = (param[row] < param[col]) ? param[row] : param[col];
+      const uint8_t c = (param[row] < param[col]) ? param[col] : param[row];
+      m[row][col] = fit->ata[ATA_INDEX(r, c)];
+    }
+    m[row][n] = fit->atb[param[row]];
+  }
+
+  // Gaussian elimination with partial pivoting
+  for (uint8_t col = 0; col < n; ++col) {
+    uint8_t pivot = col;
+    for (uint8_t row = col + 1; row < n; ++row) {
+      if (fabs(m[row][col]) > fabs(m[pivot][col])) {
+        pivot = row;
+      }
+    }
+    if (fabs(m[pivot][col]) < 1e-12 * fabs(m[0][0]) || m[pivot][col] == 0.0) {
+      return 0;
+    }
+    if (pivot != col) {
+      for (uint8_t c = col; c <= n; ++c) {
+        const double tmp = m[col][c];
+        m[col][c] = m[pivot][c];
+        m[pivot][c] = tmp;
+      }
+    }
+    for (uint8_t row = col + 1; row < n; ++row) {
+      const double f = m[row][col] / m[col][col];
+      for (uint8_t c = col; c <= n; ++c) {
+        m[row][c] -= f * m[col][c];
+      }
+    }
+  }
+  for (int8_t row = (int8_t)n - 1; row >= 0; --row) {
+    for (uint8_t c = (uint8_t)row + 1; c < n; ++c) {
+      m[row][n] -= m[row][c] * m[c][n];
+    }
+    m[row][n] /= m[row][row];
+  }
+
+  // extract center and radii
+  {
+    double quad[3] = {0.0, 0.0, 0.0};
+    double lin[3] = {0.0, 0.0, 0.0};
+    double g = 1.0;
+    double radius[3];
+    double meanradius = 0.0;
+    uint8_t fitted = 0;
+
+    for (uint8_t i = 0; i < n; ++i) {
+      if (param[i] < 3) {
+        quad[param[i]] = m[i][n];
+      } else {
+        lin[param[i] - 3] = m[i][n];
+      }
+    }
+    for (uint8_t axis = 0; axis < 3; ++axis) {
+      if (axes & (1 << axis)) {
+        if (quad[axis] <= 0.0) {
+          return 0;
+        }
+        g += (lin[axis] * lin[axis]) / (4.0 * quad[axis]);
+      }
+    }
+    for (uint8_t axis = 0; axis < 3; ++axis) {
+      if (axes & (1 << axis)) {
+        radius[axis] = sqrt(g / quad[axis]);
+        meanradius += radius[axis];
+        ++fitted;
+      }
+    }
+    meanradius /= fitted;
+
+    memset(matrix, 0, 9 * sizeof(float));
+    for (uint8_t axis = 0; axis < 3; ++axis) {
+      if (axes & (1 << axis)) {
+        offset[axis] = (float)(-lin[axis] / (2.0 * quad[axis]));
+        matrix[axis * 4] = (float)(meanradius / radius[axis]);
+      } else {
+        matrix[axis * 4] = 1.0f;
+      }
+    }
+  }
+
+  return axes;
+}
+
+/**
+ * @brief   Serializes a calibration into a compact, checksummed representation.
+ *
+ * @param[in]  calibration  The calibration to serialize.
+ * @param[out] buffer       Destination buffer.
+ */
+void svcImuCalibSerialize(const svc_imu_calibration_t* calibration, uint8_t buffer[SVC_IMUCALIB_SERIALIZED_SIZE])
+{
+  buffer[0] = SERIALIZED_MAGIC;
+  for (uint8_t i = 0; i < 3; ++i) {
+    _putInt16(calibration->gyrobias[i] / SERIALIZED_GYROBIAS_LSB, &buffer[2 + 2*i]);
+    _putInt16(calibration->magoffset[i], &buffer[8 + 2*i]);
+  }
+  for (uint8_t i = 0; i < 9; ++i) {
+    _putInt16(calibration->magmatrix[i] / SERIALIZED_MAGMATRIX_LSB, &buffer[14 + 2*i]);
+  }
+  buffer[1] = aosCrc8(&buffer[2], SVC_IMUCALIB_SERIALIZED_SIZE - 2);
+
+  return;
+}
+
+/**
+ * @brief   Deserializes a calibration.
+ *
+ * @param[out] calibration  The calibration to set.
+ * @param[in]  buffer       Serialized calibration.
+ *
+ * @return  False if the data is not a valid calibration (@p calibration is not modified in that case).
+ */
+bool svcImuCalibDeserialize(svc_imu_calibration_t* calibration, const uint8_t buffer[SVC_IMUCALIB_SERIALIZED_SIZE])
+{
+  if (buffer[0] != SERIALIZED_MAGIC || buffer[1] != aosCrc8(&buffer[2], SVC_IMUCALIB_SERIALIZED_SIZE - 2)) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < 3; ++i) {
+    calibration->gyrobias[i] = _getInt16(&buffer[2 + 2*i]) * SERIALIZED_GYROBIAS_LSB;
+    calibration->magoffset[i] = _getInt16(&buffer[8 + 2*i]);
+  }
+  for (uint8_t i = 0; i < 9; ++i) {
+    calibration->magmatrix[i] = _getInt16(&buffer[14 + 2*i]) * SERIALIZED_MAGMATRIX_LSB;
+  }
+
+  return true;
+}
@@ -0,0 +1,181 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_imufilter.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief   Normalizes a vector in place.
+ *
+ * @param[in,out] v   The vector.
+ * @param[in]     n   Number of elements.
+ *
+ * @return  False if the vector has zero length and was not modified.
+ */
+static bool _normalize(float* v, size_t n)
+{
+  float norm = 0.0f;
+
+  for (size_t i = 0; i < n; ++i) {
+    norm += v[i] * v[i];
+  }
+  if (norm <= 0.0f) {
+    return false;
+  }
+  norm = 1.0f / sqrtf(norm);
+  for (size_t i = 0; i < n; ++i) {
+    v[i] *= norm;
+  }
+
+  return true;
+}
+
+/**
+ * @brief   Initializes a filter with the identity orientation.
+ *
+ * @param[in] filter  The filter to initialize.
+ * @param[in] kp      Proportional gain.
+ * @param[in] ki      Integral gain.
+ */
+void svcImuFilterInit(svc_imufilter_t* filter, float kp, float ki)
+{
+  filter->q[0] = 1.0f;
+  filter->q[1] = 0.0f;
+  filter->q[2] = 0.0f;
+  filter->q[3] = 0.0f;
+  filter->integral[0] = 0.0f;
+  filter->integral[1] = 0.0f;
+  filter->integral[2] = 0.0f;
+  filter->kp = kp;
+  filter->ki = ki;
+
+  return;
+}
+
+/**
+ * @brief   Executes a single filter step.
+ * @details Accelerometer and magnetometer data is optional, so each sensor can be fed at its native rate.
+ *
+ * @param[in] filter  The filter.
+ * @param[in] gyro    Angular rates in radians per second.
+ * @param[in] accel   Acceleration in arbitrary units or NULL if no new measurement is available.
+ * @param[in] mag     Magnetic field in arbitrary units or NULL if no new measurement is available (ignored without @p accel).
+ * @param[in] dt      Time since the last step in seconds.
+ */
+void svcImuFilterUpdate(svc_imufilter_t* filter, const float gyro[3], const float accel[3], const float mag[3], float dt)
+{
+  float* const q = filter->q;
+  float g[3] = {gyro[0], gyro[1], gyro[2]};
+  float a[3], m[3];
+  float e[3] = {0.0f, 0.0f, 0.0f};
+  float qa, qb, qc;
+
+  // correction is only applied if the accelerometer is valid (gravity is required as reference)
+  if (accel != NULL) {
+    a[0] = accel[0];
+    a[1] = accel[1];
+    a[2] = accel[2];
+  }
+  if (accel != NULL && _normalize(a, 3)) {
+    const float q0q0 = q[0] * q[0];
+    const float q0q1 = q[0] * q[1];
+    const float q0q2 = q[0] * q[2];
+    const float q0q3 = q[0] * q[3];
+    const float q1q1 = q[1] * q[1];
+    const float q1q2 = q[1] * q[2];
+    const float q1q3 = q[1] * q[3];
+    const float q2q2 = q[2] * q[2];
+    const float q2q3 = q[2] * q[3];
+    const float q3q3 = q[3] * q[3];
+
+    // error between measured and estimated direction of the magnetic field
+    if (mag != NULL) {
+      m[0] = mag[0];
+      m[1] = mag[1];
+      m[2] = mag[2];
+    }
+    if (mag != NULL && _normalize(m, 3)) {
+      const float hx = 2.0f * (m[0] * (0.5f - q2q2 - q3q3) + m[1] * (q1q2 - q0q3) + m[2] * (q1q3 + q0q2));
+      const float hy = 2.0f * (m[0] * (q1q2 + q0q3) + m[1] * (0.5f - q1q1 - q3q3) + m[2] * (q2q3 - q0q1));
+      const float bx = sqrtf(hx * hx + hy * hy);
+      const float bz = 2.0f * (m[0] * (q1q3 - q0q2) + m[1] * (q2q3 + q0q1) + m[2] * (0.5f - q1q1 - q2q2));
+      const float wx = bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+      const float wy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+      const float wz = bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2);
+      e[0] += m[1] * wz - m[2] * wy;
+      e[1] += m[2] * wx - m[0] * wz;
+      e[2] += m[0] * wy - m[1] * wx;
+    }
+
+    // error between measured and estimated direction of gravity (both halved)
+    {
+      const float vx = q1q3 - q0q2;
+      const float vy = q0q1 + q2q3;
+      const float vz = q0q0 - 0.5f + q3q3;
+      e[0] += a[1] * vz - a[2] * vy;
+      e[1] += a[2] * vx - a[0] * vz;
+      e[2] += a[0] * vy - a[1] * vx;
+    }
+
+    // PI feedback
+    for (size_t i = 0; i < 3; ++i) {
+      if (filter->ki > 0.0f) {
+        filter->integral[i] += 2.0f * filter->ki * e[i] * dt;
+      } else {
+        filter->integral[i] = 0.0f;
+      }
+      g[i] += filter->integral[i] + 2.0f * filter->kp * e[i];
+    }
+  }
+
+  // integrate the rate of change of the quaternion
+  g[0] *= 0.5f * dt;
+  g[1] *= 0.5f * dt;
+  g[2] *= 0.5f * dt;
+  qa = q[0];
+  qb = q[1];
+  qc = q[2];
+  q[0] += -qb * g[0] - qc * g[1] - q[3] * g[2];
+  q[1] += qa * g[0] + qc * g[2] - q[3] * g[1];
+  q[2] += qa * g[1] - qb * g[2] + q[3] * g[0];
+  q[3] += qa * g[2] + qb * g[1] - qc * g[0];
+  _normalize(q, 4);
+
+  return;
+}
+
+/**
+ * @brief   Converts the orientation to Euler angles.
+ *
+ * @param[in]  filter   The filter.
+ * @param[out] euler    Roll, pitch and yaw in radians.
+ */
+void svcImuFilterGetEuler(const svc_imufilter_t* filter, float euler[3])
+{
+  const float* const q = filter->q;
+  const float sinp = 2.0f * (q[0] * q[2] - q[3] * q[1]);
+
+  euler[0] = atan2f(2.0f * (q[0] * q[1] + q[2] * q[3]), 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]));
+  euler[1] = (sinp >= 1.0f) ? 1.57079633f : (sinp <= -1.0f) ? -1.57079633f : asinf(sinp);
+  euler[2] = atan2f(2.0f * (q[0] * q[3] + q[1] * q[2]), 1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3]));
+
+  return;
+}
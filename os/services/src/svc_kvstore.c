@@ -0,0 +1,385 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <svc_kvstore.h>
+
+#include <aos_crc.h>
+#include <string.h>
+
+/**
+ * @brief   Offset of the CRC in a record.
+ */
+#define CRC_OFFSET                    (SVC_KVSTORE_SLOTSIZE - 1)
+
+/**
+ * @brief   Size of the record header scanned at mount time.
+ */
+#define HEADER_SIZE                   3
+
+/**
+ * @brief   Checks whether a sequence number is more recent than another one (serial number arithmetic).
+ *
+ * @param[in] a   The sequence number to check.
+ * @param[in] b   The sequence number to compare with.
+ *
+ * @return  True if a is more recent than b.
+ */
+static inline bool _isNewer(const uint16_t a, const uint16_t b)
+{
+  return (int16_t)(uint16_t)(a - b) > 0;
+}
+
+/**
+ * @brief   Decodes a record header.
+ *
+ * @param[in]  header     The header bytes.
+ * @param[out] key        The key of the record.
+ * @param[out] length     The length of the value.
+ * @param[out] sequence   The sequence number of the record.
+ *
+ * @return  True if the header is plausible.
+ */
+static bool _decodeHeader(const uint8_t* header, uint8_t* key, uint8_t* length, uint16_t* sequence)
+{
+  *key = header[0] & 0x1F;
+  *length = header[0] >> 5;
+  *sequence = (uint16_t)header[1] | ((uint16_t)header[2] << 8);
+
+  return (*key > 0) && (*key < SVC_KVSTORE_NUMKEYS) && (*length <= SVC_KVSTORE_MAXVALUE);
+}
+
+/**
+ * @brief   Reads a complete record and verifies it.
+ *
+ * @param[in]  store    The key-value store.
+ * @param[in]  slot     The slot to read.
+ * @param[out] record   Buffer for the record.
+ *
+ * @return  True if the record was read and the checksum matches.
+ */
+static bool _readRecord(svc_kvstore_t* store, uint8_t slot, uint8_t* record)
+{
+  if (!store->backend->read(store->backend->arg, store->address + (size_t)slot * SVC_KVSTORE_SLOTSIZE, record, SVC_KVSTORE_SLOTSIZE)) {
+    return false;
+  }
+
+  return record[CRC_OFFSET] == aosCrc8(record, CRC_OFFSET);
+}
+
+/**
+ * @brief   Scans all slots for the most recent valid record of a key with full verification.
+ *
+ * @param[in] store     The key-value store.
+ * @param[in] key       The key to scan for.
+ * @param[in] corrupt   Bitmask of slots known to be corrupt.
+ *
+ * @return  False on backend errors.
+ */
+static bool _rescanKey(svc_kvstore_t* store, uint8_t key, uint32_t corrupt)
+{
+  uint8_t record[SVC_KVSTORE_SLOTSIZE];
+  uint8_t k, length;
+  uint16_t sequence;
+  bool found = false;
+
+  store->index[key].slot = SVC_KVSTORE_NOSLOT;
+  for (uint8_t slot = 0; slot < store->numslots; ++slot) {
+    if (corrupt & (1u << slot)) {
+      continue;
+    }
+    if (!store->backend->read(store->backend->arg, store->address + (size_t)slot * SVC_KVSTORE_SLOTSIZE, record, SVC_KVSTORE_SLOTSIZE)) {
+      return false;
+    }
+    if (record[CRC_OFFSET] != aosCrc8(record, CRC_OFFSET) ||
+        !_decodeHeader(record, &k, &length, &sequence) || k != key) {
+      continue;
+    }
+    if (!found || _isNewer(sequence, store->index[key].sequence)) {
+      store->index[key].slot = (length > 0) ? (int8_t)slot : SVC_KVSTORE_NOSLOT;
+      store->index[key].sequence = sequence;
+      found = true;
+    }
+  }
+  store->index[key].known = found;
+
+  return true;
+}
+
+/**
+ * @brief   Writes a record for a key.
+ *
+ * @param[in] store     The key-value store.
+ * @param[in] key       The key.
+ * @param[in] data      The value (may be NULL if length is 0).
+ * @param[in] length    Length of the value (0 for a tombstone).
+ *
+ * @return  True on success, false if there is no free slot or the backend failed.
+ */
+static bool _append(svc_kvstore_t* store, uint8_t key, const uint8_t* data, uint8_t length)
+{
+  // find the next slot that does not hold a current value
+  uint8_t slot = store->head;
+  uint8_t n;
+  for (n = 0; n < store->numslots; ++n) {
+    if (!(store->live & (1u << slot))) {
+      break;
+    }
+    slot = (slot + 1) % store->numslots;
+  }
+  if (n == store->numslots) {
+    return false;
+  }
+
+  // the new record must supersede the previous one of the key in any case
+  uint16_t sequence = store->sequence + 1;
+  if (store->index[key].known && !_isNewer(sequence, store->index[key].sequence)) {
+    sequence = store->index[key].sequence + 1;
+  }
+
+  // assemble the record
+  uint8_t record[SVC_KVSTORE_SLOTSIZE];
+  memset(record, 0xFF, sizeof(record));
+  record[0] = (uint8_t)((length << 5) | key);
+  record[1] = (uint8_t)(sequence & 0xFF);
+  record[2] = (uint8_t)(sequence >> 8);
+  if (length > 0) {
+    memcpy(&record[HEADER_SIZE], data, length);
+  }
+  record[CRC_OFFSET] = aosCrc8(record, CRC_OFFSET);
+
+  // the slot is consumed even if the write fails, so a defective page is not hammered
+  store->head = (slot + 1) % store->numslots;
+  if (!store->backend->write(store->backend->arg, store->address + (size_t)slot * SVC_KVSTORE_SLOTSIZE, record, SVC_KVSTORE_SLOTSIZE)) {
+    return false;
+  }
+  ++store->stats.writes;
+
+  // update the index
+  if (store->index[key].slot != SVC_KVSTORE_NOSLOT) {
+    store->live &= ~(1u << store->index[key].slot);
+  }
+  store->index[key].slot = (length > 0) ? (int8_t)slot : SVC_KVSTORE_NOSLOT;
+  store->index[key].known = true;
+  store->index[key].sequence = sequence;
+  if (length > 0) {
+    store->live |= (1u << slot);
+  }
+  store->sequence = sequence;
+
+  return true;
+}
+
+/**
+ * @brief   Initializes a key-value store.
+ * @details The store must be mounted before it can be used.
+ *
+ * @param[out] store    The key-value store to initialize.
+ * @param[in]  backend  The storage backend.
+ * @param[in]  address  Start address of the region (should be page aligned).
+ * @param[in]  size     Size of the region in bytes (at most SVC_KVSTORE_MAXSLOTS slots are used).
+ */
+void svcKvStoreInit(svc_kvstore_t* store, const svc_kvstore_backend_t* backend, size_t address, size_t size)
+{
+  size_t numslots = size / SVC_KVSTORE_SLOTSIZE;
+
+  memset(store, 0, sizeof(svc_kvstore_t));
+  store->backend = backend;
+  store->address = address;
+  store->numslots = (uint8_t)((numslots > SVC_KVSTORE_MAXSLOTS) ? SVC_KVSTORE_MAXSLOTS : numslots);
+  for (uint8_t key = 0; key < SVC_KVSTORE_NUMKEYS; ++key) {
+    store->index[key].slot = SVC_KVSTORE_NOSLOT;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Builds the index of a key-value store from the backend.
+ * @details Only the record headers are read for all slots.
+ *          The checksum is verified for the most recent record of each key, so the full scan with verification is only
+ *          required for keys whose most recent record is corrupt.
+ *
+ * @param[in] store   The key-value store.
+ *
+ * @return  False on backend errors.
+ */
+bool svcKvStoreMount(svc_kvstore_t* store)
+{
+  uint8_t header[HEADER_SIZE];
+  uint8_t key, length;
+  uint16_t sequence;
+  bool any = false;
+  uint8_t newest = 0;
+
+  for (key = 0; key < SVC_KVSTORE_NUMKEYS; ++key) {
+    store->index[key].slot = SVC_KVSTORE_NOSLOT;
+    store->index[key].known = false;
+  }
+  store->live = 0;
+
+  // find the most recent record of each key by its header
+  for (uint8_t slot = 0; slot < store->numslots; ++slot) {
+    if (!store->backend->read(store->backend->arg, store->address + (size_t)slot * SVC_KVSTORE_SLOTSIZE, header, HEADER_SIZE)) {
+      return false;
+    }
+    if (!_decodeHeader(header, &key, &length, &sequence)) {
+      continue;
+    }
+    if (!store->index[key].known || _isNewer(sequence, store->index[key].sequence)) {
+      store->index[key].slot = (int8_t)slot;
+      store->index[key].known = true;
+      store->index[key].sequence = sequence;
+    }
+    if (!any || _isNewer(sequence, store->sequence)) {
+      store->sequence = sequence;
+      newest = slot;
+      any = true;
+    }
+  }
+
+  // verify the winners and fall back to a full scan for corrupt ones
+  for (key = 1; key < SVC_KVSTORE_NUMKEYS; ++key) {
+    if (!store->index[key].known) {
+      continue;
+    }
+    uint8_t record[SVC_KVSTORE_SLOTSIZE];
+    if (!_readRecord(store, (uint8_t)store->index[key].slot, record)) {
+      ++store->stats.rescans;
+      if (!_rescanKey(store, key, 1u << store->index[key].slot)) {
+        return false;
+      }
+    }
+    else if ((record[0] >> 5) == 0) {
+      // tombstone
+      store->index[key].slot = SVC_KVSTORE_NOSLOT;
+    }
+    if (store->index[key].slot != SVC_KVSTORE_NOSLOT) {
+      store->live |= (1u << store->index[key].slot);
+    }
+  }
+
+  // continue writing after the most recent record
+  store->head = any ? (newest + 1) % store->numslots : 0;
+
+  return true;
+}
+
+/**
+ * @brief   Erases all records of a key-value store.
+ *
+ * @param[in] store   The key-value store.
+ *
+ * @return  False on backend errors.
+ */
+bool svcKvStoreFormat(svc_kvstore_t* store)
+{
+  uint8_t erased[SVC_KVSTORE_SLOTSIZE];
+  bool retval = true;
+
+  memset(erased, 0xFF, sizeof(erased));
+  for (uint8_t slot = 0; slot < store->numslots; ++slot) {
+    retval = store->backend->write(store->backend->arg, store->address + (size_t)slot * SVC_KVSTORE_SLOTSIZE, erased, SVC_KVSTORE_SLOTSIZE) && retval;
+  }
+  for (uint8_t key = 0; key < SVC_KVSTORE_NUMKEYS; ++key) {
+    store->index[key].slot = SVC_KVSTORE_NOSLOT;
+    store->index[key].known = false;
+  }
+  store->live = 0;
+  store->sequence = 0;
+  store->head = 0;
+
+  return retval;
+}
+
+/**
+ * @brief   Retrieves the value of a key.
+ *
+ * @param[in]  store    The key-value store.
+ * @param[in]  key      The key.
+ * @param[out] buffer   Buffer to store the value to.
+ * @param[in]  size     Size of the buffer.
+ *
+ * @return  Length of the value or -1 if the key has no value (or the buffer is too small).
+ */
+int svcKvStoreGet(svc_kvstore_t* store, uint8_t key, uint8_t* buffer, size_t size)
+{
+  if (key == 0 || key >= SVC_KVSTORE_NUMKEYS || store->index[key].slot == SVC_KVSTORE_NOSLOT) {
+    return -1;
+  }
+
+  uint8_t record[SVC_KVSTORE_SLOTSIZE];
+  if (!_readRecord(store, (uint8_t)store->index[key].slot, record)) {
+    return -1;
+  }
+  const uint8_t length = record[0] >> 5;
+  if (length > size) {
+    return -1;
+  }
+  memcpy(buffer, &record[HEADER_SIZE], length);
+
+  return length;
+}
+
+/**
+ * @brief   Sets the value of a key.
+ * @details Nothing is written if the value did not change.
+ *
+ * @param[in] store   The key-value store.
+ * @param[in] key     The key (1 to SVC_KVSTORE_NUMKEYS-1).
+ * @param[in] data    The value.
+ * @param[in] length  Length of the value (1 to SVC_KVSTORE_MAXVALUE).
+ *
+ * @return  True on success, false on invalid arguments, a full store or backend errors.
+ */
+bool svcKvStoreSet(svc_kvstore_t* store, uint8_t key, const uint8_t* data, size_t length)
+{
+  if (key == 0 || key >= SVC_KVSTORE_NUMKEYS || length == 0 || length > SVC_KVSTORE_MAXVALUE) {
+    return false;
+  }
+
+  // skip the write if the value is unchanged
+  uint8_t value[SVC_KVSTORE_MAXVALUE];
+  if (svcKvStoreGet(store, key, value, sizeof(value)) == (int)length && memcmp(value, data, length) == 0) {
+    ++store->stats.skipped;
+    return true;
+  }
+
+  return _append(store, key, data, (uint8_t)length);
+}
+
+/**
+ * @brief   Removes the value of a key.
+ * @details A tombstone record is written, so older records of the key are not restored at the next mount.
+ *
+ * @param[in] store   The key-value store.
+ * @param[in] key     The key.
+ *
+ * @return  True on success, false on invalid arguments, a full store or backend errors.
+ */
+bool svcKvStoreDelete(svc_kvstore_t* store, uint8_t key)
+{
+  if (key == 0 || key >= SVC_KVSTORE_NUMKEYS) {
+    return false;
+  }
+  if (store->index[key].slot == SVC_KVSTORE_NOSLOT) {
+    return true;
+  }
+
+  return _append(store, key, NULL, 0);
+}
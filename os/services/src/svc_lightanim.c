@@ -0,0 +1,407 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_lightanim.h>
+
+#if (defined(AMIROLLD_CFG_USE_TLC5947) && (HAL_USE_SPI == TRUE)) || defined(__DOXYGEN__)
+
+#include <aos_clock.h>
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief   Event ID of the vsync listener.
+ */
+#define VSYNC_EVENTID                 0
+
+/**
+ * @brief   Built-in script of a single white LED spinning around the ring with cross fading.
+ */
+static const uint8_t _presetSpin[] = {
+  SVC_LIGHTSCRIPT_OP_FILL, 0x00, 0x00, 0, 0, 0,
+  SVC_LIGHTSCRIPT_OP_SET, 0x00, 0x00, 3, 0, 255, 1, 255, 2, 255,
+  SVC_LIGHTSCRIPT_OP_ROTATE, 0x7D, 0x00, 1,
+  SVC_LIGHTSCRIPT_OP_LOOP, 16,
+};
+
+/**
+ * @brief   Built-in script of all LEDs slowly pulsing blue.
+ */
+static const uint8_t _presetPulse[] = {
+  SVC_LIGHTSCRIPT_OP_FILL | SVC_LIGHTSCRIPT_FLAG_EASE, 0xF4, 0x01, 0, 0, 255,
+  SVC_LIGHTSCRIPT_OP_SCALE | SVC_LIGHTSCRIPT_FLAG_EASE, 0xF4, 0x01, 16,
+  SVC_LIGHTSCRIPT_OP_LOOP, 0,
+};
+
+/**
+ * @brief   Converts a hexadecimal digit.
+ *
+ * @param[in] c   The character.
+ *
+ * @return  Value of the digit or -1 if the character is no hexadecimal digit.
+ */
+static int _hexdigit(char c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  } else if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  } else {
+    return -1;
+  }
+}
+
+/**
+ * @brief   Animation thread.
+ * @details Renders a frame at each vsync event of the frame buffer.
+ *          Frames are only drawn while a script is running or the lookup table changed.
+ *
+ * @param[in] anim  The animation engine.
+ */
+static THD_FUNCTION(_svcLightAnimThread, anim)
+{
+  svc_lightanim_t* const a = (svc_lightanim_t*)anim;
+  svc_framebuffer_t* const fb = a->config->framebuffer;
+  event_listener_t listener;
+  tlc5947_lld_buffer_t* buffer;
+  aos_timestamp_t uptime;
+  bool draw;
+
+  chRegSetThreadName("lightanim");
+
+  chEvtRegisterMask(&fb->source, &listener, EVENT_MASK(VSYNC_EVENTID));
+
+  while (!chThdShouldTerminateX()) {
+    // the timeout allows termination even if the frame buffer was stopped
+    if (chEvtWaitAnyTimeout(EVENT_MASK(VSYNC_EVENTID), TIME_US2I(2 * fb->config->period)) == 0) {
+      continue;
+    }
+    chEvtGetAndClearFlags(&listener);
+
+    chMtxLock(&a->lock);
+    draw = a->playing || a->dirty;
+    if (draw) {
+      chTMStartMeasurementX(&a->frametime);
+      if (a->playing) {
+        aosSysGetUptime(&uptime);
+        a->playing = svcLightScriptRender(&a->player, uptime, a->values);
+      }
+      buffer = svcFrameBufferGetBack(fb);
+      for (uint8_t channel = 0; channel < SVC_LIGHTSCRIPT_NUMCHANNELS; ++channel) {
+        tlc5947_lld_setBuffer(buffer, channel, svcLightScriptMap(a->lut, a->values[channel]));
+      }
+      chTMStopMeasurementX(&a->frametime);
+      a->dirty = false;
+      ++a->stats.frames;
+      if (RTC2US(aosClockGetHclkX(), a->frametime.last) > a->config->budget) {
+        ++a->stats.overbudget;
+      }
+    }
+    chMtxUnlock(&a->lock);
+
+    if (draw) {
+      svcFrameBufferSwap(fb);
+    }
+  }
+
+  chEvtUnregister(&fb->source, &listener);
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes an animation engine object.
+ * @details All LEDs are off and no script is loaded.
+ *
+ * @param[in] anim    The animation engine to initialize.
+ * @param[in] config  The configuration to use.
+ */
+void svcLightAnimInit(svc_lightanim_t* anim, const svc_lightanim_config_t* config)
+{
+  aosDbgCheck(anim != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->framebuffer != NULL);
+
+  anim->config = config;
+  memset(&anim->player, 0, sizeof(anim->player));
+  memset(anim->scripts, 0, sizeof(anim->scripts));
+  anim->active = 0;
+  anim->playing = false;
+  anim->dirty = false;
+  memset(anim->values, 0, sizeof(anim->values));
+  anim->brightness = config->brightness;
+  svcLightScriptBuildLut(anim->lut, anim->brightness);
+  chMtxObjectInit(&anim->lock);
+  chTMObjectInit(&anim->frametime);
+  memset(&anim->stats, 0, sizeof(anim->stats));
+  anim->thread = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Starts the animation thread.
+ * @details The thread should have a higher priority than all other threads drawing to the frame buffer.
+ *
+ * @param[in] anim    The animation engine.
+ * @param[in] wa      Working area for the thread.
+ * @param[in] wasize  Size of the working area.
+ * @param[in] prio    Priority of the thread.
+ */
+void svcLightAnimStart(svc_lightanim_t* anim, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(anim != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(anim->thread == NULL);
+
+  anim->thread = chThdCreateStatic(wa, wasize, prio, _svcLightAnimThread, anim);
+
+  return;
+}
+
+/**
+ * @brief   Stops the animation thread.
+ * @details The frame buffer keeps the last rendered frame.
+ *
+ * @param[in] anim  The animation engine.
+ */
+void svcLightAnimStop(svc_lightanim_t* anim)
+{
+  aosDbgCheck(anim != NULL);
+
+  if (anim->thread != NULL) {
+    chThdTerminate(anim->thread);
+    chThdWait(anim->thread);
+    anim->thread = NULL;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] anim  The animation engine.
+ */
+void svcLightAnimTeardown(void* anim)
+{
+  svcLightAnimStop((svc_lightanim_t*)anim);
+
+  return;
+}
+
+/**
+ * @brief   Writes a chunk of a script to the staging buffer.
+ * @details Chunks may be written in any order, so a script can be transmitted in small messages (e.g. CAN frames).
+ *
+ * @param[in] anim    The animation engine.
+ * @param[in] offset  Offset of the chunk within the script.
+ * @param[in] data    The chunk.
+ * @param[in] length  Length of the chunk in bytes.
+ *
+ * @return  False if the chunk exceeds SVC_LIGHTANIM_MAXSCRIPTSIZE.
+ */
+bool svcLightAnimLoad(svc_lightanim_t* anim, size_t offset, const uint8_t* data, size_t length)
+{
+  aosDbgCheck(anim != NULL);
+  aosDbgCheck(data != NULL || length == 0);
+
+  if (offset + length > SVC_LIGHTANIM_MAXSCRIPTSIZE) {
+    return false;
+  }
+
+  chMtxLock(&anim->lock);
+  memcpy(&anim->scripts[anim->active ^ 1][offset], data, length);
+  chMtxUnlock(&anim->lock);
+
+  return true;
+}
+
+/**
+ * @brief   Validates the staged script and starts playing it.
+ * @details The first transition starts at the currently displayed intensities, so switching scripts is seamless.
+ *
+ * @param[in] anim  The animation engine.
+ * @param[in] size  Size of the staged script in bytes.
+ *
+ * @return  False if the staged script is invalid (the active script keeps playing).
+ */
+bool svcLightAnimCommit(svc_lightanim_t* anim, size_t size)
+{
+  aosDbgCheck(anim != NULL);
+
+  uint8_t initial[SVC_LIGHTSCRIPT_NUMCHANNELS];
+  aos_timestamp_t uptime;
+  bool valid;
+
+  chMtxLock(&anim->lock);
+  valid = (size <= SVC_LIGHTANIM_MAXSCRIPTSIZE) && svcLightScriptValidate(anim->scripts[anim->active ^ 1], size);
+  if (valid) {
+    anim->active ^= 1;
+    for (uint8_t channel = 0; channel < SVC_LIGHTSCRIPT_NUMCHANNELS; ++channel) {
+      initial[channel] = (uint8_t)((anim->values[channel] + 0x80) >> 8);
+    }
+    aosSysGetUptime(&uptime);
+    svcLightScriptStart(&anim->player, anim->scripts[anim->active], size, initial, uptime);
+    anim->playing = true;
+    ++anim->stats.loads;
+  }
+  chMtxUnlock(&anim->lock);
+
+  return valid;
+}
+
+/**
+ * @brief   Halts the active script.
+ * @details The current frame is kept, so other threads may draw to the frame buffer afterwards.
+ *
+ * @param[in] anim  The animation engine.
+ */
+void svcLightAnimHalt(svc_lightanim_t* anim)
+{
+  aosDbgCheck(anim != NULL);
+
+  chMtxLock(&anim->lock);
+  anim->playing = false;
+  chMtxUnlock(&anim->lock);
+
+  return;
+}
+
+/**
+ * @brief   Sets the global brightness.
+ * @details The lookup table is rebuilt and the current frame is drawn again with the next vsync event.
+ *
+ * @param[in] anim        The animation engine.
+ * @param[in] brightness  The brightness (255 for full intensity).
+ */
+void svcLightAnimSetBrightness(svc_lightanim_t* anim, uint8_t brightness)
+{
+  aosDbgCheck(anim != NULL);
+
+  chMtxLock(&anim->lock);
+  anim->brightness = brightness;
+  svcLightScriptBuildLut(anim->lut, brightness);
+  anim->dirty = true;
+  chMtxUnlock(&anim->lock);
+
+  return;
+}
+
+/**
+ * @brief   Shell command implementation to load scripts and print animation statistics.
+ *
+ * @param[in] anim    The animation engine.
+ * @param[in] stream  The I/O stream to use.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+int svcLightAnimShellCmd(svc_lightanim_t* anim, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(anim != NULL);
+  aosDbgCheck(stream != NULL);
+
+  time_measurement_t tm;
+  uint32_t average;
+
+  if (argc == 3 && (strcmp(argv[1], "--load") == 0 || strcmp(argv[1], "-l") == 0)) {
+    const size_t length = strlen(argv[2]);
+    uint8_t byte;
+    if (length == 0 || length % 2 != 0 || length / 2 > SVC_LIGHTANIM_MAXSCRIPTSIZE) {
+      chprintf(stream, "script must consist of 1 to %u hexadecimal bytes\n", SVC_LIGHTANIM_MAXSCRIPTSIZE);
+      return AOS_INVALID_ARGUMENTS;
+    }
+    for (size_t i = 0; i < length / 2; ++i) {
+      const int high = _hexdigit(argv[2][2 * i]);
+      const int low = _hexdigit(argv[2][2 * i + 1]);
+      if (high < 0 || low < 0) {
+        chprintf(stream, "invalid hexadecimal byte at offset %u\n", i);
+        return AOS_INVALID_ARGUMENTS;
+      }
+      byte = (uint8_t)((high << 4) | low);
+      svcLightAnimLoad(anim, i, &byte, 1);
+    }
+    if (!svcLightAnimCommit(anim, length / 2)) {
+      chprintf(stream, "invalid script\n");
+      return AOS_INVALID_ARGUMENTS;
+    }
+    return AOS_OK;
+  } else if (argc == 3 && (strcmp(argv[1], "--preset") == 0 || strcmp(argv[1], "-p") == 0)) {
+    if (strcmp(argv[2], "spin") == 0) {
+      svcLightAnimLoad(anim, 0, _presetSpin, sizeof(_presetSpin));
+      svcLightAnimCommit(anim, sizeof(_presetSpin));
+    } else if (strcmp(argv[2], "pulse") == 0) {
+      svcLightAnimLoad(anim, 0, _presetPulse, sizeof(_presetPulse));
+      svcLightAnimCommit(anim, sizeof(_presetPulse));
+    } else {
+      chprintf(stream, "unknown preset '%s'\n", argv[2]);
+      return AOS_INVALID_ARGUMENTS;
+    }
+    return AOS_OK;
+  } else if (argc == 3 && (strcmp(argv[1], "--brightness") == 0 || strcmp(argv[1], "-b") == 0)) {
+    const int brightness = atoi(argv[2]);
+    if (brightness < 0 || brightness > 255) {
+      chprintf(stream, "brightness must be in [0, 255]\n");
+      return AOS_INVALID_ARGUMENTS;
+    }
+    svcLightAnimSetBrightness(anim, (uint8_t)brightness);
+    return AOS_OK;
+  } else if (argc == 2 && strcmp(argv[1], "--halt") == 0) {
+    svcLightAnimHalt(anim);
+    return AOS_OK;
+  } else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the animation statistics.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --load, -l <HEX>\n");
+    chprintf(stream, "    Load and play a script given as hexadecimal bytes.\n");
+    chprintf(stream, "  --preset, -p <NAME>\n");
+    chprintf(stream, "    Play a built-in script (spin, pulse).\n");
+    chprintf(stream, "  --brightness, -b <VALUE>\n");
+    chprintf(stream, "    Set the global brightness (0 to 255).\n");
+    chprintf(stream, "  --halt\n");
+    chprintf(stream, "    Halt the script and keep the current frame.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  chMtxLock(&anim->lock);
+  memcpy(&tm, &anim->frametime, sizeof(time_measurement_t));
+  chMtxUnlock(&anim->lock);
+  average = (tm.n > 0) ? (uint32_t)RTC2US(aosClockGetHclkX(), tm.cumulative / tm.n) : 0;
+
+  chprintf(stream, "state:      %s (%u scripts loaded), brightness %u\n", anim->playing ? "playing" : "idle", anim->stats.loads, anim->brightness);
+  chprintf(stream, "frames:     %u rendered, %u over budget of %uus\n", anim->stats.frames, anim->stats.overbudget, anim->config->budget);
+  chprintf(stream, "render:     %uus / %uus (avg / worst), %u%% of the frame period\n",
+           average, (uint32_t)RTC2US(aosClockGetHclkX(), tm.worst), average * 100 / anim->config->framebuffer->config->period);
+
+  return AOS_OK;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_TLC5947) && (HAL_USE_SPI == TRUE) */
@@ -0,0 +1,302 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_lightscript.h>
+
+#include <string.h>
+
+/**
+ * @brief   Gamma correction table (gamma 2.2) from 8 bit intensities to 12 bit PWM values.
+ * @details Generated at build time of the source as round(4095 * (min(i, 255) / 255)^2.2), so no floating point
+ *          arithmetics are required on the target.
+ */
+const uint16_t svcLightScriptGamma[SVC_LIGHTSCRIPT_LUT_SIZE] = {
+     0,    0,    0,    0,    0,    1,    1,    2,    2,    3,    3,    4,    5,    6,    7,    8,
+     9,   11,   12,   14,   15,   17,   19,   21,   23,   25,   27,   29,   32,   34,   37,   40,
+    43,   46,   49,   52,   55,   59,   62,   66,   70,   73,   77,   82,   86,   90,   95,   99,
+   104,  109,  114,  119,  124,  129,  135,  140,  146,  152,  158,  164,  170,  176,  182,  189,
+   196,  202,  209,  216,  224,  231,  238,  246,  254,  261,  269,  277,  286,  294,  302,  311,
+   320,  328,  337,  347,  356,  365,  375,  384,  394,  404,  414,  424,  435,  445,  456,  467,
+   477,  488,  500,  511,  522,  534,  545,  557,  569,  581,  594,  606,  619,  631,  644,  657,
+   670,  683,  697,  710,  724,  738,  752,  766,  780,  794,  809,  823,  838,  853,  868,  884,
+   899,  914,  930,  946,  962,  978,  994, 1011, 1027, 1044, 1061, 1078, 1095, 1112, 1130, 1147,
+  1165, 1183, 1201, 1219, 1237, 1256, 1274, 1293, 1312, 1331, 1350, 1370, 1389, 1409, 1429, 1449,
+  1469, 1489, 1509, 1530, 1551, 1572, 1593, 1614, 1635, 1657, 1678, 1700, 1722, 1744, 1766, 1789,
+  1811, 1834, 1857, 1880, 1903, 1926, 1950, 1974, 1997, 2021, 2045, 2070, 2094, 2119, 2143, 2168,
+  2193, 2219, 2244, 2270, 2295, 2321, 2347, 2373, 2400, 2426, 2453, 2479, 2506, 2534, 2561, 2588,
+  2616, 2644, 2671, 2700, 2728, 2756, 2785, 2813, 2842, 2871, 2900, 2930, 2959, 2989, 3019, 3049,
+  3079, 3109, 3140, 3170, 3201, 3232, 3263, 3295, 3326, 3358, 3390, 3421, 3454, 3486, 3518, 3551,
+  3584, 3617, 3650, 3683, 3716, 3750, 3784, 3818, 3852, 3886, 3920, 3955, 3990, 4025, 4060, 4095,
+  4095
+};
+
+/**
+ * @brief   Retrieves the encoded size of a keyframe.
+ *
+ * @param[in] script  The script.
+ * @param[in] offset  Offset of the keyframe.
+ * @param[in] size    Size of the script.
+ *
+ * @return  Size of the keyframe in bytes or 0 if the keyframe is invalid or truncated.
+ */
+static size_t _keyframeSize(const uint8_t* script, size_t offset, size_t size)
+{
+  size_t length;
+
+  switch (script[offset] & ~SVC_LIGHTSCRIPT_FLAG_EASE) {
+    case SVC_LIGHTSCRIPT_OP_SET:
+      if (offset + 4 > size) {
+        return 0;
+      }
+      length = 4 + 2 * (size_t)script[offset + 3];
+      if (script[offset + 3] > SVC_LIGHTSCRIPT_NUMCHANNELS || offset + length > size) {
+        return 0;
+      }
+      for (size_t i = 0; i < script[offset + 3]; ++i) {
+        if (script[offset + 4 + 2 * i] >= SVC_LIGHTSCRIPT_NUMCHANNELS) {
+          return 0;
+        }
+      }
+      return length;
+    case SVC_LIGHTSCRIPT_OP_FILL:
+      length = 6;
+      break;
+    case SVC_LIGHTSCRIPT_OP_ROTATE:
+    case SVC_LIGHTSCRIPT_OP_SCALE:
+      length = 4;
+      break;
+    case SVC_LIGHTSCRIPT_OP_LOOP:
+      length = 2;
+      break;
+    default:
+      return 0;
+  }
+
+  return (offset + length > size) ? 0 : length;
+}
+
+/**
+ * @brief   Decodes the next keyframe relative to the previous one.
+ * @details The previous keyframe must already be copied to the @p from intensities.
+ *
+ * @param[in] player  The player.
+ *
+ * @return  False if the end of the script was reached.
+ */
+static bool _next(svc_lightscript_player_t* player)
+{
+  const uint8_t* s;
+
+  if (player->pc < player->size && (player->script[player->pc] & ~SVC_LIGHTSCRIPT_FLAG_EASE) == SVC_LIGHTSCRIPT_OP_LOOP) {
+    player->pc = player->script[player->pc + 1];
+  }
+  if (player->pc >= player->size) {
+    return false;
+  }
+
+  s = &player->script[player->pc];
+  player->ease = (s[0] & SVC_LIGHTSCRIPT_FLAG_EASE) != 0;
+  player->duration = ((uint32_t)s[1] | ((uint32_t)s[2] << 8)) * 1000;
+  switch (s[0] & ~SVC_LIGHTSCRIPT_FLAG_EASE) {
+    case SVC_LIGHTSCRIPT_OP_SET:
+      for (uint8_t i = 0; i < s[3]; ++i) {
+        player->to[s[4 + 2 * i]] = s[5 + 2 * i];
+      }
+      break;
+    case SVC_LIGHTSCRIPT_OP_FILL:
+      for (uint8_t led = 0; led < SVC_LIGHTSCRIPT_NUMLEDS; ++led) {
+        player->to[3 * led + 0] = s[3];
+        player->to[3 * led + 1] = s[4];
+        player->to[3 * led + 2] = s[5];
+      }
+      break;
+    case SVC_LIGHTSCRIPT_OP_ROTATE:
+    {
+      const uint8_t shift = (uint8_t)((((int)(int8_t)s[3] % SVC_LIGHTSCRIPT_NUMLEDS) + SVC_LIGHTSCRIPT_NUMLEDS) % SVC_LIGHTSCRIPT_NUMLEDS);
+      for (uint8_t led = 0; led < SVC_LIGHTSCRIPT_NUMLEDS; ++led) {
+        const uint8_t target = (uint8_t)((led + shift) % SVC_LIGHTSCRIPT_NUMLEDS);
+        player->to[3 * target + 0] = player->from[3 * led + 0];
+        player->to[3 * target + 1] = player->from[3 * led + 1];
+        player->to[3 * target + 2] = player->from[3 * led + 2];
+      }
+      break;
+    }
+    case SVC_LIGHTSCRIPT_OP_SCALE:
+      for (uint8_t channel = 0; channel < SVC_LIGHTSCRIPT_NUMCHANNELS; ++channel) {
+        player->to[channel] = (uint8_t)(((uint16_t)player->to[channel] * s[3] + 127) / 255);
+      }
+      break;
+    default:
+      break;
+  }
+  player->pc += _keyframeSize(player->script, player->pc, player->size);
+
+  return true;
+}
+
+/**
+ * @brief   Checks whether a script is well formed.
+ * @details Scripts must be validated before playing them, since the player does not check the encoding.
+ *          A loop is only valid at the end of a script and must jump to the start of a keyframe, with a non-zero
+ *          transition time between the target and the loop.
+ *
+ * @param[in] script  The script.
+ * @param[in] size    Size of the script in bytes.
+ *
+ * @return  True if the script is valid.
+ */
+bool svcLightScriptValidate(const uint8_t* script, size_t size)
+{
+  size_t offset = 0;
+  size_t length;
+
+  if (script == NULL || size == 0) {
+    return false;
+  }
+
+  while (offset < size) {
+    length = _keyframeSize(script, offset, size);
+    if (length == 0) {
+      return false;
+    }
+    if ((script[offset] & ~SVC_LIGHTSCRIPT_FLAG_EASE) == SVC_LIGHTSCRIPT_OP_LOOP) {
+      const size_t target = script[offset + 1];
+      uint32_t total = 0;
+      bool found = false;
+      if (offset + length != size) {
+        return false;
+      }
+      for (size_t frame = 0; frame < offset; frame += _keyframeSize(script, frame, size)) {
+        if (frame == target) {
+          found = true;
+        }
+        if (frame >= target) {
+          total += (uint32_t)script[frame + 1] | ((uint32_t)script[frame + 2] << 8);
+        }
+      }
+      return found && total > 0;
+    }
+    offset += length;
+  }
+
+  return true;
+}
+
+/**
+ * @brief   Starts playing a script.
+ *
+ * @param[in] player    The player.
+ * @param[in] script    The script (must be valid).
+ * @param[in] size      Size of the script in bytes.
+ * @param[in] initial   Intensities to start the first transition from.
+ * @param[in] now       Current time in microseconds.
+ */
+void svcLightScriptStart(svc_lightscript_player_t* player, const uint8_t* script, size_t size, const uint8_t initial[SVC_LIGHTSCRIPT_NUMCHANNELS], uint64_t now)
+{
+  player->script = script;
+  player->size = size;
+  player->pc = 0;
+  memcpy(player->from, initial, SVC_LIGHTSCRIPT_NUMCHANNELS);
+  memcpy(player->to, initial, SVC_LIGHTSCRIPT_NUMCHANNELS);
+  player->start = now;
+  player->duration = 0;
+  player->ease = false;
+  player->running = _next(player);
+
+  return;
+}
+
+/**
+ * @brief   Computes the intensities of all channels at the given time.
+ * @details Elapsed keyframes are skipped.
+ *          If the caller fell behind by more than a whole loop (e.g. after pausing), the current keyframe restarts.
+ *
+ * @param[in]  player   The player.
+ * @param[in]  now      Current time in microseconds (must not decrease between calls).
+ * @param[out] values   Intensities in Q8.8 format (0 to SVC_LIGHTSCRIPT_VALUE_MAX).
+ *
+ * @return  True if the script is still running, false if the last keyframe is held.
+ */
+bool svcLightScriptRender(svc_lightscript_player_t* player, uint64_t now, uint16_t values[SVC_LIGHTSCRIPT_NUMCHANNELS])
+{
+  size_t steps = 0;
+  uint32_t t;
+
+  while (player->running && now >= player->start + player->duration) {
+    player->start += player->duration;
+    memcpy(player->from, player->to, SVC_LIGHTSCRIPT_NUMCHANNELS);
+    if (!_next(player)) {
+      player->running = false;
+    } else if (++steps > player->size) {
+      player->start = now;
+    }
+  }
+
+  if (!player->running) {
+    for (uint8_t channel = 0; channel < SVC_LIGHTSCRIPT_NUMCHANNELS; ++channel) {
+      values[channel] = (uint16_t)player->to[channel] << 8;
+    }
+    return false;
+  }
+
+  // transition progress in Q0.16 format
+  t = (now > player->start) ? (uint32_t)(((now - player->start) << 16) / player->duration) : 0;
+  if (player->ease) {
+    const uint32_t t2 = (uint32_t)(((uint64_t)t * t) >> 16);
+    t = (uint32_t)(((uint64_t)t2 * ((3u << 16) - 2 * t)) >> 16);
+  }
+  for (uint8_t channel = 0; channel < SVC_LIGHTSCRIPT_NUMCHANNELS; ++channel) {
+    const int32_t delta = (int32_t)player->to[channel] - (int32_t)player->from[channel];
+    values[channel] = (uint16_t)(((int32_t)player->from[channel] << 8) + ((delta * (int32_t)t) / 256));
+  }
+
+  return true;
+}
+
+/**
+ * @brief   Builds a lookup table which combines global brightness and gamma correction.
+ * @details The table only needs to be rebuilt when the brightness changes, so each channel costs a single
+ *          interpolated lookup per frame.
+ *
+ * @param[out] lut          The lookup table.
+ * @param[in]  brightness   Global brightness (255 for full intensity).
+ */
+void svcLightScriptBuildLut(uint16_t lut[SVC_LIGHTSCRIPT_LUT_SIZE], uint8_t brightness)
+{
+  for (uint16_t i = 0; i < SVC_LIGHTSCRIPT_LUT_SIZE; ++i) {
+    const uint32_t intensity = (i < 255) ? i : 255;
+    lut[i] = svcLightScriptMap(svcLightScriptGamma, (uint16_t)((intensity * brightness * 256) / 255));
+  }
+
+  return;
+}
+
+/**
+ * @brief   Maps an intensity to a PWM value by linear interpolation between the table entries.
+ *
+ * @param[in] lut     The lookup table (must be monotonically increasing).
+ * @param[in] value   Intensity in Q8.8 format.
+ *
+ * @return  The PWM value.
+ */
+uint16_t svcLightScriptMap(const uint16_t lut[SVC_LIGHTSCRIPT_LUT_SIZE], uint16_t value)
+{
+  const uint16_t index = value >> 8;
+
+  return lut[index] + (uint16_t)((((uint32_t)lut[index + 1] - lut[index]) * (value & 0xFF)) >> 8);
+}
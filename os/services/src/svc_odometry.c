@@ -0,0 +1,402 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_odometry.h>
+
+#if ((HAL_USE_QEI == TRUE) && (QEI_USE_EXTENDED_POSITION == TRUE) && (QEI_USE_VELOCITY == TRUE)) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Binary angle per microradian-microsecond (24 fractional bits).
+ * @details 2^32 / (2 * pi * 10^6) / 10^6 * 2^24
+ */
+#define SVC_ODOMETRY_BAMPERURADUS     ((int64_t)11468)
+
+/**
+ * @brief   Number of fractional bits of the sine table.
+ */
+#define SVC_ODOMETRY_SIN_FRACBITS     30
+
+/**
+ * @brief   Compiler barrier to order the accesses of the sequence lock.
+ */
+#define _seqBarrier()                 __asm__ volatile ("" ::: "memory")
+
+/**
+ * @brief   First quadrant of the sine function in 256 steps (@p SVC_ODOMETRY_SIN_FRACBITS fractional bits).
+ */
+static const int32_t _sinTable[257] = {
+  0, 6588356, 13176464, 19764076, 26350943, 32936819,
+  39521455, 46104602, 52686014, 59265442, 65842639, 72417357,
+  78989349, 85558366, 92124163, 98686491, 105245103, 111799753,
+  118350194, 124896179, 131437462, 137973796, 144504935, 151030634,
+  157550647, 164064728, 170572633, 177074115, 183568930, 190056834,
+  196537583, 203010932, 209476638, 215934457, 222384147, 228825464,
+  235258165, 241682010, 248096755, 254502159, 260897982, 267283981,
+  273659918, 280025552, 286380643, 292724951, 299058239, 305380268,
+  311690799, 317989595, 324276419, 330551034, 336813204, 343062693,
+  349299266, 355522689, 361732726, 367929144, 374111709, 380280190,
+  386434353, 392573967, 398698801, 404808624, 410903207, 416982319,
+  423045732, 429093217, 435124548, 441139496, 447137835, 453119340,
+  459083786, 465030947, 470960600, 476872522, 482766489, 488642281,
+  494499676, 500338453, 506158392, 511959275, 517740883, 523502998,
+  529245404, 534967884, 540670223, 546352205, 552013618, 557654248,
+  563273883, 568872310, 574449320, 580004702, 585538248, 591049748,
+  596538995, 602005783, 607449906, 612871159, 618269338, 623644239,
+  628995660, 634323400, 639627258, 644907034, 650162530, 655393548,
+  660599890, 665781362, 670937767, 676068911, 681174602, 686254647,
+  691308855, 696337036, 701339000, 706314559, 711263525, 716185713,
+  721080937, 725949013, 730789757, 735602987, 740388522, 745146182,
+  749875788, 754577161, 759250125, 763894504, 768510122, 773096806,
+  777654384, 782182683, 786681534, 791150767, 795590213, 799999706,
+  804379079, 808728167, 813046808, 817334838, 821592095, 825818421,
+  830013654, 834177638, 838310216, 842411232, 846480531, 850517961,
+  854523370, 858496606, 862437520, 866345964, 870221790, 874064853,
+  877875009, 881652112, 885396022, 889106597, 892783698, 896427186,
+  900036924, 903612776, 907154608, 910662286, 914135678, 917574653,
+  920979082, 924348837, 927683790, 930983817, 934248793, 937478595,
+  940673101, 943832191, 946955747, 950043650, 953095785, 956112036,
+  959092290, 962036435, 964944360, 967815955, 970651112, 973449725,
+  976211688, 978936898, 981625251, 984276646, 986890984, 989468165,
+  992008094, 994510675, 996975812, 999403415, 1001793390, 1004145648,
+  1006460100, 1008736660, 1010975242, 1013175761, 1015338134, 1017462281,
+  1019548121, 1021595575, 1023604567, 1025575020, 1027506862, 1029400018,
+  1031254418, 1033069992, 1034846671, 1036584389, 1038283080, 1039942680,
+  1041563127, 1043144360, 1044686319, 1046188946, 1047652185, 1049075980,
+  1050460278, 1051805027, 1053110176, 1054375676, 1055601479, 1056787540,
+  1057933813, 1059040255, 1060106826, 1061133483, 1062120190, 1063066909,
+  1063973603, 1064840240, 1065666786, 1066453210, 1067199483, 1067905576,
+  1068571464, 1069197120, 1069782521, 1070327646, 1070832474, 1071296985,
+  1071721163, 1072104991, 1072448455, 1072751542, 1073014240, 1073236540,
+  1073418433, 1073559913, 1073660973, 1073721611, 1073741824,
+};
+
+/**
+ * @brief   Fixed-point sine of a binary angle.
+ * @details Linear interpolation within the quarter wave table results in a maximum error of about 5e-6.
+ *
+ * @param[in] angle   Binary angle.
+ *
+ * @return  The sine (@p SVC_ODOMETRY_SIN_FRACBITS fractional bits).
+ */
+static int32_t _sin(uint32_t angle)
+{
+  const uint32_t quadrant = angle >> 30;
+  uint32_t phase = angle & 0x3FFFFFFFu;
+  int32_t value;
+
+  // mirror the phase in the second and fourth quadrant
+  if (quadrant & 1) {
+    phase = 0x40000000u - phase;
+  }
+  value = _sinTable[phase >> 22];
+  if ((phase >> 22) < 256) {
+    value += (int32_t)(((int64_t)(_sinTable[(phase >> 22) + 1] - value) * (phase & 0x3FFFFFu)) >> 22);
+  }
+
+  return (quadrant & 2) ? -value : value;
+}
+
+/**
+ * @brief   Fixed-point cosine of a binary angle.
+ *
+ * @param[in] angle   Binary angle.
+ *
+ * @return  The cosine (@p SVC_ODOMETRY_SIN_FRACBITS fractional bits).
+ */
+static inline int32_t _cos(uint32_t angle)
+{
+  return _sin(angle + 0x40000000u);
+}
+
+/**
+ * @brief   Publishes the current integrator state.
+ * @details Writers are serialized by the system lock, readers detect concurrent updates by the sequence counter.
+ *
+ * @param[in] odo       The service object.
+ * @param[in] linear    Linear velocity in micrometers per second.
+ * @param[in] angular   Angular velocity in microradians per second.
+ * @param[in] timestamp Uptime of the underlying encoder capture.
+ */
+static void _publishI(svc_odometry_t* odo, int32_t linear, int32_t angular, aos_timestamp_t timestamp)
+{
+  ++odo->sequence;
+  _seqBarrier();
+  odo->pose.x = (int32_t)(odo->state.x >> SVC_ODOMETRY_POSITION_FRACBITS);
+  odo->pose.y = (int32_t)(odo->state.y >> SVC_ODOMETRY_POSITION_FRACBITS);
+  odo->pose.theta = odo->state.theta;
+  odo->pose.linear = linear;
+  odo->pose.angular = angular;
+  odo->pose.timestamp = timestamp;
+  _seqBarrier();
+  ++odo->sequence;
+
+  return;
+}
+
+/**
+ * @brief   Integration step.
+ *
+ * @param[in] par   Pointer to the service object.
+ */
+static void _integrateCb(void* par)
+{
+  svc_odometry_t* odo = (svc_odometry_t*)par;
+  aos_qeicapture_t capture[2];
+  int64_t distance[2];
+  int64_t ds;
+  int32_t dtheta;
+  int32_t velocity[2];
+  int32_t linear, angular;
+  uint32_t heading;
+
+  chSysLockFromISR();
+
+  if (!odo->running) {
+    chSysUnlockFromISR();
+    return;
+  }
+  chVTSetI(&odo->timer, odo->config->period, _integrateCb, odo);
+
+  // wheel distances since the last step
+  aosQeiCaptureMultipleI(odo->config->qei, capture, 2);
+  for (size_t w = 0; w < 2; ++w) {
+    distance[w] = (int64_t)(capture[w].position - odo->state.last[w].position) * odo->umperinc;
+    velocity[w] = qeiGetVelocityI(odo->config->qei[w]);
+  }
+
+  // encoder based estimates
+  ds = (distance[0] + distance[1]) / 2;
+  dtheta = (int32_t)(((distance[1] - distance[0]) * odo->bamperum) >> (2 * SVC_ODOMETRY_POSITION_FRACBITS));
+  linear = (int32_t)((((int64_t)velocity[0] + velocity[1]) * odo->umperinc) >> (QEI_VELOCITY_FRACBITS + SVC_ODOMETRY_POSITION_FRACBITS + 1));
+  angular = (int32_t)((((((int64_t)velocity[1] - velocity[0]) * odo->umperinc) >> (QEI_VELOCITY_FRACBITS + SVC_ODOMETRY_POSITION_FRACBITS)) * 1000000) / odo->wheelbase);
+
+  // fuse the heading with the gyroscope if a recent measurement is available
+  if (odo->gyroweight > 0 && odo->gyro.timestamp > 0 && (capture[0].uptime - odo->gyro.timestamp) <= odo->config->gyrotimeout) {
+    const aos_interval_t dt = (aos_interval_t)(capture[0].uptime - odo->state.last[0].uptime);
+    const int32_t dthetagyro = (int32_t)(((int64_t)odo->gyro.rate * dt * SVC_ODOMETRY_BAMPERURADUS) >> 24);
+    dtheta += (int32_t)(((int64_t)(dthetagyro - dtheta) * odo->gyroweight) >> SVC_ODOMETRY_WEIGHT_FRACBITS);
+    angular += (int32_t)(((int64_t)(odo->gyro.rate - angular) * odo->gyroweight) >> SVC_ODOMETRY_WEIGHT_FRACBITS);
+    ++odo->stats.fused;
+  }
+
+  // integrate along the mean heading of the step (second order Runge-Kutta)
+  heading = odo->state.theta + (uint32_t)(dtheta / 2);
+  odo->state.x += (ds * _cos(heading)) >> SVC_ODOMETRY_SIN_FRACBITS;
+  odo->state.y += (ds * _sin(heading)) >> SVC_ODOMETRY_SIN_FRACBITS;
+  odo->state.theta += (uint32_t)dtheta;
+  odo->state.last[0] = capture[0];
+  odo->state.last[1] = capture[1];
+  ++odo->stats.updates;
+
+  _publishI(odo, linear, angular, capture[0].uptime);
+
+  chSysUnlockFromISR();
+
+  return;
+}
+
+/**
+ * @brief   Initializes an odometry service object.
+ *
+ * @param[in] odo     The service object to initialize.
+ * @param[in] config  Configuration.
+ */
+void svcOdometryInit(svc_odometry_t* odo, const svc_odometry_config_t* config)
+{
+  aosDbgCheck(odo != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->qei[0] != NULL && config->qei[1] != NULL);
+  aosDbgCheck(config->period > 0);
+  aosDbgCheck(config->increments > 0 && config->wheeldiameter > 0.0f && config->wheelbase > 0.0f);
+  aosDbgCheck(config->gyroweight >= 0.0f && config->gyroweight <= 1.0f);
+
+  memset(odo, 0, sizeof(svc_odometry_t));
+  odo->config = config;
+  odo->umperinc = (uint32_t)(config->wheeldiameter * 1e6f * 3.14159265f / (float)config->increments * (1 << SVC_ODOMETRY_POSITION_FRACBITS) + 0.5f);
+  odo->bamperum = (uint32_t)(4294967296.0f / (2.0f * 3.14159265f * config->wheelbase * 1e6f) * (1 << SVC_ODOMETRY_POSITION_FRACBITS) + 0.5f);
+  odo->wheelbase = (uint32_t)(config->wheelbase * 1e6f + 0.5f);
+  odo->gyroweight = (uint32_t)(config->gyroweight * (1 << SVC_ODOMETRY_WEIGHT_FRACBITS) + 0.5f);
+  chVTObjectInit(&odo->timer);
+  odo->running = false;
+
+  return;
+}
+
+/**
+ * @brief   Starts the integration.
+ * @note    The encoders must have been enabled before.
+ *
+ * @param[in] odo   The service object.
+ */
+void svcOdometryStart(svc_odometry_t* odo)
+{
+  aosDbgCheck(odo != NULL);
+  aosDbgAssert(!odo->running);
+
+  chSysLock();
+  aosQeiCaptureMultipleI(odo->config->qei, odo->state.last, 2);
+  odo->running = true;
+  chVTSetI(&odo->timer, odo->config->period, _integrateCb, odo);
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Stops the integration.
+ *
+ * @param[in] odo   The service object.
+ */
+void svcOdometryStop(svc_odometry_t* odo)
+{
+  aosDbgCheck(odo != NULL);
+
+  chSysLock();
+  odo->running = false;
+  chVTResetI(&odo->timer);
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] odo   The service object.
+ */
+void svcOdometryTeardown(void* odo)
+{
+  svcOdometryStop((svc_odometry_t*)odo);
+
+  return;
+}
+
+/**
+ * @brief   Overwrites the current pose.
+ *
+ * @param[in] odo     The service object.
+ * @param[in] x       X position in micrometers.
+ * @param[in] y       Y position in micrometers.
+ * @param[in] theta   Heading as binary angle.
+ */
+void svcOdometrySetPose(svc_odometry_t* odo, int32_t x, int32_t y, uint32_t theta)
+{
+  aosDbgCheck(odo != NULL);
+
+  chSysLock();
+  odo->state.x = (int64_t)x << SVC_ODOMETRY_POSITION_FRACBITS;
+  odo->state.y = (int64_t)y << SVC_ODOMETRY_POSITION_FRACBITS;
+  odo->state.theta = theta;
+  _publishI(odo, odo->pose.linear, odo->pose.angular, odo->pose.timestamp);
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Feeds a yaw rate measurement of a gyroscope.
+ *
+ * @param[in] odo         The service object.
+ * @param[in] rate        Yaw rate in microradians per second (counterclockwise).
+ * @param[in] timestamp   Uptime of the measurement.
+ */
+void svcOdometrySetYawRateI(svc_odometry_t* odo, int32_t rate, aos_timestamp_t timestamp)
+{
+  aosDbgCheck(odo != NULL);
+
+  odo->gyro.rate = rate;
+  odo->gyro.timestamp = timestamp;
+
+  return;
+}
+
+/**
+ * @brief   Retrieves the most recent pose estimate without locking.
+ * @details The copy is retried if it was interrupted by an update.
+ * @note    Must not be called from an ISR which may preempt the integration step.
+ *
+ * @param[in]  odo    The service object.
+ * @param[out] pose   Pointer to store the pose to.
+ */
+void svcOdometryGetPose(svc_odometry_t* odo, svc_odometry_pose_t* pose)
+{
+  aosDbgCheck(odo != NULL);
+  aosDbgCheck(pose != NULL);
+
+  uint32_t sequence;
+
+  do {
+    sequence = odo->sequence;
+    _seqBarrier();
+    *pose = odo->pose;
+    _seqBarrier();
+  } while ((sequence & 1) || sequence != odo->sequence);
+
+  return;
+}
+
+/**
+ * @brief   Shell command to print the pose estimate.
+ *
+ * @param[in] odo     The service object.
+ * @param[in] stream  Stream for input/output.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return  An exit status.
+ */
+int svcOdometryShellCmd(svc_odometry_t* odo, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(odo != NULL);
+  aosDbgCheck(stream != NULL);
+
+  svc_odometry_pose_t pose;
+  aos_timestamp_t uptime;
+
+  if (argc == 2 && (strcmp(argv[1], "--reset") == 0 || strcmp(argv[1], "-r") == 0)) {
+    svcOdometrySetPose(odo, 0, 0, 0);
+    return AOS_OK;
+  } else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the current pose estimate.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --reset, -r\n");
+    chprintf(stream, "    Reset the pose to the origin.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  svcOdometryGetPose(odo, &pose);
+  aosSysGetUptime(&uptime);
+  chprintf(stream, "position: %.1fmm, %.1fmm\n", pose.x / 1e3f, pose.y / 1e3f);
+  chprintf(stream, "heading:  %.2fdeg\n", SVC_ODOMETRY_BAM2RAD(pose.theta) * (180.0f / 3.14159265f));
+  chprintf(stream, "velocity: %dmm/s, %.3frad/s\n", pose.linear / 1000, pose.angular / 1e6f);
+  chprintf(stream, "age:      %uus\n", (uint32_t)(uptime - pose.timestamp));
+  chprintf(stream, "updates:  %u (%u fused with gyroscope)\n", odo->stats.updates, odo->stats.fused);
+
+  return AOS_OK;
+}
+
+#endif /* (HAL_USE_QEI == TRUE) && (QEI_USE_EXTENDED_POSITION == TRUE) && (QEI_USE_VELOCITY == TRUE) */
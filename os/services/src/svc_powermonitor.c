@@ -0,0 +1,389 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_powermonitor.h>
+
+#if defined(AMIROLLD_CFG_USE_INA219) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <aos_thread.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Register indices of the INA219 register set as stored in the snapshot.
+ */
+#define INA219_REGIDX_BUSVOLTAGE      2
+#define INA219_REGIDX_POWER           3
+#define INA219_REGIDX_CURRENT         4
+
+/**
+ * @brief   Resets the statistics of the current window of a rail.
+ *
+ * @param[in] rail  The rail to reset.
+ */
+static inline void _resetAccu(svc_powermonitor_rail_t* rail)
+{
+  rail->accu.min = ~0;
+  rail->accu.max = 0;
+  rail->accu.sum = 0;
+  rail->accu.n = 0;
+
+  return;
+}
+
+/**
+ * @brief   Samples a single rail and updates its energy counter and statistics.
+ *
+ * @param[in] pm    The power monitor.
+ * @param[in] rail  The rail to sample.
+ */
+static void _sample(svc_powermonitor_t* pm, svc_powermonitor_rail_t* rail)
+{
+  uint16_t regs[6];
+  aos_timestamp_t t;
+
+  // read the register set (shares the bus transaction with any other reader of the snapshot)
+  if (aosSnapshotRead(rail->snapshot, regs, pm->interval / 2, &t) != APAL_STATUS_SUCCESS) {
+    chMtxLock(&pm->lock);
+    ++rail->errors;
+    chMtxUnlock(&pm->lock);
+    return;
+  }
+  // no new data
+  if (t == rail->last.timestamp) {
+    return;
+  }
+
+  chMtxLock(&pm->lock);
+
+  // convert raw register values
+  const uint32_t power = (uint32_t)regs[INA219_REGIDX_POWER] * 20 * rail->driver->current_lsb_uA;
+  rail->last.voltage = (uint32_t)(regs[INA219_REGIDX_BUSVOLTAGE] >> 3) * 4000;
+  rail->last.current = (int32_t)(int16_t)regs[INA219_REGIDX_CURRENT] * (int32_t)rail->driver->current_lsb_uA;
+
+  // integrate energy
+  if (rail->last.timestamp != 0) {
+    rail->energy.remainder += (uint64_t)power * (t - rail->last.timestamp);
+    rail->energy.uwh += rail->energy.remainder / SVC_POWERMONITOR_UWUS_PER_UWH;
+    rail->energy.remainder %= SVC_POWERMONITOR_UWUS_PER_UWH;
+  }
+  rail->last.power = power;
+  rail->last.timestamp = t;
+
+  // update window statistics
+  if (power < rail->accu.min) {
+    rail->accu.min = power;
+  }
+  if (power > rail->accu.max) {
+    rail->accu.max = power;
+  }
+  rail->accu.sum += power;
+  ++rail->accu.n;
+
+  chMtxUnlock(&pm->lock);
+
+  return;
+}
+
+/**
+ * @brief   Completes the current statistics window of all rails.
+ *
+ * @param[in] pm  The power monitor.
+ */
+static void _completeWindow(svc_powermonitor_t* pm)
+{
+  chMtxLock(&pm->lock);
+  for (size_t r = 0; r < pm->numrails; ++r) {
+    svc_powermonitor_rail_t* rail = &pm->rails[r];
+    if (rail->accu.n > 0) {
+      rail->window.min = rail->accu.min;
+      rail->window.max = rail->accu.max;
+      rail->window.mean = (uint32_t)(rail->accu.sum / rail->accu.n);
+    } else {
+      rail->window.min = 0;
+      rail->window.max = 0;
+      rail->window.mean = 0;
+    }
+    rail->window.samples = rail->accu.n;
+    _resetAccu(rail);
+  }
+  pm->windowstart += pm->windowlength;
+  chMtxUnlock(&pm->lock);
+
+  return;
+}
+
+/**
+ * @brief   Power monitor sampling thread.
+ * @details Samples one rail per interval in round-robin order.
+ *
+ * @param[in] pm  The power monitor.
+ */
+static THD_FUNCTION(_svcPowerMonitorThread, pm)
+{
+  svc_powermonitor_t* const p = (svc_powermonitor_t*)pm;
+  size_t rail = 0;
+  aos_timestamp_t next;
+  aos_timestamp_t uptime;
+
+  chRegSetThreadName("powermonitor");
+
+  aosSysGetUptime(&next);
+  p->windowstart = next;
+
+  while (!chThdShouldTerminateX()) {
+    _sample(p, &p->rails[rail]);
+    rail = (rail + 1) % p->numrails;
+
+    aosSysGetUptime(&uptime);
+    if (uptime - p->windowstart >= p->windowlength) {
+      _completeWindow(p);
+    }
+
+    // resynchronize if sampling fell behind for more than one interval
+    next += p->interval;
+    if (uptime > next + p->interval) {
+      next = uptime;
+    }
+    chSysLock();
+    aosThdSleepUntilS(&next);
+    chSysUnlock();
+  }
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes a power monitor object.
+ *
+ * @param[in] pm            The power monitor to initialize.
+ * @param[in] rails         Array of rails to monitor.
+ * @param[in] numrails      Number of rails.
+ * @param[in] interval      Interval between two samples (of any rail) in microseconds.
+ * @param[in] windowlength  Length of a statistics window in microseconds.
+ * @param[in] timeout       I2C timeout in microseconds.
+ */
+void svcPowerMonitorInit(svc_powermonitor_t* pm, svc_powermonitor_rail_t* rails, size_t numrails, aos_interval_t interval, aos_interval_t windowlength, apalTime_t timeout)
+{
+  aosDbgCheck(pm != NULL);
+  aosDbgCheck(rails != NULL && numrails > 0);
+  aosDbgCheck(interval > 0);
+  aosDbgCheck(windowlength >= interval * numrails);
+
+  pm->rails = rails;
+  pm->numrails = numrails;
+  pm->interval = interval;
+  pm->windowlength = windowlength;
+  pm->windowstart = 0;
+  pm->timeout = timeout;
+  chMtxObjectInit(&pm->lock);
+  pm->thread = NULL;
+  for (size_t r = 0; r < numrails; ++r) {
+    aosDbgCheck(rails[r].driver != NULL && rails[r].snapshot != NULL);
+    memset(&rails[r].last, 0, sizeof(rails[r].last));
+    memset(&rails[r].energy, 0, sizeof(rails[r].energy));
+    memset(&rails[r].window, 0, sizeof(rails[r].window));
+    rails[r].errors = 0;
+    _resetAccu(&rails[r]);
+  }
+
+  return;
+}
+
+/**
+ * @brief   Configures hardware averaging and calibration of all INA219 devices.
+ * @details The devices are set to continuous conversion with 16 samples averaging.
+ *
+ * @param[in] pm  The power monitor.
+ *
+ * @return  The accumulated status of all I2C transactions.
+ */
+apalExitStatus_t svcPowerMonitorConfigure(svc_powermonitor_t* pm)
+{
+  aosDbgCheck(pm != NULL);
+
+  apalExitStatus_t status = APAL_STATUS_SUCCESS;
+  ina219_lld_cfg_t cfg;
+  ina219_lld_calib_input_t calib_in;
+  ina219_lld_calib_output_t calib_out;
+
+  cfg.data = SVC_POWERMONITOR_INA219_CONFIG;
+  for (size_t r = 0; r < pm->numrails; ++r) {
+    svc_powermonitor_rail_t* rail = &pm->rails[r];
+    calib_in.shunt_resistance_0 = rail->shunt;
+    calib_in.max_expected_current_A = rail->maxcurrent;
+    calib_in.current_lsb_uA = SVC_POWERMONITOR_CURRENT_LSB_UA;
+    calib_in.cfg_reg = cfg;
+    status |= ina219_lld_write_config(rail->driver, cfg, pm->timeout);
+    status |= ina219_lld_calibration(rail->driver, &calib_in, &calib_out);
+    status |= ina219_lld_write_calibration(rail->driver, calib_out.calibration & 0xFFFEu, pm->timeout);
+    rail->driver->current_lsb_uA = SVC_POWERMONITOR_CURRENT_LSB_UA;
+    // the cached register set is outdated now
+    aosSnapshotInvalidate(rail->snapshot);
+  }
+
+  return status;
+}
+
+/**
+ * @brief   Starts the sampling thread.
+ *
+ * @param[in] pm      The power monitor.
+ * @param[in] wa      Working area for the thread.
+ * @param[in] wasize  Size of the working area.
+ * @param[in] prio    Priority of the thread.
+ */
+void svcPowerMonitorStart(svc_powermonitor_t* pm, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(pm != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(pm->thread == NULL);
+
+  pm->thread = chThdCreateStatic(wa, wasize, prio, _svcPowerMonitorThread, pm);
+
+  return;
+}
+
+/**
+ * @brief   Stops the sampling thread.
+ *
+ * @param[in] pm  The power monitor.
+ */
+void svcPowerMonitorStop(svc_powermonitor_t* pm)
+{
+  aosDbgCheck(pm != NULL);
+
+  if (pm->thread != NULL) {
+    chThdTerminate(pm->thread);
+    chThdWait(pm->thread);
+    pm->thread = NULL;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] pm  The power monitor.
+ */
+void svcPowerMonitorTeardown(void* pm)
+{
+  svcPowerMonitorStop((svc_powermonitor_t*)pm);
+
+  return;
+}
+
+/**
+ * @brief   Retrieves a consistent copy of the data of a rail.
+ *
+ * @param[in]  pm     The power monitor.
+ * @param[in]  rail   Index of the rail.
+ * @param[out] dst    Object to copy the data to.
+ */
+void svcPowerMonitorGetRail(svc_powermonitor_t* pm, size_t rail, svc_powermonitor_rail_t* dst)
+{
+  aosDbgCheck(pm != NULL);
+  aosDbgCheck(rail < pm->numrails);
+  aosDbgCheck(dst != NULL);
+
+  chMtxLock(&pm->lock);
+  memcpy(dst, &pm->rails[rail], sizeof(svc_powermonitor_rail_t));
+  chMtxUnlock(&pm->lock);
+
+  return;
+}
+
+/**
+ * @brief   Resets the energy counters of all rails.
+ *
+ * @param[in] pm  The power monitor.
+ */
+void svcPowerMonitorResetEnergy(svc_powermonitor_t* pm)
+{
+  aosDbgCheck(pm != NULL);
+
+  chMtxLock(&pm->lock);
+  for (size_t r = 0; r < pm->numrails; ++r) {
+    pm->rails[r].energy.uwh = 0;
+    pm->rails[r].energy.remainder = 0;
+  }
+  chMtxUnlock(&pm->lock);
+
+  return;
+}
+
+/**
+ * @brief   Shell command implementation to print and reset power monitor data.
+ *
+ * @param[in] pm      The power monitor.
+ * @param[in] stream  The I/O stream to use.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+int svcPowerMonitorShellCmd(svc_powermonitor_t* pm, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(pm != NULL);
+  aosDbgCheck(stream != NULL);
+
+  svc_powermonitor_rail_t rail;
+
+  if (argc == 2 && (strcmp(argv[1], "--reset") == 0 || strcmp(argv[1], "-r") == 0)) {
+    svcPowerMonitorResetEnergy(pm);
+    chprintf(stream, "energy counters reset\n");
+    return AOS_OK;
+  }
+  else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the current measurements, the statistics of the last window and the consumed energy of all rails.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --reset, -r\n");
+    chprintf(stream, "    Reset all energy counters.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  chprintf(stream, "window: %ums, %u rails sampled every %ums\n",
+           pm->windowlength / MICROSECONDS_PER_MILLISECOND, pm->numrails, (pm->interval * pm->numrails) / MICROSECONDS_PER_MILLISECOND);
+  chprintf(stream, "%-8s%10s%10s%10s%10s%10s%10s%12s%8s\n", "rail", "U [V]", "I [mA]", "P [mW]", "min [mW]", "avg [mW]", "max [mW]", "E [mWh]", "errors");
+  for (size_t r = 0; r < pm->numrails; ++r) {
+    svcPowerMonitorGetRail(pm, r, &rail);
+    chprintf(stream, "%-8s%10.3f%10.2f%10.2f%10.2f%10.2f%10.2f%12.3f%8u\n",
+             rail.name,
+             (float)rail.last.voltage / 1000000.0f,
+             (float)rail.last.current / 1000.0f,
+             (float)rail.last.power / 1000.0f,
+             (float)rail.window.min / 1000.0f,
+             (float)rail.window.mean / 1000.0f,
+             (float)rail.window.max / 1000.0f,
+             svcPowerMonitorEnergyMWh(&rail),
+             rail.errors);
+  }
+
+  return AOS_OK;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_INA219) */
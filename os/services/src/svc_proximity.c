@@ -0,0 +1,356 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_proximity.h>
+
+#if (defined(AMIROLLD_CFG_USE_VCNL4020) && defined(AMIROLLD_CFG_USE_PCA9544A)) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <aos_thread.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Event ID of the interrupt listener.
+ */
+#define INTERRUPT_EVENTID             0
+
+/**
+ * @brief   Proximity data ready flag of the VCNL4020 interrupt control and status registers.
+ */
+#define VCNL4020_INT_PROXREADY        0x08u
+
+/**
+ * @brief   All flags of the VCNL4020 interrupt status register.
+ */
+#define VCNL4020_INTSTATUS_ALL        0x0Fu
+
+/**
+ * @brief   Selects the multiplexer channel of a sensor.
+ * @details The bus transaction is skipped if the channel is already selected.
+ *
+ * @param[in] prox    The proximity service.
+ * @param[in] sensor  Index of the sensor.
+ *
+ * @return  The status of the I2C transaction.
+ */
+static apalExitStatus_t _select(svc_proximity_t* prox, uint8_t sensor)
+{
+  const pca9544a_lld_chid_t channel = prox->config->sensors[sensor].channel;
+  apalExitStatus_t status = APAL_STATUS_SUCCESS;
+
+  if (prox->channel != channel) {
+    status = pca9544a_lld_setchannel(prox->config->mux, channel, prox->config->timeout);
+    // force a new selection on the next access if the state of the multiplexer is unknown
+    prox->channel = (status == APAL_STATUS_SUCCESS) ? channel : PCA9544A_LLD_CH_NONE;
+  }
+
+  return status;
+}
+
+/**
+ * @brief   Starts or stops the self-timed measurements and the data ready interrupt of all sensors.
+ *
+ * @param[in] prox    The proximity service.
+ * @param[in] enable  Flag whether to start or stop the sensors.
+ *
+ * @return  The accumulated status of all I2C transactions.
+ */
+static apalExitStatus_t _configure(svc_proximity_t* prox, bool enable)
+{
+  const svc_proximity_config_t* const cfg = prox->config;
+  apalExitStatus_t status = APAL_STATUS_SUCCESS;
+
+  for (uint8_t s = 0; s < cfg->numsensors; ++s) {
+    status |= _select(prox, s);
+    // the measurement rate can only be changed while self-timed measurements are disabled
+    status |= vcnl4020_lld_writereg(cfg->driver, VCNL4020_LLD_REGADDR_CMD, 0, cfg->timeout);
+    if (enable) {
+      status |= vcnl4020_lld_writereg(cfg->driver, VCNL4020_LLD_REGADDR_PROXRATE, cfg->proxrate, cfg->timeout);
+      status |= vcnl4020_lld_writereg(cfg->driver, VCNL4020_LLD_REGADDR_INTCTRL, VCNL4020_INT_PROXREADY, cfg->timeout);
+      status |= vcnl4020_lld_writereg(cfg->driver, VCNL4020_LLD_REGADDR_INTSTATUS, VCNL4020_INTSTATUS_ALL, cfg->timeout);
+      status |= vcnl4020_lld_writereg(cfg->driver, VCNL4020_LLD_REGADDR_CMD, (VCNL4020_LLD_CMDREG_ALSEN | VCNL4020_LLD_CMDREG_PROXEN | VCNL4020_LLD_CMDREG_SELFTIMED), cfg->timeout);
+    } else {
+      status |= vcnl4020_lld_writereg(cfg->driver, VCNL4020_LLD_REGADDR_INTCTRL, 0, cfg->timeout);
+      status |= vcnl4020_lld_writereg(cfg->driver, VCNL4020_LLD_REGADDR_INTSTATUS, VCNL4020_INTSTATUS_ALL, cfg->timeout);
+    }
+  }
+
+  return status;
+}
+
+/**
+ * @brief   Reads all sensors with pending proximity data.
+ * @details The sensors are visited in round-robin order, starting with a different sensor each round, so no sensor is
+ *          favored if the bus is saturated.
+ *
+ * @param[in] prox  The proximity service.
+ *
+ * @return  Event flags of all updated sensors.
+ */
+static eventflags_t _round(svc_proximity_t* prox)
+{
+  const svc_proximity_config_t* const cfg = prox->config;
+  eventflags_t updated = 0;
+  apalExitStatus_t status;
+  uint8_t intstatus;
+  uint16_t ambient, proximity;
+  aos_timestamp_t t;
+
+  for (uint8_t i = 0; i < cfg->numsensors; ++i) {
+    const uint8_t s = (prox->next + i) % cfg->numsensors;
+    status = _select(prox, s);
+    status |= vcnl4020_lld_readreg(cfg->driver, VCNL4020_LLD_REGADDR_INTSTATUS, &intstatus, cfg->timeout);
+    if (status != APAL_STATUS_SUCCESS) {
+      ++prox->stats.errors;
+      continue;
+    }
+    if (!(intstatus & VCNL4020_INT_PROXREADY)) {
+      continue;
+    }
+
+    // acknowledge before reading, so a measurement which completes meanwhile triggers a new interrupt
+    status = vcnl4020_lld_writereg(cfg->driver, VCNL4020_LLD_REGADDR_INTSTATUS, intstatus, cfg->timeout);
+    status |= vcnl4020_lld_readalsandprox(cfg->driver, &ambient, &proximity, cfg->timeout);
+    aosSysGetUptime(&t);
+    if (status != APAL_STATUS_SUCCESS) {
+      ++prox->stats.errors;
+      continue;
+    }
+
+    chMtxLock(&prox->lock);
+    prox->readings[s].proximity = proximity;
+    prox->readings[s].ambient = ambient;
+    if (cfg->ambientfactor > 0) {
+      const uint32_t offset = ((uint32_t)ambient * cfg->ambientfactor) >> 8;
+      prox->readings[s].compensated = (proximity > offset) ? (uint16_t)(proximity - offset) : 0;
+    } else {
+      prox->readings[s].compensated = proximity;
+    }
+    prox->readings[s].timestamp = t;
+    ++prox->stats.readings;
+    chMtxUnlock(&prox->lock);
+    updated |= SVC_PROXIMITY_EVENTFLAG_SENSOR(s);
+  }
+  prox->next = (prox->next + 1) % cfg->numsensors;
+  ++prox->stats.rounds;
+
+  return updated;
+}
+
+/**
+ * @brief   Proximity thread.
+ * @details Sleeps until the interrupt signals new data or the watchdog expires.
+ *
+ * @param[in] prox  The proximity service.
+ */
+static THD_FUNCTION(_svcProximityThread, prox)
+{
+  svc_proximity_t* const p = (svc_proximity_t*)prox;
+  const svc_proximity_config_t* const cfg = p->config;
+  event_listener_t listener;
+  eventflags_t updated;
+
+  chRegSetThreadName("proximity");
+
+  chEvtRegisterMaskWithFlags(cfg->intsource, &listener, EVENT_MASK(INTERRUPT_EVENTID), cfg->intflags);
+  p->channel = PCA9544A_LLD_CH_NONE;
+  if (_configure(p, true) != APAL_STATUS_SUCCESS) {
+    ++p->stats.errors;
+  }
+  aosIntEnable(cfg->intdriver, cfg->intchannel);
+  aosSysGetUptime(&p->started);
+
+  while (!chThdShouldTerminateX()) {
+    // the line is shared among all sensors (and possibly other signals), so the flags carry no further information
+    if (chEvtWaitAnyTimeout(EVENT_MASK(INTERRUPT_EVENTID), TIME_US2I(cfg->watchdog)) == 0) {
+      ++p->stats.timeouts;
+    }
+    chEvtGetAndClearFlags(&listener);
+
+    // a sensor which became ready during a round keeps the line asserted without generating a new edge
+    for (uint8_t round = 0; round <= cfg->numsensors; ++round) {
+      updated = _round(p);
+      if (updated == 0) {
+        break;
+      }
+      chEvtBroadcastFlags(&p->source, updated);
+    }
+  }
+
+  aosIntDisable(cfg->intdriver, cfg->intchannel);
+  chEvtUnregister(cfg->intsource, &listener);
+  if (_configure(p, false) != APAL_STATUS_SUCCESS) {
+    ++p->stats.errors;
+  }
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes a proximity service object.
+ *
+ * @param[in] prox    The proximity service to initialize.
+ * @param[in] config  The configuration to use.
+ */
+void svcProximityInit(svc_proximity_t* prox, const svc_proximity_config_t* config)
+{
+  aosDbgCheck(prox != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->mux != NULL && config->driver != NULL);
+  aosDbgCheck(config->sensors != NULL && config->numsensors > 0 && config->numsensors <= SVC_PROXIMITY_MAXSENSORS);
+  aosDbgCheck(config->intdriver != NULL && config->intsource != NULL);
+  aosDbgCheck(config->watchdog > 0);
+
+  prox->config = config;
+  memset(prox->readings, 0, sizeof(prox->readings));
+  prox->next = 0;
+  prox->channel = PCA9544A_LLD_CH_NONE;
+  chMtxObjectInit(&prox->lock);
+  chEvtObjectInit(&prox->source);
+  prox->started = 0;
+  memset(&prox->stats, 0, sizeof(prox->stats));
+  prox->thread = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Configures the sensors and starts the proximity thread.
+ *
+ * @param[in] prox    The proximity service.
+ * @param[in] wa      Working area for the thread.
+ * @param[in] wasize  Size of the working area.
+ * @param[in] prio    Priority of the thread.
+ */
+void svcProximityStart(svc_proximity_t* prox, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(prox != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(prox->thread == NULL);
+
+  memset(&prox->stats, 0, sizeof(prox->stats));
+  prox->thread = chThdCreateStatic(wa, wasize, prio, _svcProximityThread, prox);
+
+  return;
+}
+
+/**
+ * @brief   Stops the proximity thread and the self-timed measurements of all sensors.
+ * @details Returns after the watchdog interval at most.
+ *
+ * @param[in] prox  The proximity service.
+ */
+void svcProximityStop(svc_proximity_t* prox)
+{
+  aosDbgCheck(prox != NULL);
+
+  if (prox->thread != NULL) {
+    chThdTerminate(prox->thread);
+    chThdWait(prox->thread);
+    prox->thread = NULL;
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] prox  The proximity service.
+ */
+void svcProximityTeardown(void* prox)
+{
+  svcProximityStop((svc_proximity_t*)prox);
+
+  return;
+}
+
+/**
+ * @brief   Retrieves a consistent copy of the readings of all sensors.
+ *
+ * @param[in]  prox       The proximity service.
+ * @param[out] readings   Array to copy the readings to (must hold as many elements as sensors are configured).
+ */
+void svcProximityGetReadings(svc_proximity_t* prox, svc_proximity_reading_t* readings)
+{
+  aosDbgCheck(prox != NULL);
+  aosDbgCheck(readings != NULL);
+
+  chMtxLock(&prox->lock);
+  memcpy(readings, prox->readings, prox->config->numsensors * sizeof(svc_proximity_reading_t));
+  chMtxUnlock(&prox->lock);
+
+  return;
+}
+
+/**
+ * @brief   Shell command implementation to print the proximity readings.
+ *
+ * @param[in] prox    The proximity service.
+ * @param[in] stream  The I/O stream to use.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+int svcProximityShellCmd(svc_proximity_t* prox, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(prox != NULL);
+  aosDbgCheck(stream != NULL);
+
+  const svc_proximity_config_t* const cfg = prox->config;
+  svc_proximity_reading_t readings[SVC_PROXIMITY_MAXSENSORS];
+  aos_timestamp_t uptime;
+
+  if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the most recent readings of all proximity sensors and the achieved sample rate.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  svcProximityGetReadings(prox, readings);
+  aosSysGetUptime(&uptime);
+  chprintf(stream, "%-8s%12s%12s%12s%10s\n", "sensor", "proximity", "ambient", "compensated", "age [ms]");
+  for (uint8_t s = 0; s < cfg->numsensors; ++s) {
+    chprintf(stream, "%-8s%12u%12u%12u%10u\n",
+             cfg->sensors[s].name,
+             readings[s].proximity,
+             readings[s].ambient,
+             readings[s].compensated,
+             (readings[s].timestamp != 0) ? (uint32_t)((uptime - readings[s].timestamp) / MICROSECONDS_PER_MILLISECOND) : 0);
+  }
+  if (prox->thread != NULL && uptime > prox->started) {
+    chprintf(stream, "%.1f readings per second and sensor, %u rounds, %u watchdog timeouts, %u errors\n",
+             ((float)prox->stats.readings * (float)MICROSECONDS_PER_SECOND) / ((float)(uptime - prox->started) * (float)cfg->numsensors),
+             prox->stats.rounds, prox->stats.timeouts, prox->stats.errors);
+  } else {
+    chprintf(stream, "service not running\n");
+  }
+
+  return AOS_OK;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_VCNL4020) && defined(AMIROLLD_CFG_USE_PCA9544A) */
@@ -0,0 +1,277 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <svc_settings.h>
+
+#if defined(AMIROLLD_CFG_USE_AT24C01BN) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief   Shell configuration flags which are persisted.
+ */
+#define SHELL_CONFIG_MASK             (AOS_SHELL_CONFIG_INPUT_OVERWRITE | AOS_SHELL_CONFIG_PROMPT_MINIMAL | \
+                                       AOS_SHELL_CONFIG_PROMPT_UPTIME | AOS_SHELL_CONFIG_PROMPT_DATETIME |  \
+                                       AOS_SHELL_CONFIG_MATCH_CASE)
+
+/**
+ * @brief   Read callback of the storage backend.
+ */
+static bool _read(void* arg, size_t address, uint8_t* buffer, size_t length)
+{
+  return svcEepromRead((svc_eeprom_t*)arg, address, buffer, length) == APAL_STATUS_SUCCESS;
+}
+
+/**
+ * @brief   Write callback of the storage backend.
+ * @details The record is written to the cache and flushed asynchronously with a single page write.
+ */
+static bool _write(void* arg, size_t address, const uint8_t* data, size_t length)
+{
+  return svcEepromWrite((svc_eeprom_t*)arg, address, data, length) == APAL_STATUS_SUCCESS;
+}
+
+/**
+ * @brief   Packs a date and time into 32 bits.
+ * @details The fields are ordered from the most to the least significant, so packed values compare chronologically:
+ *          [year-2000:6] [month:4] [day:5] [hour:5] [minute:6] [second:6]
+ *
+ * @param[in] dt  The date and time to pack.
+ *
+ * @return  The packed date and time.
+ */
+static uint32_t _packDateTime(const struct tm* dt)
+{
+  const uint32_t year = (dt->tm_year < 100) ? 0 : (dt->tm_year > 163) ? 63 : (uint32_t)(dt->tm_year - 100);
+
+  return (year << 26) | ((uint32_t)(dt->tm_mon + 1) << 22) | ((uint32_t)dt->tm_mday << 17) |
+         ((uint32_t)dt->tm_hour << 12) | ((uint32_t)dt->tm_min << 6) | (uint32_t)dt->tm_sec;
+}
+
+/**
+ * @brief   Unpacks a date and time.
+ *
+ * @param[in]  packed   The packed date and time.
+ * @param[out] dt       The unpacked date and time.
+ *
+ * @return  True if the date and time is plausible.
+ */
+static bool _unpackDateTime(const uint32_t packed, struct tm* dt)
+{
+  memset(dt, 0, sizeof(struct tm));
+  dt->tm_year = (int)(packed >> 26) + 100;
+  dt->tm_mon = (int)((packed >> 22) & 0x0F) - 1;
+  dt->tm_mday = (int)((packed >> 17) & 0x1F);
+  dt->tm_hour = (int)((packed >> 12) & 0x1F);
+  dt->tm_min = (int)((packed >> 6) & 0x3F);
+  dt->tm_sec = (int)(packed & 0x3F);
+
+  return (dt->tm_mon >= 0 && dt->tm_mon < 12 && dt->tm_mday >= 1 && dt->tm_hour < 24 && dt->tm_min < 60 && dt->tm_sec < 60);
+}
+
+/**
+ * @brief   Initializes a persistent settings service.
+ *
+ * @param[out] settings   The settings service to initialize.
+ * @param[in]  config     The configuration to use.
+ */
+void svcSettingsInit(svc_settings_t* settings, const svc_settings_config_t* config)
+{
+  aosDbgCheck(settings != NULL);
+  aosDbgCheck(config != NULL && config->eeprom != NULL);
+  aosDbgCheck(config->address + config->size <= SVC_EEPROM_SIZE);
+  aosDbgCheck(config->size >= 2 * SVC_KVSTORE_SLOTSIZE);
+
+  settings->config = config;
+  settings->backend.read = _read;
+  settings->backend.write = _write;
+  settings->backend.arg = config->eeprom;
+  svcKvStoreInit(&settings->store, &settings->backend, config->address, config->size);
+  settings->mounted = false;
+  chMtxObjectInit(&settings->lock);
+
+  return;
+}
+
+/**
+ * @brief   Mounts the store and restores the settings.
+ * @details The date and time is only restored if the clock is behind the stored value (e.g. after the backup domain lost power).
+ *
+ * @param[in] settings  The settings service.
+ */
+void svcSettingsStart(svc_settings_t* settings)
+{
+  aosDbgCheck(settings != NULL);
+
+  uint8_t value[SVC_KVSTORE_MAXVALUE];
+  struct tm dt;
+
+  chMtxLock(&settings->lock);
+  settings->mounted = svcKvStoreMount(&settings->store);
+  if (settings->mounted) {
+#if (AMIROOS_CFG_SHELL_ENABLE == true)
+    if (svcKvStoreGet(&settings->store, SVC_SETTINGS_KEY_SHELL, value, sizeof(value)) == 1) {
+      aos.shell.config = (aos.shell.config & ~SHELL_CONFIG_MASK) | (value[0] & SHELL_CONFIG_MASK);
+    }
+#endif
+    if (svcKvStoreGet(&settings->store, SVC_SETTINGS_KEY_DATETIME, value, sizeof(value)) == sizeof(uint32_t)) {
+      const uint32_t stored = (uint32_t)value[0] | ((uint32_t)value[1] << 8) | ((uint32_t)value[2] << 16) | ((uint32_t)value[3] << 24);
+      aosSysGetDateTime(&dt);
+      if (_packDateTime(&dt) < stored && _unpackDateTime(stored, &dt)) {
+        dt.tm_wday = aosTimeDayOfWeekFromDate(dt.tm_mday, dt.tm_mon+1, dt.tm_year+1900) % 7;
+        aosSysSetDateTime(&dt);
+      }
+    }
+  }
+  chMtxUnlock(&settings->lock);
+
+  return;
+}
+
+/**
+ * @brief   Stores the current date and time before shutdown.
+ * @details The EEPROM cache must be stopped afterwards to flush the record.
+ *
+ * @param[in] settings  The settings service.
+ */
+void svcSettingsStop(svc_settings_t* settings)
+{
+  aosDbgCheck(settings != NULL);
+
+  svcSettingsSave(settings);
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] settings  The settings service.
+ */
+void svcSettingsTeardown(void* settings)
+{
+  svcSettingsStop((svc_settings_t*)settings);
+
+  return;
+}
+
+/**
+ * @brief   Stores the current shell configuration and date and time.
+ * @details Values which did not change are not written.
+ *
+ * @param[in] settings  The settings service.
+ *
+ * @return  True on success.
+ */
+bool svcSettingsSave(svc_settings_t* settings)
+{
+  aosDbgCheck(settings != NULL);
+
+  uint8_t value[SVC_KVSTORE_MAXVALUE];
+  struct tm dt;
+  bool retval;
+
+  chMtxLock(&settings->lock);
+  retval = settings->mounted;
+#if (AMIROOS_CFG_SHELL_ENABLE == true)
+  value[0] = aos.shell.config & SHELL_CONFIG_MASK;
+  retval = retval && svcKvStoreSet(&settings->store, SVC_SETTINGS_KEY_SHELL, value, 1);
+#endif
+  aosSysGetDateTime(&dt);
+  const uint32_t packed = _packDateTime(&dt);
+  value[0] = (uint8_t)packed;
+  value[1] = (uint8_t)(packed >> 8);
+  value[2] = (uint8_t)(packed >> 16);
+  value[3] = (uint8_t)(packed >> 24);
+  retval = retval && svcKvStoreSet(&settings->store, SVC_SETTINGS_KEY_DATETIME, value, sizeof(uint32_t));
+  chMtxUnlock(&settings->lock);
+
+  return retval;
+}
+
+/**
+ * @brief   Shell command to inspect the persistent settings.
+ *
+ * @param[in] settings  The settings service.
+ * @param[in] stream    The I/O stream to use.
+ * @param[in] argc      Number of arguments.
+ * @param[in] argv      List of pointers to the arguments.
+ *
+ * @return  An exit status.
+ */
+int svcSettingsShellCmd(svc_settings_t* settings, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(settings != NULL);
+  aosDbgCheck(stream != NULL);
+
+  uint8_t value[SVC_KVSTORE_MAXVALUE];
+  struct tm dt;
+  int length;
+
+  if (argc == 2 && (strcmp(argv[1], "--save") == 0 || strcmp(argv[1], "-s") == 0)) {
+    return svcSettingsSave(settings) ? AOS_OK : AOS_ERROR;
+  } else if (argc == 2 && strcmp(argv[1], "--clear") == 0) {
+    chMtxLock(&settings->lock);
+    settings->mounted = svcKvStoreFormat(&settings->store);
+    chMtxUnlock(&settings->lock);
+    return settings->mounted ? AOS_OK : AOS_ERROR;
+  } else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the persistent settings.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --save, -s\n");
+    chprintf(stream, "    Store the current settings now.\n");
+    chprintf(stream, "  --clear\n");
+    chprintf(stream, "    Erase all stored settings (defaults are used after the next restart).\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  chMtxLock(&settings->lock);
+  length = svcKvStoreGet(&settings->store, SVC_SETTINGS_KEY_SHELL, value, sizeof(value));
+  if (length == 1) {
+    chprintf(stream, "shell:     0x%02X\n", value[0]);
+  } else {
+    chprintf(stream, "shell:     n/a\n");
+  }
+  length = svcKvStoreGet(&settings->store, SVC_SETTINGS_KEY_DATETIME, value, sizeof(value));
+  if (length == sizeof(uint32_t) &&
+      _unpackDateTime((uint32_t)value[0] | ((uint32_t)value[1] << 8) | ((uint32_t)value[2] << 16) | ((uint32_t)value[3] << 24), &dt)) {
+    chprintf(stream, "date/time: %02u:%02u:%02u @ %02u-%02u-%04u\n",
+             dt.tm_hour, dt.tm_min, dt.tm_sec,
+             dt.tm_mday, dt.tm_mon+1, dt.tm_year+1900);
+  } else {
+    chprintf(stream, "date/time: n/a\n");
+  }
+  chprintf(stream, "store:     %u slots @ 0x%02X, %s, sequence %u\n",
+           settings->store.numslots, settings->store.address, settings->mounted ? "mounted" : "not mounted", settings->store.sequence);
+  chprintf(stream, "records:   %u written, %u skipped, %u rescans\n",
+           settings->store.stats.writes, settings->store.stats.skipped, settings->store.stats.rescans);
+  chMtxUnlock(&settings->lock);
+
+  return AOS_OK;
+}
+
+#endif /* defined(AMIROLLD_CFG_USE_AT24C01BN) */
@@ -0,0 +1,218 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_timesync.h>
+
+#if (HAL_USE_CAN == TRUE) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Event ID of the synchronization signal listener.
+ */
+#define SYNCEVENT_ID                  0
+
+/**
+ * @brief   Time synchronization thread.
+ * @details The master publishes its uptime after each synchronization edge, while the slaves pass the received
+ *          references to the clock discipline.
+ *
+ * @param[in] sync  The time synchronization service.
+ */
+static THD_FUNCTION(_svcTimeSyncThread, sync)
+{
+  svc_timesync_t* const s = (svc_timesync_t*)sync;
+  aos_timestamp_t reference;
+
+  chRegSetThreadName("timesync");
+
+#if (AMIROOS_CFG_SSSP_MASTER == true)
+  event_listener_t listener;
+  uint8_t data[SVC_TIMESYNC_REFERENCESIZE];
+  uint32_t edges = aosSysGetSyncEdge(&reference);
+
+  chEvtRegisterMaskWithFlags(&aos.events.io, &listener, EVENT_MASK(SYNCEVENT_ID), s->config->syncflags);
+
+  while (!chThdShouldTerminateX()) {
+    chEvtWaitAny(EVENT_MASK(SYNCEVENT_ID));
+    chEvtGetAndClearFlags(&listener);
+    // both edges of the signal are reported, but only the synchronizing one is counted
+    const uint32_t edge = aosSysGetSyncEdge(&reference);
+    if (edge != edges) {
+      edges = edge;
+      for (uint8_t b = 0; b < SVC_TIMESYNC_REFERENCESIZE; ++b) {
+        data[b] = (uint8_t)(reference >> (8 * b));
+      }
+      if (svcCanBusPublish(s->config->bus, SVC_CANBUS_TOPIC_TIMESYNC, SVC_CANTX_CONTROL, data, SVC_TIMESYNC_REFERENCESIZE, TIME_IMMEDIATE) == MSG_OK) {
+        ++s->stats.references;
+      } else {
+        ++s->stats.invalid;
+      }
+    }
+  }
+
+  chEvtUnregister(&aos.events.io, &listener);
+#else
+  while (!chThdShouldTerminateX()) {
+    svc_canbus_message_t* const message = svcCanBusReceive(&s->subscription, TIME_MS2I(100));
+    if (message != NULL) {
+      if (message->length == SVC_TIMESYNC_REFERENCESIZE) {
+        reference = 0;
+        for (uint8_t b = 0; b < SVC_TIMESYNC_REFERENCESIZE; ++b) {
+          reference |= (aos_timestamp_t)message->data[b] << (8 * b);
+        }
+        aosSysSyncReference(reference);
+        ++s->stats.references;
+      } else {
+        ++s->stats.invalid;
+      }
+      svcCanBusRelease(s->config->bus, message);
+    }
+  }
+#endif
+
+  chThdExit(MSG_OK);
+}
+
+/**
+ * @brief   Initializes a time synchronization service object.
+ *
+ * @param[in] sync    The time synchronization service to initialize.
+ * @param[in] config  The configuration to use.
+ */
+void svcTimeSyncInit(svc_timesync_t* sync, const svc_timesync_config_t* config)
+{
+  aosDbgCheck(sync != NULL);
+  aosDbgCheck(config != NULL);
+  aosDbgCheck(config->bus != NULL);
+
+  sync->config = config;
+  memset(&sync->stats, 0, sizeof(sync->stats));
+  sync->thread = NULL;
+
+  return;
+}
+
+/**
+ * @brief   Subscribes the references (on slaves) and starts the thread.
+ * @details The thread should run with high priority, so the references are published and applied shortly after the
+ *          synchronization edge.
+ *
+ * @param[in] sync    The time synchronization service.
+ * @param[in] wa      Working area for the thread.
+ * @param[in] wasize  Size of the working area.
+ * @param[in] prio    Priority of the thread.
+ */
+void svcTimeSyncStart(svc_timesync_t* sync, void* wa, size_t wasize, tprio_t prio)
+{
+  aosDbgCheck(sync != NULL);
+  aosDbgCheck(wa != NULL);
+  aosDbgAssert(sync->thread == NULL);
+
+#if (AMIROOS_CFG_SSSP_MASTER != true)
+  svcCanBusSubscribe(sync->config->bus, &sync->subscription, SVC_CANBUS_TOPIC_TIMESYNC, sync->queue, sizeof(sync->queue) / sizeof(sync->queue[0]));
+#endif
+  sync->thread = chThdCreateStatic(wa, wasize, prio, _svcTimeSyncThread, sync);
+
+  return;
+}
+
+/**
+ * @brief   Stops the thread and cancels the subscription.
+ * @details Without references, slaves align their clock with the synchronization period grid.
+ *
+ * @param[in] sync  The time synchronization service.
+ */
+void svcTimeSyncStop(svc_timesync_t* sync)
+{
+  aosDbgCheck(sync != NULL);
+
+  if (sync->thread != NULL) {
+    chThdTerminate(sync->thread);
+#if (AMIROOS_CFG_SSSP_MASTER == true)
+    chEvtSignal(sync->thread, EVENT_MASK(SYNCEVENT_ID));
+#endif
+    chThdWait(sync->thread);
+    sync->thread = NULL;
+#if (AMIROOS_CFG_SSSP_MASTER != true)
+    svcCanBusUnsubscribe(sync->config->bus, &sync->subscription);
+#endif
+  }
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] sync  The time synchronization service.
+ */
+void svcTimeSyncTeardown(void* sync)
+{
+  svcTimeSyncStop((svc_timesync_t*)sync);
+
+  return;
+}
+
+/**
+ * @brief   Shell command to print the state of the time synchronization service.
+ *
+ * @param[in] sync    The time synchronization service.
+ * @param[in] stream  The I/O stream to use.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return              An exit status.
+ * @retval  AOS_OK                  The command was executed successfully.
+ * @retval  AOS_INVALID_ARGUMENTS   There was an issue with the arguments.
+ */
+int svcTimeSyncShellCmd(svc_timesync_t* sync, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(sync != NULL);
+  aosDbgCheck(stream != NULL);
+
+  aos_timestamp_t edge;
+  uint32_t edges;
+
+  if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the state of the time synchronization via CAN.\n");
+    chprintf(stream, "The clock discipline of slaves is printed by module:info.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  edges = aosSysGetSyncEdge(&edge);
+#if (AMIROOS_CFG_SSSP_MASTER == true)
+  chprintf(stream, "master: %u references published, %u failed\n", sync->stats.references, sync->stats.invalid);
+#else
+  chprintf(stream, "slave: %u references received, %u malformed\n", sync->stats.references, sync->stats.invalid);
+#endif
+  chprintf(stream, "%u synchronization edges, last at %u.%06us\n", edges,
+           (uint32_t)(edge / MICROSECONDS_PER_SECOND), (uint32_t)(edge % MICROSECONDS_PER_SECOND));
+
+  return AOS_OK;
+}
+
+#endif /* (HAL_USE_CAN == TRUE) */
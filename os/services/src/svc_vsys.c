@@ -0,0 +1,441 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <svc_vsys.h>
+
+#if (HAL_USE_ADC == TRUE) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <aos_system.h>
+#include <chprintf.h>
+#include <string.h>
+
+/**
+ * @brief   Maximum value of a 12 bit ADC sample.
+ */
+#define SVC_VSYS_ADC_MAX              ((adcsample_t)((1 << 12) - 1))
+
+/**
+ * @brief   Retrieves the service object from an ADC driver.
+ * @details The conversion group is the first member of the service object.
+ */
+#define _vsysFromDriver(adcp)         ((svc_vsys_t*)(void*)(adcp)->grpp)
+
+/**
+ * @brief   Converts a voltage in microvolts to ADC counts.
+ *
+ * @param[in] vsys  The service object.
+ * @param[in] uv    Voltage in microvolts.
+ *
+ * @return  Corresponding ADC value (saturated).
+ */
+static inline adcsample_t _uv2adc(svc_vsys_t* vsys, uint32_t uv)
+{
+  const uint64_t adc = ((uint64_t)uv << SVC_VSYS_SCALE_FRACBITS) / vsys->scale;
+  return (adc > SVC_VSYS_ADC_MAX) ? SVC_VSYS_ADC_MAX : (adcsample_t)adc;
+}
+
+/**
+ * @brief   Converts a sum of ADC samples to microvolts.
+ *
+ * @param[in] vsys  The service object.
+ * @param[in] sum   Sum of samples.
+ * @param[in] n     Number of samples.
+ *
+ * @return  Mean voltage in microvolts.
+ */
+static inline uint32_t _sum2uv(svc_vsys_t* vsys, uint32_t sum, uint32_t n)
+{
+  return (n > 0) ? (uint32_t)((((uint64_t)sum * vsys->scale) / n) >> SVC_VSYS_SCALE_FRACBITS) : 0;
+}
+
+/**
+ * @brief   Classifies an ADC value.
+ *
+ * @param[in] vsys    The service object.
+ * @param[in] sample  ADC value to classify.
+ *
+ * @return  The zone the value belongs to.
+ */
+static inline svc_vsys_zone_t _classify(svc_vsys_t* vsys, adcsample_t sample)
+{
+  if (sample < vsys->threshold.low) {
+    return SVC_VSYS_ZONE_LOW;
+  } else if (sample > vsys->threshold.high) {
+    return SVC_VSYS_ZONE_HIGH;
+  } else {
+    return SVC_VSYS_ZONE_NORMAL;
+  }
+}
+
+/**
+ * @brief   Sets the analog watchdog window according to the current zone.
+ * @details Once a threshold was violated, the window is widened by the hysteresis so it only triggers again when the zone is left.
+ *
+ * @param[in] vsys  The service object.
+ */
+static void _applyWindow(svc_vsys_t* vsys)
+{
+  switch (vsys->zone) {
+    case SVC_VSYS_ZONE_LOW:
+      vsys->group.ltr = 0;
+      vsys->group.htr = ((uint32_t)vsys->threshold.low + vsys->threshold.hysteresis > SVC_VSYS_ADC_MAX) ? SVC_VSYS_ADC_MAX : vsys->threshold.low + vsys->threshold.hysteresis;
+      break;
+    case SVC_VSYS_ZONE_HIGH:
+      vsys->group.ltr = (vsys->threshold.high > vsys->threshold.hysteresis) ? vsys->threshold.high - vsys->threshold.hysteresis : 0;
+      vsys->group.htr = SVC_VSYS_ADC_MAX;
+      break;
+    case SVC_VSYS_ZONE_NORMAL:
+    default:
+      vsys->group.ltr = vsys->threshold.low;
+      vsys->group.htr = vsys->threshold.high;
+      break;
+  }
+
+  return;
+}
+
+/**
+ * @brief   DMA half/full transfer callback.
+ * @details Sums up the completed half of the buffer (first filter stage) and feeds it to the moving average (second filter stage).
+ *
+ * @param[in] adcp    ADC driver.
+ * @param[in] buffer  Pointer to the completed half of the buffer.
+ * @param[in] n       Number of samples in the completed half.
+ */
+static void _adcEndCb(ADCDriver* adcp, adcsample_t* buffer, size_t n)
+{
+  svc_vsys_t* vsys = _vsysFromDriver(adcp);
+  uint32_t sum = 0;
+
+  // first stage: integrate and decimate by n
+  for (size_t s = 0; s < n; ++s) {
+    sum += buffer[s];
+  }
+
+  chSysLockFromISR();
+
+  // second stage: moving average over the most recent blocks
+  vsys->filter.sum = vsys->filter.sum - vsys->filter.blocks[vsys->filter.idx] + sum;
+  vsys->filter.blocks[vsys->filter.idx] = sum;
+  vsys->filter.idx = (vsys->filter.idx + 1) & (SVC_VSYS_AVERAGE_DEPTH - 1);
+  if (vsys->filter.fill < SVC_VSYS_AVERAGE_DEPTH) {
+    ++vsys->filter.fill;
+  }
+
+  // extrema and statistics
+  if (sum < vsys->extrema.min) {
+    vsys->extrema.min = sum;
+  }
+  if (sum > vsys->extrema.max) {
+    vsys->extrema.max = sum;
+  }
+  ++vsys->stats.blocks;
+  aosSysGetUptimeX(&vsys->timestamp);
+
+  chSysUnlockFromISR();
+
+  return;
+}
+
+/**
+ * @brief   Restarts the conversion after it was stopped by a watchdog or error condition.
+ *
+ * @param[in] par   Pointer to the service object.
+ */
+static void _restartCb(void* par)
+{
+  svc_vsys_t* vsys = (svc_vsys_t*)par;
+
+  chSysLockFromISR();
+  if (vsys->running) {
+    adcStartConversionI(vsys->driver, &vsys->group, vsys->buffer, vsys->depth);
+  }
+  chSysUnlockFromISR();
+
+  return;
+}
+
+/**
+ * @brief   ADC error callback.
+ * @details Handles analog watchdog events, which are reported as errors by the patched driver.
+ *          Since the driver stops the conversion on any error, it is restarted from a virtual timer with an updated watchdog window.
+ *
+ * @param[in] adcp  ADC driver.
+ * @param[in] err   ADC error value.
+ */
+static void _adcErrorCb(ADCDriver* adcp, adcerror_t err)
+{
+  svc_vsys_t* vsys = _vsysFromDriver(adcp);
+
+  chSysLockFromISR();
+
+  if (err == ADC_ERR_WATCHDOG) {
+    // the data register still holds the sample which triggered the watchdog
+    const svc_vsys_zone_t zone = _classify(vsys, (adcsample_t)adcp->adc->DR);
+    if (zone != vsys->zone) {
+      vsys->zone = zone;
+      aosSysGetUptimeX(&vsys->transition);
+      switch (zone) {
+        case SVC_VSYS_ZONE_LOW:
+          ++vsys->stats.low;
+          chEvtBroadcastFlagsI(&vsys->source, SVC_VSYS_EVENTFLAG_LOW);
+          break;
+        case SVC_VSYS_ZONE_HIGH:
+          ++vsys->stats.high;
+          chEvtBroadcastFlagsI(&vsys->source, SVC_VSYS_EVENTFLAG_HIGH);
+          break;
+        case SVC_VSYS_ZONE_NORMAL:
+          chEvtBroadcastFlagsI(&vsys->source, SVC_VSYS_EVENTFLAG_NORMAL);
+          break;
+      }
+    }
+    _applyWindow(vsys);
+  } else {
+    ++vsys->stats.errors;
+  }
+
+  // restart as soon as possible
+  if (vsys->running) {
+    chVTSetI(&vsys->restarttimer, 1, _restartCb, vsys);
+  }
+
+  chSysUnlockFromISR();
+
+  return;
+}
+
+/**
+ * @brief   Initializes a VSYS service object.
+ *
+ * @param[in] vsys    The service object to initialize.
+ * @param[in] driver  ADC driver to use.
+ * @param[in] group   Conversion group template (a single channel with the analog watchdog enabled).
+ * @param[in] buffer  Circular DMA buffer.
+ * @param[in] depth   Number of samples in @p buffer (must be even).
+ * @param[in] scale   Voltage in volts represented by one LSB (including any voltage divider).
+ */
+void svcVsysInit(svc_vsys_t* vsys, ADCDriver* driver, const ADCConversionGroup* group, adcsample_t* buffer, size_t depth, float scale)
+{
+  aosDbgCheck(vsys != NULL);
+  aosDbgCheck(driver != NULL);
+  aosDbgCheck(group != NULL && group->num_channels == 1);
+  aosDbgCheck(buffer != NULL);
+  aosDbgCheck(depth >= 2 && (depth % 2) == 0);
+  aosDbgCheck(scale > 0.0f);
+
+  memset(vsys, 0, sizeof(svc_vsys_t));
+  vsys->group = *group;
+  vsys->group.circular = true;
+  vsys->group.end_cb = _adcEndCb;
+  vsys->group.error_cb = _adcErrorCb;
+  vsys->group.cr1 |= ADC_CR1_AWDEN | ADC_CR1_AWDIE;
+  vsys->driver = driver;
+  vsys->buffer = buffer;
+  vsys->depth = depth;
+  vsys->scale = (uint32_t)(scale * 1e6f * (1 << SVC_VSYS_SCALE_FRACBITS) + 0.5f);
+  vsys->threshold.low = 0;
+  vsys->threshold.high = SVC_VSYS_ADC_MAX;
+  vsys->threshold.hysteresis = 0;
+  vsys->extrema.min = ~0;
+  vsys->extrema.max = 0;
+  vsys->zone = SVC_VSYS_ZONE_NORMAL;
+  _applyWindow(vsys);
+  chVTObjectInit(&vsys->restarttimer);
+  chEvtObjectInit(&vsys->source);
+  vsys->running = false;
+
+  return;
+}
+
+/**
+ * @brief   Sets the thresholds for low/high events.
+ * @details May be called while the service is running, the new window becomes active with the next watchdog event or restart.
+ *
+ * @param[in] vsys        The service object.
+ * @param[in] low         Low threshold in microvolts.
+ * @param[in] high        High threshold in microvolts.
+ * @param[in] hysteresis  Hysteresis in microvolts to leave the low/high range again.
+ */
+void svcVsysSetThresholds(svc_vsys_t* vsys, uint32_t low, uint32_t high, uint32_t hysteresis)
+{
+  aosDbgCheck(vsys != NULL);
+  aosDbgCheck(low < high);
+
+  chSysLock();
+  vsys->threshold.low = _uv2adc(vsys, low);
+  vsys->threshold.high = _uv2adc(vsys, high);
+  vsys->threshold.hysteresis = _uv2adc(vsys, hysteresis);
+  _applyWindow(vsys);
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Starts continuous sampling.
+ * @note    The ADC driver must have been started before.
+ *
+ * @param[in] vsys  The service object.
+ */
+void svcVsysStart(svc_vsys_t* vsys)
+{
+  aosDbgCheck(vsys != NULL);
+  aosDbgAssert(!vsys->running);
+
+  chSysLock();
+  vsys->filter.sum = 0;
+  vsys->filter.idx = 0;
+  vsys->filter.fill = 0;
+  memset(vsys->filter.blocks, 0, sizeof(vsys->filter.blocks));
+  vsys->zone = SVC_VSYS_ZONE_NORMAL;
+  _applyWindow(vsys);
+  vsys->running = true;
+  adcStartConversionI(vsys->driver, &vsys->group, vsys->buffer, vsys->depth);
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Stops continuous sampling.
+ *
+ * @param[in] vsys  The service object.
+ */
+void svcVsysStop(svc_vsys_t* vsys)
+{
+  aosDbgCheck(vsys != NULL);
+
+  chSysLock();
+  if (vsys->running) {
+    vsys->running = false;
+    chVTResetI(&vsys->restarttimer);
+    adcStopConversionI(vsys->driver);
+  }
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Teardown callback, which stops the service.
+ * @details Can be passed to aosTeardownInit() directly.
+ *
+ * @param[in] vsys  The service object.
+ */
+void svcVsysTeardown(void* vsys)
+{
+  svcVsysStop((svc_vsys_t*)vsys);
+
+  return;
+}
+
+/**
+ * @brief   Retrieves the current filtered reading.
+ *
+ * @param[in]  vsys     The service object.
+ * @param[out] reading  Pointer to store the reading to.
+ */
+void svcVsysGet(svc_vsys_t* vsys, svc_vsys_reading_t* reading)
+{
+  aosDbgCheck(vsys != NULL);
+  aosDbgCheck(reading != NULL);
+
+  uint32_t sum, fill, min, max;
+
+  chSysLock();
+  sum = vsys->filter.sum;
+  fill = vsys->filter.fill;
+  min = vsys->extrema.min;
+  max = vsys->extrema.max;
+  reading->zone = vsys->zone;
+  reading->timestamp = vsys->timestamp;
+  chSysUnlock();
+
+  // the expensive conversion is done outside the critical zone
+  reading->voltage = _sum2uv(vsys, sum, fill * (vsys->depth / 2));
+  reading->min = (max >= min) ? _sum2uv(vsys, min, vsys->depth / 2) : 0;
+  reading->max = (max >= min) ? _sum2uv(vsys, max, vsys->depth / 2) : 0;
+
+  return;
+}
+
+/**
+ * @brief   Resets the recorded minimum and maximum.
+ *
+ * @param[in] vsys  The service object.
+ */
+void svcVsysResetExtrema(svc_vsys_t* vsys)
+{
+  aosDbgCheck(vsys != NULL);
+
+  chSysLock();
+  vsys->extrema.min = ~0;
+  vsys->extrema.max = 0;
+  chSysUnlock();
+
+  return;
+}
+
+/**
+ * @brief   Shell command to print the state of the service.
+ *
+ * @param[in] vsys    The service object.
+ * @param[in] stream  Stream for input/output.
+ * @param[in] argc    Number of arguments.
+ * @param[in] argv    List of pointers to the arguments.
+ *
+ * @return  An exit status.
+ */
+int svcVsysShellCmd(svc_vsys_t* vsys, BaseSequentialStream* stream, int argc, char* argv[])
+{
+  aosDbgCheck(vsys != NULL);
+  aosDbgCheck(stream != NULL);
+
+  svc_vsys_reading_t reading;
+  aos_timestamp_t uptime;
+  static const char* const zones[] = {"normal", "low", "high"};
+
+  if (argc == 2 && (strcmp(argv[1], "--reset") == 0 || strcmp(argv[1], "-r") == 0)) {
+    svcVsysResetExtrema(vsys);
+    return AOS_OK;
+  } else if (argc > 1) {
+    chprintf(stream, "Usage: %s [OPTION]\n", argv[0]);
+    chprintf(stream, "Prints the filtered system voltage, its extrema and the threshold statistics.\n");
+    chprintf(stream, "Options:\n");
+    chprintf(stream, "  --help\n");
+    chprintf(stream, "    Print this help text.\n");
+    chprintf(stream, "  --reset, -r\n");
+    chprintf(stream, "    Reset the recorded minimum and maximum.\n");
+    return (strcmp(argv[1], "--help") == 0) ? AOS_OK : AOS_INVALID_ARGUMENTS;
+  }
+
+  svcVsysGet(vsys, &reading);
+  aosSysGetUptime(&uptime);
+  chprintf(stream, "VSYS:       %.3fV (%s)\n", reading.voltage / 1e6f, zones[reading.zone]);
+  chprintf(stream, "min/max:    %.3fV / %.3fV\n", reading.min / 1e6f, reading.max / 1e6f);
+  chprintf(stream, "thresholds: %u / %u (hysteresis %u) [ADC]\n", vsys->threshold.low, vsys->threshold.high, vsys->threshold.hysteresis);
+  chprintf(stream, "age:        %uus\n", (uint32_t)(uptime - reading.timestamp));
+  chprintf(stream, "blocks:     %u (%u samples each)\n", vsys->stats.blocks, vsys->depth / 2);
+  chprintf(stream, "events:     %u low, %u high\n", vsys->stats.low, vsys->stats.high);
+  chprintf(stream, "errors:     %u\n", vsys->stats.errors);
+
+  return AOS_OK;
+}
+
+#endif /* (HAL_USE_ADC == TRUE) */
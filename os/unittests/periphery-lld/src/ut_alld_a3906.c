@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <chprintf.h>
 #include <alld_a3906.h>
 #include <aos_thread.h>
+#include <aos_qei.h>
 #include <stdlib.h>
 #include <math.h>
 
@@ -144,6 +145,10 @@ aos_utresult_t utAlldA3906Func(BaseSequentialStream* stream, aos_unittest_t* ut)
   apalQEICount_t qei_increments[2][2];
   uint32_t stable_counter;
   apalQEICount_t qei_increments_diff[2];
+#if (QEI_USE_EXTENDED_POSITION == TRUE)
+  QEIDriver* const qei_drivers[2] = {((ut_a3906data_t*)ut->data)->qei.left, ((ut_a3906data_t*)ut->data)->qei.right};
+  aos_qeicapture_t qei_capture[2][2];
+#endif
 
   chprintf(stream, "enable power...\n");
   power_state = A3906_LLD_POWER_ON;
@@ -182,6 +187,17 @@ aos_utresult_t utAlldA3906Func(BaseSequentialStream* stream, aos_unittest_t* ut)
   qei_increments[WHEEL_RIGHT][1] = 0;
   stable_counter = 0;
   do {
+#if (QEI_USE_EXTENDED_POSITION == TRUE)
+    // the extended position already accounts for all counter wraps
+    aosQeiCaptureMultiple(qei_drivers, qei_capture[0], 2);
+    aosThdMSleep(QEI_POLL_INTERVAL_MS);
+    aosQeiCaptureMultiple(qei_drivers, qei_capture[1], 2);
+    timeout_counter += QEI_POLL_INTERVAL_MS;
+    qei_increments[WHEEL_LEFT][0] = qei_increments[WHEEL_LEFT][1];
+    qei_increments[WHEEL_LEFT][1] = (apalQEICount_t)(qei_capture[1][WHEEL_LEFT].position - qei_capture[0][WHEEL_LEFT].position);
+    qei_increments[WHEEL_RIGHT][0] = qei_increments[WHEEL_RIGHT][1];
+    qei_increments[WHEEL_RIGHT][1] = (apalQEICount_t)(qei_capture[1][WHEEL_RIGHT].position - qei_capture[0][WHEEL_RIGHT].position);
+#else
     status |= apalQEIGetPosition(((ut_a3906data_t*)ut->data)->qei.left, &qei_count[WHEEL_LEFT][0]);
     status |= apalQEIGetPosition(((ut_a3906data_t*)ut->data)->qei.right, &qei_count[WHEEL_RIGHT][0]);
     aosThdMSleep(QEI_POLL_INTERVAL_MS);
@@ -192,6 +208,7 @@ aos_utresult_t utAlldA3906Func(BaseSequentialStream* stream, aos_unittest_t* ut)
     qei_increments[WHEEL_LEFT][1] = (qei_count[WHEEL_LEFT][1] > qei_count[WHEEL_LEFT][0]) ? (qei_count[WHEEL_LEFT][1] - qei_count[WHEEL_LEFT][0]) : (qei_count[WHEEL_LEFT][1] + (qei_range[WHEEL_LEFT] - qei_count[WHEEL_LEFT][0]));
     qei_increments[WHEEL_RIGHT][0] = qei_increments[WHEEL_RIGHT][1];
     qei_increments[WHEEL_RIGHT][1] = (qei_count[WHEEL_RIGHT][1] > qei_count[WHEEL_RIGHT][0]) ? (qei_count[WHEEL_RIGHT][1] - qei_count[WHEEL_RIGHT][0]) : (qei_count[WHEEL_RIGHT][1] + (qei_range[WHEEL_RIGHT] - qei_count[WHEEL_RIGHT][0]));
+#endif
     qei_increments_diff[WHEEL_LEFT] = abs((int32_t)(qei_increments[WHEEL_LEFT][0]) - (int32_t)qei_increments[WHEEL_LEFT][1]);
     qei_increments_diff[WHEEL_RIGHT] = abs((int32_t)(qei_increments[WHEEL_RIGHT][0]) - (int32_t)qei_increments[WHEEL_RIGHT][1]);
     stable_counter = (qei_increments_diff[WHEEL_LEFT] <= QEI_DIFF_THRESHOLD && qei_increments_diff[WHEEL_RIGHT] < QEI_DIFF_THRESHOLD) ? stable_counter+1 : 0;
@@ -207,10 +224,16 @@ aos_utresult_t utAlldA3906Func(BaseSequentialStream* stream, aos_unittest_t* ut)
                                tps[WHEEL_RIGHT] / (float)(((ut_a3906data_t*)ut->data)->qei.increments_per_revolution) * ((ut_a3906data_t*)ut->data)->wheel_diameter * acos(-1)};
     chprintf(stream, "left wheel:\n");
     chprintf(stream, "\t%f tps\n", tps[WHEEL_LEFT]);
+#if (QEI_USE_VELOCITY == TRUE)
+    chprintf(stream, "\t%f tps (M/T)\n", (float)qeiGetVelocity(((ut_a3906data_t*)ut->data)->qei.left) / (1 << QEI_VELOCITY_FRACBITS));
+#endif
     chprintf(stream, "\t%f RPM\n", rpm[WHEEL_LEFT]);
     chprintf(stream, "\t%f m/s\n", velocity[WHEEL_LEFT]);
     chprintf(stream, "right wheel:\n");
     chprintf(stream, "\t%f tps\n", tps[WHEEL_RIGHT]);
+#if (QEI_USE_VELOCITY == TRUE)
+    chprintf(stream, "\t%f tps (M/T)\n", (float)qeiGetVelocity(((ut_a3906data_t*)ut->data)->qei.right) / (1 << QEI_VELOCITY_FRACBITS));
+#endif
     chprintf(stream, "\t%f RPM\n", rpm[WHEEL_RIGHT]);
     chprintf(stream, "\t%f m/s\n", velocity[WHEEL_RIGHT]);
     chprintf(stream, "\n");
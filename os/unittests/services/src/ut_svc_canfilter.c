@@ -0,0 +1,155 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <ut_svc_canfilter.h>
+
+#if (AMIROOS_CFG_TESTS_ENABLE == true) || defined(__DOXYGEN__)
+
+#include <chprintf.h>
+#include <svc_canfilter.h>
+
+/**
+ * @brief   Maximum number of filter banks.
+ */
+#define MAX_BANKS                     8
+
+/**
+ * @brief   Identifier bits of a topic pattern (see svc_canproto.h).
+ */
+#define TOPIC_MASK                    0x1FFE0000u
+
+/**
+ * @brief   Creates a rule that matches a topic of the publish/subscribe protocol.
+ */
+static inline svc_canfilter_rule_t _topic(uint16_t topic)
+{
+  const svc_canfilter_rule_t rule = {
+    /* id       */ (uint32_t)topic << 17,
+    /* mask     */ TOPIC_MASK,
+    /* extended */ true,
+  };
+  return rule;
+}
+
+/**
+ * @brief   Counts the topics accepted by compiled filter banks.
+ */
+static uint16_t _acceptedTopics(const svc_canfilter_bank_t* banks, size_t numbanks)
+{
+  uint16_t count = 0;
+  for (uint32_t topic = 0; topic <= 0x0FFF; ++topic) {
+    if (svcCanFilterMatch(banks, numbanks, true, (topic << 17) | 0x1234)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief   CAN filter unit test function.
+ * @details Tests the packing of identifiers and patterns into filter banks and the merging of rules if banks are scarce.
+ *
+ * @param[in] stream  Stream for input/output.
+ * @param[in] ut      Unit test object.
+ *
+ * @return            Unit test result value.
+ */
+aos_utresult_t utSvcCanFilterFunc(BaseSequentialStream* stream, aos_unittest_t* ut)
+{
+  (void)ut;
+
+  // local variables
+  aos_utresult_t result = {0, 0};
+  svc_canfilter_rule_t rules[SVC_CANFILTER_MAXRULES];
+  svc_canfilter_bank_t banks[MAX_BANKS];
+  int numbanks;
+  bool ok;
+
+  chprintf(stream, "pack identifiers into list banks...\n");
+  for (uint8_t i = 0; i < 5; ++i) {
+    rules[i] = (svc_canfilter_rule_t){0x010 + i, 0x7FF, false};
+  }
+  for (uint8_t i = 5; i < 8; ++i) {
+    rules[i] = (svc_canfilter_rule_t){0x12345670 + i, 0x1FFFFFFF, true};
+  }
+  numbanks = svcCanFilterCompile(rules, 8, banks, MAX_BANKS);
+  ok = (numbanks == 4);
+  for (uint8_t i = 0; i < 5; ++i) {
+    ok = ok && svcCanFilterMatch(banks, (size_t)numbanks, false, 0x010 + i) && !svcCanFilterMatch(banks, (size_t)numbanks, true, 0x010 + i);
+  }
+  for (uint8_t i = 5; i < 8; ++i) {
+    ok = ok && svcCanFilterMatch(banks, (size_t)numbanks, true, 0x12345670 + i);
+  }
+  ok = ok && !svcCanFilterMatch(banks, (size_t)numbanks, false, 0x015) && !svcCanFilterMatch(banks, (size_t)numbanks, true, 0x12345670);
+  if (ok) {
+    aosUtPassedMsg(stream, &result, "%d banks\n", numbanks);
+  } else {
+    aosUtFailedMsg(stream, &result, "%d banks\n", numbanks);
+  }
+
+  chprintf(stream, "combine patterns and identifiers...\n");
+  rules[0] = _topic(0x100);
+  rules[1] = _topic(0x200);
+  rules[2] = (svc_canfilter_rule_t){0x004, 0x7FF, false};
+  rules[3] = (svc_canfilter_rule_t){0x020, 0x7F0, false};
+  // covered by the topic pattern
+  rules[4] = (svc_canfilter_rule_t){(0x100u << 17) | 0x42, 0x1FFFFFFF, true};
+  numbanks = svcCanFilterCompile(rules, 5, banks, MAX_BANKS);
+  ok = (numbanks == 3) && (_acceptedTopics(banks, (size_t)numbanks) == 2);
+  ok = ok && svcCanFilterMatch(banks, (size_t)numbanks, false, 0x004) && svcCanFilterMatch(banks, (size_t)numbanks, false, 0x02F);
+  ok = ok && !svcCanFilterMatch(banks, (size_t)numbanks, false, 0x005) && !svcCanFilterMatch(banks, (size_t)numbanks, false, 0x030);
+  if (ok) {
+    aosUtPassedMsg(stream, &result, "%d banks\n", numbanks);
+  } else {
+    aosUtFailedMsg(stream, &result, "%d banks\n", numbanks);
+  }
+
+  chprintf(stream, "merge neighboring topics if banks are scarce...\n");
+  {
+    static const uint16_t topics[6] = {0x100, 0x300, 0x200, 0x101, 0x201, 0x301};
+    for (uint8_t i = 0; i < 6; ++i) {
+      rules[i] = _topic(topics[i]);
+    }
+    numbanks = svcCanFilterCompile(rules, 6, banks, 3);
+    ok = (numbanks == 3) && (_acceptedTopics(banks, (size_t)numbanks) == 6);
+    for (uint8_t i = 0; i < 6; ++i) {
+      ok = ok && svcCanFilterMatch(banks, (size_t)numbanks, true, (uint32_t)topics[i] << 17);
+    }
+    if (ok) {
+      aosUtPassedMsg(stream, &result, "%d banks\n", numbanks);
+    } else {
+      aosUtFailedMsg(stream, &result, "%d banks, %u topics accepted\n", numbanks, _acceptedTopics(banks, (size_t)(numbanks > 0 ? numbanks : 0)));
+    }
+  }
+
+  chprintf(stream, "fall back to a single bank...\n");
+  rules[0] = _topic(0x100);
+  rules[1] = (svc_canfilter_rule_t){0x004, 0x7FF, false};
+  numbanks = svcCanFilterCompile(rules, 2, banks, 1);
+  if (numbanks == 1 && svcCanFilterMatch(banks, 1, true, 0x100u << 17) && svcCanFilterMatch(banks, 1, false, 0x004) &&
+      svcCanFilterCompile(rules, 0, banks, MAX_BANKS) == 0 && svcCanFilterCompile(rules, 2, banks, 0) < 0) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailedMsg(stream, &result, "%d banks\n", numbanks);
+  }
+
+  return result;
+}
+
+#endif /* AMIROOS_CFG_TESTS_ENABLE == true */
@@ -0,0 +1,164 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <ut_svc_canproto.h>
+
+#if (AMIROOS_CFG_TESTS_ENABLE == true) || defined(__DOXYGEN__)
+
+#include <chprintf.h>
+#include <string.h>
+#include <svc_canproto.h>
+
+/**
+ * @brief   Size of the reassembly buffer.
+ */
+#define BUFFER_SIZE                   32
+
+/**
+ * @brief   Transmits a message fragment by fragment to a reassembly context.
+ *
+ * @param[in] reassembly  The reassembly context.
+ * @param[in] topic       Topic of the message.
+ * @param[in] sequence    Sequence number of the message.
+ * @param[in] payload     The payload.
+ * @param[in] length      Length of the payload.
+ * @param[in] skip        Index of a fragment to drop (or -1).
+ *
+ * @return  The result of the last fragment.
+ */
+static svc_canproto_result_t _transfer(svc_canproto_reassembly_t* reassembly, uint16_t topic, uint8_t sequence, const uint8_t* payload, size_t length, int skip)
+{
+  svc_canproto_result_t result = SVC_CANPROTO_PENDING;
+  svc_canproto_header_t header;
+  uint32_t id;
+  uint8_t dlc;
+
+  for (uint8_t f = 0; f < svcCanProtoNumFragments(length); ++f) {
+    dlc = svcCanProtoFragment(topic, 0x42, sequence, length, f, &id);
+    if (f == skip) {
+      continue;
+    }
+    svcCanProtoDecodeId(id, &header);
+    result = svcCanProtoReassemble(reassembly, &header, &payload[f * SVC_CANPROTO_FRAMESIZE], dlc);
+    if (result != SVC_CANPROTO_PENDING) {
+      break;
+    }
+  }
+
+  return result;
+}
+
+/**
+ * @brief   CAN protocol unit test function.
+ * @details Tests identifier coding, fragmentation and reassembly including loss detection.
+ *
+ * @param[in] stream  Stream for input/output.
+ * @param[in] ut      Unit test object.
+ *
+ * @return            Unit test result value.
+ */
+aos_utresult_t utSvcCanProtoFunc(BaseSequentialStream* stream, aos_unittest_t* ut)
+{
+  (void)ut;
+
+  // local variables
+  aos_utresult_t result = {0, 0};
+  svc_canproto_reassembly_t reassembly;
+  svc_canproto_header_t header, decoded;
+  uint8_t buffer[BUFFER_SIZE];
+  uint8_t payload[BUFFER_SIZE + SVC_CANPROTO_FRAMESIZE];
+  uint32_t id;
+  svc_canproto_result_t state;
+  bool ok;
+
+  for (size_t i = 0; i < sizeof(payload); ++i) {
+    payload[i] = (uint8_t)(i * 7 + 3);
+  }
+
+  chprintf(stream, "encode and decode identifiers...\n");
+  header.topic = SVC_CANPROTO_MAXTOPIC;
+  header.source = 0xA5;
+  header.index = SVC_CANPROTO_MAXFRAGMENTS - 1;
+  header.last = true;
+  header.sequence = 2;
+  id = svcCanProtoEncodeId(&header);
+  svcCanProtoDecodeId(id, &decoded);
+  ok = (id < (1u << 29)) && (decoded.topic == header.topic) && (decoded.source == header.source) &&
+       (decoded.index == header.index) && (decoded.last == header.last) && (decoded.sequence == header.sequence);
+  header.topic = 1;
+  ok = ok && (svcCanProtoEncodeId(&header) < id) && ((svcCanProtoEncodeId(&header) & SVC_CANPROTO_TOPICMASK) == (1u << SVC_CANPROTO_TOPICSHIFT));
+  if (ok) {
+    aosUtPassedMsg(stream, &result, "0x%08X\n", id);
+  } else {
+    aosUtFailedMsg(stream, &result, "0x%08X\n", id);
+  }
+
+  chprintf(stream, "count fragments...\n");
+  if (svcCanProtoNumFragments(0) == 1 && svcCanProtoNumFragments(8) == 1 && svcCanProtoNumFragments(9) == 2 &&
+      svcCanProtoNumFragments(SVC_CANPROTO_MAXFRAGMENTS * SVC_CANPROTO_FRAMESIZE) == SVC_CANPROTO_MAXFRAGMENTS &&
+      svcCanProtoNumFragments(SVC_CANPROTO_MAXFRAGMENTS * SVC_CANPROTO_FRAMESIZE + 1) == 0) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+
+  chprintf(stream, "reassemble single and fragmented messages...\n");
+  svcCanProtoReassemblyInit(&reassembly, buffer, sizeof(buffer));
+  ok = (_transfer(&reassembly, 7, 0, payload, 0, -1) == SVC_CANPROTO_COMPLETE) && (reassembly.length == 0);
+  ok = ok && (_transfer(&reassembly, 7, 1, payload, 5, -1) == SVC_CANPROTO_COMPLETE) && (reassembly.length == 5);
+  ok = ok && (_transfer(&reassembly, 7, 2, payload, 27, -1) == SVC_CANPROTO_COMPLETE) && (reassembly.length == 27);
+  ok = ok && (memcmp(buffer, payload, 27) == 0);
+  ok = ok && (_transfer(&reassembly, 7, 3, payload, BUFFER_SIZE, -1) == SVC_CANPROTO_COMPLETE) && (memcmp(buffer, payload, BUFFER_SIZE) == 0);
+  if (ok) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailedMsg(stream, &result, "length %u\n", (unsigned int)reassembly.length);
+  }
+
+  chprintf(stream, "detect lost fragments...\n");
+  ok = (_transfer(&reassembly, 7, 0, payload, 27, 1) == SVC_CANPROTO_LOST) && !reassembly.active;
+  // a lost last fragment is detected when the next message starts with a different sequence number
+  state = _transfer(&reassembly, 7, 1, payload, 27, 3);
+  ok = ok && (state == SVC_CANPROTO_PENDING) && reassembly.active;
+  svcCanProtoFragment(7, 0x42, 2, 27, 1, &id);
+  svcCanProtoDecodeId(id, &header);
+  ok = ok && (svcCanProtoReassemble(&reassembly, &header, payload, SVC_CANPROTO_FRAMESIZE) == SVC_CANPROTO_LOST);
+  // the following message is received correctly
+  ok = ok && (_transfer(&reassembly, 7, 3, payload, 20, -1) == SVC_CANPROTO_COMPLETE) && (reassembly.length == 20);
+  if (ok) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+
+  chprintf(stream, "reject oversized and malformed messages...\n");
+  ok = (_transfer(&reassembly, 7, 0, payload, BUFFER_SIZE + 1, -1) == SVC_CANPROTO_OVERFLOW) && !reassembly.active;
+  svcCanProtoFragment(7, 0x42, 1, 20, 0, &id);
+  svcCanProtoDecodeId(id, &header);
+  ok = ok && (svcCanProtoReassemble(&reassembly, &header, payload, 4) == SVC_CANPROTO_LOST);
+  if (ok) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+
+  return result;
+}
+
+#endif /* AMIROOS_CFG_TESTS_ENABLE == true */
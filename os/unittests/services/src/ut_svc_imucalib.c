@@ -0,0 +1,153 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <ut_svc_imucalib.h>
+
+#if (AMIROOS_CFG_TESTS_ENABLE == true) || defined(__DOXYGEN__)
+
+#include <chprintf.h>
+#include <math.h>
+#include <string.h>
+#include <svc_imucalib.h>
+
+/**
+ * @brief   Hard iron offset of the synthetic compass data.
+ */
+static const float _offset[3] = {120.0f, -80.0f, 40.0f};
+
+/**
+ * @brief   Radii of the synthetic compass data.
+ */
+static const float _radius[3] = {300.0f, 250.0f, 280.0f};
+
+/**
+ * @brief   IMU calibration unit test function.
+ * @details Tests standstill detection, ellipsoid fit and serialization with synthetic data.
+ *
+ * @param[in] stream  Stream for input/output.
+ * @param[in] ut      Unit test object.
+ *
+ * @return            Unit test result value.
+ */
+aos_utresult_t utSvcImuCalibFunc(BaseSequentialStream* stream, aos_unittest_t* ut)
+{
+  (void)ut;
+
+  // local variables
+  aos_utresult_t result = {0, 0};
+  svc_imucalib_standstill_t standstill;
+  svc_imucalib_magfit_t fit;
+  svc_imu_calibration_t calib, copy;
+  uint8_t buffer[SVC_IMUCALIB_SERIALIZED_SIZE];
+  float bias[3] = {0.0f, 0.0f, 0.0f};
+  float offset[3] = {0.0f, 0.0f, 0.0f};
+  float matrix[9];
+  float mag[3];
+  uint8_t axes;
+
+  chprintf(stream, "estimate bias during standstill...\n");
+  svcImuCalibStandstillInit(&standstill, 50, 0.005f, 0.05f, 0.5f);
+  for (uint16_t i = 0; i < 500; ++i) {
+    const float noise = (float)((int)(i * 7919u % 101u) - 50) * 1.0e-5f;
+    const float rate[3] = {0.01f + noise, -0.02f - noise, 0.015f + noise};
+    svcImuCalibStandstillUpdate(&standstill, rate, bias);
+  }
+  if (fabsf(bias[0] - 0.01f) < 0.0002f && fabsf(bias[1] + 0.02f) < 0.0002f && fabsf(bias[2] - 0.015f) < 0.0002f) {
+    aosUtPassedMsg(stream, &result, "bias %f %f %f after %u windows\n", bias[0], bias[1], bias[2], standstill.detections);
+  } else {
+    aosUtFailedMsg(stream, &result, "bias %f %f %f after %u windows\n", bias[0], bias[1], bias[2], standstill.detections);
+  }
+
+  chprintf(stream, "ignore constant rotation...\n");
+  memcpy(offset, bias, sizeof(bias));
+  for (uint16_t i = 0; i < 500; ++i) {
+    const float rate[3] = {0.01f, -0.02f, 0.5f};
+    svcImuCalibStandstillUpdate(&standstill, rate, bias);
+  }
+  if (memcmp(offset, bias, sizeof(bias)) == 0) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailedMsg(stream, &result, "bias %f %f %f\n", bias[0], bias[1], bias[2]);
+  }
+
+  chprintf(stream, "fit ellipsoid...\n");
+  svcImuCalibMagFitReset(&fit);
+  for (uint16_t i = 0; i < 24; ++i) {
+    const float elevation = (float)i * (3.14159265f / 24.0f) - 1.5f;
+    for (uint16_t j = 0; j < 36; ++j) {
+      const float azimuth = (float)j * (6.2831853f / 36.0f);
+      mag[0] = _offset[0] + _radius[0] * cosf(elevation) * cosf(azimuth);
+      mag[1] = _offset[1] + _radius[1] * cosf(elevation) * sinf(azimuth);
+      mag[2] = _offset[2] + _radius[2] * sinf(elevation);
+      svcImuCalibMagFitAdd(&fit, mag);
+    }
+  }
+  axes = svcImuCalibMagFitSolve(&fit, 100.0f, offset, matrix);
+  if (axes == 0x07 &&
+      fabsf(offset[0] - _offset[0]) < 1.0f && fabsf(offset[1] - _offset[1]) < 1.0f && fabsf(offset[2] - _offset[2]) < 1.0f &&
+      fabsf(matrix[0] * _radius[0] - matrix[4] * _radius[1]) < 1.0f && fabsf(matrix[4] * _radius[1] - matrix[8] * _radius[2]) < 1.0f) {
+    aosUtPassedMsg(stream, &result, "offset %.1f %.1f %.1f, scale %.3f %.3f %.3f\n", offset[0], offset[1], offset[2], matrix[0], matrix[4], matrix[8]);
+  } else {
+    aosUtFailedMsg(stream, &result, "axes 0x%X, offset %.1f %.1f %.1f, scale %.3f %.3f %.3f\n", axes, offset[0], offset[1], offset[2], matrix[0], matrix[4], matrix[8]);
+  }
+
+  chprintf(stream, "fit ellipse (planar rotation)...\n");
+  svcImuCalibMagFitReset(&fit);
+  offset[2] = 0.0f;
+  for (uint16_t i = 0; i < 360; ++i) {
+    const float azimuth = (float)i * (6.2831853f / 360.0f);
+    mag[0] = _offset[0] + _radius[0] * cosf(azimuth);
+    mag[1] = _offset[1] + _radius[1] * sinf(azimuth);
+    mag[2] = -400.0f;
+    svcImuCalibMagFitAdd(&fit, mag);
+  }
+  axes = svcImuCalibMagFitSolve(&fit, 100.0f, offset, matrix);
+  if (axes == 0x03 &&
+      fabsf(offset[0] - _offset[0]) < 1.0f && fabsf(offset[1] - _offset[1]) < 1.0f && offset[2] == 0.0f &&
+      fabsf(matrix[0] * _radius[0] - matrix[4] * _radius[1]) < 1.0f && matrix[8] == 1.0f) {
+    aosUtPassedMsg(stream, &result, "offset %.1f %.1f, scale %.3f %.3f\n", offset[0], offset[1], matrix[0], matrix[4]);
+  } else {
+    aosUtFailedMsg(stream, &result, "axes 0x%X, offset %.1f %.1f %.1f, scale %.3f %.3f %.3f\n", axes, offset[0], offset[1], offset[2], matrix[0], matrix[4], matrix[8]);
+  }
+
+  chprintf(stream, "serialize and deserialize...\n");
+  svcImuCalibDefault(&calib);
+  memcpy(calib.gyrobias, bias, sizeof(bias));
+  memcpy(calib.magoffset, offset, sizeof(offset));
+  memcpy(calib.magmatrix, matrix, sizeof(matrix));
+  svcImuCalibSerialize(&calib, buffer);
+  svcImuCalibDefault(&copy);
+  if (svcImuCalibDeserialize(&copy, buffer) &&
+      fabsf(copy.gyrobias[2] - calib.gyrobias[2]) < 1.0e-5f && fabsf(copy.magoffset[0] - calib.magoffset[0]) <= 0.5f && fabsf(copy.magmatrix[4] - calib.magmatrix[4]) < 1.0e-3f) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+
+  chprintf(stream, "detect corrupted data...\n");
+  buffer[SVC_IMUCALIB_SERIALIZED_SIZE - 1] ^= 0x01;
+  if (!svcImuCalibDeserialize(&copy, buffer)) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+
+  return result;
+}
+
+#endif /* AMIROOS_CFG_TESTS_ENABLE == true */
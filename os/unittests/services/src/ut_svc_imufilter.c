@@ -0,0 +1,141 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <ut_svc_imufilter.h>
+
+#if (AMIROOS_CFG_TESTS_ENABLE == true) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <chprintf.h>
+#include <math.h>
+#include <svc_imufilter.h>
+
+/**
+ * @brief   Filter gains used for all tests.
+ */
+#define _kp                                     2.0f
+#define _ki                                     0.01f
+
+/**
+ * @brief   Filter step width in seconds (100 Hz).
+ */
+#define _dt                                     0.01f
+
+/**
+ * @brief   Allowed deviation in radians (0.5 degree).
+ */
+#define _tolerance                              0.0087f
+
+/**
+ * @brief   Helper function to convert realtime counter ticks to microseconds.
+ *
+ * @param[in] cycles      Realtime counter ticks.
+ * @param[in] frequency   Realtime counter frequency in Hz.
+ *
+ * @return                Converted value in microseconds.
+ */
+static inline uint32_t _cycles2us(rtcnt_t cycles, uint32_t frequency) {
+  return (uint32_t)((uint64_t)cycles * 1000000 / frequency);
+}
+
+/**
+ * @brief   IMU filter unit test function.
+ * @details Tests the filter core with synthetic data and measures its execution time.
+ *
+ * @param[in] stream  Stream for input/output.
+ * @param[in] ut      Unit test object.
+ *
+ * @return            Unit test result value.
+ */
+aos_utresult_t utSvcImuFilterFunc(BaseSequentialStream* stream, aos_unittest_t* ut)
+{
+  aosDbgCheck(ut->data != NULL && ((ut_imufilterdata_t*)(ut->data))->iterations > 0 && ((ut_imufilterdata_t*)(ut->data))->rtcfrequency > 0);
+
+  // local variables
+  aos_utresult_t result = {0, 0};
+  svc_imufilter_t filter;
+  float euler[3];
+  const float zero[3] = {0.0f, 0.0f, 0.0f};
+  const float yawrate[3] = {0.0f, 0.0f, 1.0f};
+  const float tilted[3] = {0.0f, 0.5f, 0.8660254f}; // 30 degree roll
+  const float level[3] = {0.0f, 0.0f, 1.0f};
+  const float field[3] = {0.3f, 0.0f, -0.5f};
+  rtcnt_t start, cycles;
+
+  chprintf(stream, "converge to accelerometer data...\n");
+  svcImuFilterInit(&filter, _kp, _ki);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    svcImuFilterUpdate(&filter, zero, tilted, NULL, _dt);
+  }
+  svcImuFilterGetEuler(&filter, euler);
+  if (fabsf(euler[0] - 0.5235988f) < _tolerance && fabsf(euler[1]) < _tolerance) {
+    aosUtPassedMsg(stream, &result, "roll %f, pitch %f\n", euler[0], euler[1]);
+  } else {
+    aosUtFailedMsg(stream, &result, "roll %f, pitch %f\n", euler[0], euler[1]);
+  }
+
+  chprintf(stream, "integrate gyroscope data...\n");
+  svcImuFilterInit(&filter, _kp, _ki);
+  for (uint32_t i = 0; i < 100; ++i) {
+    svcImuFilterUpdate(&filter, yawrate, NULL, NULL, _dt);
+  }
+  svcImuFilterGetEuler(&filter, euler);
+  if (fabsf(euler[2] - 1.0f) < _tolerance && fabsf(euler[0]) < _tolerance && fabsf(euler[1]) < _tolerance) {
+    aosUtPassedMsg(stream, &result, "yaw %f after 1s at 1rad/s\n", euler[2]);
+  } else {
+    aosUtFailedMsg(stream, &result, "yaw %f after 1s at 1rad/s\n", euler[2]);
+  }
+
+  chprintf(stream, "compensate gyroscope bias...\n");
+  svcImuFilterInit(&filter, _kp, 0.1f);
+  for (uint32_t i = 0; i < 6000; ++i) {
+    const float biased[3] = {0.01f, -0.02f, 0.02f};
+    svcImuFilterUpdate(&filter, biased, level, field, _dt);
+  }
+  svcImuFilterGetEuler(&filter, euler);
+  if (fabsf(filter.integral[0] + 0.01f) < 0.002f && fabsf(filter.integral[1] - 0.02f) < 0.002f && fabsf(filter.integral[2] + 0.02f) < 0.002f &&
+      fabsf(euler[0]) < _tolerance && fabsf(euler[1]) < _tolerance) {
+    aosUtPassedMsg(stream, &result, "bias estimate %f %f %f\n", -filter.integral[0], -filter.integral[1], -filter.integral[2]);
+  } else {
+    aosUtFailedMsg(stream, &result, "bias estimate %f %f %f\n", -filter.integral[0], -filter.integral[1], -filter.integral[2]);
+  }
+
+  chprintf(stream, "benchmark (%u updates)...\n", ((ut_imufilterdata_t*)(ut->data))->iterations);
+  svcImuFilterInit(&filter, _kp, _ki);
+  start = chSysGetRealtimeCounterX();
+  for (uint32_t i = 0; i < ((ut_imufilterdata_t*)(ut->data))->iterations; ++i) {
+    svcImuFilterUpdate(&filter, yawrate, NULL, NULL, _dt);
+  }
+  cycles = (chSysGetRealtimeCounterX() - start) / ((ut_imufilterdata_t*)(ut->data))->iterations;
+  aosUtInfoMsg(stream, "gyroscope only: %u cycles (%uus) per update\n", cycles, _cycles2us(cycles, ((ut_imufilterdata_t*)(ut->data))->rtcfrequency));
+  start = chSysGetRealtimeCounterX();
+  for (uint32_t i = 0; i < ((ut_imufilterdata_t*)(ut->data))->iterations; ++i) {
+    svcImuFilterUpdate(&filter, yawrate, tilted, field, _dt);
+  }
+  cycles = (chSysGetRealtimeCounterX() - start) / ((ut_imufilterdata_t*)(ut->data))->iterations;
+  // a single update must not take more than a tenth of the filter period
+  if (_cycles2us(cycles, ((ut_imufilterdata_t*)(ut->data))->rtcfrequency) < (uint32_t)(_dt * 1000000.0f / 10.0f)) {
+    aosUtPassedMsg(stream, &result, "all sensors: %u cycles (%uus) per update\n", cycles, _cycles2us(cycles, ((ut_imufilterdata_t*)(ut->data))->rtcfrequency));
+  } else {
+    aosUtFailedMsg(stream, &result, "all sensors: %u cycles (%uus) per update\n", cycles, _cycles2us(cycles, ((ut_imufilterdata_t*)(ut->data))->rtcfrequency));
+  }
+
+  return result;
+}
+
+#endif /* AMIROOS_CFG_TESTS_ENABLE == true */
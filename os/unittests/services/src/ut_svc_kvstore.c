@@ -0,0 +1,227 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <ut_svc_kvstore.h>
+
+#if (AMIROOS_CFG_TESTS_ENABLE == true) || defined(__DOXYGEN__)
+
+#include <chprintf.h>
+#include <string.h>
+#include <svc_kvstore.h>
+
+/**
+ * @brief   Size of the simulated storage.
+ */
+#define MEMORY_SIZE                   (12 * SVC_KVSTORE_SLOTSIZE)
+
+/**
+ * @brief   Simulated storage.
+ */
+static uint8_t _memory[MEMORY_SIZE];
+
+/**
+ * @brief   Number of write cycles per slot of the simulated storage.
+ */
+static uint16_t _cycles[MEMORY_SIZE / SVC_KVSTORE_SLOTSIZE];
+
+/**
+ * @brief   Read callback of the simulated storage.
+ */
+static bool _read(void* arg, size_t address, uint8_t* buffer, size_t length)
+{
+  (void)arg;
+  if (address + length > MEMORY_SIZE) {
+    return false;
+  }
+  memcpy(buffer, &_memory[address], length);
+  return true;
+}
+
+/**
+ * @brief   Write callback of the simulated storage.
+ */
+static bool _write(void* arg, size_t address, const uint8_t* data, size_t length)
+{
+  (void)arg;
+  if (address + length > MEMORY_SIZE) {
+    return false;
+  }
+  memcpy(&_memory[address], data, length);
+  ++_cycles[address / SVC_KVSTORE_SLOTSIZE];
+  return true;
+}
+
+/**
+ * @brief   Simulated storage backend.
+ */
+static const svc_kvstore_backend_t _backend = {
+  /* read   */ _read,
+  /* write  */ _write,
+  /* arg    */ NULL,
+};
+
+/**
+ * @brief   Key-value store unit test function.
+ * @details Tests the store on a simulated storage, including wear leveling and recovery from corrupt records.
+ *
+ * @param[in] stream  Stream for input/output.
+ * @param[in] ut      Unit test object.
+ *
+ * @return            Unit test result value.
+ */
+aos_utresult_t utSvcKvStoreFunc(BaseSequentialStream* stream, aos_unittest_t* ut)
+{
+  (void)ut;
+
+  // local variables
+  aos_utresult_t result = {0, 0};
+  svc_kvstore_t store;
+  uint8_t value[SVC_KVSTORE_MAXVALUE];
+  uint32_t counter;
+  int length;
+  bool ok;
+
+  chprintf(stream, "format and mount empty store...\n");
+  memset(_memory, 0x00, sizeof(_memory));
+  svcKvStoreInit(&store, &_backend, 0, MEMORY_SIZE);
+  ok = svcKvStoreFormat(&store) && svcKvStoreMount(&store);
+  for (uint8_t key = 1; key < SVC_KVSTORE_NUMKEYS; ++key) {
+    ok = ok && (svcKvStoreGet(&store, key, value, sizeof(value)) < 0);
+  }
+  if (ok && store.numslots == MEMORY_SIZE / SVC_KVSTORE_SLOTSIZE) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+
+  chprintf(stream, "set and get values...\n");
+  memset(_cycles, 0, sizeof(_cycles));
+  ok = svcKvStoreSet(&store, 1, (const uint8_t*)"\x2A", 1) && svcKvStoreSet(&store, 2, (const uint8_t*)"\x01\x02\x03\x04", 4);
+  length = svcKvStoreGet(&store, 2, value, sizeof(value));
+  if (ok && length == 4 && memcmp(value, "\x01\x02\x03\x04", 4) == 0 &&
+      svcKvStoreGet(&store, 1, value, sizeof(value)) == 1 && value[0] == 0x2A) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailedMsg(stream, &result, "length %d\n", length);
+  }
+
+  chprintf(stream, "skip unchanged values...\n");
+  counter = store.stats.writes;
+  if (svcKvStoreSet(&store, 1, (const uint8_t*)"\x2A", 1) && store.stats.writes == counter && store.stats.skipped == 1) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailedMsg(stream, &result, "%u writes\n", store.stats.writes - counter);
+  }
+
+  chprintf(stream, "level wear of frequent updates...\n");
+  ok = true;
+  for (counter = 0; counter < 1000 && ok; ++counter) {
+    ok = svcKvStoreSet(&store, 1, (const uint8_t*)&counter, sizeof(counter));
+  }
+  {
+    const uint8_t cold = (uint8_t)store.index[2].slot;
+    uint16_t min = 0xFFFF, max = 0;
+    for (uint8_t slot = 0; slot < store.numslots; ++slot) {
+      if (slot != cold) {
+        min = (_cycles[slot] < min) ? _cycles[slot] : min;
+        max = (_cycles[slot] > max) ? _cycles[slot] : max;
+      }
+    }
+    length = svcKvStoreGet(&store, 2, value, sizeof(value));
+    if (ok && max - min <= 1 && _cycles[cold] == 1 && length == 4 && memcmp(value, "\x01\x02\x03\x04", 4) == 0) {
+      aosUtPassedMsg(stream, &result, "%u to %u cycles per slot\n", min, max);
+    } else {
+      aosUtFailedMsg(stream, &result, "%u to %u cycles per slot, %u cycles of the cold slot\n", min, max, _cycles[cold]);
+    }
+  }
+
+  chprintf(stream, "mount existing store...\n");
+  svcKvStoreInit(&store, &_backend, 0, MEMORY_SIZE);
+  ok = svcKvStoreMount(&store);
+  length = svcKvStoreGet(&store, 1, value, sizeof(value));
+  memcpy(&counter, value, sizeof(counter));
+  if (ok && length == sizeof(counter) && counter == 999 && store.stats.rescans == 0) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailedMsg(stream, &result, "value %u\n", counter);
+  }
+
+  chprintf(stream, "recover from a torn write...\n");
+  _memory[store.index[1].slot * SVC_KVSTORE_SLOTSIZE + 4] ^= 0x10;
+  svcKvStoreInit(&store, &_backend, 0, MEMORY_SIZE);
+  ok = svcKvStoreMount(&store);
+  length = svcKvStoreGet(&store, 1, value, sizeof(value));
+  memcpy(&counter, value, sizeof(counter));
+  if (ok && length == sizeof(counter) && counter == 998 && store.stats.rescans == 1) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailedMsg(stream, &result, "value %u, %u rescans\n", counter, store.stats.rescans);
+  }
+
+  chprintf(stream, "survive sequence number overflow...\n");
+  store.sequence = 0xFFFE;
+  ok = true;
+  for (counter = 0; counter < 8 && ok; ++counter) {
+    ok = svcKvStoreSet(&store, 3, (const uint8_t*)&counter, sizeof(counter));
+  }
+  svcKvStoreInit(&store, &_backend, 0, MEMORY_SIZE);
+  ok = ok && svcKvStoreMount(&store);
+  length = svcKvStoreGet(&store, 3, value, sizeof(value));
+  memcpy(&counter, value, sizeof(counter));
+  ok = ok && (length == sizeof(counter) && counter == 7);
+  counter = 100;
+  ok = ok && svcKvStoreSet(&store, 3, (const uint8_t*)&counter, sizeof(counter));
+  svcKvStoreInit(&store, &_backend, 0, MEMORY_SIZE);
+  ok = ok && svcKvStoreMount(&store);
+  length = svcKvStoreGet(&store, 3, value, sizeof(value));
+  memcpy(&counter, value, sizeof(counter));
+  if (ok && length == sizeof(counter) && counter == 100) {
+    aosUtPassedMsg(stream, &result, "sequence %u\n", store.index[3].sequence);
+  } else {
+    aosUtFailedMsg(stream, &result, "value %u, sequence %u\n", counter, store.index[3].sequence);
+  }
+
+  chprintf(stream, "delete values...\n");
+  ok = svcKvStoreDelete(&store, 3);
+  svcKvStoreInit(&store, &_backend, 0, MEMORY_SIZE);
+  ok = ok && svcKvStoreMount(&store);
+  if (ok && svcKvStoreGet(&store, 3, value, sizeof(value)) < 0 && svcKvStoreGet(&store, 2, value, sizeof(value)) == 4) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+
+  chprintf(stream, "reject writes to a full store...\n");
+  svcKvStoreInit(&store, &_backend, 0, 4 * SVC_KVSTORE_SLOTSIZE);
+  ok = svcKvStoreFormat(&store);
+  for (uint8_t key = 1; key <= 4; ++key) {
+    ok = ok && svcKvStoreSet(&store, key, &key, 1);
+  }
+  value[0] = 0xFF;
+  if (ok && !svcKvStoreSet(&store, 5, value, 1) && !svcKvStoreSet(&store, 1, value, 1) &&
+      svcKvStoreGet(&store, 1, value, sizeof(value)) == 1 && value[0] == 1) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+
+  return result;
+}
+
+#endif /* AMIROOS_CFG_TESTS_ENABLE == true */
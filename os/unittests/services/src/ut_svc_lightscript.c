@@ -0,0 +1,187 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <ut_svc_lightscript.h>
+
+#if (AMIROOS_CFG_TESTS_ENABLE == true) || defined(__DOXYGEN__)
+
+#include <aos_debug.h>
+#include <chprintf.h>
+#include <svc_lightscript.h>
+
+/**
+ * @brief   Frame period in microseconds the renderer must keep up with (100 fps).
+ */
+#define _period                                 10000
+
+/**
+ * @brief   Helper function to convert realtime counter ticks to microseconds.
+ *
+ * @param[in] cycles      Realtime counter ticks.
+ * @param[in] frequency   Realtime counter frequency in Hz.
+ *
+ * @return                Converted value in microseconds.
+ */
+static inline uint32_t _cycles2us(rtcnt_t cycles, uint32_t frequency) {
+  return (uint32_t)((uint64_t)cycles * 1000000 / frequency);
+}
+
+/**
+ * @brief   Light script unit test function.
+ * @details Tests script validation, keyframe interpolation and the lookup tables and measures the rendering time.
+ *
+ * @param[in] stream  Stream for input/output.
+ * @param[in] ut      Unit test object.
+ *
+ * @return            Unit test result value.
+ */
+aos_utresult_t utSvcLightScriptFunc(BaseSequentialStream* stream, aos_unittest_t* ut)
+{
+  aosDbgCheck(ut->data != NULL && ((ut_lightscriptdata_t*)(ut->data))->iterations > 0 && ((ut_lightscriptdata_t*)(ut->data))->rtcfrequency > 0);
+
+  // local variables
+  aos_utresult_t result = {0, 0};
+  svc_lightscript_player_t player;
+  uint16_t values[SVC_LIGHTSCRIPT_NUMCHANNELS];
+  uint16_t pwm[SVC_LIGHTSCRIPT_NUMCHANNELS];
+  uint16_t lut[SVC_LIGHTSCRIPT_LUT_SIZE];
+  const uint8_t off[SVC_LIGHTSCRIPT_NUMCHANNELS] = {0};
+  const uint8_t fade[] = {SVC_LIGHTSCRIPT_OP_FILL, 0xE8, 0x03, 200, 100, 0};
+  const uint8_t eased[] = {SVC_LIGHTSCRIPT_OP_FILL | SVC_LIGHTSCRIPT_FLAG_EASE, 0xE8, 0x03, 200, 100, 0};
+  const uint8_t rotate[] = {SVC_LIGHTSCRIPT_OP_SET, 0x00, 0x00, 3, 0, 255, 1, 128, 2, 64,
+                            SVC_LIGHTSCRIPT_OP_ROTATE, 0x00, 0x00, (uint8_t)-1};
+  const uint8_t spin[] = {SVC_LIGHTSCRIPT_OP_FILL, 0x00, 0x00, 0, 0, 0,
+                          SVC_LIGHTSCRIPT_OP_SET, 0x00, 0x00, 3, 0, 255, 1, 255, 2, 255,
+                          SVC_LIGHTSCRIPT_OP_ROTATE, 0x7D, 0x00, 1,
+                          SVC_LIGHTSCRIPT_OP_LOOP, 16};
+  const uint8_t badchannel[] = {SVC_LIGHTSCRIPT_OP_SET, 0x00, 0x00, 1, SVC_LIGHTSCRIPT_NUMCHANNELS, 255};
+  const uint8_t truncated[] = {SVC_LIGHTSCRIPT_OP_SET, 0x00, 0x00, 2, 0, 255, 1};
+  const uint8_t zeroloop[] = {SVC_LIGHTSCRIPT_OP_SCALE, 0x00, 0x00, 128, SVC_LIGHTSCRIPT_OP_LOOP, 0};
+  const uint8_t misaligned[] = {SVC_LIGHTSCRIPT_OP_SCALE, 0x10, 0x00, 128, SVC_LIGHTSCRIPT_OP_LOOP, 1};
+  const uint8_t earlyloop[] = {SVC_LIGHTSCRIPT_OP_SCALE, 0x10, 0x00, 128, SVC_LIGHTSCRIPT_OP_LOOP, 0, SVC_LIGHTSCRIPT_OP_SCALE, 0x10, 0x00, 128};
+  const uint8_t unknown[] = {0x7F, 0x00, 0x00};
+  bool running;
+  rtcnt_t start, cycles;
+
+  chprintf(stream, "validate scripts...\n");
+  if (svcLightScriptValidate(fade, sizeof(fade)) && svcLightScriptValidate(rotate, sizeof(rotate)) && svcLightScriptValidate(spin, sizeof(spin))) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+  if (!svcLightScriptValidate(badchannel, sizeof(badchannel)) && !svcLightScriptValidate(truncated, sizeof(truncated)) &&
+      !svcLightScriptValidate(zeroloop, sizeof(zeroloop)) && !svcLightScriptValidate(misaligned, sizeof(misaligned)) &&
+      !svcLightScriptValidate(earlyloop, sizeof(earlyloop)) && !svcLightScriptValidate(unknown, sizeof(unknown)) &&
+      !svcLightScriptValidate(fade, 0)) {
+    aosUtPassedMsg(stream, &result, "malformed scripts rejected\n");
+  } else {
+    aosUtFailedMsg(stream, &result, "malformed script accepted\n");
+  }
+
+  chprintf(stream, "interpolate linear fade...\n");
+  svcLightScriptStart(&player, fade, sizeof(fade), off, 1000000);
+  svcLightScriptRender(&player, 1500000, values);
+  if (values[0] == (100 << 8) && values[1] == (50 << 8) && values[2] == 0) {
+    aosUtPassedMsg(stream, &result, "0x%04X 0x%04X 0x%04X at half time\n", values[0], values[1], values[2]);
+  } else {
+    aosUtFailedMsg(stream, &result, "0x%04X 0x%04X 0x%04X at half time\n", values[0], values[1], values[2]);
+  }
+  running = svcLightScriptRender(&player, 2000000, values);
+  if (!running && values[0] == (200 << 8) && values[22] == (100 << 8)) {
+    aosUtPassedMsg(stream, &result, "final keyframe held\n");
+  } else {
+    aosUtFailedMsg(stream, &result, "final keyframe not held\n");
+  }
+
+  chprintf(stream, "interpolate eased fade...\n");
+  svcLightScriptStart(&player, eased, sizeof(eased), off, 0);
+  svcLightScriptRender(&player, 250000, pwm);
+  svcLightScriptRender(&player, 500000, values);
+  // the eased transition starts slower than the linear one but is symmetric
+  if (pwm[0] < (50 << 8) && values[0] == (100 << 8)) {
+    aosUtPassedMsg(stream, &result, "0x%04X at quarter time, 0x%04X at half time\n", pwm[0], values[0]);
+  } else {
+    aosUtFailedMsg(stream, &result, "0x%04X at quarter time, 0x%04X at half time\n", pwm[0], values[0]);
+  }
+
+  chprintf(stream, "rotate pattern...\n");
+  svcLightScriptStart(&player, rotate, sizeof(rotate), off, 0);
+  running = svcLightScriptRender(&player, 0, values);
+  if (!running && values[21] == (255 << 8) && values[22] == (128 << 8) && values[23] == (64 << 8) && values[0] == 0) {
+    aosUtPassed(stream, &result);
+  } else {
+    aosUtFailed(stream, &result);
+  }
+
+  chprintf(stream, "loop script...\n");
+  svcLightScriptStart(&player, spin, sizeof(spin), off, 0);
+  svcLightScriptRender(&player, 62500, values);
+  if (values[0] == (128 << 8) - 128 && values[3] == (127 << 8) + 128) {
+    aosUtPassedMsg(stream, &result, "cross fade 0x%04X 0x%04X\n", values[0], values[3]);
+  } else {
+    aosUtFailedMsg(stream, &result, "cross fade 0x%04X 0x%04X\n", values[0], values[3]);
+  }
+  running = svcLightScriptRender(&player, 1000000, values);
+  if (running && values[0] == (255 << 8) && values[3] == 0 && values[21] == 0) {
+    aosUtPassedMsg(stream, &result, "full turn after one second\n");
+  } else {
+    aosUtFailedMsg(stream, &result, "no full turn after one second\n");
+  }
+
+  chprintf(stream, "lookup tables...\n");
+  {
+    bool monotonic = true;
+    for (uint16_t i = 1; i < SVC_LIGHTSCRIPT_LUT_SIZE; ++i) {
+      monotonic = monotonic && (svcLightScriptGamma[i] >= svcLightScriptGamma[i - 1]);
+    }
+    if (monotonic && svcLightScriptGamma[0] == 0 && svcLightScriptMap(svcLightScriptGamma, SVC_LIGHTSCRIPT_VALUE_MAX) == (1 << SVC_LIGHTSCRIPT_PWM_BITS) - 1) {
+      aosUtPassed(stream, &result);
+    } else {
+      aosUtFailed(stream, &result);
+    }
+  }
+  svcLightScriptBuildLut(lut, 128);
+  if (lut[255] == svcLightScriptGamma[128] && lut[0] == 0 &&
+      svcLightScriptMap(svcLightScriptGamma, 0x8080) > svcLightScriptGamma[128] && svcLightScriptMap(svcLightScriptGamma, 0x8080) < svcLightScriptGamma[129]) {
+    aosUtPassedMsg(stream, &result, "half brightness maximum %u\n", lut[255]);
+  } else {
+    aosUtFailedMsg(stream, &result, "half brightness maximum %u\n", lut[255]);
+  }
+
+  chprintf(stream, "benchmark (%u frames)...\n", ((ut_lightscriptdata_t*)(ut->data))->iterations);
+  svcLightScriptBuildLut(lut, 255);
+  svcLightScriptStart(&player, spin, sizeof(spin), off, 0);
+  start = chSysGetRealtimeCounterX();
+  for (uint32_t i = 0; i < ((ut_lightscriptdata_t*)(ut->data))->iterations; ++i) {
+    svcLightScriptRender(&player, (uint64_t)i * _period, values);
+    for (uint8_t channel = 0; channel < SVC_LIGHTSCRIPT_NUMCHANNELS; ++channel) {
+      pwm[channel] = svcLightScriptMap(lut, values[channel]);
+    }
+  }
+  cycles = (chSysGetRealtimeCounterX() - start) / ((ut_lightscriptdata_t*)(ut->data))->iterations;
+  // a frame must not take more than a tenth of the frame period
+  if (_cycles2us(cycles, ((ut_lightscriptdata_t*)(ut->data))->rtcfrequency) < _period / 10) {
+    aosUtPassedMsg(stream, &result, "%u cycles (%uus) per frame\n", cycles, _cycles2us(cycles, ((ut_lightscriptdata_t*)(ut->data))->rtcfrequency));
+  } else {
+    aosUtFailedMsg(stream, &result, "%u cycles (%uus) per frame\n", cycles, _cycles2us(cycles, ((ut_lightscriptdata_t*)(ut->data))->rtcfrequency));
+  }
+
+  return result;
+}
+
+#endif /* AMIROOS_CFG_TESTS_ENABLE == true */
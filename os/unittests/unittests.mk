@@ -28,7 +28,8 @@ UNITTESTS_DIR := $(dir $(lastword $(MAKEFILE_LIST)))
 
 # include path
 UNITTESTSINC = $(UNITTESTS_DIR)lld/inc \
-               $(UNITTESTS_DIR)periphery-lld/inc
+               $(UNITTESTS_DIR)periphery-lld/inc \
+               $(UNITTESTS_DIR)services/inc
 
 # C sources
 UNITTESTSCSRC = $(UNITTESTS_DIR)lld/src/ut_lld_adc.c \
@@ -50,5 +51,11 @@ UNITTESTSCSRC = $(UNITTESTS_DIR)lld/src/ut_lld_adc.c \
                 $(UNITTESTS_DIR)periphery-lld/src/ut_alld_tps2051bdbv.c \
                 $(UNITTESTS_DIR)periphery-lld/src/ut_alld_tps62113.c \
                 $(UNITTESTS_DIR)periphery-lld/src/ut_alld_tps62113_ina219.c \
-                $(UNITTESTS_DIR)periphery-lld/src/ut_alld_vcnl4020.c
+                $(UNITTESTS_DIR)periphery-lld/src/ut_alld_vcnl4020.c \
+                $(UNITTESTS_DIR)services/src/ut_svc_canfilter.c \
+                $(UNITTESTS_DIR)services/src/ut_svc_canproto.c \
+                $(UNITTESTS_DIR)services/src/ut_svc_imucalib.c \
+                $(UNITTESTS_DIR)services/src/ut_svc_imufilter.c \
+                $(UNITTESTS_DIR)services/src/ut_svc_kvstore.c \
+                $(UNITTESTS_DIR)services/src/ut_svc_lightscript.c
 
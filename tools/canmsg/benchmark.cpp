@@ -0,0 +1,311 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * Host benchmark of the compile-time CAN message codecs (aos_canmsg.hpp)
+ * against the byte loops, which were used by aos_main.cpp before.
+ *
+ * Both implementations must produce identical payloads, which is verified
+ * for random values and TM structs before the timing is measured.
+ */
+
+#include <aos_canmsg.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+
+/******************************************************************************/
+/* REFERENCE IMPLEMENTATION (aos_main.cpp before the codecs)                  */
+/******************************************************************************/
+
+namespace reference {
+
+inline void _serialize(uint8_t* dst, const uint64_t src, const uint8_t n)
+{
+  for (uint8_t byte = 0; byte < n; ++byte) {
+    dst[byte] = (uint8_t)((src >> (byte * 8)) & 0xFF);
+  }
+
+  return;
+}
+
+inline uint64_t _deserialize(uint8_t* src, const uint8_t n)
+{
+  uint64_t result = 0;
+  for (uint8_t byte = 0; byte < n; ++byte) {
+    result |= ((uint64_t)src[byte]) << (byte * 8);
+  }
+
+  return result;
+}
+
+inline uint64_t _TM2U64(struct tm* src)
+{
+  return (((uint64_t)(src->tm_sec  & 0x0000003F) << (0))               |
+          ((uint64_t)(src->tm_min  & 0x0000003F) << (6))               |
+          ((uint64_t)(src->tm_hour & 0x0000001F) << (12))              |
+          ((uint64_t)(src->tm_mday & 0x0000001F) << (17))              |
+          ((uint64_t)(src->tm_mon  & 0x0000000F) << (22))              |
+          ((uint64_t)(src->tm_year & 0x00FFFFFF) << (26))              |
+          ((uint64_t)(src->tm_wday & 0x00000007) << (50))              |
+          ((uint64_t)(src->tm_yday & 0x000001FF) << (53))              |
+          ((uint64_t)((src->tm_isdst == 0) ? 0 : (src->tm_isdst > 0) ? 1 : 2) << (62)));
+}
+
+inline void _U642TM(struct tm* dst, const uint64_t src)
+{
+  dst->tm_sec  = (src >> 0)  & 0x0000003F;
+  dst->tm_min  = (src >> 6)  & 0x0000003F;
+  dst->tm_hour = (src >> 12) & 0x0000001F;
+  dst->tm_mday = (src >> 17) & 0x0000001F;
+  dst->tm_mon  = (src >> 22) & 0x0000000F;
+  dst->tm_year = (src >> 26) & 0x00FFFFFF;
+  dst->tm_wday = (src >> 50) & 0x00000007;
+  dst->tm_yday = (src >> 53) & 0x000001FF;
+  dst->tm_isdst = (((src >> 62) & 0x03) == 0) ? 0 : (((src >> 62) & 0x03) > 0) ? 1 : -1;
+
+  return;
+}
+
+} /* namespace reference */
+
+/******************************************************************************/
+/* CODECS (as declared in aos_main.cpp)                                       */
+/******************************************************************************/
+
+namespace codec {
+
+typedef amiroos::CanField<0, 4, uint32_t> ModuleIdField;
+typedef amiroos::CanMessage<0x000, 4, ModuleIdField> ModuleIdMessage;
+
+typedef amiroos::CanField<0, 8, uint64_t> CalendarSyncField;
+typedef amiroos::CanMessage<0x000, 8, CalendarSyncField> CalendarSyncMessage;
+
+namespace calendar {
+  typedef amiroos::CanBitField<0, 6, int> Sec;
+  typedef amiroos::CanBitField<6, 6, int> Min;
+  typedef amiroos::CanBitField<12, 5, int> Hour;
+  typedef amiroos::CanBitField<17, 5, int> Mday;
+  typedef amiroos::CanBitField<22, 4, int> Mon;
+  typedef amiroos::CanBitField<26, 24, int> Year;
+  typedef amiroos::CanBitField<50, 3, int> Wday;
+  typedef amiroos::CanBitField<53, 9, int> Yday;
+  typedef amiroos::CanBitField<62, 2, int> Isdst;
+  typedef amiroos::CanWord<Sec, Min, Hour, Mday, Mon, Year, Wday, Yday, Isdst> Word;
+}
+
+inline uint64_t _TM2U64(const struct tm* src)
+{
+  return calendar::Word::encode(src->tm_sec, src->tm_min, src->tm_hour, src->tm_mday, src->tm_mon, src->tm_year,
+                                src->tm_wday, src->tm_yday, (src->tm_isdst == 0) ? 0 : (src->tm_isdst > 0) ? 1 : 2);
+}
+
+inline void _U642TM(struct tm* dst, const uint64_t src)
+{
+  dst->tm_sec  = calendar::Sec::decode(src);
+  dst->tm_min  = calendar::Min::decode(src);
+  dst->tm_hour = calendar::Hour::decode(src);
+  dst->tm_mday = calendar::Mday::decode(src);
+  dst->tm_mon  = calendar::Mon::decode(src);
+  dst->tm_year = calendar::Year::decode(src);
+  dst->tm_wday = calendar::Wday::decode(src);
+  dst->tm_yday = calendar::Yday::decode(src);
+  dst->tm_isdst = (calendar::Isdst::decode(src) == 0) ? 0 : (calendar::Isdst::decode(src) == 1) ? 1 : -1;
+
+  return;
+}
+
+} /* namespace codec */
+
+/******************************************************************************/
+/* BENCHMARK                                                                  */
+/******************************************************************************/
+
+/**
+ * @brief   Number of random values for the equality check.
+ */
+#define CHECK_SAMPLES                           1000000
+
+/**
+ * @brief   Number of pack/unpack iterations per timing run.
+ */
+#define TIMING_ITERATIONS                       100000000
+
+/**
+ * @brief   Number of distinct values cycled through by the timing runs (power of two).
+ */
+#define TIMING_VALUES                           1024
+
+/**
+ * @brief   Prevents the compiler from optimizing the payload accesses away.
+ *
+ * @param[in] p   Pointer to the payload.
+ */
+static inline void _clobber(void* p)
+{
+  asm volatile("" : : "g"(p) : "memory");
+  return;
+}
+
+/**
+ * @brief   Creates a random TM struct, which covers all encodable values.
+ *
+ * @param[in] rng   Random number generator.
+ *
+ * @return  The TM struct.
+ */
+static struct tm _randomTM(std::mt19937_64& rng)
+{
+  struct tm t;
+  memset(&t, 0, sizeof(t));
+  t.tm_sec = rng() % 62;
+  t.tm_min = rng() % 60;
+  t.tm_hour = rng() % 24;
+  t.tm_mday = 1 + rng() % 31;
+  t.tm_mon = rng() % 12;
+  t.tm_year = rng() % (1 << 24);
+  t.tm_wday = rng() % 7;
+  t.tm_yday = rng() % 366;
+  t.tm_isdst = (int)(rng() % 3) - 1;
+  return t;
+}
+
+/**
+ * @brief   Verifies that both implementations produce identical payloads.
+ *
+ * @param[in] rng   Random number generator.
+ *
+ * @return  Number of mismatches.
+ */
+static unsigned int _check(std::mt19937_64& rng)
+{
+  unsigned int errors = 0;
+
+  for (unsigned int i = 0; i < CHECK_SAMPLES; ++i) {
+    uint8_t ref[8] = {0};
+    uint8_t cod[8] = {0};
+
+    // 4 byte field
+    const uint32_t id = (uint32_t)rng();
+    reference::_serialize(ref, id, 4);
+    codec::ModuleIdMessage::pack<codec::ModuleIdField>(cod, id);
+    if (memcmp(ref, cod, sizeof(ref)) != 0 ||
+        reference::_deserialize(ref, 4) != codec::ModuleIdMessage::unpack<codec::ModuleIdField>(cod)) {
+      ++errors;
+    }
+
+    // 8 byte field
+    const uint64_t value = rng();
+    reference::_serialize(ref, value, 8);
+    codec::CalendarSyncMessage::pack<codec::CalendarSyncField>(cod, value);
+    if (memcmp(ref, cod, sizeof(ref)) != 0 ||
+        reference::_deserialize(ref, 8) != codec::CalendarSyncMessage::unpack<codec::CalendarSyncField>(cod)) {
+      ++errors;
+    }
+
+    // calendar encoding
+    struct tm t = _randomTM(rng);
+    struct tm tref, tcod;
+    const uint64_t eref = reference::_TM2U64(&t);
+    const uint64_t ecod = codec::_TM2U64(&t);
+    reference::_U642TM(&tref, eref);
+    codec::_U642TM(&tcod, ecod);
+    // the reference decodes "no information available" (2) as DST in effect, which was a bug
+    if (t.tm_isdst < 0) {
+      tref.tm_isdst = -1;
+    }
+    if (eref != ecod ||
+        tref.tm_sec != tcod.tm_sec || tref.tm_min != tcod.tm_min || tref.tm_hour != tcod.tm_hour ||
+        tref.tm_mday != tcod.tm_mday || tref.tm_mon != tcod.tm_mon || tref.tm_year != tcod.tm_year ||
+        tref.tm_wday != tcod.tm_wday || tref.tm_yday != tcod.tm_yday || tref.tm_isdst != tcod.tm_isdst) {
+      ++errors;
+    }
+  }
+
+  return errors;
+}
+
+/**
+ * @brief   Measures the average time of a pack/unpack round trip.
+ *
+ * @tparam  F       Round trip function.
+ *
+ * @param[in] values  Values to cycle through.
+ * @param[in] f       The round trip function.
+ *
+ * @return  Average time per round trip in nanoseconds.
+ */
+template <typename F>
+static double _measure(const uint64_t* values, F f)
+{
+  uint8_t data[8];
+  uint64_t sink = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < TIMING_ITERATIONS; ++i) {
+    sink += f(data, values[i & (TIMING_VALUES - 1)]);
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  _clobber(&sink);
+
+  return std::chrono::duration<double, std::nano>(stop - start).count() / TIMING_ITERATIONS;
+}
+
+int main(void)
+{
+  std::mt19937_64 rng(0x414D69526F4F53ull);
+  uint64_t values[TIMING_VALUES];
+
+  const unsigned int errors = _check(rng);
+  printf("equality check: %u samples, %u mismatches\n", CHECK_SAMPLES, errors);
+  if (errors != 0) {
+    return EXIT_FAILURE;
+  }
+
+  for (unsigned int i = 0; i < TIMING_VALUES; ++i) {
+    values[i] = rng();
+  }
+
+  // a 4 byte and an 8 byte field are packed and unpacked per iteration
+  const double ref = _measure(values, [](uint8_t* data, uint64_t value) {
+    reference::_serialize(data, value, 4);
+    _clobber(data);
+    uint64_t result = reference::_deserialize(data, 4);
+    reference::_serialize(data, value, 8);
+    _clobber(data);
+    return result + reference::_deserialize(data, 8);
+  });
+  const double cod = _measure(values, [](uint8_t* data, uint64_t value) {
+    codec::ModuleIdMessage::pack<codec::ModuleIdField>(data, (uint32_t)value);
+    _clobber(data);
+    uint64_t result = codec::ModuleIdMessage::unpack<codec::ModuleIdField>(data);
+    codec::CalendarSyncMessage::pack<codec::CalendarSyncField>(data, value);
+    _clobber(data);
+    return result + codec::CalendarSyncMessage::unpack<codec::CalendarSyncField>(data);
+  });
+
+  printf("loops:  %6.1f ns\n", ref);
+  printf("codecs: %6.1f ns\n", cod);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,43 @@
+/*
+AMiRo-OS is an operating system designed for the Autonomous Mini Robot (AMiRo) platform.
+Copyright (C) 2016..2018  Thomas Schöpping et al.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _HAL_H_
+#define _HAL_H_
+
+/*
+ * Minimal host replacement of the ChibiOS HAL, which provides only what
+ * aos_canmsg.hpp needs. The frame layout is irrelevant for the benchmark.
+ */
+
+#include <stdint.h>
+
+#define CAN_IDE_STD                             0
+#define CAN_RTR_DATA                            0
+
+typedef struct {
+  uint8_t DLC;
+  uint8_t RTR;
+  uint8_t IDE;
+  uint32_t SID;
+  uint8_t data8[8];
+} CANTxFrame;
+
+typedef CANTxFrame CANRxFrame;
+
+#endif /* _HAL_H_ */